@@ -0,0 +1,66 @@
+// Autosave capture stall: how long the simulation thread waits for each background save.
+//
+// Usage: AutosaveBench
+// For several map sizes and fleet sizes steps the turn simulation, autosaving every 10 turns
+// to the temp directory, and prints the average and worst stall per capture (taking the
+// snapshot and handing it to the writer) next to the time capturing and writing a keyframe on
+// the simulation thread would take instead.
+
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+#include "bench.hpp"
+#include "job_system.hpp"
+#include "snapshot.hpp"
+#include "turn_simulation.hpp"
+
+int main() {
+    const int TURNS = 200;
+    const int AUTOSAVE_EVERY = 10;
+    const std::string basePath = (std::filesystem::temp_directory_path() / "autosave_bench").string();
+    JobSystem jobs;
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (auto [size, ships] : {std::pair{128, 500}, std::pair{256, 2000}, std::pair{512, 8000}}) {
+        HexGrid grid = randomGrid(size, size, static_cast<uint32_t>(size));
+        TurnSimulation simulation(grid, jobs);
+        simulation.populate(ships, 8);
+
+        int captures = 0;
+        double stallTotal = 0.0;
+        double stallMax = 0.0;
+        {
+            AutosaveWriter autosave(basePath);
+            for (int turn = 0; turn < TURNS; ++turn) {
+                simulation.step();
+                if (simulation.getTurn() % AUTOSAVE_EVERY != 0) continue;
+                Stopwatch watch;
+                auto snapshot = std::make_shared<Snapshot>();
+                simulation.save(*snapshot);
+                autosave.save(std::move(snapshot));
+                double stall = watch.milliseconds();
+                ++captures;
+                stallTotal += stall;
+                stallMax = std::max(stallMax, stall);
+            }
+            autosave.wait();
+        }
+
+        Stopwatch watch;
+        Snapshot snapshot;
+        simulation.save(snapshot);
+        writeKeyframe(snapshot, basePath + ".sync");
+        double syncMs = watch.milliseconds();
+
+        std::cout << size << "x" << size << ", " << simulation.getEntities().size() << " entities, "
+                  << snapshot.getByteSize() / 1024 << " KiB: stall " << stallTotal / captures << " ms average, "
+                  << stallMax << " ms worst over " << captures << " captures; keyframe on this thread " << syncMs
+                  << " ms" << std::endl;
+    }
+
+    for (const char* extension : {".key", ".delta", ".sync"}) std::filesystem::remove(basePath + extension);
+    return 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include "hex_grid.hpp"
+
+// Shared by the benchmark executables. They time CPU-side systems on synthetic maps and
+// print the results; correctness is left to the tests, though a bench comparing two
+// implementations exits with 1 when their answers disagree.
+
+// Every tile gets a uniformly random terrain type, so entry costs vary from tile to tile
+// everywhere on the map. Under MovementProfile::allTerrain() every tile is passable and paths
+// and ranges bend around the costly ones; under land() the scattered water tiles block them.
+inline HexGrid randomGrid(int width, int height, uint32_t seed) {
+    HexGrid grid(width, height, TerrainType::Grassland);
+    std::mt19937 rng(seed);
+    for (int i = 0; i < grid.size(); ++i) {
+        grid.setType(i, static_cast<TerrainType>(rng() % static_cast<uint32_t>(TerrainType::Count)));
+    }
+    return grid;
+}
+
+class Stopwatch {
+public:
+    Stopwatch() : start(std::chrono::steady_clock::now()) {}
+
+    void restart() { start = std::chrono::steady_clock::now(); }
+    double seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+    double milliseconds() const { return seconds() * 1e3; }
+    double microseconds() const { return seconds() * 1e6; }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
@@ -0,0 +1,104 @@
+// Combat resolution at 10k engagements per turn.
+//
+// Usage: CombatBench
+// Lines up 5000 pairs of enemy ships side by side, so every ship has one target, and prints
+// the average time per turn of each combat phase on one thread, then of the gather, merge and
+// resolve phases run as a job graph the way TurnSimulation runs them, on one worker and on
+// every core.
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "bench.hpp"
+#include "combat_resolver.hpp"
+#include "job_system.hpp"
+
+namespace {
+
+constexpr int PAIRS = 5000;
+constexpr uint32_t TURNS = 200;
+constexpr size_t CHUNK_SIZE = 512;
+constexpr size_t SLICES = 64;
+
+double timeJobGraph(JobSystem& jobs, CombatResolver& combat, const EntityStore& entities) {
+    std::vector<EngagementBatch> chunks((entities.size() + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    EngagementBatch engagements;
+    JobGraph graph;
+    uint32_t turn = 0;
+    JobId gather = graph.addParallel(entities.size(), CHUNK_SIZE, [&](size_t begin, size_t end) {
+        combat.gather(entities, begin, end, chunks[begin / CHUNK_SIZE]);
+    });
+    JobId merge = graph.add([&]() { combat.merge(chunks, engagements); });
+    JobId fire = graph.addParallel(SLICES, 1, [&](size_t begin, size_t end) {
+        size_t total = engagements.size();
+        combat.resolve(engagements, turn, begin * total / SLICES, end * total / SLICES);
+    });
+    graph.precede(gather, merge);
+    graph.precede(merge, fire);
+
+    Stopwatch watch;
+    for (turn = 0; turn < TURNS; ++turn) {
+        for (EngagementBatch& chunk : chunks) chunk.clear();
+        jobs.run(graph);
+    }
+    return watch.milliseconds() / TURNS;
+}
+
+} // namespace
+
+int main() {
+    const int WIDTH = 400;
+    HexGrid grid(WIDTH, WIDTH, TerrainType::Ocean);
+    EntityStore entities(grid);
+    entities.reserve(PAIRS * 2);
+    const EntityKind kinds[] = {EntityKind::Frigate, EntityKind::ShipOfTheLine, EntityKind::Privateer,
+                                EntityKind::Flagship};
+    int pairs = 0;
+    for (int row = 0; row < WIDTH && pairs < PAIRS; row += 2) {
+        for (int col = 0; col + 1 < WIDTH && pairs < PAIRS; col += 4, ++pairs) {
+            entities.spawn(kinds[pairs % 4], row * WIDTH + col, 0, static_cast<uint8_t>(pairs % 6));
+            entities.spawn(kinds[(pairs + 1) % 4], row * WIDTH + col + 1, 1, static_cast<uint8_t>((pairs + 3) % 6));
+        }
+    }
+
+    CombatResolver combat(42);
+    std::vector<EngagementBatch> chunks((entities.size() + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    EngagementBatch engagements;
+    double gatherMs = 0.0;
+    double mergeMs = 0.0;
+    double resolveMs = 0.0;
+    double applyMs = 0.0;
+    for (uint32_t turn = 0; turn < TURNS; ++turn) {
+        Stopwatch watch;
+        for (size_t chunk = 0; chunk < chunks.size(); ++chunk) {
+            chunks[chunk].clear();
+            combat.gather(entities, chunk * CHUNK_SIZE, std::min(entities.size(), (chunk + 1) * CHUNK_SIZE),
+                          chunks[chunk]);
+        }
+        gatherMs += watch.milliseconds();
+        watch.restart();
+        combat.merge(chunks, engagements);
+        mergeMs += watch.milliseconds();
+        watch.restart();
+        combat.resolve(engagements, turn, 0, engagements.size());
+        resolveMs += watch.milliseconds();
+        watch.restart();
+        combat.apply(engagements, entities);
+        applyMs += watch.milliseconds();
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << engagements.size() << " engagements per turn, one thread: gather " << gatherMs / TURNS
+              << " ms, merge " << mergeMs / TURNS << " ms, resolve " << resolveMs / TURNS << " ms, apply "
+              << applyMs / TURNS << " ms" << std::endl;
+
+    JobSystem single(1);
+    JobSystem all;
+    double singleMs = timeJobGraph(single, combat, entities);
+    double allMs = timeJobGraph(all, combat, entities);
+    std::cout << "Job graph: 1 worker " << singleMs << " ms/turn, " << all.getWorkerCount() << " workers " << allMs
+              << " ms/turn" << std::endl;
+    return 0;
+}
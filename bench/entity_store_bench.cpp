@@ -0,0 +1,90 @@
+// EntityStore at 100k entities: spawning, despawning, iterating components and moving.
+//
+// Usage: EntityStoreBench
+// Prints the time for each operation over the whole store, and per entity. Iteration runs a
+// health decay touching one component, once on one thread and once on every core.
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "bench.hpp"
+#include "entity_store.hpp"
+
+namespace {
+
+void report(const char* what, double milliseconds, size_t count) {
+    std::cout << std::setw(28) << std::left << what << std::right << std::setw(9) << milliseconds << " ms, "
+              << std::setw(6) << milliseconds * 1e6 / count << " ns/entity" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    const int ENTITIES = 100000;
+    const int ITERATIONS = 100;
+    HexGrid grid(512, 512, TerrainType::Ocean);
+    EntityStore store(grid);
+    std::mt19937 rng(1);
+    std::vector<EntityHandle> handles;
+    handles.reserve(ENTITIES);
+    std::cout << std::fixed << std::setprecision(2);
+
+    Stopwatch watch;
+    for (int i = 0; i < ENTITIES; ++i) {
+        handles.push_back(store.spawn(static_cast<EntityKind>(i % static_cast<int>(EntityKind::Count)),
+                                      static_cast<int>(rng() % grid.size()), static_cast<uint8_t>(i % 8),
+                                      static_cast<uint8_t>(i % 6)));
+    }
+    report("Spawn", watch.milliseconds(), ENTITIES);
+
+    watch.restart();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        std::vector<float>& health = store.getHealth();
+        for (float& h : health) h *= 0.999f;
+    }
+    report("Iterate health, 1 thread", watch.milliseconds() / ITERATIONS, ENTITIES);
+
+    watch.restart();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        store.forEachParallel(0, [&store](size_t begin, size_t end, int) {
+            std::vector<float>& health = store.getHealth();
+            for (size_t e = begin; e < end; ++e) health[e] *= 0.999f;
+        });
+    }
+    report("Iterate health, all cores", watch.milliseconds() / ITERATIONS, ENTITIES);
+
+    // Despawn half in random order, so the swaps scatter through the arrays
+    std::vector<size_t> order(ENTITIES / 2);
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i * 2;
+    std::shuffle(order.begin(), order.end(), rng);
+    watch.restart();
+    for (size_t i : order) store.despawn(handles[i]);
+    report("Despawn half", watch.milliseconds(), order.size());
+
+    watch.restart();
+    for (size_t i : order) handles[i] = store.spawn(EntityKind::Caravel, static_cast<int>(rng() % grid.size()));
+    report("Respawn into freed slots", watch.milliseconds(), order.size());
+
+    watch.restart();
+    for (EntityHandle handle : handles) {
+        int tile = store.getTiles()[store.denseIndex(handle)];
+        int next = grid.neighborIndex(tile, static_cast<int>(rng() % 6));
+        if (next >= 0) store.move(handle, next);
+    }
+    report("Move to a neighbor", watch.milliseconds(), ENTITIES);
+
+    const int QUERIES = 10000;
+    std::vector<EntityHandle> found;
+    size_t hits = 0;
+    watch.restart();
+    for (int i = 0; i < QUERIES; ++i) {
+        found.clear();
+        store.queryRadius(grid.coordOf(static_cast<int>(rng() % grid.size())), 5, found);
+        hits += found.size();
+    }
+    double queryMs = watch.milliseconds();
+    std::cout << QUERIES << " radius-5 queries: " << queryMs << " ms, " << hits / QUERIES << " hits each" << std::endl;
+    return 0;
+}
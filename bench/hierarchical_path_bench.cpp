@@ -0,0 +1,118 @@
+// HPA* against flat A* on the same queries, at several map sizes.
+//
+// Usage: HierarchicalPathBench
+// For each size prints the abstract graph's build time and node count, the average latency of
+// both pathfinders over random long queries, and how much longer HPA*'s paths are (cost
+// ratio to the optimal flat path, average and worst). Queries where only one of them found a
+// path are counted and make the bench exit with 1, since both search the same graph. Ends
+// with the cost of repairing the abstract graph after single-tile edits.
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "bench.hpp"
+#include "hierarchical_pathfinder.hpp"
+
+namespace {
+
+// Random terrain with round lakes, which land paths have to go around
+HexGrid lakeGrid(int size, uint32_t seed) {
+    HexGrid grid = randomGrid(size, size, seed);
+    std::mt19937 rng(seed);
+    for (int lake = 0; lake < size * size / 400; ++lake) {
+        HexCoord center = grid.coordOf(static_cast<int>(rng() % grid.size()));
+        int radius = 2 + static_cast<int>(rng() % 5);
+        for (int dq = -radius; dq <= radius; ++dq) {
+            for (int dr = -radius; dr <= radius; ++dr) {
+                HexCoord hex(center.q + dq, center.r + dr);
+                int index = grid.indexOf(hex);
+                if (index >= 0 && hexDistance(hex, center) <= radius) grid.setType(index, TerrainType::Ocean);
+            }
+        }
+    }
+    return grid;
+}
+
+} // namespace
+
+int main() {
+    const MovementProfile profile = MovementProfile::land();
+    std::mt19937 rng(7);
+    std::vector<int> flatPath;
+    std::vector<int> hierarchicalPath;
+    std::cout << std::fixed;
+    int mismatches = 0;
+
+    for (int size : {64, 256, 1024}) {
+        HexGrid grid = lakeGrid(size, static_cast<uint32_t>(size));
+        Stopwatch watch;
+        HierarchicalPathfinder hierarchical(grid, profile, 16);
+        double buildMs = watch.milliseconds();
+        HexPathfinder flat(grid);
+
+        const int queries = size >= 1024 ? 50 : 500;
+        double flatSeconds = 0.0;
+        double hierarchicalSeconds = 0.0;
+        double ratioSum = 0.0;
+        double ratioMax = 1.0;
+        int found = 0;
+        int flatOnly = 0;
+        int hierarchicalOnly = 0;
+        for (int i = 0; i < queries; ++i) {
+            int start = static_cast<int>(rng() % grid.size());
+            int goal = static_cast<int>(rng() % grid.size());
+            float flatCost = 0.0f;
+            float hierarchicalCost = 0.0f;
+
+            watch.restart();
+            bool flatFound = flat.findPath(start, goal, profile, flatPath, &flatCost);
+            flatSeconds += watch.seconds();
+            watch.restart();
+            bool hierarchicalFound = hierarchical.findPath(start, goal, hierarchicalPath, &hierarchicalCost);
+            hierarchicalSeconds += watch.seconds();
+
+            if (flatFound && hierarchicalFound) {
+                double ratio = flatCost > 0.0f ? hierarchicalCost / flatCost : 1.0;
+                ratioSum += ratio;
+                ratioMax = std::max(ratioMax, ratio);
+                ++found;
+            } else if (flatFound) {
+                ++flatOnly;
+            } else if (hierarchicalFound) {
+                ++hierarchicalOnly;
+            }
+        }
+        mismatches += flatOnly + hierarchicalOnly;
+
+        std::cout << size << "x" << size << ": build " << std::setprecision(1) << buildMs << " ms, "
+                  << hierarchical.getAbstractNodeCount() << " abstract nodes" << std::endl;
+        std::cout << "  flat " << flatSeconds / queries * 1e6 << " us/query, HPA* "
+                  << hierarchicalSeconds / queries * 1e6 << " us/query ("
+                  << flatSeconds / hierarchicalSeconds << "x)";
+        if (hierarchicalSeconds > flatSeconds) std::cout << " (HPA* slower than flat A* at this size)";
+        std::cout << std::endl;
+        std::cout << "  path cost ratio " << std::setprecision(4) << (found > 0 ? ratioSum / found : 1.0)
+                  << " average, " << ratioMax << " worst over " << found << " paths" << std::endl;
+        if (flatOnly + hierarchicalOnly > 0) {
+            std::cout << "  MISMATCH: " << flatOnly << " paths only flat A* found, " << hierarchicalOnly
+                      << " only HPA* found" << std::endl;
+        }
+    }
+
+    HexGrid grid = lakeGrid(128, 3);
+    HierarchicalPathfinder hierarchical(grid, profile, 16);
+    const int edits = 300;
+    double repairSeconds = 0.0;
+    for (int i = 0; i < edits; ++i) {
+        int tile = static_cast<int>(rng() % grid.size());
+        grid.setType(tile, rng() % 2 ? TerrainType::Ocean : TerrainType::Grassland);
+        Stopwatch watch;
+        hierarchical.onTileChanged(tile);
+        repairSeconds += watch.seconds();
+    }
+    std::cout << "Repair after a tile edit: " << std::setprecision(1) << repairSeconds / edits * 1e6 << " us"
+              << std::endl;
+    return mismatches > 0 ? 1 : 0;
+}
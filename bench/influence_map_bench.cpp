@@ -0,0 +1,81 @@
+// Influence map updates at several map sizes.
+//
+// Usage: InfluenceMapBench
+// For each size places one range-8 source per 256 tiles over four layers and prints the time
+// for the first full update, for an incremental update after a tenth of the sources moved,
+// for re-summing every layer, and for sampling 10k tiles from each layer.
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "bench.hpp"
+#include "influence_map.hpp"
+
+namespace {
+
+// Mostly sea with land of mixed cost, like the generated archipelagos
+HexGrid archipelagoGrid(int size, std::mt19937& rng) {
+    HexGrid grid(size, size);
+    for (int i = 0; i < grid.size(); ++i) {
+        uint32_t roll = rng() % 10;
+        TerrainType type = roll < 4   ? TerrainType::Ocean
+                           : roll < 6 ? TerrainType::Grassland
+                           : roll < 8 ? TerrainType::Forest
+                           : roll < 9 ? TerrainType::Hills
+                                      : TerrainType::Mountains;
+        grid.setType(i, type);
+    }
+    return grid;
+}
+
+} // namespace
+
+int main() {
+    const int LAYERS = 4;
+    std::mt19937 rng(7);
+    std::cout << std::fixed << std::setprecision(2);
+
+    for (int size : {256, 512, 1024}) {
+        HexGrid grid = archipelagoGrid(size, rng);
+        InfluenceMap map(grid, LAYERS);
+        int sourceCount = size * size / 256;
+        std::vector<InfluenceSourceId> sources;
+        sources.reserve(sourceCount);
+        for (int i = 0; i < sourceCount; ++i) {
+            sources.push_back(map.addSource(i % LAYERS, static_cast<int>(rng() % grid.size()), 1.0f, 8.0f));
+        }
+
+        Stopwatch watch;
+        map.update();
+        double fullMs = watch.milliseconds();
+
+        for (int i = 0; i < sourceCount / 10; ++i) {
+            map.moveSource(sources[rng() % sources.size()], static_cast<int>(rng() % grid.size()));
+        }
+        watch.restart();
+        size_t recomputed = map.update();
+        double incrementalMs = watch.milliseconds();
+
+        watch.restart();
+        map.resum();
+        double resumMs = watch.milliseconds();
+
+        std::vector<int32_t> tiles(10000);
+        for (int32_t& tile : tiles) tile = static_cast<int32_t>(rng() % grid.size());
+        std::vector<float> samples;
+        float total = 0.0f;
+        watch.restart();
+        for (int layer = 0; layer < LAYERS; ++layer) {
+            map.sampleBatch(layer, tiles, samples);
+            for (float value : samples) total += value;
+        }
+        double sampleMs = watch.milliseconds();
+
+        std::cout << size << "x" << size << ", " << sourceCount << " sources: full update " << fullMs << " ms, "
+                  << recomputed << " moved sources " << incrementalMs << " ms, resum " << resumMs << " ms, "
+                  << LAYERS * tiles.size() << " samples " << std::setprecision(3) << sampleMs << " ms"
+                  << std::setprecision(2) << " (total " << total << ")" << std::endl;
+    }
+    return 0;
+}
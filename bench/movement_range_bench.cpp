@@ -0,0 +1,64 @@
+// Movement-range queries for unit selection, against the 50 us budget per query.
+//
+// Usage: MovementRangeBench
+// For several movement budgets prints the average reachable tile count and time per query on
+// a 1024x1024 map of random terrain, with and without tracing the outline, and the same on
+// open grassland, where the reachable set is largest for a budget.
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+#include "bench.hpp"
+#include "movement_range.hpp"
+
+namespace {
+
+constexpr double TARGET_MICROSECONDS = 50.0;
+
+struct RangeTiming {
+    double microseconds;
+    size_t tiles;
+};
+
+RangeTiming timeQueries(MovementRangeFinder& finder, const HexGrid& grid, float budget, bool outline,
+                        std::mt19937& rng) {
+    const MovementProfile profile = MovementProfile::allTerrain();
+    MovementRange range;
+    // Warm up so the scratch and the range's vectors have grown
+    finder.compute(grid.size() / 2, budget, profile, range);
+
+    const int queries = 20000;
+    size_t tiles = 0;
+    Stopwatch watch;
+    for (int i = 0; i < queries; ++i) {
+        finder.compute(static_cast<int>(rng() % grid.size()), budget, profile, range);
+        if (outline) finder.buildOutline(range, 1.0f);
+        tiles += range.tiles.size();
+    }
+    return {watch.microseconds() / queries, tiles / queries};
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(4);
+    HexGrid mixed = randomGrid(1024, 1024, 2);
+    HexGrid grassland(1024, 1024, TerrainType::Grassland);
+    MovementRangeFinder mixedFinder(mixed);
+    MovementRangeFinder grasslandFinder(grassland);
+    std::cout << std::fixed << std::setprecision(2);
+
+    for (float budget : {2.0f, 4.0f, 6.0f, 10.0f}) {
+        RangeTiming range = timeQueries(mixedFinder, mixed, budget, false, rng);
+        RangeTiming outlined = timeQueries(mixedFinder, mixed, budget, true, rng);
+        RangeTiming open = timeQueries(grasslandFinder, grassland, budget, true, rng);
+        std::cout << "Budget " << std::setprecision(0) << budget << std::setprecision(2) << ": mixed "
+                  << range.tiles << " tiles " << range.microseconds << " us, " << outlined.microseconds
+                  << " us with outline | grassland " << open.tiles << " tiles " << open.microseconds
+                  << " us with outline";
+        if (std::max(outlined.microseconds, open.microseconds) > TARGET_MICROSECONDS) std::cout << " (over target)";
+        std::cout << std::endl;
+    }
+    return 0;
+}
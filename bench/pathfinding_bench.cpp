@@ -0,0 +1,53 @@
+// A* throughput on random terrain at several map sizes.
+//
+// Usage: PathfindingBench
+// For each size prints queries per second and nodes expanded for random start and goal
+// tiles anywhere on the map, then the time for 10k short queries (goal 8 hexes away), the
+// common case of moving a unit.
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "bench.hpp"
+#include "pathfinding.hpp"
+
+int main() {
+    const MovementProfile profile = MovementProfile::allTerrain();
+    std::mt19937 rng(5);
+    std::vector<int> path;
+    std::cout << std::fixed << std::setprecision(1);
+
+    for (int size : {64, 256, 1024}) {
+        HexGrid grid = randomGrid(size, size, 2);
+        HexPathfinder pathfinder(grid);
+
+        // Warm up so the node arrays and the path are already allocated
+        pathfinder.findPath(0, grid.size() - 1, profile, path);
+
+        const int queries = size >= 1024 ? 50 : 1000;
+        uint64_t expanded = 0;
+        Stopwatch watch;
+        for (int i = 0; i < queries; ++i) {
+            int start = static_cast<int>(rng() % grid.size());
+            int goal = static_cast<int>(rng() % grid.size());
+            pathfinder.findPath(start, goal, profile, path);
+            expanded += pathfinder.getLastExpandedCount();
+        }
+        double seconds = watch.seconds();
+        std::cout << size << "x" << size << ": " << queries / seconds << " queries/s, "
+                  << expanded / queries << " nodes expanded per query" << std::endl;
+
+        int local = 0;
+        watch.restart();
+        for (int i = 0; i < 10000; ++i) {
+            int start = static_cast<int>(rng() % grid.size());
+            int goal = grid.indexOf(grid.coordOf(start) + HexCoord(8, -4));
+            if (goal < 0) continue;
+            pathfinder.findPath(start, goal, profile, path);
+            ++local;
+        }
+        std::cout << "  " << local << " queries 8 hexes away: " << watch.milliseconds() << " ms" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+// HexSpatialIndex with 50k entities moving every turn.
+//
+// Usage: SpatialIndexBench
+// Scatters 50k ids over a 512x512 map, then for a number of turns moves every one of them to
+// a random neighbor and prints the average time per turn, followed by the time for a batched
+// radius query around every entity at a few radii.
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "bench.hpp"
+#include "hex_spatial_index.hpp"
+
+int main() {
+    const uint32_t ENTITIES = 50000;
+    const int TURNS = 100;
+    HexGrid grid(512, 512, TerrainType::Ocean);
+    HexSpatialIndex index(grid);
+    index.reserve(ENTITIES);
+    std::mt19937 rng(11);
+    std::vector<int> tiles(ENTITIES);
+    for (uint32_t id = 0; id < ENTITIES; ++id) {
+        tiles[id] = static_cast<int>(rng() % grid.size());
+        index.insert(id, tiles[id]);
+    }
+    std::cout << std::fixed << std::setprecision(2);
+
+    // Pick the moves up front, so the timing is the index's alone
+    std::vector<uint8_t> directions(size_t(ENTITIES) * TURNS);
+    for (uint8_t& direction : directions) direction = static_cast<uint8_t>(rng() % 6);
+
+    double moveMs = 0.0;
+    for (int turn = 0; turn < TURNS; ++turn) {
+        const uint8_t* turnDirections = &directions[size_t(turn) * ENTITIES];
+        Stopwatch watch;
+        for (uint32_t id = 0; id < ENTITIES; ++id) {
+            int next = grid.neighborIndex(tiles[id], turnDirections[id]);
+            if (next < 0) continue;
+            tiles[id] = next;
+            index.move(id, next);
+        }
+        moveMs += watch.milliseconds();
+    }
+    std::cout << ENTITIES << " moves per turn: " << moveMs / TURNS << " ms, "
+              << moveMs / TURNS * 1e6 / ENTITIES << " ns/move" << std::endl;
+
+    std::vector<HexCoord> centers(ENTITIES);
+    for (uint32_t id = 0; id < ENTITIES; ++id) centers[id] = grid.coordOf(tiles[id]);
+    std::vector<uint32_t> ids;
+    std::vector<uint32_t> offsets;
+    for (int radius : {1, 3, 6}) {
+        // Once to grow the result vectors, then timed
+        index.queryRadiusBatch(centers, radius, ids, offsets);
+        Stopwatch watch;
+        index.queryRadiusBatch(centers, radius, ids, offsets);
+        double queryMs = watch.milliseconds();
+        std::cout << "Radius " << radius << " around every entity: " << queryMs << " ms, "
+                  << double(ids.size()) / ENTITIES << " hits each" << std::endl;
+    }
+    return 0;
+}
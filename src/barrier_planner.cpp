@@ -0,0 +1,394 @@
+#include "barrier_planner.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+constexpr VkAccessFlags2 WRITE_ACCESS = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+                                        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_SHADER_WRITE_BIT |
+                                        VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+constexpr VkPipelineStageFlags2 FRAGMENT_TESTS =
+    VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+
+// Whether two barriers differ only in the subresources they cover
+bool sameSync(const VkImageMemoryBarrier2& a, const VkImageMemoryBarrier2& b) {
+    return a.srcStageMask == b.srcStageMask && a.srcAccessMask == b.srcAccessMask && a.dstStageMask == b.dstStageMask &&
+           a.dstAccessMask == b.dstAccessMask && a.oldLayout == b.oldLayout && a.newLayout == b.newLayout;
+}
+
+// Fold another use of the same subresources into a merged one
+void mergeUsage(ImageUsageInfo& into, bool& discard, const ImageUsageInfo& info, bool otherDiscard) {
+    into.stages |= info.stages;
+    into.access |= info.access;
+    into.writes = into.writes || info.writes;
+    discard = discard && otherDiscard;
+}
+
+} // namespace
+
+VkImageAspectFlags aspectFromFormat(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_D16_UNORM:
+    case VK_FORMAT_X8_D24_UNORM_PACK32:
+    case VK_FORMAT_D32_SFLOAT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT;
+    case VK_FORMAT_S8_UINT:
+        return VK_IMAGE_ASPECT_STENCIL_BIT;
+    case VK_FORMAT_D16_UNORM_S8_UINT:
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    default:
+        return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+ImageUsageInfo usageInfo(ImageUsage usage, VkFormat format, bool discard) {
+    bool depth = (aspectFromFormat(format) & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT)) != 0;
+    VkImageLayout sampledLayout =
+        depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    switch (usage) {
+    case ImageUsage::ColorAttachment:
+        return {VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | (discard ? 0 : VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT), true};
+    case ImageUsage::ColorResolve:
+        return {VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, true};
+    case ImageUsage::DepthAttachment:
+        return {VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, FRAGMENT_TESTS,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                    (discard ? 0 : VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT),
+                true};
+    case ImageUsage::DepthReadOnly:
+        return {VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, FRAGMENT_TESTS,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT, false};
+    case ImageUsage::DepthResolve:
+        // Resolves run in the color output stage with color write access, depth included
+        return {VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, true};
+    case ImageUsage::SampledFragment:
+        return {sampledLayout, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, false};
+    case ImageUsage::SampledCompute:
+        return {sampledLayout, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, false};
+    case ImageUsage::StorageCompute:
+        return {VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | (discard ? 0 : VK_ACCESS_2_SHADER_STORAGE_READ_BIT), true};
+    case ImageUsage::TransferSrc:
+        return {VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                VK_ACCESS_2_TRANSFER_READ_BIT, false};
+    case ImageUsage::TransferDst:
+        return {VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                VK_ACCESS_2_TRANSFER_WRITE_BIT, true};
+    case ImageUsage::Present:
+        return {VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, false};
+    }
+    throw std::runtime_error("Unknown image usage");
+}
+
+void BarrierPlanner::reset() {
+    handles.clear();
+    images.clear();
+    states.clear();
+}
+
+ImageHandle BarrierPlanner::registerImage(VkImage image, uint32_t mipLevels, uint32_t arrayLayers) {
+    mipLevels = std::max(mipLevels, 1u);
+    arrayLayers = std::max(arrayLayers, 1u);
+    auto [it, inserted] = handles.try_emplace(image, static_cast<ImageHandle>(images.size()));
+    if (inserted) {
+        images.push_back(TrackedImage{image, mipLevels, arrayLayers, static_cast<uint32_t>(states.size())});
+        states.resize(states.size() + size_t(mipLevels) * arrayLayers);
+        return it->second;
+    }
+
+    TrackedImage& tracked = images[it->second];
+    if (mipLevels <= tracked.mipLevels && arrayLayers <= tracked.arrayLayers) return it->second;
+
+    // Move to a bigger block at the end; the old one stays unused until reset()
+    TrackedImage grown{image, std::max(mipLevels, tracked.mipLevels), std::max(arrayLayers, tracked.arrayLayers),
+                       static_cast<uint32_t>(states.size())};
+    states.resize(states.size() + size_t(grown.mipLevels) * grown.arrayLayers);
+    for (uint32_t mip = 0; mip < grown.mipLevels; ++mip) {
+        for (uint32_t layer = 0; layer < grown.arrayLayers; ++layer) {
+            uint32_t from = tracked.firstState + std::min(mip, tracked.mipLevels - 1) * tracked.arrayLayers +
+                            std::min(layer, tracked.arrayLayers - 1);
+            states[grown.firstState + mip * grown.arrayLayers + layer] = states[from];
+        }
+    }
+    tracked = grown;
+    return it->second;
+}
+
+ImageHandle BarrierPlanner::handleOf(VkImage image) const {
+    auto it = handles.find(image);
+    return it != handles.end() ? it->second : INVALID_IMAGE_HANDLE;
+}
+
+ImageHandle BarrierPlanner::resolve(VkImage image) {
+    auto it = handles.find(image);
+    return it != handles.end() ? it->second : registerImage(image);
+}
+
+BarrierPlanner::ImageState* BarrierPlanner::stateOf(ImageHandle handle, uint32_t mipLevel, uint32_t arrayLayer) {
+    const TrackedImage& tracked = images[handle];
+    return &states[tracked.firstState + mipLevel * tracked.arrayLayers + arrayLayer];
+}
+
+void BarrierPlanner::forget(VkImage image) {
+    ImageHandle handle = handleOf(image);
+    if (handle == INVALID_IMAGE_HANDLE) return;
+    const TrackedImage& tracked = images[handle];
+    std::fill_n(states.begin() + tracked.firstState, size_t(tracked.mipLevels) * tracked.arrayLayers, ImageState{});
+}
+
+void BarrierPlanner::import(VkImage image, VkImageLayout layout, VkPipelineStageFlags2 stages) {
+    import(resolve(image), layout, stages);
+}
+
+void BarrierPlanner::import(ImageHandle handle, VkImageLayout layout, VkPipelineStageFlags2 stages) {
+    ImageState state;
+    state.layout = layout;
+    state.writeStages = stages;
+    const TrackedImage& tracked = images[handle];
+    std::fill_n(states.begin() + tracked.firstState, size_t(tracked.mipLevels) * tracked.arrayLayers, state);
+}
+
+void BarrierPlanner::alias(VkImage image, VkImage previous) {
+    // Everything done to any part of previous has to finish first
+    ImageState before;
+    ImageHandle previousHandle = handleOf(previous);
+    if (previousHandle != INVALID_IMAGE_HANDLE) {
+        const TrackedImage& tracked = images[previousHandle];
+        for (size_t i = 0; i < size_t(tracked.mipLevels) * tracked.arrayLayers; ++i) {
+            const ImageState& state = states[tracked.firstState + i];
+            before.writeStages |= state.writeStages;
+            before.writeAccess |= state.writeAccess;
+            before.readStages |= state.readStages;
+        }
+    }
+
+    const TrackedImage& tracked = images[resolve(image)];
+    for (size_t i = 0; i < size_t(tracked.mipLevels) * tracked.arrayLayers; ++i) {
+        ImageState& state = states[tracked.firstState + i];
+        state.writeStages |= before.writeStages;
+        state.writeAccess |= before.writeAccess;
+        state.readStages |= before.readStages;
+        state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        state.visibleStages = 0;
+        state.visibleAccess = 0;
+    }
+}
+
+VkImageLayout BarrierPlanner::layoutOf(VkImage image, uint32_t mipLevel, uint32_t arrayLayer) const {
+    return layoutOf(handleOf(image), mipLevel, arrayLayer);
+}
+
+VkImageLayout BarrierPlanner::layoutOf(ImageHandle handle, uint32_t mipLevel, uint32_t arrayLayer) const {
+    if (handle == INVALID_IMAGE_HANDLE) return VK_IMAGE_LAYOUT_UNDEFINED;
+    const TrackedImage& tracked = images[handle];
+    mipLevel = std::min(mipLevel, tracked.mipLevels - 1);
+    arrayLayer = std::min(arrayLayer, tracked.arrayLayers - 1);
+    return states[tracked.firstState + mipLevel * tracked.arrayLayers + arrayLayer].layout;
+}
+
+void BarrierPlanner::plan(const ImageAccess* accesses, size_t count, std::vector<VkImageMemoryBarrier2>& out) {
+    // The levels and layers each access reaches, counting a VK_REMAINING_* count as one
+    auto endsOf = [](const ImageAccess& access, uint32_t& mipEnd, uint32_t& layerEnd) {
+        mipEnd = access.baseMipLevel + (access.levelCount == VK_REMAINING_MIP_LEVELS ? 1 : access.levelCount);
+        layerEnd = access.baseArrayLayer + (access.layerCount == VK_REMAINING_ARRAY_LAYERS ? 1 : access.layerCount);
+    };
+
+    // Grow every registration before resolving any use, so a VK_REMAINING_* use ahead of the
+    // access that grows its image still runs to the last level and layer
+    for (size_t i = 0; i < count; ++i) {
+        const ImageAccess& access = accesses[i];
+        if (access.image == VK_NULL_HANDLE) continue;
+        ImageHandle handle = resolve(access.image);
+        uint32_t mipEnd, layerEnd;
+        endsOf(access, mipEnd, layerEnd);
+        if (mipEnd > images[handle].mipLevels || layerEnd > images[handle].arrayLayers) {
+            registerImage(access.image, mipEnd, layerEnd);
+        }
+    }
+
+    // Group overlapping uses of an image so a pass gets at most one barrier per subresource
+    uses.clear();
+    groups.clear();
+    for (size_t i = 0; i < count; ++i) {
+        const ImageAccess& access = accesses[i];
+        if (access.image == VK_NULL_HANDLE) continue;
+        ImageUsageInfo info = usageInfo(access.usage, access.format, access.discard);
+        ImageHandle handle = resolve(access.image);
+
+        RangeUse use{};
+        use.toLastMip = access.levelCount == VK_REMAINING_MIP_LEVELS;
+        use.toLastLayer = access.layerCount == VK_REMAINING_ARRAY_LAYERS;
+        use.mipBegin = access.baseMipLevel;
+        use.layerBegin = access.baseArrayLayer;
+        uint32_t mipEnd, layerEnd;
+        endsOf(access, mipEnd, layerEnd);
+        const TrackedImage& tracked = images[handle];
+        use.mipEnd = use.toLastMip ? tracked.mipLevels : mipEnd;
+        use.layerEnd = use.toLastLayer ? tracked.arrayLayers : layerEnd;
+
+        // Join every group this use overlaps; a use bridging several folds them into the earliest
+        uint32_t target = UINT32_MAX;
+        for (const RangeUse& other : uses) {
+            uint32_t group = other.group;
+            if (group == target || groups[group].handle != handle || !other.overlaps(use)) continue;
+            if (groups[group].info.layout != info.layout) {
+                throw std::runtime_error("Image used in two layouts in one pass (" +
+                                         std::to_string(groups[group].info.layout) + " and " +
+                                         std::to_string(info.layout) + ")");
+            }
+            if (target == UINT32_MAX) {
+                target = group;
+                continue;
+            }
+            uint32_t keep = std::min(target, group);
+            uint32_t drop = std::max(target, group);
+            mergeUsage(groups[keep].info, groups[keep].access.discard, groups[drop].info, groups[drop].access.discard);
+            groups[drop].live = false;
+            for (RangeUse& moved : uses) {
+                if (moved.group == drop) moved.group = keep;
+            }
+            target = keep;
+        }
+        if (target == UINT32_MAX) {
+            target = static_cast<uint32_t>(groups.size());
+            groups.push_back(UseGroup{access, info, handle, true});
+        } else {
+            mergeUsage(groups[target].info, groups[target].access.discard, info, access.discard);
+        }
+        use.group = target;
+        uses.push_back(use);
+    }
+
+    for (uint32_t group = 0; group < groups.size(); ++group) {
+        if (groups[group].live) planGroup(group, out);
+    }
+}
+
+void BarrierPlanner::planGroup(uint32_t group, std::vector<VkImageMemoryBarrier2>& out) {
+    const UseGroup& use = groups[group];
+    const ImageUsageInfo& info = use.info;
+    const TrackedImage& tracked = images[use.handle];
+    size_t first = out.size();
+
+    uint32_t mipBegin = UINT32_MAX, mipEnd = 0, layerBegin = UINT32_MAX, layerEnd = 0;
+    for (const RangeUse& range : uses) {
+        if (range.group != group) continue;
+        mipBegin = std::min(mipBegin, range.mipBegin);
+        mipEnd = std::max(mipEnd, range.mipEnd);
+        layerBegin = std::min(layerBegin, range.layerBegin);
+        layerEnd = std::max(layerEnd, range.layerEnd);
+    }
+    // Whether one of the group's uses contains a subresource, and whether one running to the
+    // last level (or layer) with a VK_REMAINING_* count does
+    auto covered = [&](uint32_t mip, uint32_t layer, bool toLastMip, bool toLastLayer) {
+        for (const RangeUse& range : uses) {
+            if (range.group == group && range.contains(mip, layer) && (!toLastMip || range.toLastMip) &&
+                (!toLastLayer || range.toLastLayer)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    for (uint32_t mip = mipBegin; mip < mipEnd; ++mip) {
+        size_t rowStart = out.size();
+        for (uint32_t layer = layerBegin; layer < layerEnd; ++layer) {
+            if (!covered(mip, layer, false, false)) continue;
+            ImageState& state = *stateOf(use.handle, mip, layer);
+            bool transition = info.layout != state.layout;
+
+            VkImageMemoryBarrier2 barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstStageMask = info.stages;
+            barrier.dstAccessMask = info.access;
+            barrier.oldLayout = state.layout;
+            barrier.newLayout = info.layout;
+            barrier.image = use.access.image;
+            barrier.subresourceRange.aspectMask = aspectFromFormat(use.access.format);
+            barrier.subresourceRange.baseMipLevel = mip;
+            barrier.subresourceRange.levelCount = 1;
+            barrier.subresourceRange.baseArrayLayer = layer;
+            barrier.subresourceRange.layerCount = 1;
+
+            bool needed = false;
+            if (info.writes || transition) {
+                // Wait for the last write and, since this overwrites, for every read after it
+                barrier.srcStageMask = state.writeStages | state.readStages;
+                barrier.srcAccessMask = state.writeAccess;
+                if (info.writes && use.access.discard) barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                needed = transition || barrier.srcStageMask != 0;
+
+                // A layout transition is itself a write that later uses must order after
+                state.writeStages = info.stages;
+                state.writeAccess = info.writes ? (info.access & WRITE_ACCESS) : VK_ACCESS_2_NONE;
+                state.readStages = info.writes ? VK_PIPELINE_STAGE_2_NONE : info.stages;
+                state.visibleStages = info.stages;
+                state.visibleAccess = info.access;
+                state.layout = info.layout;
+            } else {
+                bool visible = (info.stages & ~state.visibleStages) == 0 && (info.access & ~state.visibleAccess) == 0;
+                if (state.writeStages != 0 && !visible) {
+                    barrier.srcStageMask = state.writeStages;
+                    barrier.srcAccessMask = state.writeAccess;
+                    needed = true;
+                    state.visibleStages |= info.stages;
+                    state.visibleAccess |= info.access;
+                }
+                state.readStages |= info.stages;
+            }
+            if (!needed) continue;
+
+            // Extend this level's previous barrier to the next layer when nothing else differs
+            if (out.size() > rowStart) {
+                VkImageMemoryBarrier2& last = out.back();
+                VkImageSubresourceRange& range = last.subresourceRange;
+                if (sameSync(last, barrier) && range.baseArrayLayer + range.layerCount == layer) {
+                    ++range.layerCount;
+                    continue;
+                }
+            }
+            out.push_back(barrier);
+        }
+
+        // Then a level that needed one barrier onto the level before it, if they cover the same layers
+        if (out.size() == rowStart + 1 && rowStart > first) {
+            VkImageMemoryBarrier2& previous = out[rowStart - 1];
+            const VkImageMemoryBarrier2& row = out[rowStart];
+            const VkImageSubresourceRange& a = previous.subresourceRange;
+            const VkImageSubresourceRange& b = row.subresourceRange;
+            if (sameSync(previous, row) && a.baseMipLevel + a.levelCount == mip &&
+                a.baseArrayLayer == b.baseArrayLayer && a.layerCount == b.layerCount) {
+                ++previous.subresourceRange.levelCount;
+                out.pop_back();
+            }
+        }
+    }
+
+    // Barriers running to the last tracked level or layer of VK_REMAINING_* uses keep it, so
+    // they also cover subresources the image has beyond what is tracked
+    for (size_t i = first; i < out.size(); ++i) {
+        VkImageSubresourceRange& range = out[i].subresourceRange;
+        bool toLastMip = range.baseMipLevel + range.levelCount == tracked.mipLevels;
+        for (uint32_t layer = range.baseArrayLayer; toLastMip && layer < range.baseArrayLayer + range.layerCount; ++layer) {
+            toLastMip = covered(tracked.mipLevels - 1, layer, true, false);
+        }
+        bool toLastLayer = range.baseArrayLayer + range.layerCount == tracked.arrayLayers;
+        for (uint32_t mip = range.baseMipLevel; toLastLayer && mip < range.baseMipLevel + range.levelCount; ++mip) {
+            toLastLayer = covered(mip, tracked.arrayLayers - 1, false, true);
+        }
+        if (toLastMip) range.levelCount = VK_REMAINING_MIP_LEVELS;
+        if (toLastLayer) range.layerCount = VK_REMAINING_ARRAY_LAYERS;
+    }
+}
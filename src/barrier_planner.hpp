@@ -0,0 +1,154 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// How a pass uses an image. Each usage implies a layout, pipeline stages and access flags
+// (see usageInfo()).
+enum class ImageUsage : uint8_t {
+    ColorAttachment,  // Rendered to
+    ColorResolve,     // Multisample resolve destination
+    DepthAttachment,  // Depth tested and written
+    DepthReadOnly,    // Depth tested without writes
+    DepthResolve,     // Depth resolve destination
+    SampledFragment,  // Sampled in a fragment shader
+    SampledCompute,   // Sampled in a compute shader
+    StorageCompute,   // Read and written as a storage image in a compute shader
+    TransferSrc,
+    TransferDst,
+    Present,
+};
+
+struct ImageUsageInfo {
+    VkImageLayout layout;
+    VkPipelineStageFlags2 stages;
+    VkAccessFlags2 access;
+    bool writes;
+};
+
+// One image a pass touches. The aspect comes from the format, so a sampled depth buffer gets
+// a depth barrier rather than a color one.
+struct ImageAccess {
+    VkImage image{VK_NULL_HANDLE};
+    VkFormat format{VK_FORMAT_UNDEFINED};
+    ImageUsage usage{ImageUsage::SampledFragment};
+    uint32_t baseMipLevel{0};
+    uint32_t levelCount{VK_REMAINING_MIP_LEVELS};
+    uint32_t baseArrayLayer{0};
+    uint32_t layerCount{VK_REMAINING_ARRAY_LAYERS};
+    bool discard{false}; // Previous contents aren't needed (cleared or fully overwritten)
+};
+
+ImageUsageInfo usageInfo(ImageUsage usage, VkFormat format, bool discard = false);
+VkImageAspectFlags aspectFromFormat(VkFormat format);
+
+// Dense index of an image registered with a BarrierPlanner
+using ImageHandle = uint32_t;
+constexpr ImageHandle INVALID_IMAGE_HANDLE = UINT32_MAX;
+
+// Derives the barriers a sequence of passes needs from what each pass declares it touches.
+//
+// For every mip level and array layer of every image it tracks the current layout, the stages
+// and accesses of the last write, the stages that have read it since, and which stages and
+// accesses that write is already visible to. A pass gets a barrier for a subresource only when
+// it has to:
+//   - a write or layout change waits for the last write (availability) and any reads since
+//     (execution only, write-after-read);
+//   - a read in the same layout waits only if the last write isn't yet visible to it.
+// Neighbouring subresources that need the same barrier share one. Uses of an image in a pass
+// that overlap, directly or through other uses, are merged first and every subresource they
+// cover is planned once; overlapping uses needing different layouts throw std::runtime_error.
+// No Vulkan calls are made, so plans can be checked on machines without a GPU.
+//
+// Images get dense handles when registered, and state lives in flat arrays indexed by them.
+// An image the planner hasn't seen is registered with one level and one layer, which tracks
+// it as a whole: barriers for it keep VK_REMAINING_* counts, so they cover every subresource
+// whatever the image has. Register images with mip chains or layers to track them
+// separately; an access beyond the registered counts registers the image again with more.
+class BarrierPlanner {
+public:
+    // Forget every image (e.g. after the swapchain is recreated). Handles become invalid.
+    void reset();
+
+    // Track image's levels and layers separately. Registering again with more of them keeps the
+    // state of the ones already tracked; the new ones take the state of the nearest tracked
+    // one, which barriers with VK_REMAINING_* counts kept them in step with.
+    ImageHandle registerImage(VkImage image, uint32_t mipLevels = 1, uint32_t arrayLayers = 1);
+    ImageHandle handleOf(VkImage image) const; // INVALID_IMAGE_HANDLE if not registered
+
+    // Its contents are no longer needed: every subresource becomes undefined
+    void forget(VkImage image);
+
+    // Declare the state of an image the graph didn't produce, e.g. a swapchain image after
+    // acquire: its layout and the stages a semaphore wait covers
+    void import(VkImage image, VkImageLayout layout, VkPipelineStageFlags2 stages);
+    void import(ImageHandle handle, VkImageLayout layout, VkPipelineStageFlags2 stages);
+
+    // image is about to reuse memory that previous was using (transient aliasing). Its
+    // contents become undefined and its next use waits for everything previous did.
+    void alias(VkImage image, VkImage previous);
+
+    // Append the barriers needed before a pass with these accesses to out and update the
+    // tracked state as if the pass had run
+    void plan(const ImageAccess* accesses, size_t count, std::vector<VkImageMemoryBarrier2>& out);
+
+    VkImageLayout layoutOf(VkImage image, uint32_t mipLevel = 0, uint32_t arrayLayer = 0) const;
+    VkImageLayout layoutOf(ImageHandle handle, uint32_t mipLevel = 0, uint32_t arrayLayer = 0) const;
+
+private:
+    struct ImageState {
+        VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+        VkPipelineStageFlags2 writeStages{0};
+        VkAccessFlags2 writeAccess{0};
+        VkPipelineStageFlags2 readStages{0};
+        VkPipelineStageFlags2 visibleStages{0};
+        VkAccessFlags2 visibleAccess{0};
+    };
+
+    struct TrackedImage {
+        VkImage image;
+        uint32_t mipLevels;
+        uint32_t arrayLayers;
+        uint32_t firstState; // Into states, arrayLayers per level
+    };
+
+    // One use of a subresource range within a pass, the range resolved against the registered
+    // counts. toLast* remember a VK_REMAINING_* count, which barriers reaching the last tracked
+    // level or layer of it keep.
+    struct RangeUse {
+        uint32_t group; // Into groups
+        uint32_t mipBegin, mipEnd;
+        uint32_t layerBegin, layerEnd;
+        bool toLastMip, toLastLayer;
+
+        bool contains(uint32_t mip, uint32_t layer) const {
+            return mip >= mipBegin && mip < mipEnd && layer >= layerBegin && layer < layerEnd;
+        }
+        bool overlaps(const RangeUse& other) const {
+            return mipBegin < other.mipEnd && other.mipBegin < mipEnd && layerBegin < other.layerEnd &&
+                   other.layerBegin < layerEnd;
+        }
+    };
+
+    // Uses of one image within a pass that overlap, directly or through each other, with their
+    // usage merged. Only the subresources one of its uses contains are planned.
+    struct UseGroup {
+        ImageAccess access; // Image, format and discard
+        ImageUsageInfo info;
+        ImageHandle handle;
+        bool live; // False once merged into an earlier group
+    };
+
+    std::unordered_map<VkImage, ImageHandle> handles; // Consulted once per access, not per subresource
+    std::vector<TrackedImage> images;
+    std::vector<ImageState> states;
+    std::vector<RangeUse> uses;     // Scratch
+    std::vector<UseGroup> groups;   // Scratch
+
+    ImageHandle resolve(VkImage image);
+    ImageState* stateOf(ImageHandle handle, uint32_t mipLevel, uint32_t arrayLayer);
+    void planGroup(uint32_t group, std::vector<VkImageMemoryBarrier2>& out);
+};
@@ -0,0 +1,180 @@
+#include "combat_resolver.hpp"
+
+#include <algorithm>
+
+namespace {
+
+// Per-kind tuning, indexed by EntityKind
+constexpr float FIREPOWER[] = {0.0f, 0.0f, 0.10f, 0.18f, 0.08f, 0.12f, 0.15f};
+
+constexpr float BASE_ACCURACY = 0.8f;
+constexpr float LINE_ACCURACY_BONUS = 0.15f;
+constexpr float LINE_DAMAGE_REDUCTION = 0.10f;
+constexpr float ADMIRAL_AURA = 1.25f;
+constexpr float FRIGATE_VS_PRIVATEER = 1.25f;
+
+constexpr float ARC_CHASER = 1.0f;
+constexpr float ARC_BROADSIDE = 1.3f;
+constexpr float ARC_CROSSING_T = 1.5f;
+
+// Bow or stern when the direction relative to the facing is 0 or 3
+bool endOn(int bearing, int facing) {
+    return (bearing - facing + 6) % 3 == 0;
+}
+
+float arcMultiplier(int bearing, int facing, int targetFacing) {
+    if (endOn(bearing, facing)) return ARC_CHASER;
+    // The line between the ships runs along the target's keel, so the broadside rakes it
+    return endOn(bearing, targetFacing) ? ARC_CROSSING_T : ARC_BROADSIDE;
+}
+
+int bearingTo(const HexCoord& from, const HexCoord& to) {
+    for (int dir = 0; dir < 6; ++dir) {
+        if (hexNeighbor(from, dir) == to) return dir;
+    }
+    return -1;
+}
+
+} // namespace
+
+void EngagementBatch::clear() {
+    attackers.clear();
+    targets.clear();
+    firepower.clear();
+    accuracy.clear();
+    arcMultiplier.clear();
+    damageTaken.clear();
+    damage.clear();
+}
+
+CombatResolver::CombatResolver(uint64_t seed)
+    : key(philoxKey(seed))
+{
+}
+
+float CombatResolver::firepowerOf(EntityKind kind) {
+    return FIREPOWER[static_cast<size_t>(kind)];
+}
+
+bool CombatResolver::hasAdjacentFriendly(const EntityStore& entities, uint32_t dense, EntityKind kind) {
+    uint32_t self = entities.getHandles()[dense].index;
+    uint8_t owner = entities.getOwners()[dense];
+    bool found = false;
+    entities.getSpatialIndex().forEachInRadius(entities.getPositions()[dense], 1, [&](uint32_t index, int) {
+        if (found || index == self) return;
+        uint32_t other = entities.denseIndex(entities.handleAt(index));
+        found = entities.getKinds()[other] == kind && entities.getOwners()[other] == owner;
+    });
+    return found;
+}
+
+float CombatResolver::formationBonus(const EntityStore& entities, uint32_t dense) {
+    if (entities.getKinds()[dense] != EntityKind::ShipOfTheLine ||
+        !hasAdjacentFriendly(entities, dense, EntityKind::ShipOfTheLine)) {
+        return 0.0f;
+    }
+    return hasAdjacentFriendly(entities, dense, EntityKind::Flagship) ? ADMIRAL_AURA : 1.0f;
+}
+
+void CombatResolver::gather(const EntityStore& entities, size_t begin, size_t end, EngagementBatch& out) const {
+    out.clear();
+
+    const auto& handles = entities.getHandles();
+    const auto& kinds = entities.getKinds();
+    const auto& positions = entities.getPositions();
+    const auto& owners = entities.getOwners();
+    const auto& facings = entities.getFacings();
+    const auto& flags = entities.getFlags();
+    const HexSpatialIndex& spatial = entities.getSpatialIndex();
+
+    for (size_t dense = begin; dense < end; ++dense) {
+        EntityKind kind = kinds[dense];
+        float firepower = firepowerOf(kind);
+        if (firepower == 0.0f || (flags[dense] & EntityFlags::MovedLastTurn)) continue; // Reloading
+
+        // Best arc among adjacent enemy ships, ties to the lowest handle index so the choice
+        // ignores list order. Cities have no arcs.
+        bool city = kind == EntityKind::City;
+        uint32_t target = EntityHandle::INVALID_INDEX;
+        uint32_t targetDense = 0;
+        float bestArc = 0.0f;
+        spatial.forEachInRadius(positions[dense], 1, [&](uint32_t index, int) {
+            uint32_t other = entities.denseIndex(entities.handleAt(index));
+            if (owners[other] == owners[dense] || kinds[other] == EntityKind::City) return;
+            float arc = ARC_CHASER;
+            if (!city) {
+                int bearing = bearingTo(positions[dense], positions[other]);
+                if (bearing < 0) return; // Same tile; no line of fire
+                arc = arcMultiplier(bearing, facings[dense], facings[other]);
+            }
+            if (arc > bestArc || (arc == bestArc && index < target)) {
+                target = index;
+                targetDense = other;
+                bestArc = arc;
+            }
+        });
+        if (target == EntityHandle::INVALID_INDEX) continue;
+
+        if (kind == EntityKind::Frigate && kinds[targetDense] == EntityKind::Privateer) {
+            firepower *= FRIGATE_VS_PRIVATEER;
+        }
+        out.attackers.push_back(handles[dense].index);
+        out.targets.push_back(target);
+        out.firepower.push_back(firepower);
+        out.accuracy.push_back(BASE_ACCURACY + LINE_ACCURACY_BONUS * formationBonus(entities, static_cast<uint32_t>(dense)));
+        out.arcMultiplier.push_back(bestArc);
+        out.damageTaken.push_back(1.0f - LINE_DAMAGE_REDUCTION * formationBonus(entities, targetDense));
+    }
+}
+
+void CombatResolver::merge(const std::vector<EngagementBatch>& chunks, EngagementBatch& out) {
+    staging.clear();
+    auto append = [](auto& to, const auto& from) { to.insert(to.end(), from.begin(), from.end()); };
+    for (const EngagementBatch& chunk : chunks) {
+        append(staging.attackers, chunk.attackers);
+        append(staging.targets, chunk.targets);
+        append(staging.firepower, chunk.firepower);
+        append(staging.accuracy, chunk.accuracy);
+        append(staging.arcMultiplier, chunk.arcMultiplier);
+        append(staging.damageTaken, chunk.damageTaken);
+    }
+
+    // Each ship fires at most once per turn, so (target, attacker) is a unique key
+    size_t count = staging.size();
+    order.resize(count);
+    for (size_t i = 0; i < count; ++i) order[i] = static_cast<uint32_t>(i);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        if (staging.targets[a] != staging.targets[b]) return staging.targets[a] < staging.targets[b];
+        return staging.attackers[a] < staging.attackers[b];
+    });
+
+    auto permute = [&](auto& to, const auto& from) {
+        to.resize(count);
+        for (size_t i = 0; i < count; ++i) to[i] = from[order[i]];
+    };
+    permute(out.attackers, staging.attackers);
+    permute(out.targets, staging.targets);
+    permute(out.firepower, staging.firepower);
+    permute(out.accuracy, staging.accuracy);
+    permute(out.arcMultiplier, staging.arcMultiplier);
+    permute(out.damageTaken, staging.damageTaken);
+    out.damage.assign(count, 0.0f);
+}
+
+void CombatResolver::resolve(EngagementBatch& batch, uint32_t turn, size_t begin, size_t end) const {
+    end = std::min(end, batch.size());
+    for (size_t i = begin; i < end; ++i) {
+        PhiloxCounter bits = philox4x32({turn, batch.attackers[i], batch.targets[i], 0}, key);
+        bool hit = philoxUnitFloat(bits[0]) < batch.accuracy[i];
+        float spread = 0.8f + 0.4f * philoxUnitFloat(bits[1]);
+        batch.damage[i] = hit ? batch.firepower[i] * batch.arcMultiplier[i] * batch.damageTaken[i] * spread : 0.0f;
+    }
+}
+
+void CombatResolver::apply(const EngagementBatch& batch, EntityStore& entities) const {
+    auto& health = entities.getHealth();
+    for (size_t i = 0; i < batch.size(); ++i) {
+        uint32_t dense = entities.denseIndex(entities.handleAt(batch.targets[i]));
+        if (dense != EntityHandle::INVALID_INDEX) health[dense] -= batch.damage[i];
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "entity_store.hpp"
+#include "philox.hpp"
+
+// One turn's engagements as parallel arrays. Everything the dice roll needs is gathered up
+// front, so resolving an engagement reads only its own slot.
+struct EngagementBatch {
+    std::vector<uint32_t> attackers;     // Handle indices
+    std::vector<uint32_t> targets;       // Handle indices
+    std::vector<float> firepower;        // Base damage including class matchups
+    std::vector<float> accuracy;         // Hit chance
+    std::vector<float> arcMultiplier;    // 1.0 bow/stern, 1.3 broadside, 1.5 crossing the T
+    std::vector<float> damageTaken;      // Target's defensive modifier
+    std::vector<float> damage;           // Output of resolve()
+
+    size_t size() const { return attackers.size(); }
+    void clear();
+};
+
+// Broadside combat from design/combat.md.
+//
+// A ship that moved last turn is reloading and can't fire. Otherwise it fires at the
+// adjacent enemy ship it has the best arc on: bow and stern chasers at 1.0x, a broadside at
+// 1.3x, and 1.5x when that broadside rakes the target's bow or stern (crossing the T).
+// Ships of the Line next to another friendly Ship of the Line form a line of battle (+15%
+// accuracy, -10% damage taken) and an adjacent friendly Flagship amplifies that by 25%.
+// Frigates hit Privateers 25% harder. Cities fire at adjacent enemy ships without arcs.
+//
+// gather() scans a dense range into its own batch, merge() joins the chunk batches and
+// sorts them by (target, attacker), resolve() rolls any slice of the batch, and apply()
+// subtracts the damage in batch order. Rolls come from Philox keyed by the seed with
+// counter (turn, attacker, target), and the sort fixes the order damage is summed in, so
+// the outcome depends neither on thread count nor on the order engagements were found.
+class CombatResolver {
+public:
+    explicit CombatResolver(uint64_t seed);
+
+    // Base damage per shot as a fraction of full health; 0 for unarmed kinds
+    static float firepowerOf(EntityKind kind);
+
+    void gather(const EntityStore& entities, size_t begin, size_t end, EngagementBatch& out) const;
+    void merge(const std::vector<EngagementBatch>& chunks, EngagementBatch& out);
+    void resolve(EngagementBatch& batch, uint32_t turn, size_t begin, size_t end) const;
+    void apply(const EngagementBatch& batch, EntityStore& entities) const;
+
+private:
+    PhiloxKey key;
+    // Merge scratch
+    EngagementBatch staging;
+    std::vector<uint32_t> order;
+
+    // Whether a friendly entity of kind other than the entity itself is adjacent
+    static bool hasAdjacentFriendly(const EntityStore& entities, uint32_t dense, EntityKind kind);
+    // Line of Battle strength: 0 alone, 1 in line, 1.25 in line next to a flagship
+    static float formationBonus(const EntityStore& entities, uint32_t dense);
+};
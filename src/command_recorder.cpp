@@ -0,0 +1,91 @@
+#include "command_recorder.hpp"
+
+void VulkanCommandRecorder::pipelineBarrier(VkCommandBuffer cmd, const VkDependencyInfo& dependency) {
+    vkCmdPipelineBarrier2(cmd, &dependency);
+}
+
+void VulkanCommandRecorder::beginRendering(VkCommandBuffer cmd, const VkRenderingInfo& rendering) {
+    vkCmdBeginRendering(cmd, &rendering);
+}
+
+void VulkanCommandRecorder::endRendering(VkCommandBuffer cmd) {
+    vkCmdEndRendering(cmd);
+}
+
+void VulkanCommandRecorder::executeCommands(VkCommandBuffer cmd, uint32_t count, const VkCommandBuffer* secondaries) {
+    vkCmdExecuteCommands(cmd, count, secondaries);
+}
+
+void VulkanCommandRecorder::resetQueries(VkCommandBuffer cmd, VkQueryPool pool, uint32_t first, uint32_t count) {
+    vkCmdResetQueryPool(cmd, pool, first, count);
+}
+
+void VulkanCommandRecorder::writeTimestamp(VkCommandBuffer cmd, VkPipelineStageFlags2 stage, VkQueryPool pool, uint32_t query) {
+    vkCmdWriteTimestamp2(cmd, stage, pool, query);
+}
+
+VulkanCommandRecorder& vulkanCommandRecorder() {
+    static VulkanCommandRecorder recorder;
+    return recorder;
+}
+
+void RecordingCommandRecorder::pipelineBarrier(VkCommandBuffer cmd, const VkDependencyInfo& dependency) {
+    RecordedCommand command{RecordedCommand::Type::Barrier, cmd};
+    command.first = static_cast<uint32_t>(barriers.size());
+    command.count = dependency.imageMemoryBarrierCount;
+    barriers.insert(barriers.end(), dependency.pImageMemoryBarriers,
+                    dependency.pImageMemoryBarriers + dependency.imageMemoryBarrierCount);
+    commands.push_back(command);
+}
+
+void RecordingCommandRecorder::beginRendering(VkCommandBuffer cmd, const VkRenderingInfo& rendering) {
+    RecordedRendering recorded{};
+    recorded.info = rendering;
+    recorded.info.pColorAttachments = nullptr;
+    recorded.info.pDepthAttachment = nullptr;
+    recorded.info.pStencilAttachment = nullptr;
+    recorded.hasColor = rendering.colorAttachmentCount > 0;
+    recorded.hasDepth = rendering.pDepthAttachment != nullptr;
+    if (recorded.hasColor) recorded.color = rendering.pColorAttachments[0];
+    if (recorded.hasDepth) recorded.depth = *rendering.pDepthAttachment;
+
+    RecordedCommand command{RecordedCommand::Type::BeginRendering, cmd};
+    command.first = static_cast<uint32_t>(renderings.size());
+    command.count = 1;
+    renderings.push_back(recorded);
+    commands.push_back(command);
+}
+
+void RecordingCommandRecorder::endRendering(VkCommandBuffer cmd) {
+    commands.push_back(RecordedCommand{RecordedCommand::Type::EndRendering, cmd});
+}
+
+void RecordingCommandRecorder::executeCommands(VkCommandBuffer cmd, uint32_t count, const VkCommandBuffer* buffers) {
+    RecordedCommand command{RecordedCommand::Type::ExecuteCommands, cmd};
+    command.first = static_cast<uint32_t>(secondaries.size());
+    command.count = count;
+    secondaries.insert(secondaries.end(), buffers, buffers + count);
+    commands.push_back(command);
+}
+
+void RecordingCommandRecorder::resetQueries(VkCommandBuffer cmd, VkQueryPool, uint32_t first, uint32_t count) {
+    RecordedCommand command{RecordedCommand::Type::ResetQueries, cmd};
+    command.first = first;
+    command.count = count;
+    commands.push_back(command);
+}
+
+void RecordingCommandRecorder::writeTimestamp(VkCommandBuffer cmd, VkPipelineStageFlags2 stage, VkQueryPool, uint32_t query) {
+    RecordedCommand command{RecordedCommand::Type::WriteTimestamp, cmd};
+    command.first = query;
+    command.count = 1;
+    command.stage = stage;
+    commands.push_back(command);
+}
+
+void RecordingCommandRecorder::clear() {
+    commands.clear();
+    barriers.clear();
+    renderings.clear();
+    secondaries.clear();
+}
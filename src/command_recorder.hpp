@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+
+// The commands the render graph records into command buffers. The graph calls these instead
+// of vkCmd* directly, so its barriers and rendering scopes can be captured as data and the
+// graph run without a device.
+class CommandRecorder {
+public:
+    virtual ~CommandRecorder() = default;
+
+    virtual void pipelineBarrier(VkCommandBuffer cmd, const VkDependencyInfo& dependency) = 0;
+    virtual void beginRendering(VkCommandBuffer cmd, const VkRenderingInfo& rendering) = 0;
+    virtual void endRendering(VkCommandBuffer cmd) = 0;
+    virtual void executeCommands(VkCommandBuffer cmd, uint32_t count, const VkCommandBuffer* secondaries) = 0;
+    virtual void resetQueries(VkCommandBuffer cmd, VkQueryPool pool, uint32_t first, uint32_t count) = 0;
+    virtual void writeTimestamp(VkCommandBuffer cmd, VkPipelineStageFlags2 stage, VkQueryPool pool, uint32_t query) = 0;
+};
+
+// Records into real command buffers
+class VulkanCommandRecorder final : public CommandRecorder {
+public:
+    void pipelineBarrier(VkCommandBuffer cmd, const VkDependencyInfo& dependency) override;
+    void beginRendering(VkCommandBuffer cmd, const VkRenderingInfo& rendering) override;
+    void endRendering(VkCommandBuffer cmd) override;
+    void executeCommands(VkCommandBuffer cmd, uint32_t count, const VkCommandBuffer* secondaries) override;
+    void resetQueries(VkCommandBuffer cmd, VkQueryPool pool, uint32_t first, uint32_t count) override;
+    void writeTimestamp(VkCommandBuffer cmd, VkPipelineStageFlags2 stage, VkQueryPool pool, uint32_t query) override;
+};
+
+// Shared by every render graph unless it's given a recorder of its own
+VulkanCommandRecorder& vulkanCommandRecorder();
+
+// A rendering scope as it was begun. The attachment pointers in info are cleared; the
+// attachments are copied into color and depth instead.
+struct RecordedRendering {
+    VkRenderingInfo info;
+    VkRenderingAttachmentInfo color;
+    VkRenderingAttachmentInfo depth;
+    bool hasColor;
+    bool hasDepth;
+};
+
+struct RecordedCommand {
+    enum class Type : uint8_t {
+        Barrier,         // first/count index RecordingCommandRecorder::barriers
+        BeginRendering,  // first indexes renderings
+        EndRendering,
+        ExecuteCommands, // first/count index secondaries
+        ResetQueries,    // first/count are the queries
+        WriteTimestamp,  // first is the query, stage the stage
+    };
+    Type type;
+    VkCommandBuffer cmd;
+    uint32_t first{0};
+    uint32_t count{0};
+    VkPipelineStageFlags2 stage{0};
+};
+
+// Captures what is recorded instead of recording it, so the graph's compilation, layout
+// tracking and aliasing barriers can be checked or timed without a GPU. Any non-null handle
+// works as a command buffer; the commands aren't validated.
+class RecordingCommandRecorder final : public CommandRecorder {
+public:
+    std::vector<RecordedCommand> commands; // In the order they were recorded, over all buffers
+    std::vector<VkImageMemoryBarrier2> barriers;
+    std::vector<RecordedRendering> renderings;
+    std::vector<VkCommandBuffer> secondaries;
+
+    void pipelineBarrier(VkCommandBuffer cmd, const VkDependencyInfo& dependency) override;
+    void beginRendering(VkCommandBuffer cmd, const VkRenderingInfo& rendering) override;
+    void endRendering(VkCommandBuffer cmd) override;
+    void executeCommands(VkCommandBuffer cmd, uint32_t count, const VkCommandBuffer* secondaries) override;
+    void resetQueries(VkCommandBuffer cmd, VkQueryPool pool, uint32_t first, uint32_t count) override;
+    void writeTimestamp(VkCommandBuffer cmd, VkPipelineStageFlags2 stage, VkQueryPool pool, uint32_t query) override;
+
+    // Forget what was captured, keeping the storage for the next frame
+    void clear();
+};
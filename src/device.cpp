@@ -81,6 +81,22 @@ void initDevice(Device& device) {
         throw std::runtime_error("failed to find a suitable queue family!");
     }
 
+    // Find a queue for async compute, preferring a compute-only family (the hardware's
+    // dedicated compute queues) over a second queue of the graphics family
+    uint32_t computeFamilyIndex = UINT32_MAX;
+    uint32_t computeQueueIndex = 0;
+    for (uint32_t i = 0; i < queueFamilyCount; i++) {
+        if (queueFamilies[i].queueCount > 0 && (queueFamilies[i].queueFlags & VK_QUEUE_COMPUTE_BIT) &&
+            !(queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+            computeFamilyIndex = i;
+            break;
+        }
+    }
+    if (computeFamilyIndex == UINT32_MAX && queueFamilies[queueFamilyIndex].queueCount > 1) {
+        computeFamilyIndex = queueFamilyIndex;
+        computeQueueIndex = 1;
+    }
+
     // Check timeline semaphore support
     VkPhysicalDeviceVulkan12Features supportedVulkan12Features{};
     supportedVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
@@ -93,12 +109,19 @@ void initDevice(Device& device) {
     }
 
     // Create logical device
-    float                   queuePriority = 1.0f;
-    VkDeviceQueueCreateInfo queueCreateInfo{};
+    float                                queuePriorities[2] = {1.0f, 1.0f};
+    std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+    VkDeviceQueueCreateInfo              queueCreateInfo{};
     queueCreateInfo.sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
     queueCreateInfo.queueFamilyIndex = queueFamilyIndex;
-    queueCreateInfo.queueCount       = 1;
-    queueCreateInfo.pQueuePriorities = &queuePriority;
+    queueCreateInfo.queueCount       = computeQueueIndex + 1;
+    queueCreateInfo.pQueuePriorities = queuePriorities;
+    queueCreateInfos.push_back(queueCreateInfo);
+    if (computeFamilyIndex != UINT32_MAX && computeFamilyIndex != queueFamilyIndex) {
+        queueCreateInfo.queueFamilyIndex = computeFamilyIndex;
+        queueCreateInfo.queueCount       = 1;
+        queueCreateInfos.push_back(queueCreateInfo);
+    }
 
     VkDeviceCreateInfo       createInfo{};
     VkPhysicalDeviceFeatures deviceFeatures{};
@@ -122,8 +145,8 @@ void initDevice(Device& device) {
     createInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     createInfo.pNext                   = &vulkan12Features;
     createInfo.pEnabledFeatures        = &deviceFeatures;
-    createInfo.pQueueCreateInfos       = &queueCreateInfo;
-    createInfo.queueCreateInfoCount    = 1;
+    createInfo.pQueueCreateInfos       = queueCreateInfos.data();
+    createInfo.queueCreateInfoCount    = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.enabledExtensionCount   = static_cast<uint32_t>(deviceExtensions.size());
     createInfo.ppEnabledExtensionNames = deviceExtensions.data();
     createInfo.enabledLayerCount       = 0;
@@ -133,9 +156,18 @@ void initDevice(Device& device) {
         throw std::runtime_error("failed to create logical device!");
     }
 
-    // Get the queue
+    // Get the queues
     vkGetDeviceQueue(device.device, queueFamilyIndex, 0, &device.queue);
+    device.queueFamilyIndex = queueFamilyIndex;
+    if (computeFamilyIndex != UINT32_MAX) {
+        vkGetDeviceQueue(device.device, computeFamilyIndex, computeQueueIndex, &device.computeQueue);
+        device.computeQueueFamilyIndex = computeFamilyIndex;
+    }
     std::cout << "Device and queue created successfully." << std::endl;
+    if (device.computeQueue != VK_NULL_HANDLE) {
+        std::cout << "Async compute queue: family " << computeFamilyIndex << ", index " << computeQueueIndex
+                  << std::endl;
+    }
 }
 
 void initVma(Device& device) {
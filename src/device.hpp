@@ -8,8 +8,14 @@ struct Device {
 	VkPhysicalDevice physicalDevice;
 	VkDevice device;
 	VkQueue queue;
+	uint32_t queueFamilyIndex;
 	VkSemaphore timelineSemaphore;
 
+	// Second queue for async compute: from a compute-only family if there is one, else a
+	// second queue of queue's family. Null when the device has neither.
+	VkQueue computeQueue = VK_NULL_HANDLE;
+	uint32_t computeQueueFamilyIndex = UINT32_MAX;
+
 	VmaAllocator allocator;
 };
 
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Axis-aligned texel rectangle (x, y = top-left corner)
+struct DirtyRect {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+
+    uint32_t right() const { return x + width; }
+    uint32_t bottom() const { return y + height; }
+    uint64_t area() const { return static_cast<uint64_t>(width) * height; }
+
+    bool operator==(const DirtyRect& other) const {
+        return x == other.x && y == other.y && width == other.width && height == other.height;
+    }
+};
+
+// Smallest rectangle covering both inputs
+inline DirtyRect dirtyRectUnion(const DirtyRect& a, const DirtyRect& b) {
+    uint32_t x0 = std::min(a.x, b.x);
+    uint32_t y0 = std::min(a.y, b.y);
+    uint32_t x1 = std::max(a.right(), b.right());
+    uint32_t y1 = std::max(a.bottom(), b.bottom());
+    return {x0, y0, x1 - x0, y1 - y0};
+}
+
+// Accumulates dirty texels of a 2D texture and coalesces them into a short list of
+// rectangles, so a partial update becomes a handful of vkCmdCopyBufferToImage regions
+// instead of one region per texel (or a full re-upload).
+//
+// Two rectangles are merged when their bounding box wastes at most `mergeSlack` texels
+// compared to uploading them separately; rects sharing a whole edge, or contained in one
+// another, always merge.
+// When the list grows past `maxRects`, the pair with the least waste is merged.
+class DirtyRectSet {
+public:
+    explicit DirtyRectSet(uint32_t maxRects = 16, uint32_t mergeSlack = 16)
+        : maxRects(std::max(maxRects, 1u))
+        , mergeSlack(mergeSlack)
+    {}
+
+    void markTexel(uint32_t x, uint32_t y) {
+        markRect({x, y, 1, 1});
+    }
+
+    void markRect(const DirtyRect& rect) {
+        if (rect.width == 0 || rect.height == 0) return;
+
+        DirtyRect pending = rect;
+        // Absorb every rect that merges cheaply; the grown rect may now reach others
+        bool merged = true;
+        while (merged) {
+            merged = false;
+            for (size_t i = 0; i < rects.size(); ++i) {
+                if (mergeWaste(rects[i], pending) <= mergeSlack) {
+                    pending = dirtyRectUnion(rects[i], pending);
+                    rects[i] = rects.back();
+                    rects.pop_back();
+                    merged = true;
+                    break;
+                }
+            }
+        }
+        rects.push_back(pending);
+
+        while (rects.size() > maxRects) {
+            mergeCheapestPair();
+        }
+    }
+
+    void clear() { rects.clear(); }
+    bool empty() const { return rects.empty(); }
+
+    // Current coalesced rectangles. They may overlap when merging would waste more than the
+    // slack; copying the overlap twice is harmless.
+    const std::vector<DirtyRect>& getRects() const { return rects; }
+
+    // Total texels covered by the rect list (what an upload will copy)
+    uint64_t texelCount() const {
+        uint64_t total = 0;
+        for (const auto& r : rects) total += r.area();
+        return total;
+    }
+
+private:
+    std::vector<DirtyRect> rects;
+    uint32_t maxRects;
+    uint32_t mergeSlack;
+
+    // Extra texels uploaded by replacing a and b with their bounding box
+    static uint64_t mergeWaste(const DirtyRect& a, const DirtyRect& b) {
+        uint64_t unionArea = dirtyRectUnion(a, b).area();
+        uint64_t separate = a.area() + b.area();
+        return unionArea > separate ? unionArea - separate : 0;
+    }
+
+    void mergeCheapestPair() {
+        size_t bestA = 0;
+        size_t bestB = 1;
+        uint64_t bestWaste = UINT64_MAX;
+        for (size_t i = 0; i < rects.size(); ++i) {
+            for (size_t j = i + 1; j < rects.size(); ++j) {
+                uint64_t waste = mergeWaste(rects[i], rects[j]);
+                if (waste < bestWaste) {
+                    bestWaste = waste;
+                    bestA = i;
+                    bestB = j;
+                }
+            }
+        }
+        rects[bestA] = dirtyRectUnion(rects[bestA], rects[bestB]);
+        rects[bestB] = rects.back();
+        rects.pop_back();
+    }
+};
@@ -0,0 +1,183 @@
+#include "entity_store.hpp"
+#include "snapshot.hpp"
+
+#include <stdexcept>
+
+EntityStore::EntityStore(const HexGrid& grid, int chunkSize)
+    : grid(grid)
+    , spatial(grid, chunkSize)
+{
+}
+
+void EntityStore::reserve(size_t count) {
+    sparse.reserve(count);
+    generations.reserve(count);
+    handles.reserve(count);
+    kinds.reserve(count);
+    tiles.reserve(count);
+    positions.reserve(count);
+    owners.reserve(count);
+    facings.reserve(count);
+    flags.reserve(count);
+    health.reserve(count);
+    spatial.reserve(count);
+}
+
+void EntityStore::clear() {
+    // Every handed-out handle goes stale, so bump the generations rather than resetting them
+    freeIndices.clear();
+    for (uint32_t index = 0; index < sparse.size(); ++index) {
+        if (sparse[index] != EntityHandle::INVALID_INDEX) {
+            sparse[index] = EntityHandle::INVALID_INDEX;
+            ++generations[index];
+        }
+        freeIndices.push_back(index);
+    }
+
+    handles.clear();
+    kinds.clear();
+    tiles.clear();
+    positions.clear();
+    owners.clear();
+    facings.clear();
+    flags.clear();
+    health.clear();
+    spatial.clear();
+}
+
+void EntityStore::save(Snapshot& snapshot) const {
+    snapshot.put(SnapshotSection::EntitySparse, sparse);
+    snapshot.put(SnapshotSection::EntityGenerations, generations);
+    snapshot.put(SnapshotSection::EntityFreeIndices, freeIndices);
+    snapshot.put(SnapshotSection::EntityHandles, handles);
+    snapshot.put(SnapshotSection::EntityKinds, kinds);
+    snapshot.put(SnapshotSection::EntityTiles, tiles);
+    snapshot.put(SnapshotSection::EntityOwners, owners);
+    snapshot.put(SnapshotSection::EntityFacings, facings);
+    snapshot.put(SnapshotSection::EntityFlags, flags);
+    snapshot.put(SnapshotSection::EntityHealth, health);
+}
+
+void EntityStore::load(const Snapshot& snapshot) {
+    snapshot.read(SnapshotSection::EntitySparse, sparse);
+    snapshot.read(SnapshotSection::EntityGenerations, generations);
+    snapshot.read(SnapshotSection::EntityFreeIndices, freeIndices);
+    snapshot.read(SnapshotSection::EntityHandles, handles);
+    snapshot.read(SnapshotSection::EntityKinds, kinds);
+    snapshot.read(SnapshotSection::EntityTiles, tiles);
+    snapshot.read(SnapshotSection::EntityOwners, owners);
+    snapshot.read(SnapshotSection::EntityFacings, facings);
+    snapshot.read(SnapshotSection::EntityFlags, flags);
+    snapshot.read(SnapshotSection::EntityHealth, health);
+
+    // Every index is either live, with its handle's generation, or free exactly once
+    size_t count = handles.size();
+    bool consistent = sparse.size() == generations.size() && count + freeIndices.size() == sparse.size() &&
+                      kinds.size() == count && tiles.size() == count && owners.size() == count &&
+                      facings.size() == count && flags.size() == count && health.size() == count;
+    for (size_t dense = 0; consistent && dense < count; ++dense) {
+        uint32_t index = handles[dense].index;
+        consistent = index < sparse.size() && sparse[index] == dense &&
+                     handles[dense].generation == generations[index] && kinds[dense] < EntityKind::Count &&
+                     tiles[dense] >= 0 && tiles[dense] < grid.size();
+    }
+    std::vector<bool> freed(consistent ? sparse.size() : 0);
+    for (size_t i = 0; consistent && i < freeIndices.size(); ++i) {
+        uint32_t index = freeIndices[i];
+        consistent = index < sparse.size() && sparse[index] == EntityHandle::INVALID_INDEX && !freed[index];
+        if (consistent) freed[index] = true;
+    }
+    if (!consistent) {
+        throw std::runtime_error("Snapshot entity store is inconsistent");
+    }
+
+    // Positions and the spatial index are derived from the tiles
+    positions.resize(count);
+    spatial.clear();
+    spatial.reserve(sparse.size());
+    for (size_t dense = 0; dense < count; ++dense) {
+        positions[dense] = grid.coordOf(tiles[dense]);
+        spatial.insert(handles[dense].index, tiles[dense]);
+    }
+}
+
+EntityHandle EntityStore::spawn(EntityKind kind, int tile, uint8_t owner, uint8_t facing) {
+    if (tile < 0 || tile >= grid.size()) return EntityHandle{};
+
+    uint32_t index;
+    if (!freeIndices.empty()) {
+        index = freeIndices.back();
+        freeIndices.pop_back();
+    } else {
+        index = static_cast<uint32_t>(sparse.size());
+        sparse.push_back(EntityHandle::INVALID_INDEX);
+        generations.push_back(0);
+    }
+
+    uint32_t dense = static_cast<uint32_t>(handles.size());
+    EntityHandle handle{index, generations[index]};
+    sparse[index] = dense;
+
+    handles.push_back(handle);
+    kinds.push_back(kind);
+    tiles.push_back(tile);
+    positions.push_back(grid.coordOf(tile));
+    owners.push_back(owner);
+    facings.push_back(facing);
+    flags.push_back(0);
+    health.push_back(1.0f);
+    spatial.insert(index, tile);
+    return handle;
+}
+
+bool EntityStore::despawn(EntityHandle handle) {
+    uint32_t dense = denseIndex(handle);
+    if (dense == EntityHandle::INVALID_INDEX) return false;
+
+    spatial.remove(handle.index);
+
+    // Move the last entity into the hole and point its sparse slot at the new position
+    uint32_t last = static_cast<uint32_t>(handles.size()) - 1;
+    if (dense != last) {
+        handles[dense] = handles[last];
+        kinds[dense] = kinds[last];
+        tiles[dense] = tiles[last];
+        positions[dense] = positions[last];
+        owners[dense] = owners[last];
+        facings[dense] = facings[last];
+        flags[dense] = flags[last];
+        health[dense] = health[last];
+        sparse[handles[dense].index] = dense;
+    }
+
+    handles.pop_back();
+    kinds.pop_back();
+    tiles.pop_back();
+    positions.pop_back();
+    owners.pop_back();
+    facings.pop_back();
+    flags.pop_back();
+    health.pop_back();
+
+    sparse[handle.index] = EntityHandle::INVALID_INDEX;
+    ++generations[handle.index];
+    freeIndices.push_back(handle.index);
+    return true;
+}
+
+bool EntityStore::move(EntityHandle handle, int tile) {
+    uint32_t dense = denseIndex(handle);
+    if (dense == EntityHandle::INVALID_INDEX || tile < 0 || tile >= grid.size()) return false;
+    moveDense(dense, tile);
+    return true;
+}
+
+void EntityStore::moveDense(uint32_t dense, int tile) {
+    tiles[dense] = tile;
+    positions[dense] = grid.coordOf(tile);
+    spatial.move(handles[dense].index, tile);
+}
+
+void EntityStore::queryRadius(const HexCoord& center, int radius, std::vector<EntityHandle>& out) const {
+    spatial.forEachInRadius(center, radius, [&](uint32_t index, int) { out.push_back(handleAt(index)); });
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "hex_coord.hpp"
+#include "hex_grid.hpp"
+#include "hex_spatial_index.hpp"
+#include "parallel_for.hpp"
+
+class Snapshot;
+
+// Stable reference to an entity. The generation changes every time a slot is reused, so a
+// handle to a despawned entity never aliases its replacement.
+struct EntityHandle {
+    static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+
+    bool isValid() const { return index != INVALID_INDEX; }
+    bool operator==(const EntityHandle& other) const = default;
+};
+
+enum class EntityKind : uint8_t {
+    Caravel,
+    Galleon,
+    Frigate,
+    ShipOfTheLine,
+    Privateer,
+    Flagship,
+    City,
+    Count
+};
+
+// Bits of EntityStore::getFlags()
+struct EntityFlags {
+    static constexpr uint8_t MovedLastTurn = 1 << 0; // Cannons reloading (design/combat.md)
+    static constexpr uint8_t Stealthed = 1 << 1;     // Privateer not yet revealed
+};
+
+// Structure-of-arrays storage for ships, convoys and cities.
+//
+// Each component lives in its own dense array, all indexed by the same dense index, so a
+// system touching only positions and flags streams just those arrays. Despawning swaps the
+// last entity into the hole to keep the arrays packed; handles map to dense indices through
+// a sparse table. Dense indices are therefore only stable until the next despawn.
+//
+// Entities are also kept in a HexSpatialIndex keyed by handle index, for radius queries.
+class EntityStore {
+public:
+    explicit EntityStore(const HexGrid& grid, int chunkSize = 8);
+
+    void reserve(size_t count);
+    void clear();
+
+    // Copy every component and the handle tables into snapshot sections, or replace the
+    // whole store with them; load() throws std::runtime_error if they are inconsistent
+    void save(Snapshot& snapshot) const;
+    void load(const Snapshot& snapshot);
+
+    // Returns an invalid handle when tile is outside the grid
+    EntityHandle spawn(EntityKind kind, int tile, uint8_t owner = 0, uint8_t facing = 0);
+    bool despawn(EntityHandle handle);
+
+    bool isAlive(EntityHandle handle) const {
+        return handle.index < generations.size() && generations[handle.index] == handle.generation &&
+               sparse[handle.index] != EntityHandle::INVALID_INDEX;
+    }
+    size_t size() const { return handles.size(); }
+
+    // Every handle index handed out so far is below this; sizes per-index side tables
+    size_t getIndexCount() const { return generations.size(); }
+
+    // Dense index of a live entity, or EntityHandle::INVALID_INDEX
+    uint32_t denseIndex(EntityHandle handle) const {
+        return isAlive(handle) ? sparse[handle.index] : EntityHandle::INVALID_INDEX;
+    }
+
+    // Change an entity's tile, keeping the spatial index current
+    bool move(EntityHandle handle, int tile);
+    void moveDense(uint32_t dense, int tile);
+
+    // Every live entity within radius hexes of center, appended to out
+    void queryRadius(const HexCoord& center, int radius, std::vector<EntityHandle>& out) const;
+
+    // Ids in the index are handle indices; denseIndex(handleAt(id)) finds the components
+    const HexSpatialIndex& getSpatialIndex() const { return spatial; }
+    EntityHandle handleAt(uint32_t index) const { return EntityHandle{index, generations[index]}; }
+
+    // Dense component arrays, size() long. Tiles and positions change through move().
+    const std::vector<EntityHandle>& getHandles() const { return handles; }
+    const std::vector<EntityKind>& getKinds() const { return kinds; }
+    const std::vector<int32_t>& getTiles() const { return tiles; }
+    const std::vector<HexCoord>& getPositions() const { return positions; }
+    std::vector<uint8_t>& getOwners() { return owners; }
+    const std::vector<uint8_t>& getOwners() const { return owners; }
+    std::vector<uint8_t>& getFacings() { return facings; }
+    const std::vector<uint8_t>& getFacings() const { return facings; }
+    std::vector<uint8_t>& getFlags() { return flags; }
+    const std::vector<uint8_t>& getFlags() const { return flags; }
+    std::vector<float>& getHealth() { return health; }
+    const std::vector<float>& getHealth() const { return health; }
+
+    // Run fn(begin, end, worker) over dense ranges on threadCount workers (0 = all cores).
+    // fn may write components of its own range but must not spawn, despawn or move.
+    template <typename Fn>
+    void forEachParallel(int threadCount, Fn&& fn) {
+        parallelFor(handles.size(), threadCount, std::forward<Fn>(fn));
+    }
+
+private:
+    const HexGrid& grid;
+    HexSpatialIndex spatial;
+
+    // Sparse side: handle index -> dense index and generation
+    std::vector<uint32_t> sparse;
+    std::vector<uint32_t> generations;
+    std::vector<uint32_t> freeIndices;
+
+    // Dense components
+    std::vector<EntityHandle> handles;
+    std::vector<EntityKind> kinds;
+    std::vector<int32_t> tiles;
+    std::vector<HexCoord> positions;
+    std::vector<uint8_t> owners;
+    std::vector<uint8_t> facings;
+    std::vector<uint8_t> flags;
+    std::vector<float> health;
+};
@@ -0,0 +1,191 @@
+#include "flow_field.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <thread>
+
+namespace {
+    // Below this many tiles the barrier per bucket costs more than the extra threads save
+    constexpr int PARALLEL_MIN_TILES = 1 << 16;
+}
+
+FlowFieldCache::FlowFieldCache(const HexGrid& grid, const MovementProfile& profile, size_t capacity, int threadCount)
+    : grid(grid)
+    , profile(profile)
+    , capacity(std::max<size_t>(capacity, 1))
+    , threadCount(threadCount)
+{
+    // get() hands out references into entries, so they must never reallocate
+    entries.reserve(this->capacity);
+}
+
+const FlowField& FlowFieldCache::get(int targetIndex) {
+    ++useClock;
+
+    Entry* slot = nullptr;
+    for (auto& entry : entries) {
+        if (entry.field.target != targetIndex) continue;
+        if (entry.valid) {
+            entry.lastUse = useClock;
+            return entry.field;
+        }
+        slot = &entry; // Stale field for this target: rebuild in place
+        break;
+    }
+
+    if (!slot) {
+        if (entries.size() < capacity) {
+            slot = &entries.emplace_back();
+        } else {
+            slot = &*std::min_element(entries.begin(), entries.end(),
+                                      [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+        }
+    }
+
+    build(slot->field, targetIndex);
+    slot->valid = true;
+    slot->lastUse = useClock;
+    ++buildCount;
+    return slot->field;
+}
+
+void FlowFieldCache::onTileChanged(int tileIndex) {
+    if (tileIndex < 0 || tileIndex >= grid.size()) return;
+
+    for (auto& entry : entries) {
+        if (!entry.valid) continue;
+        const FlowField& field = entry.field;
+        // A tile that is neither reachable nor next to a reachable tile can't change any cost
+        // in this field, whatever its new terrain
+        if (field.integration[tileIndex] != MovementProfile::IMPASSABLE ||
+            field.direction[tileIndex] != FlowField::NO_DIRECTION) {
+            entry.valid = false;
+        }
+    }
+}
+
+void FlowFieldCache::build(FlowField& field, int target) {
+    int tileCount = grid.size();
+    field.target = target;
+    field.integration.assign(tileCount, MovementProfile::IMPASSABLE);
+    field.direction.assign(tileCount, FlowField::NO_DIRECTION);
+    if (target < 0 || target >= tileCount || !profile.passable(grid.getType(target))) return;
+
+    // Bucket width = cheapest step, so relaxing a tile always lands in a later bucket and the
+    // current bucket's tiles are final. Pending tiles are never more than maxCost / width
+    // buckets ahead, which bounds the ring.
+    const float bucketWidth = profile.minCost;
+    float maxCost = 0.0f;
+    for (float cost : profile.cost) {
+        if (cost != MovementProfile::IMPASSABLE) maxCost = std::max(maxCost, cost);
+    }
+    const int ringSize = static_cast<int>(maxCost / bucketWidth) + 2;
+
+    int workers = threadCount;
+    if (workers <= 0) {
+        workers = tileCount >= PARALLEL_MIN_TILES ? static_cast<int>(std::thread::hardware_concurrency()) : 1;
+    }
+    workers = std::max(workers, 1);
+
+    settled.assign(tileCount, 0);
+    localBuckets.resize(workers);
+    for (auto& ring : localBuckets) {
+        ring.resize(ringSize);
+        for (auto& bucket : ring) bucket.clear();
+    }
+    frontier.clear();
+
+    field.integration[target] = 0.0f;
+    localBuckets[0][0].push_back(target);
+
+    int bucket = -1;
+    bool done = false;
+
+    // Runs once per phase on one thread while the others wait: gather the next non-empty
+    // bucket from every worker into the shared frontier
+    auto advance = [&]() noexcept {
+        frontier.clear();
+        for (int skipped = 0; skipped < ringSize; ++skipped) {
+            ++bucket;
+            for (auto& ring : localBuckets) {
+                auto& pending = ring[bucket % ringSize];
+                frontier.insert(frontier.end(), pending.begin(), pending.end());
+                pending.clear();
+            }
+            if (!frontier.empty()) return;
+        }
+        done = true;
+    };
+    std::barrier sync(workers, advance);
+
+    const std::vector<TerrainType>& types = grid.getTypes();
+    float* integration = field.integration.data();
+
+    auto work = [&](int worker) {
+        auto& ring = localBuckets[worker];
+        std::array<int, 6> neighbors;
+
+        while (true) {
+            sync.arrive_and_wait();
+            if (done) break;
+
+            size_t begin = frontier.size() * worker / workers;
+            size_t end = frontier.size() * (worker + 1) / workers;
+            for (size_t i = begin; i < end; ++i) {
+                int current = frontier[i];
+                // Tiles can be queued more than once; only the first copy is expanded
+                if (std::atomic_ref<uint8_t>(settled[current]).exchange(1, std::memory_order_relaxed)) continue;
+
+                // Moving from a neighbor onto current costs entering current
+                float cost = std::atomic_ref<float>(integration[current]).load(std::memory_order_relaxed) +
+                             profile.entryCost(types[current]);
+
+                grid.neighborIndices(current, neighbors);
+                for (int next : neighbors) {
+                    if (next < 0 || !profile.passable(types[next])) continue;
+
+                    std::atomic_ref<float> nextCost(integration[next]);
+                    float old = nextCost.load(std::memory_order_relaxed);
+                    while (cost < old) {
+                        if (nextCost.compare_exchange_weak(old, cost, std::memory_order_relaxed)) {
+                            // Clamp guards against rounding putting a step back into this bucket
+                            int nextBucket = std::max(static_cast<int>(cost / bucketWidth), bucket + 1);
+                            ring[nextBucket % ringSize].push_back(next);
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Integration is final once every worker has left the loop through the same barrier
+        int begin = static_cast<int>(static_cast<int64_t>(tileCount) * worker / workers);
+        int end = static_cast<int>(static_cast<int64_t>(tileCount) * (worker + 1) / workers);
+        for (int tile = begin; tile < end; ++tile) {
+            if (tile == target) continue;
+
+            // Impassable tiles (a ship in a port city) still get a way out
+            float best = MovementProfile::IMPASSABLE;
+            int8_t bestDir = FlowField::NO_DIRECTION;
+            grid.neighborIndices(tile, neighbors);
+            for (int dir = 0; dir < 6; ++dir) {
+                int next = neighbors[dir];
+                if (next < 0 || integration[next] == MovementProfile::IMPASSABLE) continue;
+                float cost = integration[next] + profile.entryCost(types[next]);
+                if (cost < best) {
+                    best = cost;
+                    bestDir = static_cast<int8_t>(dir);
+                }
+            }
+            field.direction[tile] = bestDir;
+        }
+    };
+
+    std::vector<std::jthread> threads;
+    threads.reserve(workers - 1);
+    for (int worker = 1; worker < workers; ++worker) {
+        threads.emplace_back(work, worker);
+    }
+    work(0);
+}
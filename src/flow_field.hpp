@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "hex_coord.hpp"
+#include "hex_grid.hpp"
+
+// Shared routing toward one target tile: many units heading to the same port follow the
+// field instead of each running A*.
+struct FlowField {
+    static constexpr int8_t NO_DIRECTION = -1;
+
+    int target = -1;
+    std::vector<float> integration; // Cost from each tile to the target, IMPASSABLE when unreachable
+    std::vector<int8_t> direction;  // HEX_DIRECTIONS index of the cheapest next step; NO_DIRECTION
+                                    // at the target and where the target can't be reached
+
+    // Next tile toward the target, or -1 when there is none
+    int nextTile(const HexGrid& grid, int index) const {
+        int8_t dir = direction[index];
+        return dir == NO_DIRECTION ? -1 : grid.neighborIndex(index, dir);
+    }
+};
+
+// Builds and caches flow fields for one grid and movement profile.
+//
+// The integration field is a reverse Dijkstra from the target processed in buckets of
+// width profile.minCost: every tile in the current bucket is already final, so a bucket's
+// tiles are relaxed in parallel (atomic min on the neighbor's cost) with one barrier per
+// bucket. Directions are then filled in parallel over tile ranges.
+//
+// Fields are kept in an LRU cache. onTileChanged() invalidates only fields whose reachable
+// area touches the tile; they are rebuilt in place on the next get().
+class FlowFieldCache {
+public:
+    // threadCount 0 picks hardware_concurrency for large grids and 1 for small ones
+    FlowFieldCache(const HexGrid& grid, const MovementProfile& profile, size_t capacity = 16, int threadCount = 0);
+
+    // Field toward targetIndex, building it if missing or stale. The reference stays valid
+    // until the next get() evicts or rebuilds that entry.
+    const FlowField& get(int targetIndex);
+    const FlowField& get(const HexCoord& target) { return get(grid.indexOf(target)); }
+
+    // Call after grid.setType(tileIndex, ...)
+    void onTileChanged(int tileIndex);
+
+    // Drop every field (after loading a new map)
+    void clear() { entries.clear(); }
+
+    // Fields built since construction (for profiling cache hit rates)
+    uint64_t getBuildCount() const { return buildCount; }
+
+private:
+    struct Entry {
+        FlowField field;
+        uint64_t lastUse = 0;
+        bool valid = false;
+    };
+
+    const HexGrid& grid;
+    MovementProfile profile;
+    size_t capacity;
+    int threadCount;
+    std::vector<Entry> entries;
+    uint64_t useClock = 0;
+    uint64_t buildCount = 0;
+
+    // Build scratch, reused across builds
+    std::vector<uint8_t> settled;
+    std::vector<int32_t> frontier;
+    std::vector<std::vector<std::vector<int32_t>>> localBuckets; // [worker][bucket % ringSize]
+
+    void build(FlowField& field, int target);
+};
@@ -0,0 +1,151 @@
+#include "fog_texture.hpp"
+#include "device.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+// Copy regions are packed at 4-byte aligned offsets in the staging slice
+static VkDeviceSize alignStagingOffset(VkDeviceSize offset) {
+    return (offset + 3) & ~static_cast<VkDeviceSize>(3);
+}
+
+void createFogTexture(Device& device, FogTexture& fog, uint32_t width, uint32_t height,
+                      const glm::ivec2& origin, uint32_t framesInFlight) {
+    if (width == 0 || height == 0) {
+        throw std::invalid_argument("Fog texture dimensions must be non-zero!");
+    }
+
+    fog.width = width;
+    fog.height = height;
+    fog.origin = origin;
+    fog.texels.assign(static_cast<size_t>(width) * height, 0);
+    fog.dirty.clear();
+    fog.dirty.markRect({0, 0, width, height});
+    fog.uploadedOnce = false;
+
+    fog.image = createImage(device, width, height, VK_FORMAT_R8_UNORM,
+                            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+    createImageView(device, fog.image, VK_IMAGE_ASPECT_COLOR_BIT);
+
+    // Nearest filtering: the shader fetches whole tiles
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = 0.0f;
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
+    if (vkCreateSampler(device.device, &samplerInfo, nullptr, &fog.sampler) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create fog sampler!");
+    }
+
+    // Staging ring: worst case every slice carries a full upload plus per-region alignment padding
+    fog.sliceCount = framesInFlight > 0 ? framesInFlight : 1;
+    fog.sliceSize = alignStagingOffset(static_cast<VkDeviceSize>(width) * height);
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = fog.sliceSize * fog.sliceCount;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+
+    VmaAllocationInfo allocInfoResult;
+    if (vmaCreateBuffer(device.allocator, &bufferInfo, &allocInfo, &fog.staging.buffer,
+                        &fog.staging.allocation, &allocInfoResult) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create fog staging buffer!");
+    }
+    fog.stagingMapped = static_cast<uint8_t*>(allocInfoResult.pMappedData);
+
+    std::cout << "Fog texture created: " << width << "x" << height << std::endl;
+}
+
+void destroyFogTexture(Device& device, FogTexture& fog) {
+    destroyBuffer(device, fog.staging);
+    fog.stagingMapped = nullptr;
+
+    if (fog.sampler != VK_NULL_HANDLE) {
+        vkDestroySampler(device.device, fog.sampler, nullptr);
+        fog.sampler = VK_NULL_HANDLE;
+    }
+    destroyImage(device, fog.image);
+
+    fog.width = 0;
+    fog.height = 0;
+    fog.texels.clear();
+    fog.dirty.clear();
+    fog.uploadedOnce = false;
+}
+
+void setFogTexel(FogTexture& fog, uint32_t x, uint32_t y, uint8_t value) {
+    if (x >= fog.width || y >= fog.height) return;
+    uint8_t& texel = fog.texels[static_cast<size_t>(y) * fog.width + x];
+    if (texel == value) return;
+    texel = value;
+    fog.dirty.markTexel(x, y);
+}
+
+void recordFogUpload(Device& device, VkCommandBuffer cmd, FogTexture& fog, uint32_t frameIndex) {
+    if (fog.image.image == VK_NULL_HANDLE || fog.dirty.empty()) return;
+
+    // Overlapping rects plus alignment padding could exceed one slice; a full upload always fits
+    const auto& dirtyRects = fog.dirty.getRects();
+    if (fog.dirty.texelCount() + 3 * dirtyRects.size() > fog.sliceSize) {
+        fog.dirty.clear();
+        fog.dirty.markRect({0, 0, fog.width, fog.height});
+    }
+
+    VkDeviceSize sliceBase = static_cast<VkDeviceSize>(frameIndex % fog.sliceCount) * fog.sliceSize;
+    VkDeviceSize cursor = 0;
+    fog.copyRegions.clear();
+
+    // Pack each rect tightly into this frame's slice
+    for (const DirtyRect& rect : fog.dirty.getRects()) {
+        uint8_t* dst = fog.stagingMapped + sliceBase + cursor;
+        for (uint32_t row = 0; row < rect.height; ++row) {
+            const uint8_t* src = fog.texels.data() + static_cast<size_t>(rect.y + row) * fog.width + rect.x;
+            memcpy(dst + static_cast<size_t>(row) * rect.width, src, rect.width);
+        }
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = sliceBase + cursor;
+        region.bufferRowLength = 0; // tightly packed
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {static_cast<int32_t>(rect.x), static_cast<int32_t>(rect.y), 0};
+        region.imageExtent = {rect.width, rect.height, 1};
+        fog.copyRegions.push_back(region);
+
+        cursor = alignStagingOffset(cursor + rect.area());
+    }
+
+    vmaFlushAllocation(device.allocator, fog.staging.allocation, sliceBase, cursor);
+
+    // Untouched texels must survive, so only the very first upload may discard contents
+    transitionImageLayout(cmd, fog.image.image, fog.image.format,
+                          fog.uploadedOnce ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED,
+                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+    vkCmdCopyBufferToImage(cmd, fog.staging.buffer, fog.image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<uint32_t>(fog.copyRegions.size()), fog.copyRegions.data());
+
+    transitionImageLayout(cmd, fog.image.image, fog.image.format,
+                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    fog.uploadedOnce = true;
+    fog.dirty.clear();
+}
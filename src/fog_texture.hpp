@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "buffer.hpp"
+#include "image.hpp"
+#include "dirty_rects.hpp"
+
+struct Device;
+
+// Tile-space fog-of-war texture: R8_UNORM, one texel per hex in flat-top "odd-q" offset
+// layout (texel (0,0) is the hex at offset `origin`).
+// Texel values: 0 = unexplored, 128 = explored but not visible, 255 = visible.
+struct FogTexture {
+    Image image{};
+    VkSampler sampler = VK_NULL_HANDLE;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    glm::ivec2 origin{0};
+
+    // CPU copy of the texture (row-major) and the texels changed since the last upload
+    std::vector<uint8_t> texels;
+    DirtyRectSet dirty;
+
+    // Persistent, mapped staging ring with one full-texture slice per frame in flight.
+    // A slice is reused only after that frame's timeline value has been waited on.
+    Buffer staging{VK_NULL_HANDLE, nullptr};
+    uint8_t* stagingMapped = nullptr;
+    VkDeviceSize sliceSize = 0;
+    uint32_t sliceCount = 0;
+
+    bool uploadedOnce = false; // false while the image is still in UNDEFINED layout
+    std::vector<VkBufferImageCopy> copyRegions; // scratch reused across uploads
+};
+
+// Encode a tile's explored/visible state as a fog texel
+inline uint8_t encodeFogTexel(uint8_t explored, uint8_t visible) {
+    if (visible > 0) return 255;
+    return explored > 0 ? 128 : 0;
+}
+
+// Create the fog image, sampler and staging ring. The whole texture starts dirty.
+void createFogTexture(Device& device, FogTexture& fog, uint32_t width, uint32_t height,
+                      const glm::ivec2& origin, uint32_t framesInFlight);
+void destroyFogTexture(Device& device, FogTexture& fog);
+
+// Update one texel on the CPU; marks it dirty only when the value changes
+void setFogTexel(FogTexture& fog, uint32_t x, uint32_t y, uint8_t value);
+
+// Record staging copies and layout transitions for the dirty rectangles into `cmd`.
+// Must be recorded outside of dynamic rendering. No-op when nothing changed.
+void recordFogUpload(Device& device, VkCommandBuffer cmd, FogTexture& fog, uint32_t frameIndex);
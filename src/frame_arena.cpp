@@ -0,0 +1,52 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+
+namespace {
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+FrameArena::FrameArena(size_t initialBytes)
+    : block(std::make_unique<std::byte[]>(initialBytes))
+    , capacity(initialBytes)
+    , heapAllocations(1)
+{
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    // Align the address rather than the offset: operator new[] only aligns the block for
+    // fundamental types, and callers may ask for more (cache lines, GPU upload rules)
+    uintptr_t base = reinterpret_cast<uintptr_t>(block.get());
+    size_t start = alignUp(base + offset, alignment) - base;
+    if (start + bytes <= capacity) {
+        offset = start + bytes;
+        used = spilledBytes + offset;
+        return block.get() + start;
+    }
+
+    // Out of room until the next reset(); give this request a block of its own
+    spilled.push_back(std::make_unique<std::byte[]>(bytes + alignment));
+    spilledBytes += bytes + alignment;
+    used = spilledBytes + offset;
+    ++heapAllocations;
+    void* memory = spilled.back().get();
+    size_t space = bytes + alignment;
+    return std::align(alignment, bytes, memory, space);
+}
+
+void FrameArena::reset() {
+    peak = std::max(peak, used);
+    if (!spilled.empty()) {
+        spilled.clear();
+        spilledBytes = 0;
+        capacity = alignUp(peak, 4096);
+        block = std::make_unique<std::byte[]>(capacity);
+        ++heapAllocations;
+    }
+    offset = 0;
+    used = 0;
+}
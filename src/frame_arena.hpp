@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Linear allocator for data that lives for one frame in flight. Allocating bumps an offset and
+// reset() releases everything at once, so it must only be called after the GPU has finished
+// the frame (its timeline value has been waited on). Requests that don't fit the block spill
+// into extra blocks; reset() folds them into one block of the peak size, so a steady workload
+// stops touching the heap after its first frames.
+//
+// Nothing allocated here is destroyed: only trivially destructible types belong in it. Not
+// thread-safe.
+class FrameArena {
+public:
+    explicit FrameArena(size_t initialBytes = 16 * 1024);
+
+    // alignment is a power of two, and may be larger than alignof(std::max_align_t)
+    void* allocate(size_t bytes, size_t alignment);
+
+    // count value-initialized Ts
+    template <typename T>
+    T* allocateArray(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "FrameArena never runs destructors");
+        if (count == 0) return nullptr;
+        T* array = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        std::uninitialized_value_construct_n(array, count);
+        return array;
+    }
+
+    void reset();
+
+    size_t getUsedBytes() const { return used; }
+    size_t getCapacity() const { return capacity + spilledBytes; }
+    uint64_t getHeapAllocations() const { return heapAllocations; } // Blocks allocated so far
+
+private:
+    std::unique_ptr<std::byte[]> block;
+    size_t capacity{0};
+    size_t offset{0};
+    size_t used{0}; // Including what spilled
+
+    std::vector<std::unique_ptr<std::byte[]>> spilled;
+    size_t spilledBytes{0};
+    size_t peak{0};
+    uint64_t heapAllocations{0};
+};
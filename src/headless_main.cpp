@@ -0,0 +1,221 @@
+// Headless turn simulation for servers and soak tests: no window, no Vulkan.
+//
+// Usage: HeadlessSim [--turns N] [--threads N] [--size N] [--ships N] [--cities N] [--seed N]
+//                    [--record FILE] [--replay FILE] [--autosave BASE] [--autosave-every N] [--load BASE]
+// Prints the throughput and the final checksum, which is the same for any --threads value.
+// --record saves the commands and per-turn checksums; --replay reruns such a log (its map,
+// seed and turns override the other options) and reports the first turn that diverged.
+// --autosave writes BASE.key and BASE.delta in the background every N turns (default 10)
+// and reports how long the simulation thread stalled; --load continues from such a save.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "hex_grid.hpp"
+#include "job_system.hpp"
+#include "noise.hpp"
+#include "replay_log.hpp"
+#include "snapshot.hpp"
+#include "turn_simulation.hpp"
+
+namespace {
+
+// Rough archipelago from fractal noise; the renderer's MapBuilder writes straight into
+// TerrainRenderer, so the headless build makes its own
+HexGrid generateGrid(int size, uint32_t seed) {
+    HexGrid grid(size, size);
+    SimplexNoise noise(seed);
+    for (int row = 0; row < size; ++row) {
+        for (int col = 0; col < size; ++col) {
+            float elevation = noise.fractalNoise(col * 0.06f, row * 0.06f, 5, 0.5f);
+            TerrainType type = TerrainType::Ocean;
+            if (elevation > 0.72f) {
+                type = TerrainType::Mountains;
+            } else if (elevation > 0.62f) {
+                type = TerrainType::Hills;
+            } else if (elevation > 0.5f) {
+                type = TerrainType::Grassland;
+            } else if (elevation > 0.45f) {
+                type = TerrainType::CoastalWater;
+            }
+            grid.setType(row * size + col, type);
+        }
+    }
+    return grid;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int turns = 1000;
+    int threads = 0;
+    int size = 128;
+    int ships = 500;
+    int cities = 8;
+    uint64_t seed = 1;
+    std::string recordPath;
+    std::string replayPath;
+    std::string autosavePath;
+    int autosaveEvery = 10;
+    std::string loadPath;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        long value = std::strtol(argv[i + 1], nullptr, 10);
+        if (std::strcmp(argv[i], "--turns") == 0) {
+            turns = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--threads") == 0) {
+            threads = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--size") == 0) {
+            size = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--ships") == 0) {
+            ships = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--cities") == 0) {
+            cities = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--seed") == 0) {
+            seed = static_cast<uint64_t>(value);
+        } else if (std::strcmp(argv[i], "--record") == 0) {
+            recordPath = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--replay") == 0) {
+            replayPath = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--autosave") == 0) {
+            autosavePath = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--autosave-every") == 0) {
+            autosaveEvery = std::max(static_cast<int>(value), 1);
+        } else if (std::strcmp(argv[i], "--load") == 0) {
+            loadPath = argv[i + 1];
+        } else {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    ReplayLog replayLog;
+    if (!replayPath.empty()) {
+        try {
+            replayLog = ReplayLog::load(replayPath);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        size = replayLog.getHeader().gridWidth;
+        seed = replayLog.getHeader().seed;
+        turns = static_cast<int>(replayLog.getTurnCount());
+    }
+
+    Snapshot loaded;
+    if (!loadPath.empty()) {
+        try {
+            loaded = loadSnapshot(loadPath + ".key", loadPath + ".delta");
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    HexGrid grid = loadPath.empty() ? generateGrid(size, static_cast<uint32_t>(seed)) : loadGrid(loaded);
+    JobSystem jobs(threads);
+
+    SimulationConfig config;
+    config.seed = seed;
+    if (!replayPath.empty()) config.playerCount = replayLog.getHeader().playerCount;
+    TurnSimulation simulation(grid, jobs, config);
+
+    if (!replayPath.empty()) {
+        std::cout << "Replaying " << turns << " turns from " << replayPath << "..." << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        int diverged = -1;
+        try {
+            diverged = simulation.replay(replayLog);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << simulation.getTurn() / seconds << " turns/s" << std::endl;
+        if (diverged >= 0) {
+            std::cout << "Desync at turn " << diverged << std::endl;
+            return 2;
+        }
+        std::cout << "All " << turns << " turns match, checksum " << std::hex << simulation.checksum() << std::dec
+                  << std::endl;
+        return 0;
+    }
+
+    ReplayLog recording(simulation.makeReplayHeader());
+    if (!recordPath.empty()) simulation.setRecorder(&recording);
+    if (loadPath.empty()) {
+        simulation.populate(ships, cities);
+    } else {
+        simulation.load(loaded);
+        loaded = Snapshot(); // Unmap the keyframe
+        std::cout << "Loaded turn " << simulation.getTurn() << " from " << loadPath << std::endl;
+    }
+    std::cout << "Simulating " << turns << " turns on " << grid.getWidth() << "x" << grid.getHeight() << " with "
+              << simulation.getEntities().size() << " entities and " << jobs.getWorkerCount() << " workers..."
+              << std::endl;
+
+    std::unique_ptr<AutosaveWriter> autosave;
+    if (!autosavePath.empty()) autosave = std::make_unique<AutosaveWriter>(autosavePath);
+    int captures = 0;
+    double stallTotal = 0.0;
+    double stallMax = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int turn = 0; turn < turns; ++turn) {
+        simulation.step();
+        if (autosave && simulation.getTurn() % autosaveEvery == 0) {
+            // The capture is all the simulation thread waits for; encoding and I/O are the writer's
+            auto captureStart = std::chrono::steady_clock::now();
+            auto snapshot = std::make_shared<Snapshot>();
+            simulation.save(*snapshot);
+            try {
+                autosave->save(std::move(snapshot));
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+            double stall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - captureStart).count();
+            ++captures;
+            stallTotal += stall;
+            stallMax = std::max(stallMax, stall);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (autosave) {
+        try {
+            autosave->wait();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << "Autosaved " << captures << " times (" << autosave->getSavedCount() << " written), stall "
+                  << (captures ? stallTotal / captures : 0.0) << " ms average, " << stallMax << " ms max" << std::endl;
+    }
+
+    std::cout << turns / seconds << " turns/s, " << simulation.getEntities().size() << " entities left" << std::endl;
+    for (size_t player = 0; player < simulation.getPlayers().size(); ++player) {
+        const PlayerState& state = simulation.getPlayers()[player];
+        std::cout << "Player " << player << ": " << state.gold << " gold, " << state.visibleTiles
+                  << " tiles visible, " << state.shipsLost << " ships lost" << std::endl;
+    }
+    std::cout << "Checksum " << std::hex << simulation.checksum() << std::dec << std::endl;
+
+    if (!recordPath.empty()) {
+        try {
+            recording.save(recordPath);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << "Recorded " << recording.getTurnCount() << " turns in " << recording.getByteSize() << " bytes to "
+                  << recordPath << std::endl;
+    }
+    return 0;
+}
@@ -99,6 +99,17 @@ inline HexCoord worldToHex(const glm::vec3& worldPos, float hexSize) {
     return HexCoord(rq, rr);
 }
 
+// Convert axial coordinates to flat-top "odd-q" offset (col, row), the layout used by the
+// rectangular grid builders (r = row - floor(col/2))
+inline glm::ivec2 hexToOffset(const HexCoord& hex) {
+    return glm::ivec2(hex.q, hex.r + (hex.q - (hex.q & 1)) / 2);
+}
+
+// Convert flat-top "odd-q" offset (col, row) back to axial coordinates
+inline HexCoord offsetToHex(int col, int row) {
+    return HexCoord(col, row - (col - (col & 1)) / 2);
+}
+
 // Get hex vertices in world space (flat-top orientation)
 inline std::array<glm::vec3, 6> hexVertices(const HexCoord& hex, float hexSize, float height = 0.0f) {
     glm::vec3 center = hexToWorld(hex, hexSize);
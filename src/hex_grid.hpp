@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "hex_coord.hpp"
+#include "terrain.hpp"
+
+// Cells inside the grid rectangle that have no tile hold this type; every movement profile
+// treats them as impassable
+inline constexpr TerrainType VOID_TERRAIN = TerrainType::Count;
+
+// Dense tile grid over a flat-top "odd-q" offset rectangle.
+// Tiles are addressed by index = row * width + col so gameplay systems (pathfinding,
+// regions, influence) can keep per-tile state in flat arrays instead of hash maps.
+class HexGrid {
+public:
+    HexGrid() = default;
+
+    HexGrid(int width, int height, TerrainType fill = TerrainType::Ocean, glm::ivec2 origin = glm::ivec2(0))
+        : width(width)
+        , height(height)
+        , origin(origin)
+        , types(static_cast<size_t>(width) * height, fill)
+    {}
+
+    // Build from a sparse tile map (e.g. TerrainRenderer::getTiles()); the rectangle is the
+    // offset-space bounding box of the tiles
+    static HexGrid fromTiles(const std::unordered_map<HexCoord, TerrainTile>& tiles) {
+        if (tiles.empty()) return HexGrid();
+
+        glm::ivec2 minOffset = hexToOffset(tiles.begin()->first);
+        glm::ivec2 maxOffset = minOffset;
+        for (const auto& [hex, tile] : tiles) {
+            glm::ivec2 o = hexToOffset(hex);
+            minOffset.x = std::min(minOffset.x, o.x);
+            minOffset.y = std::min(minOffset.y, o.y);
+            maxOffset.x = std::max(maxOffset.x, o.x);
+            maxOffset.y = std::max(maxOffset.y, o.y);
+        }
+
+        HexGrid grid(maxOffset.x - minOffset.x + 1, maxOffset.y - minOffset.y + 1, VOID_TERRAIN, minOffset);
+        for (const auto& [hex, tile] : tiles) {
+            grid.types[grid.indexOf(hex)] = tile.type;
+        }
+        return grid;
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int size() const { return width * height; }
+    glm::ivec2 getOrigin() const { return origin; }
+
+    // Tile index for a hex, or -1 when outside the rectangle
+    int indexOf(const HexCoord& hex) const {
+        glm::ivec2 o = hexToOffset(hex) - origin;
+        if (o.x < 0 || o.y < 0 || o.x >= width || o.y >= height) return -1;
+        return o.y * width + o.x;
+    }
+
+    HexCoord coordOf(int index) const {
+        return offsetToHex(index % width + origin.x, index / width + origin.y);
+    }
+
+    bool contains(const HexCoord& hex) const { return indexOf(hex) >= 0; }
+
+    // Neighbor index in HEX_DIRECTIONS order, or -1 when outside the rectangle
+    int neighborIndex(int index, int direction) const {
+        int col = index % width;
+        int row = index / width;
+        return neighborAt(col, row, direction);
+    }
+
+    // All six neighbors in HEX_DIRECTIONS order (-1 where outside); one div/mod for the lot
+    void neighborIndices(int index, std::array<int, 6>& out) const {
+        int col = index % width;
+        int row = index / width;
+        for (int dir = 0; dir < 6; ++dir) {
+            out[dir] = neighborAt(col, row, dir);
+        }
+    }
+
+    TerrainType getType(int index) const { return types[index]; }
+    void setType(int index, TerrainType type) { types[index] = type; }
+    const std::vector<TerrainType>& getTypes() const { return types; }
+
+private:
+    int width = 0;
+    int height = 0;
+    glm::ivec2 origin{0}; // offset (col, row) of index 0
+    std::vector<TerrainType> types;
+
+    // Offset deltas depend on column parity in the odd-q layout
+    int neighborAt(int col, int row, int direction) const {
+        // {dcol, drow} per direction for even / odd absolute columns
+        static constexpr int DELTAS[2][6][2] = {
+            {{1, 0}, {1, -1}, {0, -1}, {-1, -1}, {-1, 0}, {0, 1}},
+            {{1, 1}, {1, 0}, {0, -1}, {-1, 0}, {-1, 1}, {0, 1}},
+        };
+        const int* d = DELTAS[(col + origin.x) & 1][direction];
+        int ncol = col + d[0];
+        int nrow = row + d[1];
+        if (ncol < 0 || nrow < 0 || ncol >= width || nrow >= height) return -1;
+        return nrow * width + ncol;
+    }
+};
+
+// Per-terrain entry cost for one kind of mover; infinity marks impassable terrain
+struct MovementProfile {
+    static constexpr float IMPASSABLE = std::numeric_limits<float>::infinity();
+
+    std::array<float, static_cast<size_t>(TerrainType::Count) + 1> cost;
+    float minCost; // Smallest finite cost, scales the hex-distance heuristic so it stays admissible
+
+    float entryCost(TerrainType type) const { return cost[static_cast<size_t>(type)]; }
+    bool passable(TerrainType type) const { return entryCost(type) != IMPASSABLE; }
+
+    // Every real terrain at TerrainProperties::movementCost
+    static MovementProfile allTerrain() {
+        return build([](TerrainType) { return true; });
+    }
+
+    // Land units: water is impassable
+    static MovementProfile land() {
+        return build([](TerrainType type) { return !isWaterTerrain(type); });
+    }
+
+    // Ships: only Ocean, CoastalWater and River
+    static MovementProfile naval() {
+        return build([](TerrainType type) { return isWaterTerrain(type); });
+    }
+
+private:
+    template <typename Filter>
+    static MovementProfile build(Filter allowed) {
+        MovementProfile profile{};
+        profile.minCost = IMPASSABLE;
+        for (size_t i = 0; i < profile.cost.size(); ++i) {
+            TerrainType type = static_cast<TerrainType>(i);
+            if (type == VOID_TERRAIN || !allowed(type)) {
+                profile.cost[i] = IMPASSABLE;
+                continue;
+            }
+            profile.cost[i] = TerrainProperties::get(type).movementCost;
+            profile.minCost = std::min(profile.minCost, profile.cost[i]);
+        }
+        return profile;
+    }
+};
@@ -0,0 +1,89 @@
+#include "hex_spatial_index.hpp"
+
+HexSpatialIndex::HexSpatialIndex(const HexGrid& grid, int chunkSize)
+    : grid(grid)
+    , chunkSize(std::max(chunkSize, 1))
+{
+    chunksX = (grid.getWidth() + this->chunkSize - 1) / this->chunkSize;
+    int chunksY = (grid.getHeight() + this->chunkSize - 1) / this->chunkSize;
+    heads.assign(static_cast<size_t>(grid.size()), NONE);
+    chunkCounts.assign(static_cast<size_t>(chunksX) * chunksY, 0);
+}
+
+void HexSpatialIndex::reserve(size_t idCount) {
+    if (idCount <= tiles.size()) return;
+    nexts.resize(idCount, NONE);
+    prevs.resize(idCount, NONE);
+    tiles.resize(idCount, -1);
+}
+
+void HexSpatialIndex::clear() {
+    std::fill(heads.begin(), heads.end(), NONE);
+    std::fill(chunkCounts.begin(), chunkCounts.end(), 0);
+    std::fill(tiles.begin(), tiles.end(), -1);
+    count = 0;
+}
+
+void HexSpatialIndex::link(uint32_t id, int tile) {
+    uint32_t head = heads[tile];
+    nexts[id] = head;
+    prevs[id] = NONE;
+    if (head != NONE) prevs[head] = id;
+    heads[tile] = id;
+    tiles[id] = tile;
+    ++chunkCounts[chunkOf(tile)];
+}
+
+void HexSpatialIndex::unlink(uint32_t id) {
+    int tile = tiles[id];
+    if (prevs[id] != NONE) {
+        nexts[prevs[id]] = nexts[id];
+    } else {
+        heads[tile] = nexts[id];
+    }
+    if (nexts[id] != NONE) prevs[nexts[id]] = prevs[id];
+    tiles[id] = -1;
+    --chunkCounts[chunkOf(tile)];
+}
+
+void HexSpatialIndex::insert(uint32_t id, int tile) {
+    if (contains(id)) {
+        move(id, tile);
+        return;
+    }
+    // Grow geometrically so a stream of new ids stays amortized O(1)
+    if (id >= tiles.size()) reserve(std::max<size_t>(id + 1, tiles.size() * 2));
+    link(id, tile);
+    ++count;
+}
+
+void HexSpatialIndex::remove(uint32_t id) {
+    if (!contains(id)) return;
+    unlink(id);
+    --count;
+}
+
+void HexSpatialIndex::move(uint32_t id, int tile) {
+    if (!contains(id)) {
+        insert(id, tile);
+        return;
+    }
+    if (tiles[id] == tile) return;
+    unlink(id);
+    link(id, tile);
+}
+
+void HexSpatialIndex::queryRadius(const HexCoord& center, int radius, std::vector<uint32_t>& out) const {
+    forEachInRadius(center, radius, [&](uint32_t id, int) { out.push_back(id); });
+}
+
+void HexSpatialIndex::queryRadiusBatch(const std::vector<HexCoord>& centers, int radius,
+                                       std::vector<uint32_t>& ids, std::vector<uint32_t>& offsets) const {
+    ids.clear();
+    offsets.resize(centers.size() + 1);
+    for (size_t i = 0; i < centers.size(); ++i) {
+        offsets[i] = static_cast<uint32_t>(ids.size());
+        queryRadius(centers[i], radius, ids);
+    }
+    offsets[centers.size()] = static_cast<uint32_t>(ids.size());
+}
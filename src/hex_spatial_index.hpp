@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "hex_coord.hpp"
+#include "hex_grid.hpp"
+
+// Which entities stand on which tiles, for "what is within k hexes of X" queries (adjacency
+// bonuses, escort auras, privateers revealed when adjacent).
+//
+// Every tile heads an intrusive doubly linked list of the ids standing on it, so insert,
+// remove and move are O(1) and never allocate once the id range has been seen. Ids are
+// caller-chosen and should be small and stable (e.g. EntityHandle::index). Occupant counts
+// per square chunk of tiles let radius queries skip empty water in whole chunk strides.
+class HexSpatialIndex {
+public:
+    static constexpr uint32_t NONE = 0xFFFFFFFFu;
+
+    explicit HexSpatialIndex(const HexGrid& grid, int chunkSize = 8);
+
+    void reserve(size_t idCount);
+    void clear();
+
+    // tile must be inside the grid. Inserting a present id moves it and moving an absent
+    // one inserts it.
+    void insert(uint32_t id, int tile);
+    void remove(uint32_t id);
+    void move(uint32_t id, int tile);
+
+    bool contains(uint32_t id) const { return id < tiles.size() && tiles[id] >= 0; }
+    int tileOf(uint32_t id) const { return id < tiles.size() ? tiles[id] : -1; }
+    size_t size() const { return count; }
+
+    // fn(id) for every id on tile
+    template <typename Fn>
+    void forEachAt(int tile, Fn&& fn) const {
+        for (uint32_t id = heads[tile]; id != NONE; id = nexts[id]) fn(id);
+    }
+
+    // fn(id, tile) for every id within radius hexes of center, column by column like
+    // hexesInRadius() but without building the hex list. fn must not modify the index.
+    template <typename Fn>
+    void forEachInRadius(const HexCoord& center, int radius, Fn&& fn) const {
+        if (radius < 0) return;
+        int width = grid.getWidth();
+        int height = grid.getHeight();
+        glm::ivec2 origin = grid.getOrigin();
+
+        for (int dq = -radius; dq <= radius; ++dq) {
+            int q = center.q + dq;
+            int col = q - origin.x;
+            if (col < 0 || col >= width) continue;
+
+            // Each axial column is one offset column, so its hexes are a contiguous row span
+            int r1 = center.r + std::max(-radius, -dq - radius);
+            int r2 = center.r + std::min(radius, -dq + radius);
+            int rowLo = std::max(hexToOffset(HexCoord(q, r1)).y - origin.y, 0);
+            int rowHi = std::min(hexToOffset(HexCoord(q, r2)).y - origin.y, height - 1);
+
+            int chunkCol = col / chunkSize;
+            for (int row = rowLo; row <= rowHi;) {
+                int chunkRow = row / chunkSize;
+                int chunkEnd = std::min(rowHi, (chunkRow + 1) * chunkSize - 1);
+                if (chunkCounts[chunkRow * chunksX + chunkCol] == 0) {
+                    row = chunkEnd + 1;
+                    continue;
+                }
+                for (; row <= chunkEnd; ++row) {
+                    int tile = row * width + col;
+                    for (uint32_t id = heads[tile]; id != NONE; id = nexts[id]) fn(id, tile);
+                }
+            }
+        }
+    }
+
+    // Ids within radius of center, appended to out
+    void queryRadius(const HexCoord& center, int radius, std::vector<uint32_t>& out) const;
+
+    // One query per center, results packed back to back: the ids for centers[i] are
+    // ids[offsets[i] .. offsets[i + 1]). Both vectors are reused, so a batch run every turn
+    // stops allocating once they have grown to size.
+    void queryRadiusBatch(const std::vector<HexCoord>& centers, int radius,
+                          std::vector<uint32_t>& ids, std::vector<uint32_t>& offsets) const;
+
+    int chunkOf(int tile) const {
+        return (tile / grid.getWidth() / chunkSize) * chunksX + (tile % grid.getWidth()) / chunkSize;
+    }
+
+private:
+    const HexGrid& grid;
+    int chunkSize;
+    int chunksX;
+    size_t count = 0;
+
+    std::vector<uint32_t> heads;       // Per tile: first occupant
+    std::vector<uint32_t> chunkCounts; // Per chunk: number of occupants
+    std::vector<uint32_t> nexts;       // Per id
+    std::vector<uint32_t> prevs;       // Per id
+    std::vector<int32_t> tiles;        // Per id, -1 when absent
+
+    void link(uint32_t id, int tile);
+    void unlink(uint32_t id);
+};
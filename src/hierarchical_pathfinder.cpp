@@ -0,0 +1,485 @@
+#include "hierarchical_pathfinder.hpp"
+
+#include <algorithm>
+
+namespace {
+    // Runs of border crossings at least this long get entrances at both ends as well as the
+    // middle, so wide open borders don't force detours through a single gap
+    constexpr size_t LONG_RUN = 6;
+
+    struct Crossing {
+        int32_t inside;  // Tile in the chunk being scanned
+        int32_t outside; // Neighboring tile in the other chunk
+    };
+
+    // Bumps a stamp generation; on wrap-around the stamps are really reset once
+    template <typename Record>
+    void nextGeneration(std::vector<Record>& records, uint32_t& generation) {
+        if (++generation == 0) {
+            for (auto& record : records) {
+                record.openStamp = 0;
+                record.closedStamp = 0;
+            }
+            generation = 1;
+        }
+    }
+}
+
+HierarchicalPathfinder::HierarchicalPathfinder(const HexGrid& grid, const MovementProfile& profile, int chunkSize)
+    : grid(grid)
+    , profile(profile)
+    , chunkSize(std::max(chunkSize, 2))
+    , flat(grid)
+{
+    rebuild();
+}
+
+int HierarchicalPathfinder::chunkOf(int tileIndex) const {
+    int col = tileIndex % grid.getWidth();
+    int row = tileIndex / grid.getWidth();
+    return (row / chunkSize) * chunksX + col / chunkSize;
+}
+
+int HierarchicalPathfinder::getAbstractNodeCount() const {
+    size_t count = 0;
+    for (const auto& chunk : chunks) {
+        count += chunk.nodes.size();
+    }
+    return static_cast<int>(count);
+}
+
+bool HierarchicalPathfinder::isBorderTile(int tile) const {
+    int col = tile % grid.getWidth();
+    int row = tile / grid.getWidth();
+    int localCol = col % chunkSize;
+    int localRow = row % chunkSize;
+    return localCol == 0 || localRow == 0 || localCol == chunkSize - 1 || localRow == chunkSize - 1;
+}
+
+void HierarchicalPathfinder::collectNeighborChunks(int chunk, std::vector<int>& out) const {
+    out.clear();
+    int cx = chunk % chunksX;
+    int cy = chunk / chunksX;
+    // Odd-q neighbors never reach further than one chunk in each axis
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            if (dx == 0 && dy == 0) continue;
+            int nx = cx + dx;
+            int ny = cy + dy;
+            if (nx < 0 || ny < 0 || nx >= chunksX || ny >= chunksY) continue;
+            out.push_back(ny * chunksX + nx);
+        }
+    }
+}
+
+void HierarchicalPathfinder::rebuild() {
+    int tileCount = grid.size();
+    chunksX = (grid.getWidth() + chunkSize - 1) / chunkSize;
+    chunksY = (grid.getHeight() + chunkSize - 1) / chunkSize;
+
+    chunks.assign(static_cast<size_t>(chunksX) * chunksY, Chunk{});
+    nodeSlot.assign(tileCount, -1);
+    searchNodes.assign(tileCount, NodeRecord{0.0f, -1, 0, 0});
+    // A chunk has at most 4 * chunkSize - 4 border tiles, so a fixed stride keeps abstract ids
+    // stable across repairs; the last two ids are the query's start and goal
+    nodeStride = 4 * chunkSize;
+    size_t abstractCount = chunks.size() * nodeStride + 2;
+    abstractNodes.assign(abstractCount, NodeRecord{0.0f, -1, 0, 0});
+    searchGeneration = 0;
+    abstractGeneration = 0;
+    searchOpen.reserve(tileCount);
+    abstractOpen.reserve(static_cast<int>(abstractCount));
+
+    std::vector<int> neighbors;
+    for (int chunk = 0; chunk < static_cast<int>(chunks.size()); ++chunk) {
+        collectNeighborChunks(chunk, neighbors);
+        for (int other : neighbors) {
+            if (other > chunk) buildEntrances(chunk, other);
+        }
+    }
+    for (int chunk = 0; chunk < static_cast<int>(chunks.size()); ++chunk) {
+        rebuildNodes(chunk);
+        computeIntraCosts(chunk);
+    }
+}
+
+void HierarchicalPathfinder::onTileChanged(int tileIndex) {
+    if (tileIndex < 0 || tileIndex >= grid.size()) return;
+    int chunk = chunkOf(tileIndex);
+
+    if (!isBorderTile(tileIndex)) {
+        // Entrances only depend on border tiles, so the node set is unchanged
+        computeIntraCosts(chunk);
+        return;
+    }
+
+    collectNeighborChunks(chunk, neighborChunkScratch);
+    for (int other : neighborChunkScratch) {
+        // Same scan direction as rebuild() so a repair picks the same entrances
+        buildEntrances(std::min(chunk, other), std::max(chunk, other));
+    }
+    rebuildNodes(chunk);
+    computeIntraCosts(chunk);
+    for (int other : neighborChunkScratch) {
+        rebuildNodes(other);
+        computeIntraCosts(other);
+    }
+}
+
+void HierarchicalPathfinder::buildEntrances(int chunkA, int chunkB) {
+    auto removeEdgesInto = [&](Chunk& from, int target) {
+        auto& edges = from.interEdges;
+        edges.erase(std::remove_if(edges.begin(), edges.end(),
+                                   [&](const InterEdge& edge) { return chunkOf(edge.toTile) == target; }),
+                    edges.end());
+    };
+    removeEdgesInto(chunks[chunkA], chunkB);
+    removeEdgesInto(chunks[chunkB], chunkA);
+
+    // Scan A's border in row-major order; crossings into B come out ordered along the shared
+    // border, so runs are consecutive entries
+    std::vector<Crossing> crossings;
+    int width = grid.getWidth();
+    int colBegin = (chunkA % chunksX) * chunkSize;
+    int rowBegin = (chunkA / chunksX) * chunkSize;
+    int colEnd = std::min(colBegin + chunkSize, width);
+    int rowEnd = std::min(rowBegin + chunkSize, grid.getHeight());
+    std::array<int, 6> neighbors;
+    for (int row = rowBegin; row < rowEnd; ++row) {
+        for (int col = colBegin; col < colEnd; ++col) {
+            bool border = row == rowBegin || row == rowEnd - 1 || col == colBegin || col == colEnd - 1;
+            if (!border) continue;
+            int tile = row * width + col;
+            if (!passable(tile)) continue;
+
+            // HEX_DIRECTIONS order doesn't follow the border; sort this tile's crossings by
+            // index so consecutive outside tiles stay adjacent
+            size_t tileBegin = crossings.size();
+            grid.neighborIndices(tile, neighbors);
+            for (int next : neighbors) {
+                if (next < 0 || chunkOf(next) != chunkB || !passable(next)) continue;
+                crossings.push_back({tile, next});
+            }
+            std::sort(crossings.begin() + tileBegin, crossings.end(),
+                      [](const Crossing& a, const Crossing& b) { return a.outside < b.outside; });
+        }
+    }
+
+    auto addEntrance = [&](const Crossing& crossing) {
+        TerrainType insideType = grid.getType(crossing.inside);
+        TerrainType outsideType = grid.getType(crossing.outside);
+        HexCoord insideHex = grid.coordOf(crossing.inside);
+        HexCoord outsideHex = grid.coordOf(crossing.outside);
+        chunks[chunkA].interEdges.push_back({crossing.inside, crossing.outside, profile.entryCost(outsideType), outsideHex});
+        chunks[chunkB].interEdges.push_back({crossing.outside, crossing.inside, profile.entryCost(insideType), insideHex});
+    };
+
+    size_t runBegin = 0;
+    for (size_t i = 1; i <= crossings.size(); ++i) {
+        bool continues = i < crossings.size() &&
+            hexDistance(grid.coordOf(crossings[i].inside), grid.coordOf(crossings[i - 1].inside)) <= 1 &&
+            hexDistance(grid.coordOf(crossings[i].outside), grid.coordOf(crossings[i - 1].outside)) <= 1;
+        if (continues) continue;
+
+        size_t runLength = i - runBegin;
+        if (runLength >= LONG_RUN) {
+            addEntrance(crossings[runBegin]);
+            addEntrance(crossings[runBegin + runLength / 2]);
+            addEntrance(crossings[i - 1]);
+        } else if (runLength > 0) {
+            addEntrance(crossings[runBegin + runLength / 2]);
+        }
+        runBegin = i;
+    }
+}
+
+void HierarchicalPathfinder::rebuildNodes(int chunk) {
+    Chunk& data = chunks[chunk];
+    for (int32_t tile : data.nodes) {
+        nodeSlot[tile] = -1;
+    }
+
+    std::sort(data.interEdges.begin(), data.interEdges.end(),
+              [](const InterEdge& a, const InterEdge& b) { return a.fromTile < b.fromTile; });
+
+    data.nodes.clear();
+    data.nodeHexes.clear();
+    data.interStart.clear();
+    for (uint32_t i = 0; i < data.interEdges.size(); ++i) {
+        int32_t tile = data.interEdges[i].fromTile;
+        if (!data.nodes.empty() && data.nodes.back() == tile) continue;
+        nodeSlot[tile] = static_cast<int32_t>(data.nodes.size());
+        data.nodes.push_back(tile);
+        data.nodeHexes.push_back(grid.coordOf(tile));
+        data.interStart.push_back(i);
+    }
+    data.interStart.push_back(static_cast<uint32_t>(data.interEdges.size()));
+}
+
+void HierarchicalPathfinder::computeIntraCosts(int chunk) {
+    Chunk& data = chunks[chunk];
+    size_t count = data.nodes.size();
+    data.intraCost.assign(count * count, MovementProfile::IMPASSABLE);
+
+    for (size_t from = 0; from < count; ++from) {
+        chunkSearch(data.nodes[from], chunk, false, -1);
+        for (size_t to = 0; to < count; ++to) {
+            int32_t tile = data.nodes[to];
+            if (searchReached(tile)) {
+                data.intraCost[from * count + to] = searchNodes[tile].g;
+            }
+        }
+    }
+}
+
+bool HierarchicalPathfinder::chunkSearch(int source, int chunk, bool reverse, int target) {
+    nextGeneration(searchNodes, searchGeneration);
+    searchOpen.clear();
+
+    NodeRecord& sourceNode = searchNodes[source];
+    sourceNode.g = 0.0f;
+    sourceNode.parent = -1;
+    sourceNode.openStamp = searchGeneration;
+    searchOpen.push(source, 0.0f);
+
+    const std::vector<TerrainType>& types = grid.getTypes();
+    std::array<int, 6> neighbors;
+    while (!searchOpen.empty()) {
+        int current = searchOpen.pop().id;
+        NodeRecord& currentNode = searchNodes[current];
+        currentNode.closedStamp = searchGeneration;
+        if (current == target) return true;
+
+        // Reverse search walks edges backwards: stepping from current to next stands for the
+        // move next -> current, which costs entering current
+        float reverseStep = reverse ? profile.entryCost(types[current]) : 0.0f;
+
+        grid.neighborIndices(current, neighbors);
+        for (int next : neighbors) {
+            if (next < 0 || chunkOf(next) != chunk) continue;
+            NodeRecord& nextNode = searchNodes[next];
+            if (nextNode.closedStamp == searchGeneration) continue;
+
+            float entry = profile.entryCost(types[next]);
+            if (entry == MovementProfile::IMPASSABLE) continue;
+
+            float g = currentNode.g + (reverse ? reverseStep : entry);
+            if (nextNode.openStamp != searchGeneration) {
+                nextNode.g = g;
+                nextNode.parent = current;
+                nextNode.openStamp = searchGeneration;
+                searchOpen.push(next, g);
+            } else if (g < nextNode.g) {
+                nextNode.g = g;
+                nextNode.parent = current;
+                searchOpen.decreaseKey(next, g);
+            }
+        }
+    }
+    return target < 0;
+}
+
+bool HierarchicalPathfinder::findPath(int startIndex, int goalIndex, std::vector<int>& outPath, float* outCost) {
+    outPath.clear();
+    int tileCount = grid.size();
+    if (startIndex < 0 || goalIndex < 0 || startIndex >= tileCount || goalIndex >= tileCount) return false;
+    if (!passable(goalIndex)) return false;
+
+    int startChunk = chunkOf(startIndex);
+    int goalChunk = chunkOf(goalIndex);
+    if (startChunk == goalChunk ||
+        hexDistance(grid.coordOf(startIndex), grid.coordOf(goalIndex)) <= chunkSize) {
+        // Short hops: the abstract graph would cost more than it saves and can miss paths
+        // that leave the chunk and come back
+        return flat.findPath(startIndex, goalIndex, profile, outPath, outCost);
+    }
+
+    linkStart(startIndex, goalIndex);
+
+    // Link the goal chunk's entrances to the goal
+    const Chunk& goalData = chunks[goalChunk];
+    chunkSearch(goalIndex, goalChunk, true, -1);
+    goalLinkCost.assign(goalData.nodes.size(), MovementProfile::IMPASSABLE);
+    for (size_t i = 0; i < goalData.nodes.size(); ++i) {
+        int32_t tile = goalData.nodes[i];
+        if (searchReached(tile)) goalLinkCost[i] = searchNodes[tile].g;
+    }
+
+    if (startLinks.empty()) return false;
+    if (!abstractSearch(startIndex, goalIndex)) return false;
+
+    refine(outPath);
+    if (outCost) {
+        const std::vector<TerrainType>& types = grid.getTypes();
+        float cost = 0.0f;
+        for (size_t i = 1; i < outPath.size(); ++i) {
+            cost += profile.entryCost(types[outPath[i]]);
+        }
+        *outCost = cost;
+    }
+    return true;
+}
+
+bool HierarchicalPathfinder::findPath(const HexCoord& start, const HexCoord& goal, std::vector<HexCoord>& outPath,
+                                      float* outCost) {
+    outPath.clear();
+    if (!findPath(grid.indexOf(start), grid.indexOf(goal), indexScratch, outCost)) return false;
+
+    for (int index : indexScratch) {
+        outPath.push_back(grid.coordOf(index));
+    }
+    return true;
+}
+
+void HierarchicalPathfinder::linkStart(int startIndex, int goalIndex) {
+    startLinks.clear();
+    const int goalChunk = chunkOf(goalIndex);
+
+    auto linkFrom = [&](int via, float viaCost) {
+        int chunk = chunkOf(via);
+        chunkSearch(via, chunk, false, -1);
+        for (int32_t tile : chunks[chunk].nodes) {
+            if (searchReached(tile)) startLinks.push_back({tile, via, viaCost + searchNodes[tile].g});
+        }
+        // A neighbor of an impassable start can sit in the goal chunk itself
+        if (chunk == goalChunk && searchReached(goalIndex)) {
+            startLinks.push_back({goalIndex, via, viaCost + searchNodes[goalIndex].g});
+        }
+    };
+
+    if (passable(startIndex)) {
+        linkFrom(startIndex, 0.0f);
+        return;
+    }
+
+    // An impassable start is not an entrance even on a border, so step off it first
+    std::array<int, 6> neighbors;
+    grid.neighborIndices(startIndex, neighbors);
+    for (int next : neighbors) {
+        if (next >= 0 && passable(next)) linkFrom(next, profile.entryCost(grid.getType(next)));
+    }
+}
+
+bool HierarchicalPathfinder::abstractSearch(int startIndex, int goalIndex) {
+    nextGeneration(abstractNodes, abstractGeneration);
+    abstractOpen.clear();
+
+    const HexCoord goalHex = grid.coordOf(goalIndex);
+    const float hScale = profile.minCost;
+    const int goalChunk = chunkOf(goalIndex);
+    const int startId = static_cast<int>(abstractNodes.size()) - 2;
+    const int goalId = startId + 1;
+
+    auto relax = [&](int from, int to, const HexCoord& toHex, float g) {
+        NodeRecord& node = abstractNodes[to];
+        if (node.closedStamp == abstractGeneration) return;
+        if (node.openStamp != abstractGeneration) {
+            node.g = g;
+            node.parent = from;
+            node.openStamp = abstractGeneration;
+            float h = static_cast<float>(hexDistance(toHex, goalHex)) * hScale;
+            abstractOpen.push(to, g + h, h);
+        } else if (g < node.g) {
+            node.g = g;
+            node.parent = from;
+            float h = static_cast<float>(hexDistance(toHex, goalHex)) * hScale;
+            abstractOpen.decreaseKey(to, g + h, h);
+        }
+    };
+
+    NodeRecord& startNode = abstractNodes[startId];
+    startNode.g = 0.0f;
+    startNode.parent = -1;
+    startNode.openStamp = abstractGeneration;
+    abstractOpen.push(startId, 0.0f);
+
+    while (!abstractOpen.empty()) {
+        int current = abstractOpen.pop().id;
+        NodeRecord& currentNode = abstractNodes[current];
+        currentNode.closedStamp = abstractGeneration;
+        float g = currentNode.g;
+
+        if (current == goalId) {
+            abstractPath.clear();
+            for (int id = goalId; id != -1; id = abstractNodes[id].parent) {
+                if (id == goalId) {
+                    abstractPath.push_back(goalIndex);
+                } else if (id == startId) {
+                    abstractPath.push_back(startIndex);
+                } else {
+                    abstractPath.push_back(chunks[id / nodeStride].nodes[id % nodeStride]);
+                }
+            }
+            std::reverse(abstractPath.begin(), abstractPath.end());
+            return true;
+        }
+
+        if (current == startId) {
+            // Start links already hold the intra-chunk costs from the start tile (a start that
+            // is itself an entrance links to its own node at zero cost)
+            for (const Link& link : startLinks) {
+                int to = link.tile == goalIndex ? goalId : chunkOf(link.tile) * nodeStride + nodeSlot[link.tile];
+                relax(current, to, grid.coordOf(link.tile), g + link.cost);
+            }
+            continue;
+        }
+
+        int chunk = current / nodeStride;
+        int slot = current % nodeStride;
+        const Chunk& data = chunks[chunk];
+        int chunkBase = chunk * nodeStride;
+
+        size_t count = data.nodes.size();
+        const float* row = &data.intraCost[slot * count];
+        for (size_t to = 0; to < count; ++to) {
+            if (row[to] != MovementProfile::IMPASSABLE && static_cast<int>(to) != slot) {
+                relax(current, chunkBase + static_cast<int>(to), data.nodeHexes[to], g + row[to]);
+            }
+        }
+
+        for (uint32_t e = data.interStart[slot]; e < data.interStart[slot + 1]; ++e) {
+            const InterEdge& edge = data.interEdges[e];
+            int to = chunkOf(edge.toTile) * nodeStride + nodeSlot[edge.toTile];
+            relax(current, to, edge.toHex, g + edge.cost);
+        }
+
+        if (chunk == goalChunk && goalLinkCost[slot] != MovementProfile::IMPASSABLE) {
+            relax(current, goalId, goalHex, g + goalLinkCost[slot]);
+        }
+    }
+    return false;
+}
+
+void HierarchicalPathfinder::refine(std::vector<int>& outPath) {
+    int start = abstractPath[0];
+    outPath.push_back(start);
+
+    // The first abstract edge is a start link; several may reach the same tile, take the cheapest
+    const Link* firstLink = nullptr;
+    for (const Link& link : startLinks) {
+        if (link.tile == abstractPath[1] && (!firstLink || link.cost < firstLink->cost)) firstLink = &link;
+    }
+    int firstFrom = start;
+    if (firstLink->via != start) {
+        firstFrom = firstLink->via;
+        outPath.push_back(firstFrom);
+    }
+
+    for (size_t i = 1; i < abstractPath.size(); ++i) {
+        int from = i == 1 ? firstFrom : abstractPath[i - 1];
+        int to = abstractPath[i];
+        int chunk = chunkOf(from);
+        if (chunk != chunkOf(to)) {
+            // Inter-chunk edges join adjacent tiles
+            outPath.push_back(to);
+            continue;
+        }
+
+        chunkSearch(from, chunk, false, to);
+        segment.clear();
+        for (int node = to; node != from; node = searchNodes[node].parent) {
+            segment.push_back(node);
+        }
+        outPath.insert(outPath.end(), segment.rbegin(), segment.rend());
+    }
+}
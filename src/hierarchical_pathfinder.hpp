@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "hex_coord.hpp"
+#include "hex_grid.hpp"
+#include "indexed_heap.hpp"
+#include "pathfinding.hpp"
+
+// Hierarchical A* (HPA*) over square chunks of a HexGrid, for long routes where flat A*
+// expands too many tiles (e.g. naval trade lanes across a 1024x1024 map).
+//
+// Each pair of neighboring chunks is connected by entrances: one crossing per short run of
+// passable border tiles, plus both ends of a long run. Entrance tiles are the abstract nodes;
+// within a chunk every node pair is joined by a cached intra-chunk cost, and paired
+// entrance tiles by a single-step inter-chunk edge.
+// A query links start and goal to the nodes of their chunks, runs A* on the abstract graph
+// and then refines each abstract edge with a chunk-bounded search. Short queries (same
+// chunk or within one chunk width) go straight to flat A*.
+//
+// The graph is built for one MovementProfile. After changing a tile in the grid call
+// onTileChanged(): an interior tile only recomputes its chunk's intra costs; a border tile
+// also rebuilds the entrances it shares with the neighboring chunks.
+class HierarchicalPathfinder {
+public:
+    HierarchicalPathfinder(const HexGrid& grid, const MovementProfile& profile, int chunkSize = 16);
+
+    // Rebuild the whole abstract graph (after loading a new map)
+    void rebuild();
+
+    // Repair the abstract graph after grid.setType(tileIndex, ...)
+    void onTileChanged(int tileIndex);
+
+    // Near-optimal path from start to goal, both inclusive. Returns false (and clears
+    // outPath) when unreachable. outCost is the exact cost of the returned path.
+    bool findPath(int startIndex, int goalIndex, std::vector<int>& outPath, float* outCost = nullptr);
+    bool findPath(const HexCoord& start, const HexCoord& goal, std::vector<HexCoord>& outPath,
+                  float* outCost = nullptr);
+
+    int chunkOf(int tileIndex) const;
+    int getChunkSize() const { return chunkSize; }
+    int getChunkCount() const { return static_cast<int>(chunks.size()); }
+    int getAbstractNodeCount() const;
+
+private:
+    struct InterEdge {
+        int32_t fromTile;
+        int32_t toTile; // Entrance tile in the neighboring chunk
+        float cost;     // Entry cost of toTile
+        HexCoord toHex;
+    };
+
+    struct Chunk {
+        std::vector<int32_t> nodes;        // Entrance tiles, sorted
+        std::vector<HexCoord> nodeHexes;   // Coordinates of nodes, for the abstract heuristic
+        std::vector<float> intraCost;      // nodes.size()^2, row = from node
+        std::vector<InterEdge> interEdges; // Sorted by fromTile
+        std::vector<uint32_t> interStart;  // Per node offset into interEdges (nodes.size() + 1)
+    };
+
+    struct NodeRecord {
+        float g;
+        int32_t parent;
+        uint32_t openStamp;
+        uint32_t closedStamp;
+    };
+
+    // Abstract edge out of the start tile. `via` is the first tile entered: the start itself
+    // when passable, otherwise one of its passable neighbors (a ship leaving a port city)
+    struct Link {
+        int32_t tile;
+        int32_t via;
+        float cost;
+    };
+
+    const HexGrid& grid;
+    MovementProfile profile;
+    int chunkSize;
+    int chunksX = 0;
+    int chunksY = 0;
+
+    std::vector<Chunk> chunks;
+    std::vector<int32_t> nodeSlot; // Per tile: index into its chunk's nodes, or -1
+
+    // Chunk-bounded Dijkstra state
+    std::vector<NodeRecord> searchNodes;
+    uint32_t searchGeneration = 0;
+    IndexedMinHeap searchOpen;
+
+    // Abstract A* state, indexed by chunk * nodeStride + slot so it stays compact
+    int nodeStride = 0;
+    std::vector<NodeRecord> abstractNodes;
+    uint32_t abstractGeneration = 0;
+    IndexedMinHeap abstractOpen;
+
+    // Query scratch (reused, never shrunk)
+    std::vector<Link> startLinks;
+    std::vector<float> goalLinkCost; // Per node of the goal chunk
+    std::vector<int32_t> abstractPath;
+    std::vector<int32_t> segment;
+    std::vector<int> neighborChunkScratch;
+    std::vector<int> indexScratch;
+
+    HexPathfinder flat;
+
+    bool passable(int tile) const { return profile.passable(grid.getType(tile)); }
+    bool isBorderTile(int tile) const;
+    void collectNeighborChunks(int chunk, std::vector<int>& out) const;
+
+    void buildEntrances(int chunkA, int chunkB);
+    void rebuildNodes(int chunk);
+    void computeIntraCosts(int chunk);
+
+    // Dijkstra restricted to one chunk. Forward: cost from source to each tile; reverse:
+    // cost from each tile to source. Stops early once target (if >= 0) is settled.
+    bool chunkSearch(int source, int chunk, bool reverse, int target);
+    bool searchReached(int tile) const { return searchNodes[tile].closedStamp == searchGeneration; }
+
+    void linkStart(int startIndex, int goalIndex);
+    bool abstractSearch(int startIndex, int goalIndex);
+    void refine(std::vector<int>& outPath);
+};
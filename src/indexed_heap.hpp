@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Binary min-heap of node ids keyed by float, with decrease-key.
+// Positions are kept in a dense array indexed by node id; they are only meaningful for ids
+// currently in the heap, so callers track membership themselves (e.g. with generation
+// stamps) and the array never needs clearing between queries.
+// Ties on `key` are broken by the smaller `tie` value.
+class IndexedMinHeap {
+public:
+    struct Entry {
+        float key;
+        float tie;
+        int32_t id;
+    };
+
+    // Size the position table for ids in [0, idCount); allocation happens only here
+    void reserve(int idCount) {
+        if (static_cast<int>(positions.size()) < idCount) {
+            positions.resize(idCount);
+        }
+        if (static_cast<int>(entries.capacity()) < idCount) {
+            entries.reserve(idCount);
+        }
+    }
+
+    bool empty() const { return entries.empty(); }
+    size_t size() const { return entries.size(); }
+    void clear() { entries.clear(); }
+
+    const Entry& top() const { return entries.front(); }
+
+    void push(int32_t id, float key, float tie = 0.0f) {
+        entries.push_back({key, tie, id});
+        siftUp(entries.size() - 1);
+    }
+
+    // Lower the key of an id already in the heap
+    void decreaseKey(int32_t id, float key, float tie = 0.0f) {
+        size_t i = positions[id];
+        entries[i].key = key;
+        entries[i].tie = tie;
+        siftUp(i);
+    }
+
+    Entry pop() {
+        Entry result = entries.front();
+        Entry last = entries.back();
+        entries.pop_back();
+        if (!entries.empty()) {
+            entries[0] = last;
+            positions[last.id] = 0;
+            siftDown(0);
+        }
+        return result;
+    }
+
+private:
+    std::vector<Entry> entries;
+    std::vector<uint32_t> positions;
+
+    static bool less(const Entry& a, const Entry& b) {
+        return a.key < b.key || (a.key == b.key && a.tie < b.tie);
+    }
+
+    void siftUp(size_t i) {
+        Entry moving = entries[i];
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!less(moving, entries[parent])) break;
+            entries[i] = entries[parent];
+            positions[entries[i].id] = static_cast<uint32_t>(i);
+            i = parent;
+        }
+        entries[i] = moving;
+        positions[moving.id] = static_cast<uint32_t>(i);
+    }
+
+    void siftDown(size_t i) {
+        Entry moving = entries[i];
+        size_t count = entries.size();
+        while (true) {
+            size_t child = 2 * i + 1;
+            if (child >= count) break;
+            if (child + 1 < count && less(entries[child + 1], entries[child])) ++child;
+            if (!less(entries[child], moving)) break;
+            entries[i] = entries[child];
+            positions[entries[i].id] = static_cast<uint32_t>(i);
+            i = child;
+        }
+        entries[i] = moving;
+        positions[moving.id] = static_cast<uint32_t>(i);
+    }
+};
@@ -0,0 +1,196 @@
+#include "influence_map.hpp"
+
+#include <algorithm>
+#include <thread>
+#include "parallel_for.hpp"
+
+InfluenceMap::InfluenceMap(const HexGrid& grid, int layerCount, const MovementProfile& profile, int threadCount)
+    : grid(grid)
+    , profile(profile)
+    , threadCount(threadCount > 0 ? threadCount : std::max(1, static_cast<int>(std::thread::hardware_concurrency())))
+    , layers(static_cast<size_t>(std::max(layerCount, 0)), std::vector<float>(static_cast<size_t>(grid.size()), 0.0f))
+{}
+
+InfluenceSourceId InfluenceMap::addSource(int layer, int tile, float strength, float range) {
+    InfluenceSourceId id;
+    if (!freeSources.empty()) {
+        id = freeSources.back();
+        freeSources.pop_back();
+    } else {
+        id = static_cast<InfluenceSourceId>(sources.size());
+        sources.emplace_back();
+    }
+
+    Source& source = sources[id];
+    source.layer = layer;
+    source.tile = tile;
+    source.strength = strength;
+    source.range = range;
+    source.alive = true;
+    source.dirty = false;
+    source.cols = 0;
+    source.rows = 0;
+    markDirty(id);
+    return id;
+}
+
+void InfluenceMap::removeSource(InfluenceSourceId id) {
+    Source& source = sources[id];
+    if (!source.alive) return;
+    // Pending sources are still summed under their old patch; update() drops them
+    accumulate(source, -1.0f);
+    source.alive = false;
+    source.cols = 0;
+    source.rows = 0;
+    freeSources.push_back(id);
+}
+
+void InfluenceMap::markDirty(InfluenceSourceId id) {
+    Source& source = sources[id];
+    if (!source.alive || source.dirty) return;
+    source.dirty = true;
+    pending.push_back(id);
+}
+
+void InfluenceMap::moveSource(InfluenceSourceId id, int tile) {
+    if (sources[id].tile == tile) return;
+    sources[id].tile = tile;
+    markDirty(id);
+}
+
+void InfluenceMap::setStrength(InfluenceSourceId id, float strength) {
+    Source& source = sources[id];
+    if (!source.alive || source.strength == strength) return;
+    if (source.dirty || source.strength == 0.0f) {
+        source.strength = strength;
+        markDirty(id);
+        return;
+    }
+    // Same reach, so rescale the patch in place instead of searching again
+    accumulate(source, -1.0f);
+    float scale = strength / source.strength;
+    for (float& value : source.patch) value *= scale;
+    source.strength = strength;
+    accumulate(source, 1.0f);
+}
+
+void InfluenceMap::setRange(InfluenceSourceId id, float range) {
+    if (sources[id].range == range) return;
+    sources[id].range = range;
+    markDirty(id);
+}
+
+void InfluenceMap::onTileChanged(int tileIndex) {
+    int col = tileIndex % grid.getWidth();
+    int row = tileIndex / grid.getWidth();
+    // A cheaper tile can only extend a source's reach if it borders the current patch
+    for (InfluenceSourceId id = 0; id < sources.size(); ++id) {
+        const Source& source = sources[id];
+        if (!source.alive || source.cols == 0) continue;
+        if (col >= source.col0 - 1 && col <= source.col0 + source.cols &&
+            row >= source.row0 - 1 && row <= source.row0 + source.rows) {
+            markDirty(id);
+        }
+    }
+}
+
+void InfluenceMap::accumulate(const Source& source, float sign) {
+    std::vector<float>& field = layers[source.layer];
+    int width = grid.getWidth();
+    for (int r = 0; r < source.rows; ++r) {
+        float* dst = field.data() + static_cast<size_t>(source.row0 + r) * width + source.col0;
+        const float* src = source.patch.data() + static_cast<size_t>(r) * source.cols;
+        for (int c = 0; c < source.cols; ++c) dst[c] += sign * src[c];
+    }
+}
+
+void InfluenceMap::buildPatch(Source& source, MovementRangeFinder& finder, MovementRange& range) {
+    source.cols = 0;
+    source.rows = 0;
+    if (source.tile < 0 || source.tile >= grid.size()) return;
+
+    float reach = std::max(source.range, 0.0f);
+    finder.compute(source.tile, reach, profile, range);
+
+    int width = grid.getWidth();
+    int colMin = width, colMax = -1, rowMin = grid.getHeight(), rowMax = -1;
+    for (int32_t tile : range.tiles) {
+        colMin = std::min(colMin, tile % width);
+        colMax = std::max(colMax, tile % width);
+        rowMin = std::min(rowMin, tile / width);
+        rowMax = std::max(rowMax, tile / width);
+    }
+
+    source.col0 = colMin;
+    source.row0 = rowMin;
+    source.cols = colMax - colMin + 1;
+    source.rows = rowMax - rowMin + 1;
+    source.patch.assign(static_cast<size_t>(source.cols) * source.rows, 0.0f);
+    for (size_t i = 0; i < range.tiles.size(); ++i) {
+        int tile = range.tiles[i];
+        float falloff = reach > 0.0f ? 1.0f - range.costs[i] / reach : 1.0f;
+        source.patch[static_cast<size_t>(tile / width - rowMin) * source.cols + (tile % width - colMin)] =
+            source.strength * falloff;
+    }
+}
+
+size_t InfluenceMap::update() {
+    // A slot can be queued twice if it was removed and reused before an update
+    std::sort(pending.begin(), pending.end());
+    pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+    pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                 [&](InfluenceSourceId id) { return !sources[id].alive; }),
+                  pending.end());
+    if (pending.empty()) return 0;
+
+    for (InfluenceSourceId id : pending) accumulate(sources[id], -1.0f);
+
+    int workers = std::min(threadCount, static_cast<int>(pending.size()));
+    while (static_cast<int>(finders.size()) < workers) {
+        finders.emplace_back(grid);
+        ranges.emplace_back();
+    }
+    parallelFor(pending.size(), workers, [&](size_t begin, size_t end, int worker) {
+        for (size_t job = begin; job < end; ++job) {
+            buildPatch(sources[pending[job]], finders[worker], ranges[worker]);
+        }
+    });
+
+    // Sources of one layer overlap, so the sums stay on this thread
+    for (InfluenceSourceId id : pending) {
+        accumulate(sources[id], 1.0f);
+        sources[id].dirty = false;
+    }
+
+    size_t rebuilt = pending.size();
+    pending.clear();
+    return rebuilt;
+}
+
+void InfluenceMap::resum() {
+    for (auto& layer : layers) std::fill(layer.begin(), layer.end(), 0.0f);
+    for (const Source& source : sources) {
+        if (source.alive) accumulate(source, 1.0f);
+    }
+}
+
+void InfluenceMap::sampleBatch(int layer, const std::vector<int32_t>& tiles, std::vector<float>& out) const {
+    const std::vector<float>& field = layers[layer];
+    out.resize(tiles.size());
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        out[i] = field[tiles[i]];
+    }
+}
+
+int InfluenceMap::strongestLayer(int tile, int firstLayer, int count, float minimum) const {
+    int best = -1;
+    float bestValue = minimum;
+    for (int layer = firstLayer; layer < firstLayer + count; ++layer) {
+        float value = layers[layer][tile];
+        if (value > bestValue) {
+            best = layer;
+            bestValue = value;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "hex_grid.hpp"
+#include "movement_range.hpp"
+
+using InfluenceSourceId = uint32_t;
+
+// Dense per-tile influence fields (military threat, trade value, culture, ...) for AI
+// scoring and zone of control. Layers are plain indices; a game typically uses one threat
+// layer per player so the strongest layer on a tile names its controller.
+//
+// Each source spreads strength * (1 - cost / range) over every tile it can reach within
+// range, where cost is the summed entry cost along the cheapest path under the map's
+// MovementProfile (TerrainProperties::movementCost by default). A layer is the sum of its
+// sources.
+//
+// Every source keeps its contribution as a dense patch over its bounding rectangle of
+// tiles, so adding or removing it is a sweep of contiguous row spans that the compiler can
+// vectorize. Moving, re-weighting or re-ranging a source only marks it dirty; update()
+// subtracts the old patches, recomputes the dirty ones across worker threads (each with
+// its own MovementRangeFinder) and adds them back. The rest of the layer is untouched.
+class InfluenceMap {
+public:
+    // threadCount 0 uses hardware_concurrency
+    InfluenceMap(const HexGrid& grid, int layerCount, const MovementProfile& profile = MovementProfile::allTerrain(),
+                 int threadCount = 0);
+
+    // Sources take effect on the next update()
+    InfluenceSourceId addSource(int layer, int tile, float strength, float range);
+    void removeSource(InfluenceSourceId id);
+    void moveSource(InfluenceSourceId id, int tile);
+    void setStrength(InfluenceSourceId id, float strength);
+    void setRange(InfluenceSourceId id, float range);
+
+    // Call after grid.setType(tileIndex, ...); dirties every source whose reach may change
+    void onTileChanged(int tileIndex);
+
+    // Apply pending source changes; returns how many patches were recomputed
+    size_t update();
+
+    // Subtract-and-add updates drift by float rounding over many turns; this re-sums every
+    // layer from the stored patches without re-running any search
+    void resum();
+
+    int getLayerCount() const { return static_cast<int>(layers.size()); }
+    const std::vector<float>& getLayer(int layer) const { return layers[layer]; }
+    float sample(int layer, int tile) const { return layers[layer][tile]; }
+
+    // out[i] = sample(layer, tiles[i])
+    void sampleBatch(int layer, const std::vector<int32_t>& tiles, std::vector<float>& out) const;
+
+    // Layer in [firstLayer, firstLayer + count) with the most influence on tile, or -1 when
+    // none exceeds minimum
+    int strongestLayer(int tile, int firstLayer, int count, float minimum = 0.0f) const;
+
+private:
+    struct Source {
+        int layer = 0;
+        int tile = -1;
+        float strength = 0.0f;
+        float range = 0.0f;
+        bool alive = false;
+        bool dirty = false;
+
+        // Contribution over tiles [row0, row0 + rows) x [col0, col0 + cols), row-major
+        int col0 = 0;
+        int row0 = 0;
+        int cols = 0;
+        int rows = 0;
+        std::vector<float> patch;
+    };
+
+    const HexGrid& grid;
+    MovementProfile profile;
+    int threadCount;
+
+    std::vector<std::vector<float>> layers;
+    std::vector<Source> sources;
+    std::vector<InfluenceSourceId> freeSources;
+    std::vector<InfluenceSourceId> pending;
+
+    // One of each per worker
+    std::vector<MovementRangeFinder> finders;
+    std::vector<MovementRange> ranges;
+
+    void markDirty(InfluenceSourceId id);
+    void buildPatch(Source& source, MovementRangeFinder& finder, MovementRange& range);
+    void accumulate(const Source& source, float sign);
+};
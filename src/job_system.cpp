@@ -0,0 +1,199 @@
+#include "job_system.hpp"
+
+#include <algorithm>
+
+namespace {
+
+thread_local int currentWorkerIndex = -1;
+
+} // namespace
+
+JobId JobGraph::add(std::function<void()> fn) {
+    Node node;
+    node.single = std::move(fn);
+    nodes.push_back(std::move(node));
+    return static_cast<JobId>(nodes.size() - 1);
+}
+
+JobId JobGraph::addParallel(size_t count, size_t grain, std::function<void(size_t, size_t)> fn) {
+    Node node;
+    node.loop = std::move(fn);
+    node.count = count;
+    node.grain = std::max<size_t>(grain, 1);
+    // An empty loop still runs as one (empty) chunk so its successors get released
+    node.chunkCount = static_cast<uint32_t>(std::max<size_t>((count + node.grain - 1) / node.grain, 1));
+    nodes.push_back(std::move(node));
+    return static_cast<JobId>(nodes.size() - 1);
+}
+
+void JobGraph::precede(JobId before, JobId after) {
+    nodes[before].successors.push_back(after);
+    ++nodes[after].predecessorCount;
+}
+
+JobSystem::JobSystem(int threadCount)
+    : queues(static_cast<size_t>(threadCount > 0 ? threadCount
+                                                 : std::max(1, static_cast<int>(std::thread::hardware_concurrency()))))
+{
+    threads.reserve(queues.size() - 1);
+    for (int worker = 1; worker < static_cast<int>(queues.size()); ++worker) {
+        threads.emplace_back([this, worker]() { workerLoop(worker); });
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    threads.clear(); // Joins
+}
+
+void JobSystem::notifyAll() {
+    // Taking the lock orders this against a worker between checking its wait predicate and
+    // going to sleep, so the wake-up can't be lost
+    { std::lock_guard<std::mutex> lock(mutex); }
+    wake.notify_all();
+}
+
+void JobSystem::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [&]() { return busyWorkers == 0; });
+}
+
+void JobSystem::run(JobGraph& jobGraph) {
+    size_t nodeCount = jobGraph.nodes.size();
+    if (nodeCount == 0) return;
+
+    // Stragglers from the previous run may still be leaving process(); they only touch the
+    // queues and counters, but wait for them before the per-node state is rewritten
+    waitIdle();
+
+    graph = &jobGraph;
+    if (stateCapacity < nodeCount) {
+        pendingPredecessors = std::make_unique<std::atomic<uint32_t>[]>(nodeCount);
+        pendingChunks = std::make_unique<std::atomic<uint32_t>[]>(nodeCount);
+        stateCapacity = nodeCount;
+    }
+    for (size_t i = 0; i < nodeCount; ++i) {
+        pendingPredecessors[i].store(jobGraph.nodes[i].predecessorCount, std::memory_order_relaxed);
+        pendingChunks[i].store(jobGraph.nodes[i].chunkCount, std::memory_order_relaxed);
+    }
+    error = nullptr;
+    pendingNodes.store(nodeCount);
+
+    for (JobId node = 0; node < nodeCount; ++node) {
+        if (jobGraph.nodes[node].predecessorCount == 0) pushReady(0, node);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++runGeneration;
+        ++busyWorkers; // The caller
+    }
+    wake.notify_all();
+
+    process(0);
+    waitIdle();
+    graph = nullptr;
+
+    if (error) std::rethrow_exception(error);
+}
+
+void JobSystem::workerLoop(int worker) {
+    uint64_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return stopping || runGeneration != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = runGeneration;
+            ++busyWorkers;
+        }
+        process(worker);
+    }
+}
+
+int JobSystem::currentWorker() {
+    return currentWorkerIndex;
+}
+
+// Entered with busyWorkers already counting this worker
+void JobSystem::process(int worker) {
+    currentWorkerIndex = worker;
+    Task task;
+    while (pendingNodes.load() > 0) {
+        if (pop(worker, task) || steal(worker, task)) {
+            execute(worker, task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&]() { return pendingNodes.load() == 0 || queuedTasks.load() > 0 || stopping; });
+        if (stopping) break;
+    }
+    currentWorkerIndex = -1;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--busyWorkers == 0) idle.notify_all();
+}
+
+bool JobSystem::pop(int worker, Task& task) {
+    WorkerQueue& queue = queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.empty()) return false;
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    queue.rewindIfEmpty();
+    --queuedTasks;
+    return true;
+}
+
+bool JobSystem::steal(int worker, Task& task) {
+    int workerCount = static_cast<int>(queues.size());
+    for (int offset = 1; offset < workerCount; ++offset) {
+        WorkerQueue& queue = queues[(worker + offset) % workerCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.empty()) continue;
+        task = queue.tasks[queue.head++];
+        queue.rewindIfEmpty();
+        --queuedTasks;
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::pushReady(int worker, JobId node) {
+    const JobGraph::Node& ready = graph->nodes[node];
+    {
+        WorkerQueue& queue = queues[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        // Pushed in reverse so the owner pops chunk 0 first
+        for (uint32_t chunk = ready.chunkCount; chunk-- > 0;) {
+            queue.tasks.push_back(Task{node, chunk});
+        }
+        queuedTasks += ready.chunkCount;
+    }
+    if (queues.size() > 1) notifyAll();
+}
+
+void JobSystem::execute(int worker, const Task& task) {
+    const JobGraph::Node& node = graph->nodes[task.node];
+    try {
+        if (node.loop) {
+            size_t begin = static_cast<size_t>(task.chunk) * node.grain;
+            node.loop(begin, std::min(node.count, begin + node.grain));
+        } else if (node.single) {
+            node.single();
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error) error = std::current_exception();
+    }
+
+    if (pendingChunks[task.node].fetch_sub(1) != 1) return;
+
+    // Last chunk of this job: release the successors, then retire the job
+    for (JobId next : node.successors) {
+        if (pendingPredecessors[next].fetch_sub(1) == 1) pushReady(worker, next);
+    }
+    if (pendingNodes.fetch_sub(1) == 1) notifyAll();
+}
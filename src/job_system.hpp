@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using JobId = uint32_t;
+
+// A dependency graph of jobs for one JobSystem::run(). A job is either a single call or a
+// parallel loop split into fixed chunks; a job starts once every job preceding it is done.
+//
+// Chunk boundaries depend only on count and grain, never on the number of threads, so a
+// system that keeps one partial result per chunk and reduces them in chunk order produces
+// the same output on any thread count.
+class JobGraph {
+public:
+    JobId add(std::function<void()> fn);
+
+    // fn(begin, end) over [0, count) in chunks of grain items; chunk i is
+    // [i * grain, min(count, (i + 1) * grain))
+    JobId addParallel(size_t count, size_t grain, std::function<void(size_t, size_t)> fn);
+
+    // after won't start until before has finished
+    void precede(JobId before, JobId after);
+
+    // Drop every job but keep the storage for the next graph
+    void clear() { nodes.clear(); }
+    size_t size() const { return nodes.size(); }
+
+private:
+    friend class JobSystem;
+
+    struct Node {
+        std::function<void()> single;
+        std::function<void(size_t, size_t)> loop;
+        size_t count = 1;
+        size_t grain = 1;
+        uint32_t chunkCount = 1;
+        uint32_t predecessorCount = 0;
+        std::vector<JobId> successors;
+    };
+
+    std::vector<Node> nodes;
+};
+
+// Persistent work-stealing thread pool.
+//
+// Each worker owns a deque of ready chunks: it pushes and pops at the back and steals from
+// the front of the others, so a worker keeps running the chunks it just made ready while
+// idle workers take the oldest work. The thread calling run() is worker 0 and helps until
+// the graph is done.
+class JobSystem {
+public:
+    // Total workers including the caller; 0 uses hardware_concurrency
+    explicit JobSystem(int threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Run every job in graph and wait for them. The first exception thrown by a job is
+    // rethrown here once the rest of the graph has finished.
+    void run(JobGraph& graph);
+
+    int getWorkerCount() const { return static_cast<int>(queues.size()); }
+
+    // Index of the worker running the calling job, in [0, getWorkerCount()), or -1 outside
+    // a job. Lets jobs keep per-worker state (pools, scratch) without locking.
+    static int currentWorker();
+
+private:
+    struct Task {
+        JobId node;
+        uint32_t chunk;
+    };
+
+    // The owner takes from the back and thieves from head. Emptied queues rewind to the start,
+    // so the storage is reused from run to run instead of reallocated as a deque would.
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::vector<Task> tasks;
+        size_t head = 0;
+
+        bool empty() const { return head == tasks.size(); }
+        void rewindIfEmpty() {
+            if (empty()) {
+                tasks.clear();
+                head = 0;
+            }
+        }
+    };
+
+    std::vector<WorkerQueue> queues;
+    std::vector<std::jthread> threads;
+
+    // Sleep/wake for idle workers, and for run() to wait until every worker has left process()
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    uint64_t runGeneration = 0;
+    int busyWorkers = 0; // Inside process(), counted under mutex
+    bool stopping = false;
+
+    // State of the current run
+    JobGraph* graph = nullptr;
+    std::unique_ptr<std::atomic<uint32_t>[]> pendingPredecessors;
+    std::unique_ptr<std::atomic<uint32_t>[]> pendingChunks;
+    size_t stateCapacity = 0;
+    std::atomic<size_t> pendingNodes{0};
+    std::atomic<size_t> queuedTasks{0};
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    void workerLoop(int worker);
+    void process(int worker);
+    bool pop(int worker, Task& task);
+    bool steal(int worker, Task& task);
+    void execute(int worker, const Task& task);
+    void pushReady(int worker, JobId node);
+    void notifyAll();
+    void waitIdle();
+};
@@ -7,6 +7,10 @@
 #include <memory>
 #include <chrono>
 #include <thread>
+#include <optional>
+#include <atomic>
+#include <cstdlib>
+#include <new>
 
 #include "device.hpp"
 #include "buffer.hpp"
@@ -19,6 +23,28 @@
 #include <glm/glm.hpp>
 #include "render_graph.hpp"
 #include "hex_coord.hpp"
+#include "job_system.hpp"
+#include "turn_simulation.hpp"
+
+#ifdef COUNT_HEAP_ALLOCATIONS
+// Every heap allocation the process makes, so the periodic report can show what a frame
+// costs. Profiling builds only (-DCOUNT_HEAP_ALLOCATIONS=ON): it replaces the global allocator.
+static std::atomic<uint64_t> heapAllocations{0};
+
+void* operator new(std::size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+#endif
 
 // Colored vertex structure for the triangle
 struct ColoredVertex {
@@ -245,14 +271,176 @@ int main() {
         Swapchain swapchain;
         createSwapchain(device, surface, window, swapchain);
 
+        // Create persistent render graph to track image layouts across frames. It owns the
+        // frame's targets and lays out their memory by when passes use them.
+        RenderGraph graph;
+        std::unique_ptr<TerrainExample> terrainExample;
+
+        // Compute passes overlap graphics on a second queue if the device has one
+        if (graph.enableAsyncCompute(device)) {
+            std::cout << "Render graph: async compute enabled" << std::endl;
+        } else {
+            std::cout << "Render graph: no second queue, compute passes run on the graphics queue" << std::endl;
+        }
+
+        // Per-pass GPU and CPU timings, reported with the record timings; F12 writes a trace
+        graph.enableProfiling(device);
+        bool traceKeyWasDown = false;
+
+        // F11 toggles printing the heap, record and pass stats every few seconds
+        bool statsReport = false;
+        bool statsKeyWasDown = false;
+
+        // Create the frame targets, declare the frame's passes and compile them. Needed at
+        // startup and after the swapchain is recreated.
+        auto buildFrameGraph = [&]() {
+            graph.destroyTransientImages(device);
+
+            std::vector<std::pair<Image*, uint32_t>> targets;
+            auto createTarget = [&](Image& target, VkFormat format, VkSampleCountFlagBits samples, VkImageUsageFlags usage) {
+                TransientImageDesc desc{};
+                desc.format = format;
+                desc.extent = swapchain.extent;
+                desc.samples = samples;
+                desc.usage = usage;
+                uint32_t handle = graph.createTransientImage(device, desc);
+                target = graph.getTransientImage(handle);
+                targets.emplace_back(&target, handle);
+            };
+            swapchain.msaaColor = {};
+            if (swapchain.msaaSamples != VK_SAMPLE_COUNT_1_BIT) {
+                createTarget(swapchain.msaaColor, swapchain.format, swapchain.msaaSamples, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+            }
+            createTarget(swapchain.depthImage, swapchain.depthFormat, swapchain.msaaSamples,
+                         VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+            createTarget(swapchain.ssaoImage, swapchain.ssaoFormat, VK_SAMPLE_COUNT_1_BIT,
+                         VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+            createTarget(swapchain.sceneColor, swapchain.format, VK_SAMPLE_COUNT_1_BIT,
+                         VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+            createTarget(swapchain.depthResolved, swapchain.depthFormat, VK_SAMPLE_COUNT_1_BIT,
+                         VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+
+            // Depth prepass - depth only, no color
+            RenderAttachment depthAtt{};
+            depthAtt.extent = swapchain.extent;
+            depthAtt.samples = swapchain.msaaSamples;
+            depthAtt.depthFormat = swapchain.depthFormat;
+            depthAtt.depthView = swapchain.depthImage.view;
+            depthAtt.depthImage = swapchain.depthImage.image;
+            // Resolve depth to single-sample for SSAO
+            depthAtt.depthResolveView = swapchain.depthResolved.view;
+            depthAtt.depthResolveImage = swapchain.depthResolved.image;
+            // No color attachments for depth prepass
+
+            RenderPassDesc depthPass{};
+            depthPass.name = "depth_prepass";
+            depthPass.attachments = depthAtt;
+            depthPass.clearDepth = 1.0f;
+            depthPass.clearStencil = 0;
+            depthPass.depthLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            depthPass.record = [&](VkCommandBuffer c) {
+                terrainExample->renderDepthOnly(c);
+            };
+
+            graph.addPass(depthPass);
+
+            // SSAO pass - writes occlusion to R8 texture, samples resolved depth
+            RenderAttachment ssaoAtt{};
+            ssaoAtt.extent = swapchain.extent;
+            ssaoAtt.samples = VK_SAMPLE_COUNT_1_BIT;
+            ssaoAtt.colorFormat = swapchain.ssaoFormat;
+            ssaoAtt.colorView = swapchain.ssaoImage.view;
+            ssaoAtt.colorImage = swapchain.ssaoImage.image;
+
+            RenderPassDesc ssaoPass{};
+            ssaoPass.name = "ssao";
+            ssaoPass.attachments = ssaoAtt;
+            ssaoPass.clearColor = {{1.0f, 0.0f, 0.0f, 0.0f}}; // occlusion default = 1
+            ssaoPass.images.push_back(ImageAccess{swapchain.depthResolved.image, swapchain.depthFormat,
+                                                  ImageUsage::SampledFragment});
+            ssaoPass.record = [&](VkCommandBuffer c) {
+                terrainExample->renderSSAO(c);
+            };
+
+            graph.addPass(ssaoPass);
+
+            // Main pass - color + depth (load depth from prepass); render into sceneColor for post
+            RenderAttachment att{};
+            att.extent = swapchain.extent;
+            att.samples = swapchain.msaaSamples;
+            att.colorFormat = swapchain.format;
+            att.depthFormat = swapchain.depthFormat;
+            if (swapchain.msaaSamples != VK_SAMPLE_COUNT_1_BIT) {
+                att.colorView = swapchain.msaaColor.view;
+                att.colorImage = swapchain.msaaColor.image;
+                att.resolveView = swapchain.sceneColor.view;
+                att.resolveImage = swapchain.sceneColor.image;
+            } else {
+                att.colorView = swapchain.sceneColor.view;
+                att.colorImage = swapchain.sceneColor.image;
+            }
+            att.depthView = swapchain.depthImage.view;
+            att.depthImage = swapchain.depthImage.image;
+
+            RenderPassDesc pass{};
+            pass.name = "terrain";
+            pass.attachments = att;
+            pass.clearColor = {{0.05f, 0.05f, 0.08f, 1.0f}};
+            pass.clearDepth = 1.0f;
+            pass.clearStencil = 0;
+            pass.depthLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD; // Load depth from prepass
+            pass.images.push_back(ImageAccess{swapchain.ssaoImage.image, swapchain.ssaoFormat, ImageUsage::SampledFragment});
+            pass.record = [&](VkCommandBuffer c) {
+                terrainExample->render(c);
+            };
+
+            graph.addPass(pass);
+
+            // Tilt-shift post-process: write to swapchain, sample sceneColor and depthResolved
+            RenderAttachment tiltAtt{};
+            tiltAtt.extent = swapchain.extent;
+            tiltAtt.samples = VK_SAMPLE_COUNT_1_BIT;
+            tiltAtt.colorFormat = swapchain.format;
+            tiltAtt.swapchainColor = true; // Patched with the acquired image every frame
+
+            RenderPassDesc tiltPass{};
+            tiltPass.name = "tiltshift";
+            tiltPass.attachments = tiltAtt;
+            tiltPass.images.push_back(ImageAccess{swapchain.sceneColor.image, swapchain.format, ImageUsage::SampledFragment});
+            tiltPass.images.push_back(ImageAccess{swapchain.depthResolved.image, swapchain.depthFormat,
+                                                  ImageUsage::SampledFragment});
+            tiltPass.record = [&](VkCommandBuffer c) {
+                terrainExample->renderTiltShift(c);
+            };
+
+            graph.addPass(tiltPass);
+            graph.compile(device, swapchain);
+
+            // The targets have memory and views once compiled
+            for (auto& [target, handle] : targets) {
+                *target = graph.getTransientImage(handle);
+            }
+            const TransientLayout& layout = graph.getTransientLayout();
+            std::cout << "Frame targets: " << layout.peakBytes / (1024 * 1024) << " MB aliased, "
+                      << layout.naiveBytes / (1024 * 1024) << " MB unaliased" << std::endl;
+            const CompileReport& report = graph.getCompileReport();
+            for (const auto& name : report.culled) {
+                std::cout << "Render graph: culled pass " << name << std::endl;
+            }
+            for (const auto& [name, into] : report.merged) {
+                std::cout << "Render graph: merged pass " << name << " into " << into << std::endl;
+            }
+        };
+        buildFrameGraph();
+
         // Create terrain example
-        std::unique_ptr<TerrainExample> terrainExample = std::make_unique<TerrainExample>(device, swapchain);
+        terrainExample = std::make_unique<TerrainExample>(device, swapchain);
 
         // Create command pool and buffers
         VkCommandPoolCreateInfo poolInfo{};
         poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
         poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-        poolInfo.queueFamilyIndex = 0;
+        poolInfo.queueFamilyIndex = device.queueFamilyIndex;
 
         VkCommandPool commandPool;
         if (vkCreateCommandPool(device.device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
@@ -269,11 +457,25 @@ int main() {
 
         std::cout << "Terrain scene ready to render..." << std::endl;
 
-        // Create persistent render graph to track image layouts across frames
-        RenderGraph graph;
+        // Gameplay runs beside the renderer at a fixed turn rate
+        JobSystem jobs;
+        TurnSimulation simulation(terrainExample->getGrid(), jobs);
+        simulation.populate(6, 2);
+
+        // The same workers record the frame's passes into secondary command buffers
+        graph.enableParallelRecording(device, jobs, poolInfo.queueFamilyIndex);
+        auto lastRecordReport = std::chrono::high_resolution_clock::now();
+#ifdef COUNT_HEAP_ALLOCATIONS
+        uint64_t reportAllocations = heapAllocations.load();
+        uint32_t reportFrames = 0;
+#endif
 
         bool framebufferResized = false;
         
+        // Previously clicked hex, used as the start of a debug path query
+        std::optional<HexCoord> lastClickedHex;
+        std::vector<HexCoord> clickPath;
+        
         // Time tracking for deltaTime
         auto lastFrameTime = std::chrono::high_resolution_clock::now();
 
@@ -350,6 +552,37 @@ int main() {
                 }
             }
 
+            // Write the last frames' pass timings as a Chrome trace with F12
+            {
+                bool traceKeyDown = window.isKeyDown(GLFW_KEY_F12);
+                if (traceKeyDown && !traceKeyWasDown) {
+                    try {
+                        graph.getProfiler().exportChromeTrace("frame_trace.json");
+                        std::cout << "Wrote frame_trace.json" << std::endl;
+                    } catch (const std::exception& e) {
+                        std::cerr << "Error: " << e.what() << std::endl;
+                    }
+                }
+                traceKeyWasDown = traceKeyDown;
+            }
+
+            // Toggle the periodic stats report with F11
+            {
+                bool statsKeyDown = window.isKeyDown(GLFW_KEY_F11);
+                if (statsKeyDown && !statsKeyWasDown) {
+                    statsReport = !statsReport;
+                    std::cout << "Stats report " << (statsReport ? "on" : "off") << std::endl;
+                    // Start the first report from now rather than averaging over the time it was off
+                    graph.resetRecordTimings();
+                    lastRecordReport = std::chrono::high_resolution_clock::now();
+#ifdef COUNT_HEAP_ALLOCATIONS
+                    reportAllocations = heapAllocations.load();
+                    reportFrames = 0;
+#endif
+                }
+                statsKeyWasDown = statsKeyDown;
+            }
+
 			// Handle left mouse click to get hex coordinates
 			{
 				double clickX = 0.0, clickY = 0.0;
@@ -371,13 +604,25 @@ int main() {
 					
 					// Print hex coordinates to console
 					std::cout << "Clicked hex tile: (" << hex.q << ", " << hex.r << ")" << std::endl;
+
+					// Report the cheapest path from the previous click
+					if (lastClickedHex) {
+						float pathCost = 0.0f;
+						if (terrainExample->findPath(*lastClickedHex, hex, clickPath, pathCost)) {
+							std::cout << "Path from (" << lastClickedHex->q << ", " << lastClickedHex->r << "): "
+							          << clickPath.size() << " hexes, cost " << pathCost << std::endl;
+						} else {
+							std::cout << "No path from (" << lastClickedHex->q << ", " << lastClickedHex->r << ")" << std::endl;
+						}
+					}
+					lastClickedHex = hex;
 				}
 			}
 
             // Handle window resize
             if (framebufferResized) {
                 recreateSwapchain(device, surface, window, swapchain);
-                graph.resetLayoutTracking(); // Clear layout tracking for new swapchain images
+                buildFrameGraph(); // New targets and plan for the new extent
                 terrainExample->getCamera().setAspectRatio(
                     static_cast<float>(swapchain.extent.width) / 
                     static_cast<float>(swapchain.extent.height));
@@ -386,13 +631,18 @@ int main() {
                 framebufferResized = false;
             }
 
+            // Show what player 0 can see after each turn
+            if (simulation.advance(deltaTime) > 0) {
+                terrainExample->updateFog(simulation, 0);
+            }
+
             // Update terrain scene
             terrainExample->update(deltaTime);
 
             // Acquire next image
             if (!acquireNextImage(device, swapchain)) {
                 recreateSwapchain(device, surface, window, swapchain);
-                graph.resetLayoutTracking(); // Clear layout tracking for new swapchain images
+                buildFrameGraph(); // New targets and plan for the new extent
                 terrainExample->getCamera().setAspectRatio(
                     static_cast<float>(swapchain.extent.width) / 
                     static_cast<float>(swapchain.extent.height));
@@ -409,158 +659,65 @@ int main() {
             cmdBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
             vkBeginCommandBuffer(cmd, &cmdBeginInfo);
 
-            graph.beginFrame(device, swapchain, cmd);
+            // Upload dirty fog-of-war rectangles before any pass samples the texture
+            terrainExample->recordUploads(cmd, swapchain.currentFrame);
 
-            // Depth prepass - depth only, no color
-            RenderAttachment depthAtt{};
-            depthAtt.extent = swapchain.extent;
-            depthAtt.samples = swapchain.msaaSamples;
-            depthAtt.depthFormat = swapchain.depthFormat;
-            depthAtt.depthView = swapchain.depthImage.view;
-            depthAtt.depthImage = swapchain.depthImage.image;
-            // Resolve depth to single-sample for SSAO
-            depthAtt.depthResolveView = swapchain.depthResolved.view;
-            depthAtt.depthResolveImage = swapchain.depthResolved.image;
-            // No color attachments for depth prepass
+            graph.execute(cmd, swapchain);
 
-            RenderPassDesc depthPass{};
-            depthPass.name = "depth_prepass";
-            depthPass.attachments = depthAtt;
-            depthPass.clearDepth = 1.0f;
-            depthPass.clearStencil = 0;
-            depthPass.depthLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            depthPass.record = [&](VkCommandBuffer c) {
-                terrainExample->renderDepthOnly(c);
-            };
-
-            graph.addPass(depthPass);
-
-            // SSAO pass - writes occlusion to R8 texture, reads resolved depth read-only
-            RenderAttachment ssaoAtt{};
-            ssaoAtt.extent = swapchain.extent;
-            ssaoAtt.samples = VK_SAMPLE_COUNT_1_BIT;
-            ssaoAtt.colorFormat = swapchain.ssaoFormat;
-            ssaoAtt.colorView = swapchain.ssaoImage.view;
-            ssaoAtt.colorImage = swapchain.ssaoImage.image;
-            // Include resolved depth to transition it to read-only layout for sampling
-            ssaoAtt.depthFormat = swapchain.depthFormat;
-            ssaoAtt.depthView = swapchain.depthResolved.view;
-            ssaoAtt.depthImage = swapchain.depthResolved.image;
-
-            RenderPassDesc ssaoPass{};
-            ssaoPass.name = "ssao";
-            ssaoPass.attachments = ssaoAtt;
-            ssaoPass.clearColor = {{1.0f, 0.0f, 0.0f, 0.0f}}; // occlusion default = 1
-            ssaoPass.depthLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
-            ssaoPass.depthReadOnly = true;
-            ssaoPass.record = [&](VkCommandBuffer c) {
-                terrainExample->renderSSAO(c);
-            };
-
-            graph.addPass(ssaoPass);
+            vkEndCommandBuffer(cmd);
 
-            // Main pass - color + depth (load depth from prepass); render into sceneColor for post
-            RenderAttachment att{};
-            att.extent = swapchain.extent;
-            att.samples = swapchain.msaaSamples;
-            att.colorFormat = swapchain.format;
-            att.depthFormat = swapchain.depthFormat;
-            if (swapchain.msaaSamples != VK_SAMPLE_COUNT_1_BIT) {
-                att.colorView = swapchain.msaaColor.view;
-                att.colorImage = swapchain.msaaColor.image;
-                att.resolveView = swapchain.sceneColor.view;
-                att.resolveImage = swapchain.sceneColor.image;
-            } else {
-                att.colorView = swapchain.sceneColor.view;
-                att.colorImage = swapchain.sceneColor.image;
+            // Report how recording was split across threads every few seconds, when enabled
+#ifdef COUNT_HEAP_ALLOCATIONS
+            ++reportFrames;
+#endif
+            if (statsReport && std::chrono::high_resolution_clock::now() - lastRecordReport > std::chrono::seconds(5)) {
+#ifdef COUNT_HEAP_ALLOCATIONS
+                // Counted before the report allocates for its own output
+                std::cout << "Heap: " << static_cast<double>(heapAllocations.load() - reportAllocations) / reportFrames
+                          << " allocations/frame" << std::endl;
+#endif
+
+                const RecordTimings& timings = graph.getRecordTimings();
+                if (timings.frames > 0) {
+                    double frames = static_cast<double>(timings.frames);
+                    std::cout << "Record: " << timings.wallNanoseconds / frames / 1000.0 << " us/frame;";
+                    for (size_t worker = 0; worker < timings.workerNanoseconds.size(); ++worker) {
+                        if (timings.workerRecords[worker] == 0) continue;
+                        std::cout << " thread " << worker << " " << timings.workerNanoseconds[worker] / frames / 1000.0
+                                  << " us (" << timings.workerRecords[worker] / frames << " passes)";
+                    }
+                    std::cout << std::endl;
+                }
+                graph.resetRecordTimings();
+
+                const PassProfiler& profiler = graph.getProfiler();
+                for (const std::string& pass : profiler.getPassNames()) {
+                    PassTimingStats gpu = profiler.getGpuStats(pass);
+                    PassTimingStats cpu = profiler.getCpuStats(pass);
+                    std::cout << "  " << pass << ": GPU " << gpu.mean << "/" << gpu.p95 << "/" << gpu.p99
+                              << " ms, CPU " << cpu.mean << "/" << cpu.p95 << "/" << cpu.p99
+                              << " ms (mean/p95/p99)" << std::endl;
+                }
+                lastRecordReport = std::chrono::high_resolution_clock::now();
+#ifdef COUNT_HEAP_ALLOCATIONS
+                reportAllocations = heapAllocations.load();
+                reportFrames = 0;
+#endif
             }
-            att.depthView = swapchain.depthImage.view;
-            att.depthImage = swapchain.depthImage.image;
-
-            RenderPassDesc pass{};
-            pass.name = "terrain";
-            pass.attachments = att;
-            pass.clearColor = {{0.05f, 0.05f, 0.08f, 1.0f}};
-            pass.clearDepth = 1.0f;
-            pass.clearStencil = 0;
-            pass.depthLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD; // Load depth from prepass
-            // Ensure SSAO image is transitioned to SHADER_READ_ONLY for sampling
-            pass.sampledImages.push_back(swapchain.ssaoImage.image);
-            pass.record = [&](VkCommandBuffer c) {
-                terrainExample->render(c);
-            };
-
-            graph.addPass(pass);
-
-            // Tilt-shift post-process: write to swapchain, sample sceneColor and depthResolved
-            RenderAttachment tiltAtt{};
-            tiltAtt.extent = swapchain.extent;
-            tiltAtt.samples = VK_SAMPLE_COUNT_1_BIT;
-            tiltAtt.colorFormat = swapchain.format;
-            tiltAtt.colorView = swapchain.images[swapchain.currentImageIndex].view;
-            tiltAtt.colorImage = swapchain.images[swapchain.currentImageIndex].image;
-            // Include resolved depth as read-only to manage layout for sampling
-            tiltAtt.depthFormat = swapchain.depthFormat;
-            tiltAtt.depthView = swapchain.depthResolved.view;
-            tiltAtt.depthImage = swapchain.depthResolved.image;
 
-            RenderPassDesc tiltPass{};
-            tiltPass.name = "tiltshift";
-            tiltPass.attachments = tiltAtt;
-            tiltPass.depthLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
-            tiltPass.depthReadOnly = true;
-            // Ensure sceneColor transitions to sampled for this pass
-            tiltPass.sampledImages.push_back(swapchain.sceneColor.image);
-            tiltPass.record = [&](VkCommandBuffer c) {
-                terrainExample->renderTiltShift(c);
-            };
-
-            graph.addPass(tiltPass);
-            graph.execute();
-            graph.endFrame();
-
-            vkEndCommandBuffer(cmd);
-
-            // Submit command buffer
-            VkSubmitInfo submitInfo{};
-            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-            
+            // Submit command buffer. The graph splits it across queues when async compute is on.
+            FrameSubmitInfo frameSubmit{};
             // Wait on imageAvailable (indexed by currentFrame, from acquire)
-            VkSemaphore waitSemaphores[] = {swapchain.imageAvailableSemaphores[swapchain.currentFrame]};
-            VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-            submitInfo.waitSemaphoreCount = 1;
-            submitInfo.pWaitSemaphores = waitSemaphores;
-            submitInfo.pWaitDstStageMask = waitStages;
-            submitInfo.commandBufferCount = 1;
-            submitInfo.pCommandBuffers = &cmd;
-            
+            frameSubmit.waitSemaphore = swapchain.imageAvailableSemaphores[swapchain.currentFrame];
             // Signal renderFinished (indexed by currentImageIndex, for present)
-            uint64_t signalValue = swapchain.nextTimelineValue++;
-            VkSemaphore signalSemaphores[] = {
-                swapchain.renderFinishedSemaphores[swapchain.currentImageIndex],
-                device.timelineSemaphore
-            };
-            submitInfo.signalSemaphoreCount = 2;
-            submitInfo.pSignalSemaphores = signalSemaphores;
-
-            VkTimelineSemaphoreSubmitInfo timelineInfo{};
-            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
-            // Provide wait values for all wait semaphores (0 for binary imageAvailable)
-            uint64_t waitValues[1] = {0ull};
-            timelineInfo.waitSemaphoreValueCount = submitInfo.waitSemaphoreCount;
-            timelineInfo.pWaitSemaphoreValues = waitValues;
-            // Provide signal values for all signal semaphores (0 for binary renderFinished, N for timeline)
-            uint64_t signalValues[2] = {0ull, signalValue};
-            timelineInfo.signalSemaphoreValueCount = submitInfo.signalSemaphoreCount;
-            timelineInfo.pSignalSemaphoreValues = signalValues;
-            submitInfo.pNext = &timelineInfo;
+            frameSubmit.signalSemaphore = swapchain.renderFinishedSemaphores[swapchain.currentImageIndex];
+            frameSubmit.timelineSemaphore = device.timelineSemaphore;
+            frameSubmit.timelineValue = swapchain.nextTimelineValue++;
 
             // Track timeline value for this frame-in-flight so we can wait before reuse
-            swapchain.frameTimelineValues[swapchain.currentFrame] = signalValue;
+            swapchain.frameTimelineValues[swapchain.currentFrame] = frameSubmit.timelineValue;
 
-            if (vkQueueSubmit(device.queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
-                throw std::runtime_error("Failed to submit draw command buffer!");
-            }
+            graph.submit(device, cmd, frameSubmit);
 
             // Present
             if (!presentImage(device, surface, swapchain)) {
@@ -576,6 +733,10 @@ int main() {
 
         // Cleanup
         terrainExample.reset(); // Destroy terrain before command pool
+        graph.destroyTransientImages(device);
+        graph.disableParallelRecording(device);
+        graph.disableAsyncCompute(device);
+        graph.disableProfiling(device);
         vkDestroyCommandPool(device.device, commandPool, nullptr);
         
         // Destroy imageAvailable semaphores (one per frame-in-flight)
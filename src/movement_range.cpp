@@ -0,0 +1,137 @@
+#include "movement_range.hpp"
+
+#include <algorithm>
+
+MovementRangeFinder::MovementRangeFinder(const HexGrid& grid)
+    : grid(grid)
+{}
+
+void MovementRangeFinder::compute(int origin, float budget, const MovementProfile& profile, MovementRange& out) {
+    out.origin = origin;
+    out.budget = budget;
+    out.tiles.clear();
+    out.costs.clear();
+    out.predecessors.clear();
+    out.outline.clear();
+    out.outlineLoops.clear();
+
+    size_t tileCount = static_cast<size_t>(grid.size());
+    if (nodes.size() != tileCount) {
+        nodes.assign(tileCount, NodeRecord{0.0f, -1, -1, 0});
+        generation = 0;
+    }
+    // Bumping the generation forgets the previous query; on wrap-around reset once for real
+    if (++generation == 0) {
+        for (auto& node : nodes) node.stamp = 0;
+        generation = 1;
+    }
+
+    if (origin < 0 || origin >= static_cast<int>(tileCount) || budget < 0.0f) return;
+
+    nodes[origin] = NodeRecord{0.0f, -1, -1, generation};
+    if (profile.minCost == MovementProfile::IMPASSABLE) {
+        nodes[origin].slot = 0;
+        out.tiles.push_back(origin);
+        out.costs.push_back(0.0f);
+        out.predecessors.push_back(-1);
+        return;
+    }
+
+    // Bucket width = cheapest step, so everything in the lowest bucket is final and a
+    // relaxation always lands in a later bucket, at most maxCost / width ahead
+    const float bucketWidth = profile.minCost;
+    float maxCost = 0.0f;
+    for (float cost : profile.cost) {
+        if (cost != MovementProfile::IMPASSABLE) maxCost = std::max(maxCost, cost);
+    }
+    const size_t ringSize = static_cast<size_t>(maxCost / bucketWidth) + 2;
+    if (ring.size() < ringSize) ring.resize(ringSize);
+    for (auto& bucket : ring) bucket.clear();
+
+    const std::vector<TerrainType>& types = grid.getTypes();
+    ring[0].push_back(origin);
+    size_t pending = 1;
+    std::array<int, 6> neighbors;
+
+    for (int bucket = 0; pending > 0; ++bucket) {
+        auto& tiles = ring[bucket % ringSize];
+        pending -= tiles.size();
+
+        for (int32_t tile : tiles) {
+            NodeRecord& node = nodes[tile];
+            if (node.slot >= 0) continue; // Queued again after a cheaper path was found
+
+            node.slot = static_cast<int32_t>(out.tiles.size());
+            out.tiles.push_back(tile);
+            out.costs.push_back(node.cost);
+            out.predecessors.push_back(node.parent);
+
+            grid.neighborIndices(tile, neighbors);
+            for (int next : neighbors) {
+                if (next < 0) continue;
+                float cost = node.cost + profile.entryCost(types[next]);
+                if (cost > budget) continue; // Also skips impassable (infinite) entries
+
+                NodeRecord& nextNode = nodes[next];
+                if (nextNode.stamp == generation && (nextNode.slot >= 0 || cost >= nextNode.cost)) continue;
+                nextNode = NodeRecord{cost, tile, -1, generation};
+
+                // Clamp guards against rounding putting a step back into this bucket
+                int nextBucket = std::max(static_cast<int>(cost / bucketWidth), bucket + 1);
+                ring[nextBucket % ringSize].push_back(next);
+                ++pending;
+            }
+        }
+        tiles.clear();
+    }
+}
+
+bool MovementRangeFinder::pathTo(int tile, std::vector<int>& outPath) const {
+    outPath.clear();
+    if (!isReachable(tile)) return false;
+
+    for (int node = tile; node != -1; node = nodes[node].parent) {
+        outPath.push_back(node);
+    }
+    std::reverse(outPath.begin(), outPath.end());
+    return true;
+}
+
+void MovementRangeFinder::buildOutline(MovementRange& out, float hexSize, float height) {
+    out.outline.clear();
+    out.outlineLoops.clear();
+    edgeVisited.assign(out.tiles.size(), 0);
+
+    // Corner i sits between the edges facing directions i and i + 1; the edge facing
+    // direction d runs from corner d - 1 to corner d
+    const std::array<glm::vec3, 6> corners = hexVertices(HexCoord(0, 0), hexSize, height);
+
+    for (size_t slot = 0; slot < out.tiles.size(); ++slot) {
+        int tile = out.tiles[slot];
+        for (int dir = 0; dir < 6; ++dir) {
+            if (edgeVisited[slot] & (1u << dir)) continue;
+            if (isReachable(grid.neighborIndex(tile, dir))) continue;
+
+            // Walk the boundary keeping the range on the same side: at the end corner of each
+            // edge, either the tile's next edge is also a boundary, or the boundary continues
+            // on the neighbor that shares that corner
+            out.outlineLoops.push_back(static_cast<uint32_t>(out.outline.size()));
+            int currentTile = tile;
+            int currentDir = dir;
+            do {
+                edgeVisited[nodes[currentTile].slot] |= static_cast<uint8_t>(1u << currentDir);
+                out.outline.push_back(hexToWorld(grid.coordOf(currentTile), hexSize) + corners[currentDir]);
+
+                int nextDir = (currentDir + 1) % 6;
+                int across = grid.neighborIndex(currentTile, nextDir);
+                if (isReachable(across)) {
+                    currentTile = across;
+                    currentDir = (currentDir + 5) % 6;
+                } else {
+                    currentDir = nextDir;
+                }
+            } while (currentTile != tile || currentDir != dir);
+        }
+    }
+    out.outlineLoops.push_back(static_cast<uint32_t>(out.outline.size()));
+}
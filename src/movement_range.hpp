@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "hex_coord.hpp"
+#include "hex_grid.hpp"
+
+// Result of a movement-range query: every tile a unit can reach within its movement points
+struct MovementRange {
+    int origin = -1;
+    float budget = 0.0f;
+
+    // Reachable tiles, origin first, in settle order (increasing cost bucket); costs and
+    // predecessors are parallel arrays (the origin's predecessor is -1)
+    std::vector<int32_t> tiles;
+    std::vector<float> costs;
+    std::vector<int32_t> predecessors;
+
+    // Boundary of the reachable set as closed loops of world-space hex corners (the outer
+    // edge plus one loop per hole). Loop i covers outline[outlineLoops[i] .. outlineLoops[i + 1])
+    // and its last vertex connects back to its first; outlineLoops ends with outline.size().
+    std::vector<glm::vec3> outline;
+    std::vector<uint32_t> outlineLoops;
+};
+
+// Budgeted Dijkstra for unit selection. A tile is reachable when the summed entry costs
+// along the cheapest path fit in the budget.
+//
+// Costs are kept in a bucket queue of width profile.minCost: every tile in the lowest
+// bucket is already final, so no heap is needed and the search stops at the first bucket
+// past the budget. Per-tile state is stamped with a query generation and the bucket ring
+// and output vectors are reused, so repeated queries don't allocate once warmed up.
+class MovementRangeFinder {
+public:
+    explicit MovementRangeFinder(const HexGrid& grid);
+
+    // Fill out with the tiles reachable from origin within budget
+    void compute(int origin, float budget, const MovementProfile& profile, MovementRange& out);
+    void compute(const HexCoord& origin, float budget, const MovementProfile& profile, MovementRange& out) {
+        compute(grid.indexOf(origin), budget, profile, out);
+    }
+
+    // Trace the outline of the last computed range into out.outline / out.outlineLoops
+    void buildOutline(MovementRange& out, float hexSize, float height = 0.0f);
+
+    // Lookups against the last computed range
+    bool isReachable(int tile) const { return tile >= 0 && nodes[tile].stamp == generation; }
+    float costTo(int tile) const { return isReachable(tile) ? nodes[tile].cost : MovementProfile::IMPASSABLE; }
+
+    // Cheapest path from the origin to a reachable tile, both inclusive
+    bool pathTo(int tile, std::vector<int>& outPath) const;
+
+private:
+    struct NodeRecord {
+        float cost;
+        int32_t parent;
+        int32_t slot;   // Index into MovementRange::tiles once settled, -1 while queued
+        uint32_t stamp; // == generation when this record belongs to the current query
+    };
+
+    const HexGrid& grid;
+    std::vector<NodeRecord> nodes;
+    uint32_t generation = 0;
+    std::vector<std::vector<int32_t>> ring;
+    std::vector<uint8_t> edgeVisited; // Per range slot: bit d set once edge d is in a loop
+};
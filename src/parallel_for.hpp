@@ -0,0 +1,28 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Split [0, count) into one contiguous range per worker and run fn(begin, end, worker) on
+// each. The calling thread takes worker 0; returns once every range is done.
+// threadCount 0 uses hardware_concurrency.
+template <typename Fn>
+void parallelFor(size_t count, int threadCount, Fn&& fn) {
+    size_t workers = threadCount > 0 ? static_cast<size_t>(threadCount) : std::thread::hardware_concurrency();
+    workers = std::clamp<size_t>(workers, 1, std::max<size_t>(count, 1));
+    if (workers == 1) {
+        fn(size_t(0), count, 0);
+        return;
+    }
+
+    std::vector<std::jthread> threads;
+    threads.reserve(workers - 1);
+    for (size_t worker = 1; worker < workers; ++worker) {
+        threads.emplace_back([&fn, count, workers, worker]() {
+            fn(count * worker / workers, count * (worker + 1) / workers, static_cast<int>(worker));
+        });
+    }
+    fn(size_t(0), count / workers, 0);
+}
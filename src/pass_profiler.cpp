@@ -0,0 +1,240 @@
+#include "pass_profiler.hpp"
+#include "device.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace {
+
+uint64_t timestampMask(uint32_t validBits) {
+    if (validBits == 0) return 0;
+    return validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+}
+
+std::string escapeJson(const char* text) {
+    std::string escaped;
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') escaped += '\\';
+        if (static_cast<unsigned char>(*c) < 0x20) continue;
+        escaped += *c;
+    }
+    return escaped;
+}
+
+}
+
+void PassProfiler::init(Device& device, uint32_t framesInFlight, uint32_t maxPassesPerFrame) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device.physicalDevice, &properties);
+    nanosecondsPerTick = properties.limits.timestampPeriod;
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device.physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(device.physicalDevice, &familyCount, families.data());
+    const uint32_t laneFamilies[2] = {device.queueFamilyIndex, device.computeQueueFamilyIndex};
+    for (uint32_t lane = 0; lane < 2; ++lane) {
+        // Without an async queue compute passes are recorded on the graphics one
+        uint32_t family = laneFamilies[lane] < familyCount ? laneFamilies[lane] : laneFamilies[0];
+        laneMasks[lane] = family < familyCount ? timestampMask(families[family].timestampValidBits) : 0;
+    }
+
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = framesInFlight * maxPassesPerFrame * 2;
+    if (vkCreateQueryPool(device.device, &poolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create timestamp query pool!");
+    }
+
+    vkDevice = device.device;
+    maxPasses = maxPassesPerFrame;
+    pending.assign(framesInFlight, {});
+    results.resize(size_t(maxPassesPerFrame) * 4);
+    // Reserved up front, so tracing doesn't allocate while the ring first fills
+    trace.assign(TRACE_FRAMES, {});
+    for (std::vector<TraceEvent>& frame : trace) frame.reserve(size_t(maxPassesPerFrame) * 2);
+    traceFrame = 0;
+    cpuEpochNs = now();
+    gpuEpochSet = false;
+}
+
+void PassProfiler::destroy(Device& device) {
+    if (queryPool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(device.device, queryPool, nullptr);
+        queryPool = VK_NULL_HANDLE;
+    }
+    pending.clear();
+    cpuThisFrame.clear();
+    trace.clear();
+    series.clear();
+}
+
+PassProfiler::Series& PassProfiler::seriesFor(const char* name) {
+    // By contents rather than pointer: a name built at runtime may be freed and its address
+    // reused for another pass
+    auto it = series.find(std::string_view(name));
+    if (it == series.end()) {
+        it = series.emplace(name, Series{}).first;
+        it->second.gpuMs.reserve(HISTORY);
+        it->second.cpuMs.reserve(HISTORY);
+        it->second.name = it->first.c_str();
+    }
+    return it->second;
+}
+
+void PassProfiler::push(std::vector<float>& ring, uint32_t& next, float value) {
+    if (ring.size() < HISTORY) {
+        ring.push_back(value);
+    } else {
+        ring[next] = value;
+    }
+    next = (next + 1) % HISTORY;
+}
+
+void PassProfiler::beginFrame(uint32_t frame) {
+    // Close the previous frame's CPU samples, one per pass however many callbacks it has
+    for (Series* s : cpuThisFrame) {
+        push(s->cpuMs, s->cpuNext, float(s->frameCpuNs * 1e-6));
+        s->frameCpuNs = -1;
+    }
+    cpuThisFrame.clear();
+
+    traceFrame = (traceFrame + 1) % TRACE_FRAMES;
+    trace[traceFrame].clear();
+
+    // This slot's last submission is at least a frame old. Take whatever has landed without
+    // waiting; the availability word says which pairs are complete.
+    currentFrame = frame;
+    std::vector<PendingPass>& passes = pending[frame];
+    if (!passes.empty()) {
+        uint32_t queryCount = uint32_t(passes.size()) * 2;
+        VkResult result = vkGetQueryPoolResults(vkDevice, queryPool, frame * maxPasses * 2, queryCount,
+                                                queryCount * 2 * sizeof(uint64_t), results.data(),
+                                                2 * sizeof(uint64_t),
+                                                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (result == VK_SUCCESS || result == VK_NOT_READY) {
+            for (size_t i = 0; i < passes.size(); ++i) {
+                const uint64_t* begin = &results[i * 4];
+                const uint64_t* end = begin + 2;
+                if (begin[1] == 0 || end[1] == 0) continue;
+
+                uint64_t mask = laneMasks[passes[i].lane];
+                uint64_t ticks = (end[0] - begin[0]) & mask;
+                push(passes[i].series->gpuMs, passes[i].series->gpuNext,
+                     float(double(ticks) * nanosecondsPerTick * 1e-6));
+
+                if (!gpuEpochSet) {
+                    gpuEpochTicks = begin[0] & mask;
+                    gpuEpochSet = true;
+                }
+                double startUs = double(((begin[0] & mask) - gpuEpochTicks) & mask) * nanosecondsPerTick * 1e-3;
+                trace[traceFrame].push_back({passes[i].series->name, true, passes[i].lane, startUs,
+                                        double(ticks) * nanosecondsPerTick * 1e-3});
+            }
+        }
+    }
+    passes.clear();
+}
+
+int32_t PassProfiler::beginPass(CommandRecorder& recorder, VkCommandBuffer cmd, const char* name, uint32_t lane) {
+    std::vector<PendingPass>& passes = pending[currentFrame];
+    if (laneMasks[lane] == 0 || passes.size() == maxPasses) return -1;
+
+    uint32_t query = (currentFrame * maxPasses + uint32_t(passes.size())) * 2;
+    passes.push_back({&seriesFor(name), lane});
+    // Reset in the command buffer that writes the pair, so it's ordered on its own queue
+    recorder.resetQueries(cmd, queryPool, query, 2);
+    recorder.writeTimestamp(cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, queryPool, query);
+    return int32_t(query);
+}
+
+void PassProfiler::endPass(CommandRecorder& recorder, VkCommandBuffer cmd, int32_t query) {
+    if (query < 0) return;
+    recorder.writeTimestamp(cmd, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, queryPool, uint32_t(query) + 1);
+}
+
+int64_t PassProfiler::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void PassProfiler::addCpuTime(const char* name, uint32_t thread, int64_t startNs, int64_t endNs) {
+    Series& s = seriesFor(name);
+    if (s.frameCpuNs < 0) {
+        s.frameCpuNs = 0;
+        cpuThisFrame.push_back(&s);
+    }
+    s.frameCpuNs += endNs - startNs;
+
+    trace[traceFrame].push_back({s.name, false, thread, (startNs - cpuEpochNs) * 1e-3, (endNs - startNs) * 1e-3});
+}
+
+PassTimingStats PassProfiler::stats(const std::vector<float>& ring) {
+    PassTimingStats result;
+    if (ring.empty()) return result;
+
+    std::vector<float> sorted(ring);
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for (float sample : sorted) sum += sample;
+
+    auto percentile = [&](double p) {
+        size_t rank = size_t(std::ceil(p * sorted.size()));
+        return double(sorted[std::max<size_t>(rank, 1) - 1]);
+    };
+    result.mean = sum / sorted.size();
+    result.p95 = percentile(0.95);
+    result.p99 = percentile(0.99);
+    result.samples = uint32_t(sorted.size());
+    return result;
+}
+
+PassTimingStats PassProfiler::getGpuStats(const std::string& pass) const {
+    auto it = series.find(pass);
+    return it == series.end() ? PassTimingStats{} : stats(it->second.gpuMs);
+}
+
+PassTimingStats PassProfiler::getCpuStats(const std::string& pass) const {
+    auto it = series.find(pass);
+    return it == series.end() ? PassTimingStats{} : stats(it->second.cpuMs);
+}
+
+std::vector<std::string> PassProfiler::getPassNames() const {
+    std::vector<std::string> names;
+    names.reserve(series.size());
+    for (const auto& [name, s] : series) names.push_back(name);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+void PassProfiler::exportChromeTrace(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open trace for writing: " + path);
+    }
+
+    // pid 0 is the CPU with a thread per worker, pid 1 the GPU with a thread per queue
+    file << std::fixed << std::setprecision(3);
+    file << "{\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}},\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Graphics queue\"}},\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Compute queue\"}}";
+    // Oldest frame first
+    for (size_t i = 1; i <= trace.size(); ++i) {
+        for (const TraceEvent& event : trace[(traceFrame + i) % trace.size()]) {
+            file << ",\n{\"name\":\"" << escapeJson(event.name) << "\",\"cat\":\"" << (event.gpu ? "gpu" : "cpu")
+                 << "\",\"ph\":\"X\",\"pid\":" << (event.gpu ? 1 : 0) << ",\"tid\":" << event.thread
+                 << ",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs << "}";
+        }
+    }
+    file << "\n]}\n";
+
+    if (!file) {
+        throw std::runtime_error("Failed to write trace: " + path);
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include "command_recorder.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct Device;
+
+// Statistics over a pass's last PassProfiler::HISTORY samples, in milliseconds
+struct PassTimingStats {
+    double mean{0.0};
+    double p95{0.0};
+    double p99{0.0};
+    uint32_t samples{0};
+};
+
+// Per-pass GPU and CPU timings.
+//
+// GPU time comes from a pair of timestamps written around each pass into the command buffer
+// that runs it. A frame in flight's queries are read back when its slot comes round again,
+// a few frames later, so nothing waits on the GPU; timestamps that still aren't available
+// are dropped. Queries are reset with vkCmdResetQueryPool right before they are written, so
+// host query reset isn't needed and passes on either queue can be timed (lavapipe included).
+//
+// CPU time is what the passes' record callbacks took, on whichever thread ran them.
+class PassProfiler {
+public:
+    static constexpr uint32_t HISTORY = 256;      // Samples per pass kept for statistics
+    static constexpr uint32_t TRACE_FRAMES = 120; // Frames kept for exportChromeTrace()
+
+    void init(Device& device, uint32_t framesInFlight, uint32_t maxPassesPerFrame = 64);
+    void destroy(Device& device);
+    bool isEnabled() const { return queryPool != VK_NULL_HANDLE; }
+
+    // Read back what frame slot recorded the last time it was used and start recording into
+    // it again. Also closes the previous frame's CPU samples.
+    void beginFrame(uint32_t frame);
+
+    // Bracket a pass recorded on lane (0 graphics queue, 1 compute queue). Outside rendering
+    // scopes only. beginPass returns -1 when the pass can't be timed. Passes are told apart
+    // by name, which is copied the first time it's seen, so it needn't outlive the call.
+    int32_t beginPass(CommandRecorder& recorder, VkCommandBuffer cmd, const char* name, uint32_t lane);
+    void endPass(CommandRecorder& recorder, VkCommandBuffer cmd, int32_t query);
+
+    // name's record callback ran on thread (a JobSystem worker) between two now() readings
+    static int64_t now(); // steady_clock, in nanoseconds
+    void addCpuTime(const char* name, uint32_t thread, int64_t startNs, int64_t endNs);
+
+    PassTimingStats getGpuStats(const std::string& pass) const;
+    PassTimingStats getCpuStats(const std::string& pass) const;
+    std::vector<std::string> getPassNames() const;
+
+    // Write the last TRACE_FRAMES frames as Chrome trace JSON (chrome://tracing, Perfetto).
+    // GPU and CPU clocks aren't correlated, so each gets its own process row.
+    void exportChromeTrace(const std::string& path) const;
+
+private:
+    struct Series {
+        std::vector<float> gpuMs; // Rings of up to HISTORY samples
+        std::vector<float> cpuMs;
+        uint32_t gpuNext{0};
+        uint32_t cpuNext{0};
+        int64_t frameCpuNs{-1}; // Summed over this frame's callbacks, -1 if none ran
+        const char* name{nullptr}; // The map's key, which trace events point at
+    };
+
+    struct PendingPass {
+        Series* series;
+        uint32_t lane;
+    };
+
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
+    struct TraceEvent {
+        const char* name;
+        bool gpu;
+        uint32_t thread; // Lane for GPU events
+        double startUs;
+        double durationUs;
+    };
+
+    VkDevice vkDevice{VK_NULL_HANDLE};
+    VkQueryPool queryPool{VK_NULL_HANDLE};
+    uint32_t maxPasses{0};
+    double nanosecondsPerTick{1.0};
+    uint64_t laneMasks[2]{}; // Valid timestamp bits per lane, 0 if it can't be timed
+
+    std::unordered_map<std::string, Series, NameHash, std::equal_to<>> series; // Looked up without building strings
+    std::vector<std::vector<PendingPass>> pending; // Per frame slot; pass i uses queries 2i, 2i + 1
+    std::vector<Series*> cpuThisFrame;
+    uint32_t currentFrame{0};
+    std::vector<uint64_t> results; // Scratch: value and availability per query
+
+    std::vector<std::vector<TraceEvent>> trace; // Ring of TRACE_FRAMES frames, reused
+    uint32_t traceFrame{0};                    // Newest
+    int64_t cpuEpochNs{0};
+    uint64_t gpuEpochTicks{0};
+    bool gpuEpochSet{false};
+
+    Series& seriesFor(const char* name);
+    static void push(std::vector<float>& ring, uint32_t& next, float value);
+    static PassTimingStats stats(const std::vector<float>& ring);
+};
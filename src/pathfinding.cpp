@@ -0,0 +1,116 @@
+#include "pathfinding.hpp"
+
+#include <algorithm>
+
+HexPathfinder::HexPathfinder(const HexGrid& grid)
+    : grid(&grid)
+{}
+
+void HexPathfinder::setGrid(const HexGrid& newGrid) {
+    grid = &newGrid;
+}
+
+void HexPathfinder::beginQuery() {
+    size_t nodeCount = static_cast<size_t>(grid->size());
+    if (nodes.size() < nodeCount) {
+        nodes.resize(nodeCount, NodeRecord{0.0f, -1, 0, 0});
+        open.reserve(static_cast<int>(nodeCount));
+    }
+    open.clear();
+    lastExpanded = 0;
+
+    // Stamps are compared against the generation, so bumping it invalidates every node at once.
+    // On wrap-around the stamps must really be reset once.
+    if (++generation == 0) {
+        for (auto& node : nodes) {
+            node.openStamp = 0;
+            node.closedStamp = 0;
+        }
+        generation = 1;
+    }
+}
+
+bool HexPathfinder::search(int startIndex, int goalIndex, const MovementProfile& profile, float* outCost) {
+    beginQuery();
+
+    int nodeCount = grid->size();
+    if (startIndex < 0 || goalIndex < 0 || startIndex >= nodeCount || goalIndex >= nodeCount) return false;
+    // The start tile may be anything (the unit is already there); the goal must be enterable
+    if (!profile.passable(grid->getType(goalIndex)) || profile.minCost == MovementProfile::IMPASSABLE) return false;
+
+    const HexCoord goalHex = grid->coordOf(goalIndex);
+    const float hScale = profile.minCost;
+    const std::vector<TerrainType>& types = grid->getTypes();
+
+    NodeRecord& startNode = nodes[startIndex];
+    startNode.g = 0.0f;
+    startNode.parent = -1;
+    startNode.openStamp = generation;
+    float startH = static_cast<float>(hexDistance(grid->coordOf(startIndex), goalHex)) * hScale;
+    open.push(startIndex, startH, startH);
+
+    std::array<int, 6> neighbors;
+    while (!open.empty()) {
+        int current = open.pop().id;
+        NodeRecord& currentNode = nodes[current];
+        currentNode.closedStamp = generation;
+        ++lastExpanded;
+
+        if (current == goalIndex) {
+            if (outCost) *outCost = currentNode.g;
+            return true;
+        }
+
+        const HexCoord currentHex = grid->coordOf(current);
+        grid->neighborIndices(current, neighbors);
+        for (int dir = 0; dir < 6; ++dir) {
+            int next = neighbors[dir];
+            if (next < 0) continue;
+
+            NodeRecord& nextNode = nodes[next];
+            if (nextNode.closedStamp == generation) continue; // Heuristic is consistent: never reopen
+
+            float step = profile.entryCost(types[next]);
+            if (step == MovementProfile::IMPASSABLE) continue;
+
+            float g = currentNode.g + step;
+            if (nextNode.openStamp != generation) {
+                nextNode.g = g;
+                nextNode.parent = current;
+                nextNode.openStamp = generation;
+                float h = static_cast<float>(hexDistance(hexNeighbor(currentHex, dir), goalHex)) * hScale;
+                open.push(next, g + h, h);
+            } else if (g < nextNode.g) {
+                nextNode.g = g;
+                nextNode.parent = current;
+                float h = static_cast<float>(hexDistance(hexNeighbor(currentHex, dir), goalHex)) * hScale;
+                open.decreaseKey(next, g + h, h);
+            }
+        }
+    }
+
+    return false;
+}
+
+bool HexPathfinder::findPath(int startIndex, int goalIndex, const MovementProfile& profile,
+                             std::vector<int>& outPath, float* outCost) {
+    outPath.clear();
+    if (!search(startIndex, goalIndex, profile, outCost)) return false;
+
+    for (int node = goalIndex; node != -1; node = nodes[node].parent) {
+        outPath.push_back(node);
+    }
+    std::reverse(outPath.begin(), outPath.end());
+    return true;
+}
+
+bool HexPathfinder::findPath(const HexCoord& start, const HexCoord& goal, const MovementProfile& profile,
+                             std::vector<HexCoord>& outPath, float* outCost) {
+    outPath.clear();
+    if (!findPath(grid->indexOf(start), grid->indexOf(goal), profile, indexScratch, outCost)) return false;
+
+    for (int index : indexScratch) {
+        outPath.push_back(grid->coordOf(index));
+    }
+    return true;
+}
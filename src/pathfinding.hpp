@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "hex_coord.hpp"
+#include "hex_grid.hpp"
+#include "indexed_heap.hpp"
+
+// A* over a dense HexGrid. Entering a tile costs the profile's entry cost for its terrain;
+// the heuristic is hexDistance scaled by the profile's cheapest terrain.
+//
+// Per-node state lives in arrays stamped with a query generation, so nothing is cleared
+// between queries. After the first query on a grid (and once the caller's output vector
+// has grown), queries do not allocate.
+class HexPathfinder {
+public:
+    explicit HexPathfinder(const HexGrid& grid);
+
+    // Rebind to another grid (node arrays grow on the next query if needed)
+    void setGrid(const HexGrid& grid);
+
+    // Cheapest path from start to goal, both inclusive, written into outPath.
+    // Returns false (and clears outPath) when the goal is unreachable.
+    bool findPath(const HexCoord& start, const HexCoord& goal, const MovementProfile& profile,
+                  std::vector<HexCoord>& outPath, float* outCost = nullptr);
+
+    // Index-based variant for callers that already work in grid indices
+    bool findPath(int startIndex, int goalIndex, const MovementProfile& profile,
+                  std::vector<int>& outPath, float* outCost = nullptr);
+
+    // Nodes expanded by the last query (for profiling)
+    uint32_t getLastExpandedCount() const { return lastExpanded; }
+
+private:
+    struct NodeRecord {
+        float g;
+        int32_t parent;
+        uint32_t openStamp;   // == generation when g/parent are valid for this query
+        uint32_t closedStamp; // == generation once expanded
+    };
+
+    const HexGrid* grid;
+    std::vector<NodeRecord> nodes;
+    IndexedMinHeap open;
+    uint32_t generation = 0;
+    uint32_t lastExpanded = 0;
+    std::vector<int> indexScratch;
+
+    void beginQuery();
+    bool search(int startIndex, int goalIndex, const MovementProfile& profile, float* outCost);
+};
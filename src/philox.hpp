@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel random numbers: as easy as
+// 1, 2, 3"). The output is a pure function of a 128-bit counter and a 64-bit key, so each
+// decision can address its own numbers, e.g. counter = (turn, attacker, target, stream),
+// and get the same result whatever order or thread it is evaluated on.
+using PhiloxCounter = std::array<uint32_t, 4>;
+using PhiloxKey = std::array<uint32_t, 2>;
+
+inline PhiloxCounter philox4x32(PhiloxCounter counter, PhiloxKey key) {
+    constexpr uint64_t M0 = 0xD2511F53u;
+    constexpr uint64_t M1 = 0xCD9E8D57u;
+    constexpr uint32_t W0 = 0x9E3779B9u;
+    constexpr uint32_t W1 = 0xBB67AE85u;
+
+    for (int round = 0; round < 10; ++round) {
+        uint64_t product0 = M0 * counter[0];
+        uint64_t product1 = M1 * counter[2];
+        counter = {
+            static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+            static_cast<uint32_t>(product1),
+            static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+            static_cast<uint32_t>(product0),
+        };
+        key[0] += W0;
+        key[1] += W1;
+    }
+    return counter;
+}
+
+inline PhiloxKey philoxKey(uint64_t seed) {
+    return {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+}
+
+// Uniform float in [0, 1) from the top 24 bits
+inline float philoxUnitFloat(uint32_t bits) {
+    return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+}
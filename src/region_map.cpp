@@ -0,0 +1,323 @@
+#include "region_map.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <thread>
+
+RegionMap::RegionMap(const HexGrid& grid)
+    : grid(grid)
+{
+    rebuild();
+}
+
+void RegionMap::resetKinds() {
+    size_t tileCount = static_cast<size_t>(grid.size());
+    kinds.resize(tileCount);
+    for (size_t i = 0; i < tileCount; ++i) {
+        kinds[i] = regionKindOf(grid.getType(static_cast<int>(i)));
+    }
+    parent.resize(tileCount);
+    std::iota(parent.begin(), parent.end(), 0);
+
+    visitStamp.assign(tileCount, 0);
+    visitGroup.assign(tileCount, 0);
+    visitGeneration = 0;
+}
+
+int RegionMap::find(int tile) {
+    // Path halving
+    while (parent[tile] != tile) {
+        parent[tile] = parent[parent[tile]];
+        tile = parent[tile];
+    }
+    return tile;
+}
+
+void RegionMap::unite(int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) return;
+    // Linking under the smaller index keeps every root at its component's first tile, so
+    // labels come out in the same order however the unions were scheduled
+    if (a < b) {
+        parent[b] = a;
+    } else {
+        parent[a] = b;
+    }
+}
+
+void RegionMap::labelRoots() {
+    size_t tileCount = kinds.size();
+    labels.assign(tileCount, -1);
+    sizes.clear();
+    freeLabels.clear();
+
+    for (size_t i = 0; i < tileCount; ++i) {
+        if (kinds[i] == RegionKind::None) continue;
+        // Roots are the smallest index in their component, so they are labeled first
+        int root = find(static_cast<int>(i));
+        if (labels[root] < 0) {
+            labels[root] = static_cast<int32_t>(sizes.size());
+            sizes.push_back(0);
+        }
+        labels[i] = labels[root];
+        ++sizes[labels[i]];
+    }
+    regionCount = static_cast<int>(sizes.size());
+}
+
+void RegionMap::rebuild() {
+    resetKinds();
+
+    std::array<int, 6> neighbors;
+    for (int tile = 0; tile < static_cast<int>(kinds.size()); ++tile) {
+        if (kinds[tile] == RegionKind::None) continue;
+        grid.neighborIndices(tile, neighbors);
+        for (int next : neighbors) {
+            // Each adjacent pair is visited from both sides; uniting from the later one is enough
+            if (next >= 0 && next < tile && kinds[next] == kinds[tile]) unite(tile, next);
+        }
+    }
+    labelRoots();
+}
+
+void RegionMap::rebuildParallel(int threadCount) {
+    resetKinds();
+
+    int width = grid.getWidth();
+    int height = grid.getHeight();
+    int workers = threadCount > 0 ? threadCount : static_cast<int>(std::thread::hardware_concurrency());
+    workers = std::clamp(workers, 1, std::max(height, 1));
+
+    // Each worker unites only within its own strip of rows, so the union-find trees of
+    // different strips never share nodes and need no locking
+    auto labelStrip = [&](int worker) {
+        int rowBegin = height * worker / workers;
+        int rowEnd = height * (worker + 1) / workers;
+        int stripBegin = rowBegin * width;
+        std::array<int, 6> neighbors;
+        for (int tile = stripBegin; tile < rowEnd * width; ++tile) {
+            if (kinds[tile] == RegionKind::None) continue;
+            grid.neighborIndices(tile, neighbors);
+            for (int next : neighbors) {
+                if (next >= stripBegin && next < tile && kinds[next] == kinds[tile]) unite(tile, next);
+            }
+        }
+    };
+
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(workers - 1);
+        for (int worker = 1; worker < workers; ++worker) {
+            threads.emplace_back(labelStrip, worker);
+        }
+        labelStrip(0);
+    }
+
+    // Stitch each seam: the first row of a strip against the row above it
+    std::array<int, 6> neighbors;
+    for (int worker = 1; worker < workers; ++worker) {
+        int row = height * worker / workers;
+        for (int tile = row * width; tile < (row + 1) * width; ++tile) {
+            if (kinds[tile] == RegionKind::None) continue;
+            grid.neighborIndices(tile, neighbors);
+            for (int next : neighbors) {
+                if (next >= 0 && next < row * width && kinds[next] == kinds[tile]) unite(tile, next);
+            }
+        }
+    }
+    labelRoots();
+}
+
+bool RegionMap::connectedByWater(int a, int b) const {
+    std::array<int, 7> regionsA;
+    std::array<int, 7> regionsB;
+    int countA = 0;
+    int countB = 0;
+    gatherWaterRegions(a, regionsA, countA);
+    gatherWaterRegions(b, regionsB, countB);
+    for (int i = 0; i < countA; ++i) {
+        for (int j = 0; j < countB; ++j) {
+            if (regionsA[i] == regionsB[j]) return true;
+        }
+    }
+    return false;
+}
+
+void RegionMap::gatherWaterRegions(int tile, std::array<int, 7>& out, int& count) const {
+    count = 0;
+    if (kinds[tile] == RegionKind::Water) out[count++] = labels[tile];
+    std::array<int, 6> neighbors;
+    grid.neighborIndices(tile, neighbors);
+    for (int next : neighbors) {
+        if (next >= 0 && kinds[next] == RegionKind::Water) out[count++] = labels[next];
+    }
+}
+
+int RegionMap::allocateLabel() {
+    ++regionCount;
+    if (!freeLabels.empty()) {
+        int label = freeLabels.back();
+        freeLabels.pop_back();
+        return label;
+    }
+    sizes.push_back(0);
+    return static_cast<int>(sizes.size()) - 1;
+}
+
+void RegionMap::releaseLabel(int label) {
+    sizes[label] = 0;
+    freeLabels.push_back(label);
+    --regionCount;
+}
+
+void RegionMap::beginVisit() {
+    if (++visitGeneration == 0) {
+        std::fill(visitStamp.begin(), visitStamp.end(), 0);
+        visitGeneration = 1;
+    }
+}
+
+void RegionMap::relabel(int from, int fromLabel, int toLabel) {
+    queue.clear();
+    queue.push_back(from);
+    labels[from] = toLabel;
+
+    std::array<int, 6> neighbors;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        grid.neighborIndices(queue[head], neighbors);
+        for (int next : neighbors) {
+            if (next >= 0 && labels[next] == fromLabel) {
+                labels[next] = toLabel;
+                queue.push_back(next);
+            }
+        }
+    }
+    sizes[toLabel] += static_cast<int32_t>(queue.size());
+    releaseLabel(fromLabel);
+}
+
+void RegionMap::onTileChanged(int tileIndex) {
+    if (tileIndex < 0 || tileIndex >= static_cast<int>(kinds.size())) return;
+
+    RegionKind oldKind = kinds[tileIndex];
+    RegionKind newKind = regionKindOf(grid.getType(tileIndex));
+    if (oldKind == newKind) return; // e.g. Ocean -> CoastalWater
+
+    int oldLabel = labels[tileIndex];
+    kinds[tileIndex] = newKind;
+    labels[tileIndex] = -1;
+
+    if (oldKind != RegionKind::None) removeFromRegion(tileIndex, oldLabel);
+    if (newKind != RegionKind::None) addToRegion(tileIndex);
+}
+
+void RegionMap::addToRegion(int tile) {
+    std::array<int, 6> neighbors;
+    grid.neighborIndices(tile, neighbors);
+
+    // The largest neighboring region absorbs the others, so merges relabel as little as possible
+    int target = -1;
+    for (int next : neighbors) {
+        if (next < 0 || kinds[next] != kinds[tile]) continue;
+        if (target < 0 || sizes[labels[next]] > sizes[target]) target = labels[next];
+    }
+
+    if (target < 0) {
+        target = allocateLabel();
+    } else {
+        for (int next : neighbors) {
+            if (next < 0 || kinds[next] != kinds[tile] || labels[next] == target) continue;
+            relabel(next, labels[next], target);
+        }
+    }
+    labels[tile] = target;
+    ++sizes[target];
+}
+
+void RegionMap::removeFromRegion(int tile, int oldLabel) {
+    if (--sizes[oldLabel] == 0) {
+        releaseLabel(oldLabel);
+        return;
+    }
+
+    // Neighbors d and d + 1 touch each other, so each unbroken arc of same-region neighbors
+    // around the removed tile is still connected. Only separate arcs can have been split.
+    std::array<int, 6> neighbors;
+    grid.neighborIndices(tile, neighbors);
+    std::array<bool, 6> inRegion;
+    for (int dir = 0; dir < 6; ++dir) {
+        inRegion[dir] = neighbors[dir] >= 0 && labels[neighbors[dir]] == oldLabel;
+    }
+
+    std::array<int, 3> seeds;
+    int arcCount = 0;
+    for (int dir = 0; dir < 6; ++dir) {
+        if (inRegion[dir] && !inRegion[(dir + 5) % 6]) seeds[arcCount++] = neighbors[dir];
+    }
+    if (arcCount <= 1) return;
+
+    // Flood the arcs in lockstep, one tile per arc per round, so the cost is bounded by the
+    // smaller side of a split rather than the whole region. Arcs that meet are merged; an arc
+    // group that runs out of tiles without meeting the rest is a separate region.
+    beginVisit();
+    std::array<int, 3> group = {0, 1, 2};
+    std::array<bool, 3> resolved = {false, false, false};
+    std::array<size_t, 3> heads = {0, 0, 0};
+    for (int arc = 0; arc < arcCount; ++arc) {
+        arcQueues[arc].clear();
+        arcQueues[arc].push_back(seeds[arc]);
+        visitStamp[seeds[arc]] = visitGeneration;
+        visitGroup[seeds[arc]] = static_cast<uint8_t>(arc);
+    }
+    auto groupOf = [&](int arc) {
+        while (group[arc] != arc) arc = group[arc];
+        return arc;
+    };
+
+    int open = arcCount;
+    while (open > 1) {
+        for (int arc = 0; arc < arcCount && open > 1; ++arc) {
+            if (heads[arc] == arcQueues[arc].size() || resolved[groupOf(arc)]) continue;
+
+            int current = arcQueues[arc][heads[arc]++];
+            std::array<int, 6> around;
+            grid.neighborIndices(current, around);
+            for (int next : around) {
+                if (next < 0 || labels[next] != oldLabel) continue;
+                if (visitStamp[next] != visitGeneration) {
+                    visitStamp[next] = visitGeneration;
+                    visitGroup[next] = static_cast<uint8_t>(arc);
+                    arcQueues[arc].push_back(next);
+                } else {
+                    int mine = groupOf(arc);
+                    int theirs = groupOf(visitGroup[next]);
+                    if (mine != theirs) {
+                        group[std::max(mine, theirs)] = std::min(mine, theirs);
+                        if (--open == 1) break;
+                    }
+                }
+            }
+        }
+
+        // Any group with every arc exhausted is cut off from the rest
+        for (int root = 0; root < arcCount && open > 1; ++root) {
+            if (groupOf(root) != root || resolved[root]) continue;
+            bool exhausted = true;
+            for (int arc = 0; arc < arcCount; ++arc) {
+                if (groupOf(arc) == root && heads[arc] < arcQueues[arc].size()) exhausted = false;
+            }
+            if (!exhausted) continue;
+
+            int label = allocateLabel();
+            for (int arc = 0; arc < arcCount; ++arc) {
+                if (groupOf(arc) != root) continue;
+                for (int32_t member : arcQueues[arc]) labels[member] = label;
+                sizes[label] += static_cast<int32_t>(arcQueues[arc].size());
+            }
+            sizes[oldLabel] -= sizes[label];
+            resolved[root] = true;
+            --open;
+        }
+    }
+}
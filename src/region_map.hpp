@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "hex_grid.hpp"
+
+enum class RegionKind : uint8_t {
+    None,  // VOID_TERRAIN cells, never part of a region
+    Water, // Ocean, CoastalWater, River
+    Land,
+};
+
+inline RegionKind regionKindOf(TerrainType type) {
+    if (type == VOID_TERRAIN) return RegionKind::None;
+    return isWaterTerrain(type) ? RegionKind::Water : RegionKind::Land;
+}
+
+// Connected bodies of water and landmasses over a HexGrid, for constant-time "same sea?" and
+// "same continent?" checks.
+//
+// Every tile stores its region label directly, so queries are a single compare. The initial
+// labeling runs union-find over the grid; rebuildParallel() labels row strips on separate
+// threads and stitches the strip seams afterwards.
+// onTileChanged() keeps labels current without a full rebuild: a tile joining a kind merges
+// the neighboring regions by relabeling all but the largest, and a tile leaving a kind only
+// searches for a split when its remaining same-kind neighbors aren't already touching.
+class RegionMap {
+public:
+    explicit RegionMap(const HexGrid& grid);
+
+    void rebuild();
+    void rebuildParallel(int threadCount = 0);
+
+    // Call after grid.setType(tileIndex, ...)
+    void onTileChanged(int tileIndex);
+
+    int regionOf(int tile) const { return labels[tile]; }
+    RegionKind kindOf(int tile) const { return kinds[tile]; }
+    bool sameRegion(int a, int b) const { return labels[a] >= 0 && labels[a] == labels[b]; }
+
+    // True when some water region touches both tiles (a tile touches the water it is on and
+    // the water next to it), e.g. two port cities on the same sea
+    bool connectedByWater(int a, int b) const;
+
+    int regionSize(int label) const { return sizes[label]; }
+    int getRegionCount() const { return regionCount; }
+
+private:
+    const HexGrid& grid;
+    std::vector<RegionKind> kinds;
+    std::vector<int32_t> labels; // -1 for RegionKind::None
+    std::vector<int32_t> sizes;  // Per label, 0 for free labels
+    std::vector<int32_t> freeLabels;
+    int regionCount = 0;
+
+    // Union-find scratch for full rebuilds
+    std::vector<int32_t> parent;
+
+    // Flood-fill scratch for incremental edits
+    std::vector<uint32_t> visitStamp;
+    std::vector<uint8_t> visitGroup;
+    uint32_t visitGeneration = 0;
+    std::vector<int32_t> queue;
+    std::array<std::vector<int32_t>, 3> arcQueues; // A removed tile leaves at most 3 separate neighbor arcs
+
+    void resetKinds();
+    void labelRoots();
+    int find(int tile);
+    void unite(int a, int b);
+
+    int allocateLabel();
+    void releaseLabel(int label);
+    void relabel(int from, int fromLabel, int toLabel);
+    void removeFromRegion(int tile, int oldLabel);
+    void addToRegion(int tile);
+    void beginVisit();
+    void gatherWaterRegions(int tile, std::array<int, 7>& out, int& count) const;
+};
@@ -1,291 +1,1433 @@
 #include "render_graph.hpp"
+#include "device.hpp"
 
-void RenderGraph::beginFrame(Device& inDevice, Swapchain& inSwapchain, VkCommandBuffer inCmd) {
-    device = &inDevice;
-    swapchain = &inSwapchain;
-    cmd = inCmd;
-    passes.clear();
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// What a barrier recorded on a compute-only queue may wait on
+constexpr VkPipelineStageFlags2 COMPUTE_QUEUE_STAGES =
+    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT | VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+constexpr VkAccessFlags2 COMPUTE_QUEUE_ACCESS =
+    VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT |
+    VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_UNIFORM_READ_BIT |
+    VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT |
+    VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+// Mip levels and array layers of an image as half-open ranges. A range reaching the last
+// level or layer the planner tracks ends at UINT32_MAX, like its VK_REMAINING_* counts.
+struct SubresourceRect {
+    uint32_t mipBegin, mipEnd;
+    uint32_t layerBegin, layerEnd;
+
+    bool empty() const { return mipBegin >= mipEnd || layerBegin >= layerEnd; }
+};
+
+constexpr SubresourceRect WHOLE_IMAGE{0, UINT32_MAX, 0, UINT32_MAX};
+
+// Levels and layers the planner tracks of an image: as registered, or as far as accesses reach
+struct SubresourceCounts {
+    uint32_t mipLevels{1};
+    uint32_t arrayLayers{1};
+};
+
+SubresourceRect rectOf(uint32_t baseMip, uint32_t levelCount, uint32_t baseLayer, uint32_t layerCount,
+                       const SubresourceCounts& counts) {
+    uint32_t mipEnd = levelCount == VK_REMAINING_MIP_LEVELS ? UINT32_MAX : baseMip + levelCount;
+    uint32_t layerEnd = layerCount == VK_REMAINING_ARRAY_LAYERS ? UINT32_MAX : baseLayer + layerCount;
+    return {baseMip, mipEnd >= counts.mipLevels ? UINT32_MAX : mipEnd, baseLayer,
+            layerEnd >= counts.arrayLayers ? UINT32_MAX : layerEnd};
 }
 
-void RenderGraph::resetLayoutTracking() {
-    imageLayouts.clear();
-    lastMsaaImage = VK_NULL_HANDLE;
-    lastDepthImage = VK_NULL_HANDLE;
+SubresourceRect rectOf(const ImageAccess& access, const SubresourceCounts& counts) {
+    return rectOf(access.baseMipLevel, access.levelCount, access.baseArrayLayer, access.layerCount, counts);
+}
+
+SubresourceRect rectOf(const VkImageSubresourceRange& range, const SubresourceCounts& counts) {
+    return rectOf(range.baseMipLevel, range.levelCount, range.baseArrayLayer, range.layerCount, counts);
+}
+
+void setRange(VkImageSubresourceRange& range, const SubresourceRect& rect) {
+    range.baseMipLevel = rect.mipBegin;
+    range.levelCount = rect.mipEnd == UINT32_MAX ? VK_REMAINING_MIP_LEVELS : rect.mipEnd - rect.mipBegin;
+    range.baseArrayLayer = rect.layerBegin;
+    range.layerCount = rect.layerEnd == UINT32_MAX ? VK_REMAINING_ARRAY_LAYERS : rect.layerEnd - rect.layerBegin;
+}
+
+SubresourceRect intersectRect(const SubresourceRect& a, const SubresourceRect& b) {
+    return {std::max(a.mipBegin, b.mipBegin), std::min(a.mipEnd, b.mipEnd), std::max(a.layerBegin, b.layerBegin),
+            std::min(a.layerEnd, b.layerEnd)};
 }
 
+// Append the parts of a outside b: at most the levels below and above it, and the layers
+// either side of it within its levels
+void subtractRect(const SubresourceRect& a, const SubresourceRect& b, std::vector<SubresourceRect>& out) {
+    SubresourceRect shared = intersectRect(a, b);
+    if (shared.empty()) {
+        out.push_back(a);
+        return;
+    }
+    SubresourceRect parts[] = {
+        {a.mipBegin, shared.mipBegin, a.layerBegin, a.layerEnd},
+        {shared.mipEnd, a.mipEnd, a.layerBegin, a.layerEnd},
+        {shared.mipBegin, shared.mipEnd, a.layerBegin, shared.layerBegin},
+        {shared.mipBegin, shared.mipEnd, shared.layerEnd, a.layerEnd},
+    };
+    for (const SubresourceRect& part : parts) {
+        if (!part.empty()) out.push_back(part);
+    }
+}
+
+// FNV-1a over the fields that define a graph's structure
+struct StructureHasher {
+    uint64_t hash = 14695981039346656037ull;
+
+    void bytes(const void* data, size_t size) {
+        const auto* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= p[i];
+            hash *= 1099511628211ull;
+        }
+    }
+
+    template <typename T>
+    void value(const T& v) {
+        bytes(&v, sizeof(v));
+    }
+};
+
+uint64_t structureHash(const std::vector<RenderPassDesc>& passes, const Swapchain& swapchain) {
+    StructureHasher h;
+    h.value(swapchain.format);
+    h.value(swapchain.extent.width);
+    h.value(swapchain.extent.height);
+    h.value(swapchain.images.size());
+    for (const auto& pass : passes) {
+        if (pass.name) h.bytes(pass.name, std::strlen(pass.name) + 1);
+        h.value(pass.queue);
+        const RenderAttachment& att = pass.attachments;
+        h.value(att.swapchainColor);
+        if (!att.swapchainColor) {
+            h.value(att.colorView);
+            h.value(att.colorImage);
+        }
+        h.value(att.resolveView);
+        h.value(att.resolveImage);
+        h.value(att.depthView);
+        h.value(att.depthImage);
+        h.value(att.depthResolveView);
+        h.value(att.depthResolveImage);
+        h.value(att.extent.width);
+        h.value(att.extent.height);
+        h.value(att.samples);
+        h.value(att.colorFormat);
+        h.value(att.depthFormat);
+        h.value(pass.clearColor);
+        h.value(pass.clearDepth);
+        h.value(pass.clearStencil);
+        h.value(pass.colorLoadOp);
+        h.value(pass.depthLoadOp);
+        h.value(pass.sideEffects);
+        h.value(pass.images.size());
+        for (const auto& access : pass.images) {
+            h.value(access.image);
+            h.value(access.format);
+            h.value(access.usage);
+            h.value(access.baseMipLevel);
+            h.value(access.levelCount);
+            h.value(access.baseArrayLayer);
+            h.value(access.layerCount);
+            h.value(access.discard);
+        }
+    }
+    return h.hash;
+}
+
+// What a pass's attachments imply, in the order they are bound
+void appendAttachmentAccesses(const RenderPassDesc& pass, VkImage colorImage, std::vector<ImageAccess>& out) {
+    const RenderAttachment& att = pass.attachments;
+    auto add = [&](VkImage image, VkFormat format, ImageUsage usage, bool discard) {
+        if (image == VK_NULL_HANDLE) return;
+        ImageAccess access{};
+        access.image = image;
+        access.format = format;
+        access.usage = usage;
+        access.discard = discard;
+        out.push_back(access);
+    };
+    // Resolves overwrite the whole render area
+    add(colorImage, att.colorFormat, ImageUsage::ColorAttachment, pass.colorLoadOp != VK_ATTACHMENT_LOAD_OP_LOAD);
+    add(att.resolveImage, att.colorFormat, ImageUsage::ColorResolve, true);
+    add(att.depthImage, att.depthFormat, ImageUsage::DepthAttachment, pass.depthLoadOp != VK_ATTACHMENT_LOAD_OP_LOAD);
+    add(att.depthResolveImage, att.depthFormat, ImageUsage::DepthResolve, true);
+}
+
+bool readsImage(const ImageAccess& access) {
+    return !usageInfo(access.usage, access.format).writes || !access.discard;
+}
+
+bool writesImage(const ImageAccess& access) {
+    return usageInfo(access.usage, access.format).writes;
+}
+
+// Walk the passes backwards from the present: a pass is kept if it writes something a kept
+// pass (or the present) reads before it is overwritten, or if it has side effects
+std::vector<bool> findLivePasses(const std::vector<RenderPassDesc>& passes,
+                                 const std::vector<std::vector<ImageAccess>>& accesses, VkImage target) {
+    std::vector<bool> live(passes.size(), false);
+    std::vector<VkImage> needed{target};
+    auto isNeeded = [&](VkImage image) { return std::find(needed.begin(), needed.end(), image) != needed.end(); };
+
+    for (size_t i = passes.size(); i-- > 0;) {
+        live[i] = passes[i].sideEffects;
+        for (const ImageAccess& access : accesses[i]) {
+            if (writesImage(access) && isNeeded(access.image)) live[i] = true;
+        }
+        if (!live[i]) continue;
+
+        // Whatever this pass overwrites whole is no longer needed from earlier passes, unless it
+        // reads it too
+        for (const ImageAccess& access : accesses[i]) {
+            bool whole = access.baseMipLevel == 0 && access.levelCount == VK_REMAINING_MIP_LEVELS &&
+                         access.baseArrayLayer == 0 && access.layerCount == VK_REMAINING_ARRAY_LAYERS;
+            if (writesImage(access) && access.discard && whole) {
+                needed.erase(std::remove(needed.begin(), needed.end(), access.image), needed.end());
+            }
+        }
+        for (const ImageAccess& access : accesses[i]) {
+            if (readsImage(access) && !isNeeded(access.image)) needed.push_back(access.image);
+        }
+    }
+    return live;
+}
+
+bool sameAttachments(const RenderAttachment& a, const RenderAttachment& b) {
+    return a.colorView == b.colorView && a.resolveView == b.resolveView && a.depthView == b.depthView &&
+           a.depthResolveView == b.depthResolveView && a.extent.width == b.extent.width &&
+           a.extent.height == b.extent.height && a.samples == b.samples && a.colorFormat == b.colorFormat &&
+           a.depthFormat == b.depthFormat && a.colorImage == b.colorImage && a.resolveImage == b.resolveImage &&
+           a.depthImage == b.depthImage && a.depthResolveImage == b.depthResolveImage &&
+           a.swapchainColor == b.swapchainColor;
+}
+
+// Whether pass can continue the rendering scope of the pass before it: the same attachments,
+// loaded rather than cleared, and nothing it samples written earlier in the scope (that needs a
+// barrier, which can't go inside a rendering scope)
+bool canMerge(const RenderPassDesc& scope, const RenderPassDesc& pass, const ImageAccess* scopeAccesses,
+              size_t scopeAccessCount) {
+    if (scope.queue != PassQueue::Graphics || pass.queue != PassQueue::Graphics) return false;
+    if (!sameAttachments(scope.attachments, pass.attachments)) return false;
+    bool hasColor = pass.attachments.swapchainColor || pass.attachments.colorImage != VK_NULL_HANDLE;
+    if (hasColor && pass.colorLoadOp != VK_ATTACHMENT_LOAD_OP_LOAD) return false;
+    if (pass.attachments.depthImage != VK_NULL_HANDLE && pass.depthLoadOp != VK_ATTACHMENT_LOAD_OP_LOAD) return false;
+    for (const ImageAccess& access : pass.images) {
+        if (writesImage(access)) return false;
+        for (size_t i = 0; i < scopeAccessCount; ++i) {
+            if (scopeAccesses[i].image == access.image && writesImage(scopeAccesses[i])) return false;
+        }
+    }
+    return true;
+}
+
+// Plan every access group of a compiled graph in order, the last group being the present
+void planFrame(BarrierPlanner& planner, const CompiledGraph& graph, BarrierPlan& out) {
+    out.clear();
+    size_t groups = graph.accessOffsets.size() - 1;
+    size_t alias = 0;
+    for (size_t group = 0; group < groups; ++group) {
+        // The offset pushed before the present group is passOffsets.back()
+        out.passOffsets.push_back(static_cast<uint32_t>(out.barriers.size()));
+        for (; alias < graph.aliases.size() && graph.aliases[alias].group == group; ++alias) {
+            planner.alias(graph.aliases[alias].image, graph.aliases[alias].previous);
+        }
+        uint32_t begin = graph.accessOffsets[group];
+        uint32_t end = graph.accessOffsets[group + 1];
+        planner.plan(graph.accesses.data() + begin, end - begin, out.barriers);
+    }
+}
+
+void recordBarriers(CommandRecorder& recorder, VkCommandBuffer cmd, const VkImageMemoryBarrier2* barriers, uint32_t count) {
+    if (count == 0) return;
+    VkDependencyInfo dep{};
+    dep.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dep.imageMemoryBarrierCount = count;
+    dep.pImageMemoryBarriers = barriers;
+    recorder.pipelineBarrier(cmd, dep);
+}
+
+void recordBarriers(CommandRecorder& recorder, VkCommandBuffer cmd, const BarrierPlan& plan, uint32_t begin, uint32_t end) {
+    recordBarriers(recorder, cmd, plan.barriers.data() + begin, end - begin);
+}
+
+// The acquire semaphore is waited on at color output, so the first barrier must chain from
+// that stage. The image is in the layout it was last left in: undefined until presented once.
+void importSwapchainImage(BarrierPlanner& planner, ImageHandle image) {
+    planner.import(image, planner.layoutOf(image), VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+}
+
+} // namespace
+
 void RenderGraph::addPass(const RenderPassDesc& pass) {
     passes.push_back(pass);
 }
 
-void RenderGraph::execute() {
-    for (const auto& pass : passes) {
-        // Prepare image layout transitions
-        VkImageMemoryBarrier2 barriers[4]{};
-        uint32_t barrierCount = 0;
-
-        // Color or MSAA color target
-        if (pass.attachments.colorImage != VK_NULL_HANDLE) {
-            auto& b = barriers[barrierCount++];
-            b.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
-            // Choose a conservative src stage for layout-only transitions
-            b.srcStageMask = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT;
-            b.srcAccessMask = 0;
-            b.dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
-            b.dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
-            // Use known old layout if tracked; otherwise assume UNDEFINED (first use or after recreate)
-            VkImage oldImg = pass.attachments.colorImage;
-            VkImageLayout oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            auto it = imageLayouts.find(oldImg);
-            if (it != imageLayouts.end()) {
-                oldLayout = it->second;
+void RenderGraph::resetLayoutTracking() {
+    planner.reset();
+    registerImages(planner);
+    swapchainHandles.clear();
+    cache.clear();
+    current = nullptr;
+    lastExecuted = nullptr;
+    firstFramePlan.clear();
+    lastPlan = &firstFramePlan;
+    recordGraph = nullptr;
+}
+
+void RenderGraph::registerImage(VkImage image, uint32_t mipLevels, uint32_t arrayLayers) {
+    registeredImages.push_back(RegisteredImage{image, mipLevels, arrayLayers});
+    planner.registerImage(image, mipLevels, arrayLayers);
+}
+
+void RenderGraph::registerImages(BarrierPlanner& target) const {
+    for (const RegisteredImage& registered : registeredImages) {
+        target.registerImage(registered.image, registered.mipLevels, registered.arrayLayers);
+    }
+    for (const TransientImage& transient : transients) {
+        target.registerImage(transient.image.image, transient.image.mipLevels);
+    }
+}
+
+const CompiledGraph& RenderGraph::compile(Device& device, const Swapchain& swapchain) {
+    if (passes.empty()) {
+        throw std::runtime_error("Failed to compile render graph: no passes declared");
+    }
+    if (swapchain.images.empty()) {
+        throw std::runtime_error("Failed to compile render graph: swapchain has no images");
+    }
+
+    uint64_t hash = structureHash(passes, swapchain);
+    auto [it, inserted] = cache.try_emplace(hash);
+    CompiledGraph& graph = it->second;
+    if (inserted) {
+        graph.hash = hash;
+        try {
+            build(graph, device, swapchain);
+        } catch (...) {
+            cache.erase(it);
+            throw;
+        }
+    }
+    for (auto& compiled : graph.passes) {
+        compiled.records.clear();
+    }
+    for (size_t i = 0; i < passes.size(); ++i) {
+        if (graph.scopeOf[i] >= 0 && passes[i].record) {
+            graph.passes[graph.scopeOf[i]].records.push_back(std::move(passes[i].record));
+        }
+    }
+    passes.clear();
+    current = &graph;
+    recordGraph = nullptr; // New callbacks
+    return graph;
+}
+
+void RenderGraph::build(CompiledGraph& graph, Device& device, const Swapchain& swapchain) {
+    // Plan with the current swapchain image and remember where it appears so frames can
+    // substitute theirs
+    VkImage target = swapchain.images[swapchain.currentImageIndex].image;
+
+    std::vector<std::vector<ImageAccess>> declared(passes.size());
+    for (size_t i = 0; i < passes.size(); ++i) {
+        const RenderAttachment& att = passes[i].attachments;
+        appendAttachmentAccesses(passes[i], att.swapchainColor ? target : att.colorImage, declared[i]);
+        declared[i].insert(declared[i].end(), passes[i].images.begin(), passes[i].images.end());
+    }
+
+    // Drop passes nothing reads from, then fold passes into the rendering scope before them
+    // where possible. Each scope's accesses are its first pass's plus what the merged passes
+    // sample; their attachment uses are the same as the first pass's.
+    std::vector<bool> live = findLivePasses(passes, declared, target);
+    std::vector<size_t> scopeFirst;
+    graph.scopeOf.assign(passes.size(), -1);
+    for (size_t i = 0; i < passes.size(); ++i) {
+        const RenderAttachment& att = passes[i].attachments;
+        if (passes[i].queue == PassQueue::AsyncCompute &&
+            (att.swapchainColor || att.colorImage || att.colorView || att.resolveImage || att.resolveView ||
+             att.depthImage || att.depthView || att.depthResolveImage || att.depthResolveView)) {
+            throw std::runtime_error(std::string("Failed to compile render graph: compute pass ") +
+                                     (passes[i].name ? passes[i].name : "") + " has attachments");
+        }
+        if (!live[i]) {
+            graph.report.culled.push_back(passes[i].name ? passes[i].name : "");
+            continue;
+        }
+        if (!scopeFirst.empty()) {
+            const RenderPassDesc& scope = passes[scopeFirst.back()];
+            uint32_t begin = graph.accessOffsets.back();
+            if (canMerge(scope, passes[i], graph.accesses.data() + begin, graph.accesses.size() - begin)) {
+                graph.accesses.insert(graph.accesses.end(), passes[i].images.begin(), passes[i].images.end());
+                graph.scopeOf[i] = static_cast<int32_t>(scopeFirst.size() - 1);
+                graph.report.merged.emplace_back(passes[i].name ? passes[i].name : "", scope.name ? scope.name : "");
+                continue;
             }
-            b.oldLayout = oldLayout;
-            b.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-            // If transitioning from PRESENT, use BOTTOM_OF_PIPE as source stage
-            if (oldLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR) {
-                b.srcStageMask = VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT;
+        }
+        graph.scopeOf[i] = static_cast<int32_t>(scopeFirst.size());
+        scopeFirst.push_back(i);
+        graph.accessOffsets.push_back(static_cast<uint32_t>(graph.accesses.size()));
+        graph.accesses.insert(graph.accesses.end(), declared[i].begin(), declared[i].end());
+    }
+    graph.accessOffsets.push_back(static_cast<uint32_t>(graph.accesses.size()));
+    ImageAccess present{};
+    present.image = target;
+    present.format = swapchain.format;
+    present.usage = ImageUsage::Present;
+    graph.accesses.push_back(present);
+    graph.accessOffsets.push_back(static_cast<uint32_t>(graph.accesses.size()));
+
+    for (uint32_t i = 0; i < graph.accesses.size(); ++i) {
+        if (graph.accesses[i].image == target) graph.swapchainAccesses.push_back(i);
+    }
+
+    graph.passes.resize(scopeFirst.size());
+    for (size_t scope = 0; scope < scopeFirst.size(); ++scope) {
+        graph.passes[scope].name = passes[scopeFirst[scope]].name;
+        graph.passes[scope].queue = passes[scopeFirst[scope]].queue;
+    }
+
+    // Transient images need memory and views before the attachments can refer to them
+    placeTransients(graph, device);
+
+    for (size_t scope = 0; scope < scopeFirst.size(); ++scope) {
+        const RenderPassDesc& pass = passes[scopeFirst[scope]];
+        const RenderAttachment& att = pass.attachments;
+
+        CompiledPass& compiled = graph.passes[scope];
+        compiled.swapchainColor = att.swapchainColor;
+
+        // Build rendering attachments
+        bool hasColor = att.swapchainColor || att.colorImage != VK_NULL_HANDLE || att.colorView != VK_NULL_HANDLE;
+        if (hasColor) {
+            compiled.color.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+            compiled.color.imageView = att.swapchainColor ? VK_NULL_HANDLE : viewOf(att.colorView, att.colorImage);
+            compiled.color.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            compiled.color.loadOp = pass.colorLoadOp;
+            compiled.color.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            compiled.color.clearValue.color = pass.clearColor;
+
+            // Resolve if provided
+            VkImageView resolveView = viewOf(att.resolveView, att.resolveImage);
+            if (resolveView != VK_NULL_HANDLE) {
+                compiled.color.resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
+                compiled.color.resolveImageView = resolveView;
+                compiled.color.resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
             }
-            b.image = pass.attachments.colorImage;
-            b.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            b.subresourceRange.baseMipLevel = 0;
-            b.subresourceRange.levelCount = 1;
-            b.subresourceRange.baseArrayLayer = 0;
-            b.subresourceRange.layerCount = 1;
-            imageLayouts[pass.attachments.colorImage] = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-        }
-
-        // Resolve target (swapchain) if provided
-        if (pass.attachments.resolveImage != VK_NULL_HANDLE) {
-            auto& b = barriers[barrierCount++];
-            b.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
-            b.srcStageMask = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT;
-            b.srcAccessMask = 0;
-            b.dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
-            b.dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
-            VkImage oldImg = pass.attachments.resolveImage;
-            VkImageLayout oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            auto it = imageLayouts.find(oldImg);
-            if (it != imageLayouts.end()) {
-                oldLayout = it->second;
+        }
+
+        // Depth attachment
+        VkImageView depthView = viewOf(att.depthView, att.depthImage);
+        bool hasDepth = depthView != VK_NULL_HANDLE;
+        if (hasDepth) {
+            compiled.depth.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+            compiled.depth.imageView = depthView;
+            compiled.depth.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            compiled.depth.loadOp = pass.depthLoadOp;
+            compiled.depth.storeOp = VK_ATTACHMENT_STORE_OP_STORE; // Preserve depth for subsequent passes
+            compiled.depth.clearValue.depthStencil = {pass.clearDepth, pass.clearStencil};
+            // Depth resolve to single-sample if provided
+            VkImageView depthResolveView = viewOf(att.depthResolveView, att.depthResolveImage);
+            if (depthResolveView != VK_NULL_HANDLE) {
+                compiled.depth.resolveMode = VK_RESOLVE_MODE_MIN_BIT;
+                compiled.depth.resolveImageView = depthResolveView;
+                compiled.depth.resolveImageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
             }
-            b.oldLayout = oldLayout;
-            b.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-            // If transitioning from PRESENT, use BOTTOM_OF_PIPE as source stage
-            if (oldLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR) {
-                b.srcStageMask = VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT;
+        }
+
+        // graph.passes is fully sized, so these pointers stay valid
+        compiled.rendering.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+        compiled.rendering.renderArea.offset = {0, 0};
+        compiled.rendering.renderArea.extent = att.extent;
+        compiled.rendering.layerCount = 1;
+        compiled.rendering.colorAttachmentCount = hasColor ? 1 : 0;
+        compiled.rendering.pColorAttachments = hasColor ? &compiled.color : nullptr;
+        compiled.rendering.pDepthAttachment = hasDepth ? &compiled.depth : nullptr;
+
+        compiled.colorFormat = att.swapchainColor ? swapchain.format : att.colorFormat;
+        compiled.inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+        compiled.inheritance.colorAttachmentCount = hasColor ? 1 : 0;
+        compiled.inheritance.pColorAttachmentFormats = hasColor ? &compiled.colorFormat : nullptr;
+        compiled.inheritance.depthAttachmentFormat = hasDepth ? att.depthFormat : VK_FORMAT_UNDEFINED;
+        compiled.inheritance.rasterizationSamples = att.samples;
+    }
+
+    // Run the frame once to reach the state it leaves behind, then plan it again from there:
+    // those are the barriers every following frame of this plan needs
+    BarrierPlanner steady;
+    registerImages(steady);
+    ImageHandle targetHandle = steady.registerImage(target);
+    importSwapchainImage(steady, targetHandle);
+    planFrame(steady, graph, graph.barriers);
+    importSwapchainImage(steady, targetHandle);
+    planFrame(steady, graph, graph.barriers);
+    if (asyncCompute) {
+        scheduleQueues(graph);
+        splitAcrossQueues(graph, &graph, graph.barriers, graph.acquires, graph.releases, graph.handOvers);
+    }
+
+    for (uint32_t i = 0; i < graph.barriers.barriers.size(); ++i) {
+        if (graph.barriers.barriers[i].image == target) graph.swapchainBarriers.push_back(i);
+    }
+
+    // An image acquired for the first time is still undefined where the plan expects it presented
+    if (!graph.swapchainBarriers.empty()) {
+        uint32_t first = graph.swapchainBarriers.front();
+        if (graph.barriers.barriers[first].oldLayout != VK_IMAGE_LAYOUT_UNDEFINED) {
+            graph.swapchainAcquireBarrier = static_cast<int32_t>(first);
+        }
+    }
+}
+
+void RenderGraph::placeTransients(CompiledGraph& graph, Device& device) {
+    if (transients.empty()) return;
+
+    // Lifetime of each transient image: the first and last pass that touches it
+    uint32_t passCount = static_cast<uint32_t>(graph.accessOffsets.size() - 2);
+    std::vector<TransientRequest> requests(transients.size());
+    for (uint32_t t = 0; t < transients.size(); ++t) {
+        requests[t].size = transients[t].requirements.size;
+        requests[t].alignment = transients[t].requirements.alignment;
+        requests[t].memoryTypeBits = transients[t].requirements.memoryTypeBits;
+        requests[t].firstPass = UINT32_MAX;
+        requests[t].lastPass = 0;
+    }
+    for (uint32_t pass = 0; pass < passCount; ++pass) {
+        for (uint32_t i = graph.accessOffsets[pass]; i < graph.accessOffsets[pass + 1]; ++i) {
+            for (uint32_t t = 0; t < transients.size(); ++t) {
+                if (transients[t].image.image != graph.accesses[i].image) continue;
+                requests[t].firstPass = std::min(requests[t].firstPass, pass);
+                requests[t].lastPass = std::max(requests[t].lastPass, pass);
             }
-            b.image = pass.attachments.resolveImage;
-            b.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            b.subresourceRange.baseMipLevel = 0;
-            b.subresourceRange.levelCount = 1;
-            b.subresourceRange.baseArrayLayer = 0;
-            b.subresourceRange.layerCount = 1;
-            imageLayouts[pass.attachments.resolveImage] = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
         }
+    }
+    for (auto& request : requests) {
+        // Images this graph doesn't use are kept alive throughout
+        if (request.firstPass == UINT32_MAX) {
+            request.firstPass = 0;
+            request.lastPass = passCount > 0 ? passCount - 1 : 0;
+        }
+    }
 
-        // Depth attachment
-        if (pass.attachments.depthImage != VK_NULL_HANDLE) {
-            auto& b = barriers[barrierCount++];
-            b.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
-            VkImage oldImg = pass.attachments.depthImage;
-            VkImageLayout oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            auto it = imageLayouts.find(oldImg);
-            if (it != imageLayouts.end()) {
-                oldLayout = it->second;
+    if (transientMemory.empty()) {
+        transientLayout = solveAliasing(requests);
+        for (const TransientHeap& heap : transientLayout.heapInfo) {
+            VkMemoryRequirements requirements{};
+            requirements.size = heap.size;
+            requirements.alignment = heap.alignment;
+            requirements.memoryTypeBits = heap.memoryTypeBits;
+
+            VmaAllocationCreateInfo allocInfo{};
+            allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            allocInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+
+            VmaAllocation allocation = VK_NULL_HANDLE;
+            if (vmaAllocateMemory(device.allocator, &requirements, &allocInfo, &allocation, nullptr) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate transient image memory!");
+            }
+            transientMemory.push_back(allocation);
+        }
+        for (uint32_t t = 0; t < transients.size(); ++t) {
+            Image& image = transients[t].image;
+            if (vmaBindImageMemory2(device.allocator, transientMemory[transientLayout.heaps[t]],
+                                    transientLayout.offsets[t], image.image, nullptr) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to bind transient image memory!");
+            }
+            VkImageAspectFlags aspect = aspectFromFormat(image.format);
+            createImageView(device, image, (aspect & VK_IMAGE_ASPECT_DEPTH_BIT) ? VK_IMAGE_ASPECT_DEPTH_BIT : aspect);
+        }
+    }
+
+    for (uint32_t t = 0; t < transients.size(); ++t) {
+        for (uint32_t other = 0; other < transients.size(); ++other) {
+            if (!transientLayout.overlaps(t, other)) continue;
+            if (requests[t].firstPass <= requests[other].lastPass && requests[other].firstPass <= requests[t].lastPass) {
+                throw std::runtime_error("Transient images sharing memory are both alive in pass " +
+                                         std::string(graph.passes[std::max(requests[t].firstPass, requests[other].firstPass)].name));
             }
-            
-            // If depth was written in a previous pass, we need to wait for those writes
-            if (oldLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
-                b.srcStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
-                b.srcAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-            } else {
-                b.srcStageMask = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT;
-                b.srcAccessMask = 0;
+            graph.aliases.push_back(TransientAlias{requests[t].firstPass, transients[t].image.image, transients[other].image.image});
+        }
+    }
+    std::stable_sort(graph.aliases.begin(), graph.aliases.end(),
+                     [](const TransientAlias& a, const TransientAlias& b) { return a.group < b.group; });
+
+    // Memory another image has used holds nothing this one could read
+    for (const TransientAlias& alias : graph.aliases) {
+        for (uint32_t i = graph.accessOffsets[alias.group]; i < graph.accessOffsets[alias.group + 1]; ++i) {
+            const ImageAccess& access = graph.accesses[i];
+            if (access.image == alias.image && !(usageInfo(access.usage, access.format).writes && access.discard)) {
+                throw std::runtime_error("Transient image sharing memory is read before it is written in pass " +
+                                         std::string(graph.passes[alias.group].name));
             }
-            
-            // Determine destination access based on target usage
-            if (pass.depthReadOnly) {
-                // We will sample or read-only: transition to READ_ONLY optimal
-                b.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
-                b.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
-            } else {
-                // Attachment usage
-                if (pass.depthLoadOp == VK_ATTACHMENT_LOAD_OP_LOAD) {
-                    // Loading existing depth - need read access
-                    b.dstStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
-                    b.dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-                } else {
-                    // Clearing depth - just write access
-                    b.dstStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
-                    b.dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        }
+    }
+}
+
+VkImageView RenderGraph::viewOf(VkImageView view, VkImage image) const {
+    if (view != VK_NULL_HANDLE || image == VK_NULL_HANDLE) return view;
+    for (const auto& transient : transients) {
+        if (transient.image.image == image) return transient.image.view;
+    }
+    return VK_NULL_HANDLE;
+}
+
+uint32_t RenderGraph::createTransientImage(Device& device, const TransientImageDesc& desc) {
+    TransientImage transient{};
+    transient.image.format = desc.format;
+    transient.image.width = desc.extent.width;
+    transient.image.height = desc.extent.height;
+    transient.image.mipLevels = desc.mipLevels;
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width = desc.extent.width;
+    imageInfo.extent.height = desc.extent.height;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = desc.mipLevels;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = desc.format;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = desc.usage;
+    imageInfo.samples = desc.samples;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    // Memory is bound by the first compile, once lifetimes are known
+    if (vkCreateImage(device.device, &imageInfo, nullptr, &transient.image.image) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create transient image!");
+    }
+    vkGetImageMemoryRequirements(device.device, transient.image.image, &transient.requirements);
+
+    transients.push_back(transient);
+    planner.registerImage(transient.image.image, desc.mipLevels);
+    return static_cast<uint32_t>(transients.size() - 1);
+}
+
+void RenderGraph::destroyTransientImages(Device& device) {
+    for (auto& transient : transients) {
+        if (transient.image.view != VK_NULL_HANDLE) {
+            vkDestroyImageView(device.device, transient.image.view, nullptr);
+        }
+        vkDestroyImage(device.device, transient.image.image, nullptr);
+    }
+    for (VmaAllocation allocation : transientMemory) {
+        vmaFreeMemory(device.allocator, allocation);
+    }
+    transients.clear();
+    transientMemory.clear();
+    transientLayout = {};
+    resetLayoutTracking();
+}
+
+void RenderGraph::execute(VkCommandBuffer cmd, const Swapchain& swapchain) {
+    if (!current) {
+        throw std::runtime_error("Failed to execute render graph: not compiled");
+    }
+    const SwapchainImage& target = swapchain.images[swapchain.currentImageIndex];
+    CompiledGraph& graph = *current;
+    bool async = !graph.batches.empty();
+
+    uint32_t imageIndex = swapchain.currentImageIndex;
+    if (swapchainHandles.size() <= imageIndex) swapchainHandles.resize(swapchain.images.size(), INVALID_IMAGE_HANDLE);
+    ImageHandle& targetHandle = swapchainHandles[imageIndex];
+    if (targetHandle == INVALID_IMAGE_HANDLE) targetHandle = planner.registerImage(target.image);
+
+    const BarrierPlan* plan = &graph.barriers;
+    const std::vector<std::vector<VkImageMemoryBarrier2>>* acquires = &graph.acquires;
+    const std::vector<std::vector<VkImageMemoryBarrier2>>* releases = &graph.releases;
+    if (current != lastExecuted) {
+        // First frame of this plan: images are in whatever state the last plan left them, so
+        // plan against the tracked state once
+        for (uint32_t i : graph.swapchainAccesses) graph.accesses[i].image = target.image;
+        importSwapchainImage(planner, targetHandle);
+        planFrame(planner, graph, firstFramePlan);
+        if (async) splitAcrossQueues(graph, lastExecuted, firstFramePlan, firstFrameAcquires, firstFrameReleases,
+                                     graph.handOvers);
+        plan = &firstFramePlan;
+        acquires = &firstFrameAcquires;
+        releases = &firstFrameReleases;
+        lastExecuted = current;
+    } else {
+        for (uint32_t i : graph.swapchainBarriers) graph.barriers.barriers[i].image = target.image;
+        if (graph.swapchainAcquireBarrier >= 0) {
+            graph.barriers.barriers[graph.swapchainAcquireBarrier].oldLayout = planner.layoutOf(targetHandle);
+        }
+        // Every frame ends by presenting it
+        planner.import(targetHandle, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_NONE);
+    }
+    lastPlan = plan;
+
+    // The profiler reads back what this frame slot timed the last time it was recorded
+    uint32_t frame = swapchain.currentFrame;
+    bool profiling = profiler.isEnabled();
+    if (profiling) profiler.beginFrame(frame);
+
+    // So is everything in its arena
+    FrameArena& arena = frameArenas[frame];
+    arena.reset();
+    arenaFrame = frame;
+
+    // Each batch records into a command buffer of its own, the first graphics batch into cmd
+    batchCount = async ? static_cast<uint32_t>(graph.batches.size()) : 1;
+    batchCommands = arena.allocateArray<VkCommandBuffer>(batchCount);
+    std::fill_n(batchCommands, batchCount, cmd);
+    batchValues = arena.allocateArray<uint64_t>(batchCount);
+    if (async) {
+        for (size_t queue = 0; queue < 2; ++queue) {
+            RecordPool& pool = queuePools[frame * 2 + queue];
+            if (pool.used == 0) continue;
+            if (vkResetCommandPool(vkDevice, pool.pool, 0) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to reset command pool!");
+            }
+            pool.used = 0;
+        }
+        bool firstGraphics = true;
+        for (size_t batch = 0; batch < graph.batches.size(); ++batch) {
+            PassQueue queue = graph.batches[batch].queue;
+            if (queue == PassQueue::Graphics && firstGraphics) {
+                firstGraphics = false;
+                continue;
+            }
+            batchCommands[batch] = beginBatchCommands(frame, queue);
+        }
+        // Take over what the other queue family released at the end of the previous frame
+        for (size_t batch = 0; batch < graph.batches.size(); ++batch) {
+            const auto& batchAcquires = (*acquires)[batch];
+            recordBarriers(*recorder, batchCommands[batch], batchAcquires.data(), static_cast<uint32_t>(batchAcquires.size()));
+        }
+    }
+
+    bool parallel = recordJobSystem != nullptr;
+    if (parallel) {
+        recordInParallel(frame);
+        if (profiling) {
+            for (size_t i = 0; i < recordSlots.size(); ++i) {
+                const CompiledPass& pass = graph.passes[recordSlots[i].scope];
+                profiler.addCpuTime(pass.name ? pass.name : "", recordSpans[i].worker,
+                                    recordSpans[i].start, recordSpans[i].end);
+            }
+        }
+    }
+
+    // Callbacks recorded here run on the calling thread, worker 0
+    auto recordTimed = [&](const CompiledPass& pass, const std::function<void(VkCommandBuffer)>& record, VkCommandBuffer passCmd) {
+        if (!profiling) {
+            record(passCmd);
+            return;
+        }
+        int64_t start = PassProfiler::now();
+        record(passCmd);
+        profiler.addCpuTime(pass.name ? pass.name : "", 0, start, PassProfiler::now());
+    };
+
+    uint32_t slot = 0;
+    for (size_t passIndex = 0; passIndex < graph.passes.size(); ++passIndex) {
+        CompiledPass& pass = graph.passes[passIndex];
+        VkCommandBuffer passCmd = async ? batchCommands[graph.batchOf[passIndex]] : cmd;
+        // The timestamps bracket the pass's barriers too, so its waits show up in its time
+        int32_t query = -1;
+        if (profiling) {
+            uint32_t lane = async && pass.queue == PassQueue::AsyncCompute ? 1 : 0;
+            query = profiler.beginPass(*recorder, passCmd, pass.name ? pass.name : "", lane);
+        }
+        recordBarriers(*recorder, passCmd, *plan, plan->passOffsets[passIndex], plan->passOffsets[passIndex + 1]);
+
+        // Compute passes are recorded here, outside any rendering scope
+        if (pass.queue == PassQueue::AsyncCompute) {
+            for (const auto& record : pass.records) {
+                recordTimed(pass, record, passCmd);
+            }
+            if (profiling) profiler.endPass(*recorder, passCmd, query);
+            continue;
+        }
+
+        if (pass.swapchainColor) pass.color.imageView = target.view;
+        if (parallel) {
+            pass.rendering.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+            recorder->beginRendering(passCmd, pass.rendering);
+            uint32_t count = static_cast<uint32_t>(pass.records.size());
+            if (count > 0) recorder->executeCommands(passCmd, count, recordSecondaries + slot);
+            slot += count;
+        } else {
+            pass.rendering.flags = 0;
+            recorder->beginRendering(passCmd, pass.rendering);
+            for (const auto& record : pass.records) {
+                recordTimed(pass, record, passCmd);
+            }
+        }
+        recorder->endRendering(passCmd);
+        if (profiling) profiler.endPass(*recorder, passCmd, query);
+    }
+
+    // Transition the swapchain image to present
+    recordBarriers(*recorder, batchCommands[batchCount - 1], *plan, plan->passOffsets.back(), static_cast<uint32_t>(plan->barriers.size()));
+
+    if (async) {
+        // Hand images over to the other queue family after each batch's last use of them, in
+        // this frame or the next
+        for (size_t batch = 0; batch < graph.batches.size(); ++batch) {
+            const auto& batchReleases = (*releases)[batch];
+            const auto& batchHandOvers = graph.handOvers[batch];
+            recordBarriers(*recorder, batchCommands[batch], batchReleases.data(), static_cast<uint32_t>(batchReleases.size()));
+            recordBarriers(*recorder, batchCommands[batch], batchHandOvers.data(), static_cast<uint32_t>(batchHandOvers.size()));
+            if (batchCommands[batch] != cmd && vkEndCommandBuffer(batchCommands[batch]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to record command buffer!");
+            }
+        }
+    }
+}
+
+void RenderGraph::submit(Device& device, VkCommandBuffer cmd, const FrameSubmitInfo& info) {
+    VkSemaphoreSubmitInfo acquire{};
+    acquire.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    acquire.semaphore = info.waitSemaphore;
+    acquire.stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+    // Signal renderFinished for present and the frame's timeline value
+    VkSemaphoreSubmitInfo frameSignals[2]{};
+    frameSignals[0].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    frameSignals[0].semaphore = info.signalSemaphore;
+    frameSignals[0].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    frameSignals[1].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    frameSignals[1].semaphore = info.timelineSemaphore;
+    frameSignals[1].value = info.timelineValue;
+    frameSignals[1].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+    if (!current || current->batches.empty()) {
+        VkCommandBufferSubmitInfo commandInfo{};
+        commandInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+        commandInfo.commandBuffer = cmd;
+
+        VkSubmitInfo2 submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+        submitInfo.waitSemaphoreInfoCount = 1;
+        submitInfo.pWaitSemaphoreInfos = &acquire;
+        submitInfo.commandBufferInfoCount = 1;
+        submitInfo.pCommandBufferInfos = &commandInfo;
+        submitInfo.signalSemaphoreInfoCount = 2;
+        submitInfo.pSignalSemaphoreInfos = frameSignals;
+        if (vkQueueSubmit2(device.queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to submit draw command buffer!");
+        }
+        return;
+    }
+
+    // Batches go out in order. Each waits at its start for the other queue's batch it depends
+    // on; compute starts after the previous frame's graphics, and the last graphics batch
+    // waits for all of the frame's compute, so the frame's timeline value covers both queues.
+    const CompiledGraph& graph = *current;
+    uint64_t computeSignaled = 0;
+    for (size_t batch = 0; batch < graph.batches.size(); ++batch) {
+        const QueueBatch& queueBatch = graph.batches[batch];
+        size_t queue = static_cast<size_t>(queueBatch.queue);
+        bool last = batch + 1 == graph.batches.size();
+
+        VkSemaphoreSubmitInfo waits[2]{};
+        uint32_t waitCount = 0;
+        uint64_t waitValue = queueBatch.waitBatch >= 0 ? batchValues[queueBatch.waitBatch] : 0;
+        if (queueBatch.queue == PassQueue::AsyncCompute && waitValue == 0) waitValue = lastFrameGraphicsValue;
+        if (last) waitValue = std::max(waitValue, computeSignaled);
+        if (waitValue != 0) {
+            waits[waitCount].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+            waits[waitCount].semaphore = queueTimelines[1 - queue];
+            waits[waitCount].value = waitValue;
+            waits[waitCount].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+            ++waitCount;
+        }
+        if (batch == graph.acquireBatch) waits[waitCount++] = acquire;
+
+        batchValues[batch] = ++queueTimelineValues[queue];
+        VkSemaphoreSubmitInfo signals[3]{};
+        signals[0].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+        signals[0].semaphore = queueTimelines[queue];
+        signals[0].value = batchValues[batch];
+        signals[0].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        uint32_t signalCount = 1;
+        if (last) {
+            signals[signalCount++] = frameSignals[0];
+            signals[signalCount++] = frameSignals[1];
+            lastFrameGraphicsValue = batchValues[batch];
+        }
+        if (queueBatch.queue == PassQueue::AsyncCompute) computeSignaled = batchValues[batch];
+
+        VkCommandBufferSubmitInfo commandInfo{};
+        commandInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+        commandInfo.commandBuffer = batchCommands[batch];
+
+        VkSubmitInfo2 submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+        submitInfo.waitSemaphoreInfoCount = waitCount;
+        submitInfo.pWaitSemaphoreInfos = waits;
+        submitInfo.commandBufferInfoCount = 1;
+        submitInfo.pCommandBufferInfos = &commandInfo;
+        submitInfo.signalSemaphoreInfoCount = signalCount;
+        submitInfo.pSignalSemaphoreInfos = signals;
+        VkQueue target = queueBatch.queue == PassQueue::Graphics ? device.queue : device.computeQueue;
+        if (vkQueueSubmit2(target, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to submit draw command buffer!");
+        }
+    }
+}
+
+void RenderGraph::scheduleQueues(CompiledGraph& graph) const {
+    size_t scopes = graph.passes.size();
+
+    // Scopes depend on each other when they touch the same image, or images sharing memory
+    auto sharesImage = [&](size_t a, size_t b) {
+        for (uint32_t i = graph.accessOffsets[a]; i < graph.accessOffsets[a + 1]; ++i) {
+            for (uint32_t j = graph.accessOffsets[b]; j < graph.accessOffsets[b + 1]; ++j) {
+                VkImage x = graph.accesses[i].image;
+                VkImage y = graph.accesses[j].image;
+                if (x == y) return true;
+                for (const TransientAlias& alias : graph.aliases) {
+                    if ((alias.image == x && alias.previous == y) || (alias.image == y && alias.previous == x)) {
+                        return true;
+                    }
                 }
             }
-            
-            b.oldLayout = oldLayout;
-            b.newLayout = pass.depthReadOnly
-                ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
-                : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-            b.image = pass.attachments.depthImage;
-            b.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-            b.subresourceRange.baseMipLevel = 0;
-            b.subresourceRange.levelCount = 1;
-            b.subresourceRange.baseArrayLayer = 0;
-            b.subresourceRange.layerCount = 1;
-            lastDepthImage = pass.attachments.depthImage;
-            imageLayouts[pass.attachments.depthImage] = b.newLayout;
-        }
-
-        // Depth resolve target (single-sample) if provided
-        if (pass.attachments.depthResolveImage != VK_NULL_HANDLE) {
-            auto& b = barriers[barrierCount++];
-            b.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
-            VkImage oldImg = pass.attachments.depthResolveImage;
-            VkImageLayout oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            auto it = imageLayouts.find(oldImg);
-            if (it != imageLayouts.end()) {
-                oldLayout = it->second;
+        }
+        return false;
+    };
+
+    // A scope waits for the last scope on the other queue it depends on; the other queue's
+    // work before that is ordered by the queue itself
+    std::vector<int32_t> waitScope(scopes, -1);
+    std::vector<bool> waitedFor(scopes, false);
+    for (size_t s = 0; s < scopes; ++s) {
+        for (size_t t = s; t-- > 0;) {
+            if (graph.passes[t].queue != graph.passes[s].queue && sharesImage(s, t)) {
+                waitScope[s] = static_cast<int32_t>(t);
+                waitedFor[t] = true;
+                break;
+            }
+        }
+    }
+
+    // A queue's scopes share a batch until one has to wait for more than the batch already
+    // waits for, or is waited for
+    int32_t open[2] = {-1, -1};
+    graph.batchOf.assign(scopes, 0);
+    for (size_t s = 0; s < scopes; ++s) {
+        size_t queue = static_cast<size_t>(graph.passes[s].queue);
+        bool waits = waitScope[s] >= 0 &&
+                     (open[queue] < 0 || static_cast<int32_t>(graph.batchOf[waitScope[s]]) > graph.batches[open[queue]].waitBatch);
+        if (open[queue] < 0 || waits) {
+            QueueBatch batch;
+            batch.queue = graph.passes[s].queue;
+            if (waitScope[s] >= 0) batch.waitBatch = static_cast<int32_t>(graph.batchOf[waitScope[s]]);
+            graph.batches.push_back(batch);
+            open[queue] = static_cast<int32_t>(graph.batches.size() - 1);
+        }
+        graph.batchOf[s] = static_cast<uint32_t>(open[queue]);
+        if (waitedFor[s]) open[queue] = -1;
+    }
+    // The present is recorded last, on the graphics queue
+    if (graph.batches.empty() || graph.batches.back().queue != PassQueue::Graphics) {
+        graph.batches.push_back(QueueBatch{});
+    }
+
+    graph.acquireBatch = static_cast<uint32_t>(graph.batches.size() - 1);
+    for (size_t s = 0; s < scopes; ++s) {
+        if (graph.passes[s].swapchainColor) {
+            graph.acquireBatch = graph.batchOf[s];
+            break;
+        }
+    }
+}
+
+void RenderGraph::splitAcrossQueues(const CompiledGraph& graph, const CompiledGraph* previous, BarrierPlan& plan,
+                                    std::vector<std::vector<VkImageMemoryBarrier2>>& acquires,
+                                    std::vector<std::vector<VkImageMemoryBarrier2>>& releases,
+                                    std::vector<std::vector<VkImageMemoryBarrier2>>& handOvers) const {
+    size_t groups = graph.accessOffsets.size() - 1;
+    auto queueOf = [](const CompiledGraph& compiled, size_t group) {
+        bool async = !compiled.batches.empty() && group < compiled.passes.size();
+        return async ? compiled.passes[group].queue : PassQueue::Graphics;
+    };
+    auto batchOf = [&](size_t group) {
+        return group < graph.batchOf.size() ? graph.batchOf[group] : static_cast<uint32_t>(graph.batches.size() - 1);
+    };
+    auto familyOf = [&](PassQueue queue) { return queueFamilies[static_cast<size_t>(queue)]; };
+    bool sameFamily = queueFamilies[0] == queueFamilies[1];
+    bool steady = previous == &graph;
+
+    std::unordered_map<VkImage, SubresourceCounts> counts;
+    for (const RegisteredImage& registered : registeredImages) {
+        counts[registered.image] = SubresourceCounts{registered.mipLevels, registered.arrayLayers};
+    }
+    for (const TransientImage& transient : transients) {
+        counts[transient.image.image] = SubresourceCounts{transient.image.mipLevels, 1};
+    }
+    for (const CompiledGraph* compiled : {&graph, previous}) {
+        if (!compiled) continue;
+        for (const ImageAccess& access : compiled->accesses) {
+            SubresourceCounts& tracked = counts[access.image];
+            if (access.levelCount != VK_REMAINING_MIP_LEVELS) {
+                tracked.mipLevels = std::max(tracked.mipLevels, access.baseMipLevel + access.levelCount);
             }
-            // Destination is depth attachment write (resolve destination)
-            b.srcStageMask = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT;
-            b.srcAccessMask = 0;
-            b.dstStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
-            b.dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-            b.oldLayout = oldLayout;
-            b.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-            b.image = pass.attachments.depthResolveImage;
-            b.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-            b.subresourceRange.baseMipLevel = 0;
-            b.subresourceRange.levelCount = 1;
-            b.subresourceRange.baseArrayLayer = 0;
-            b.subresourceRange.layerCount = 1;
-            imageLayouts[pass.attachments.depthResolveImage] = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-        }
-
-        // Any sampled images requested by this pass
-        for (VkImage sampled : pass.sampledImages) {
-            auto& b = barriers[barrierCount++];
-            b.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
-            VkImageLayout oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            auto it = imageLayouts.find(sampled);
-            if (it != imageLayouts.end()) {
-                oldLayout = it->second;
+            if (access.layerCount != VK_REMAINING_ARRAY_LAYERS) {
+                tracked.arrayLayers = std::max(tracked.arrayLayers, access.baseArrayLayer + access.layerCount);
             }
-            // Transition from whatever (likely COLOR_ATTACHMENT_OPTIMAL) to SHADER_READ_ONLY
-            b.srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
-            b.srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-            b.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
-            b.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT;
-            b.oldLayout = oldLayout;
-            b.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            b.image = sampled;
-            b.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT; // assume color; if depth, caller should use depthReadOnly
-            b.subresourceRange.baseMipLevel = 0;
-            b.subresourceRange.levelCount = 1;
-            b.subresourceRange.baseArrayLayer = 0;
-            b.subresourceRange.layerCount = 1;
-            imageLayouts[sampled] = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        }
-
-        if (barrierCount > 0) {
-            VkDependencyInfo dep{};
-            dep.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
-            dep.imageMemoryBarrierCount = barrierCount;
-            dep.pImageMemoryBarriers = barriers;
-            vkCmdPipelineBarrier2(cmd, &dep);
         }
+    }
+    auto countsOf = [&](VkImage image) {
+        auto it = counts.find(image);
+        return it != counts.end() ? it->second : SubresourceCounts{};
+    };
 
-        // Build rendering attachments
-        VkRenderingAttachmentInfo colorAttachment{};
-        VkRenderingAttachmentInfo* pColorAttachment = nullptr;
-        if (pass.attachments.colorView != VK_NULL_HANDLE) {
-            colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
-            colorAttachment.imageView = pass.attachments.colorView;
-            colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-            colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-            colorAttachment.clearValue.color = pass.clearColor;
+    // Where each subresource range of an image was last used, starting from its last use in
+    // the frame before. An image's ranges don't overlap.
+    struct LastUse {
+        SubresourceRect range;
+        PassQueue queue;
+        int32_t scope;
+        bool previousFrame;
+    };
+    std::unordered_map<VkImage, std::vector<LastUse>> last;
+    std::vector<LastUse> kept;
+    std::vector<SubresourceRect> pieces;
+    std::vector<SubresourceRect> rest;
+    auto markUsed = [&](const ImageAccess& access, PassQueue queue, int32_t scope, bool previousFrame) {
+        SubresourceRect range = rectOf(access, countsOf(access.image));
+        std::vector<LastUse>& uses = last[access.image];
+        kept.clear();
+        for (const LastUse& use : uses) {
+            pieces.clear();
+            subtractRect(use.range, range, pieces);
+            for (const SubresourceRect& piece : pieces) kept.push_back(LastUse{piece, use.queue, use.scope, use.previousFrame});
+        }
+        kept.push_back(LastUse{range, queue, scope, previousFrame});
+        uses.swap(kept);
+    };
+    // Remove cut from every rect in rects
+    auto cutOut = [&](std::vector<SubresourceRect>& rects, const SubresourceRect& cut) {
+        rest.clear();
+        for (const SubresourceRect& rect : rects) subtractRect(rect, cut, rest);
+        rects.swap(rest);
+    };
+    if (previous) {
+        for (size_t group = 0; group + 1 < previous->accessOffsets.size(); ++group) {
+            for (uint32_t i = previous->accessOffsets[group]; i < previous->accessOffsets[group + 1]; ++i) {
+                markUsed(previous->accesses[i], queueOf(*previous, group), static_cast<int32_t>(group), true);
+            }
+        }
+    }
 
-            // Resolve if provided
-            if (pass.attachments.resolveView != VK_NULL_HANDLE) {
-                colorAttachment.resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
-                colorAttachment.resolveImageView = pass.attachments.resolveView;
-                colorAttachment.resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    // What the previous plan's last frame released at its end, for the first frame after it.
+    // Each is acquired whole by the first batch on its family to use any of it.
+    struct Pending {
+        VkImageMemoryBarrier2 acquire;
+        bool taken;
+    };
+    std::vector<Pending> pending;
+    if (previous && !steady) {
+        for (const auto& batchAcquires : previous->acquires) {
+            for (const VkImageMemoryBarrier2& acquire : batchAcquires) pending.push_back(Pending{acquire, false});
+        }
+    }
+
+    BarrierPlan split;
+    acquires.assign(graph.batches.size(), {});
+    releases.assign(graph.batches.size(), {});
+    if (steady) handOvers.assign(graph.batches.size(), {});
+    std::vector<SubresourceRect> remainder;
+    std::vector<SubresourceRect> unclaimed;
+    size_t alias = 0;
+    for (size_t group = 0; group < groups; ++group) {
+        for (; alias < graph.aliases.size() && graph.aliases[alias].group == group; ++alias) {
+            // The memory was last used where the previous image's latest use was
+            auto it = last.find(graph.aliases[alias].previous);
+            if (it == last.end() || it->second.empty()) continue;
+            LastUse latest = *std::max_element(it->second.begin(), it->second.end(), [](const LastUse& a, const LastUse& b) {
+                return a.previousFrame != b.previousFrame ? a.previousFrame : a.scope < b.scope;
+            });
+            latest.range = WHOLE_IMAGE;
+            last[graph.aliases[alias].image] = {latest};
+        }
+        PassQueue queue = queueOf(graph, group);
+        size_t begin = split.barriers.size();
+        split.passOffsets.push_back(static_cast<uint32_t>(begin));
+
+        // Within the frame, the other queue's family gives up a range it used last after that
+        // use, and this queue takes it with a barrier that matches
+        auto transfer = [&](VkImageMemoryBarrier2& acquire, const LastUse& previousUse) {
+            acquire.srcQueueFamilyIndex = familyOf(previousUse.queue);
+            acquire.dstQueueFamilyIndex = familyOf(queue);
+            VkImageMemoryBarrier2 release = acquire;
+            release.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+            release.dstAccessMask = VK_ACCESS_2_NONE;
+            releases[batchOf(previousUse.scope)].push_back(release);
+        };
+        // From one frame of this plan to the next, the range is released at the end of the batch
+        // that used it last and acquired at the start of the batch that uses it first, keeping
+        // its layout; this pass's barrier then changes the layout on this queue. Every frame of
+        // the plan releases, the first included, whichever plan runs next.
+        auto handOver = [&](const VkImageMemoryBarrier2& barrier, const LastUse& previousUse) {
+            VkImageMemoryBarrier2 acquire = barrier;
+            acquire.newLayout = acquire.oldLayout;
+            acquire.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+            acquire.srcAccessMask = VK_ACCESS_2_NONE;
+            acquire.srcQueueFamilyIndex = familyOf(previousUse.queue);
+            acquire.dstQueueFamilyIndex = familyOf(queue);
+            acquires[batchOf(group)].push_back(acquire);
+            VkImageMemoryBarrier2 release = acquire;
+            release.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+            release.dstAccessMask = VK_ACCESS_2_NONE;
+            handOvers[batchOf(previousUse.scope)].push_back(release);
+        };
+        // In the first frame after another plan: whether this queue's family owns range, taking
+        // what the other plan released to it. Contents handed to the other family, or left with
+        // it, can't be kept.
+        auto takeOver = [&](VkImage image, const SubresourceRect& range, const LastUse& previousUse) {
+            unclaimed.assign(1, range);
+            for (Pending& handed : pending) {
+                if (handed.acquire.image != image) continue;
+                SubresourceRect released = rectOf(handed.acquire.subresourceRange, countsOf(image));
+                if (intersectRect(range, released).empty()) continue;
+                if (handed.acquire.dstQueueFamilyIndex != familyOf(queue)) return false;
+                if (!handed.taken) acquires[batchOf(group)].push_back(handed.acquire);
+                handed.taken = true;
+                rest.clear();
+                for (const SubresourceRect& rect : unclaimed) subtractRect(rect, released, rest);
+                unclaimed.swap(rest);
             }
-            pColorAttachment = &colorAttachment;
-        }
-
-        // Depth attachment (only include when writing/reading as attachment)
-        VkRenderingAttachmentInfo depthAttachment{};
-        VkRenderingAttachmentInfo* pDepthAttachment = nullptr;
-        if (pass.attachments.depthView != VK_NULL_HANDLE && !pass.depthReadOnly) {
-            depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
-            depthAttachment.imageView = pass.attachments.depthView;
-            depthAttachment.imageLayout = pass.depthReadOnly
-                ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
-                : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-            depthAttachment.loadOp = pass.depthLoadOp;
-            depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; // Preserve depth for subsequent passes
-            depthAttachment.clearValue.depthStencil = { pass.clearDepth, pass.clearStencil };
-            // Depth resolve to single-sample if provided
-            if (pass.attachments.depthResolveView != VK_NULL_HANDLE) {
-                depthAttachment.resolveMode = VK_RESOLVE_MODE_MIN_BIT;
-                depthAttachment.resolveImageView = pass.attachments.depthResolveView;
-                depthAttachment.resolveImageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            return unclaimed.empty() || previousUse.queue == queue;
+        };
+
+        uint32_t planEnd = group + 1 < plan.passOffsets.size() ? plan.passOffsets[group + 1]
+                                                               : static_cast<uint32_t>(plan.barriers.size());
+        for (uint32_t b = plan.passOffsets[group]; b < planEnd; ++b) {
+            const VkImageMemoryBarrier2& planned = plan.barriers[b];
+            SubresourceRect range = rectOf(planned.subresourceRange, countsOf(planned.image));
+            remainder.assign(1, range);
+            auto it = last.find(planned.image);
+            if (it != last.end()) {
+                for (const LastUse& use : it->second) {
+                    SubresourceRect shared = intersectRect(range, use.range);
+                    bool crosses = use.queue != queue;
+                    bool handedAway = !sameFamily && !steady && use.previousFrame;
+                    if (shared.empty() || (!crosses && !handedAway)) continue;
+                    VkImageMemoryBarrier2 barrier = planned;
+                    setRange(barrier.subresourceRange, shared);
+                    if (crosses) {
+                        // The semaphore wait this batch starts with orders it after the other
+                        // queue and makes that queue's writes available
+                        barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+                        barrier.srcAccessMask = VK_ACCESS_2_NONE;
+                    }
+                    if (!sameFamily && barrier.oldLayout != VK_IMAGE_LAYOUT_UNDEFINED) {
+                        if (!use.previousFrame) {
+                            transfer(barrier, use);
+                        } else if (steady) {
+                            handOver(barrier, use);
+                        } else if (!takeOver(planned.image, shared, use)) {
+                            barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                        }
+                    }
+                    split.barriers.push_back(barrier);
+                    cutOut(remainder, shared);
+                }
             }
-            pDepthAttachment = &depthAttachment;
-        }
-
-        // Begin dynamic rendering
-        VkRenderingInfo renderingInfo{};
-        renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
-        renderingInfo.renderArea.offset = {0, 0};
-        renderingInfo.renderArea.extent = pass.attachments.extent;
-        renderingInfo.layerCount = 1;
-        renderingInfo.colorAttachmentCount = (pColorAttachment != nullptr) ? 1 : 0;
-        renderingInfo.pColorAttachments = pColorAttachment;
-        renderingInfo.pDepthAttachment = pDepthAttachment;
-
-        vkCmdBeginRendering(cmd, &renderingInfo);
-        if (pass.record) {
-            pass.record(cmd);
-        }
-        vkCmdEndRendering(cmd);
-    }
-}
-
-void RenderGraph::endFrame() {
-    // Transition current swapchain image to present for display
-    if (!swapchain || swapchain->images.empty()) return;
-
-    VkImage presentImage = swapchain->images[swapchain->currentImageIndex].image;
-    // The image should be in COLOR_ATTACHMENT_OPTIMAL after rendering
-    // (we set it in execute() after the barrier)
-    VkImageLayout currentLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    VkImageMemoryBarrier2 presentBarrier{};
-    presentBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
-    presentBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
-    presentBarrier.srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
-    presentBarrier.dstStageMask = VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT;
-    presentBarrier.dstAccessMask = 0;
-    presentBarrier.oldLayout = currentLayout;
-    presentBarrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-    presentBarrier.image = presentImage;
-    presentBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    presentBarrier.subresourceRange.baseMipLevel = 0;
-    presentBarrier.subresourceRange.levelCount = 1;
-    presentBarrier.subresourceRange.baseArrayLayer = 0;
-    presentBarrier.subresourceRange.layerCount = 1;
+            for (const SubresourceRect& piece : remainder) {
+                VkImageMemoryBarrier2 barrier = planned;
+                setRange(barrier.subresourceRange, piece);
+                if (queue == PassQueue::AsyncCompute && (barrier.srcStageMask & ~COMPUTE_QUEUE_STAGES) != 0) {
+                    // Graphics stages in here are reads the semaphore wait covers as well
+                    barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+                    barrier.srcAccessMask &= COMPUTE_QUEUE_ACCESS;
+                }
+                split.barriers.push_back(barrier);
+            }
+        }
 
-    VkDependencyInfo dep{};
-    dep.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
-    dep.imageMemoryBarrierCount = 1;
-    dep.pImageMemoryBarriers = &presentBarrier;
-    vkCmdPipelineBarrier2(cmd, &dep);
+        // Ranges the planner needed no barrier for still change owner between families
+        if (!sameFamily) {
+            for (uint32_t i = graph.accessOffsets[group]; i < graph.accessOffsets[group + 1]; ++i) {
+                const ImageAccess& access = graph.accesses[i];
+                auto it = last.find(access.image);
+                if (it == last.end()) continue;
+                SubresourceRect range = rectOf(access, countsOf(access.image));
+                ImageUsageInfo info = usageInfo(access.usage, access.format);
+                for (const LastUse& use : it->second) {
+                    SubresourceRect shared = intersectRect(range, use.range);
+                    bool crosses = use.queue != queue;
+                    if (shared.empty() || (!crosses && (steady || !use.previousFrame))) continue;
+                    remainder.assign(1, shared);
+                    for (size_t b = begin; b < split.barriers.size() && !remainder.empty(); ++b) {
+                        if (split.barriers[b].image == access.image) {
+                            cutOut(remainder, rectOf(split.barriers[b].subresourceRange, countsOf(access.image)));
+                        }
+                    }
+                    for (const SubresourceRect& piece : remainder) {
+                        VkImageMemoryBarrier2 barrier{};
+                        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+                        barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+                        barrier.dstStageMask = info.stages;
+                        barrier.dstAccessMask = info.access;
+                        barrier.oldLayout = info.layout;
+                        barrier.newLayout = info.layout;
+                        barrier.image = access.image;
+                        barrier.subresourceRange.aspectMask = aspectFromFormat(access.format);
+                        setRange(barrier.subresourceRange, piece);
+                        if (!use.previousFrame) {
+                            transfer(barrier, use);
+                        } else if (steady) {
+                            handOver(barrier, use);
+                            continue;
+                        } else if (takeOver(access.image, piece, use)) {
+                            continue;
+                        } else {
+                            barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                        }
+                        split.barriers.push_back(barrier);
+                    }
+                }
+            }
+        }
+
+        for (uint32_t i = graph.accessOffsets[group]; i < graph.accessOffsets[group + 1]; ++i) {
+            markUsed(graph.accesses[i], queue, static_cast<int32_t>(group), false);
+        }
+    }
+    plan = std::move(split);
+}
+
+VkCommandBuffer RenderGraph::beginBatchCommands(uint32_t frame, PassQueue queue) {
+    RecordPool& pool = queuePools[frame * 2 + static_cast<size_t>(queue)];
+    if (pool.used == pool.buffers.size()) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = pool.pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer buffer = VK_NULL_HANDLE;
+        if (vkAllocateCommandBuffers(vkDevice, &allocInfo, &buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate command buffer!");
+        }
+        pool.buffers.push_back(buffer);
+    }
+    VkCommandBuffer cmd = pool.buffers[pool.used++];
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to begin command buffer!");
+    }
+    return cmd;
+}
+
+bool RenderGraph::enableAsyncCompute(Device& device) {
+    disableAsyncCompute(device);
+    if (device.computeQueue == VK_NULL_HANDLE) return false;
+    vkDevice = device.device;
+    queueFamilies[0] = device.queueFamilyIndex;
+    queueFamilies[1] = device.computeQueueFamilyIndex;
+
+    VkSemaphoreTypeCreateInfo timelineCreateInfo{};
+    timelineCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    timelineCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    timelineCreateInfo.initialValue = 0;
+    VkSemaphoreCreateInfo semaphoreCreateInfo{};
+    semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreCreateInfo.pNext = &timelineCreateInfo;
+
+    for (size_t queue = 0; queue < 2; ++queue) {
+        if (vkCreateSemaphore(device.device, &semaphoreCreateInfo, nullptr, &queueTimelines[queue]) != VK_SUCCESS) {
+            disableAsyncCompute(device);
+            throw std::runtime_error("Failed to create timeline semaphore!");
+        }
+    }
+
+    queuePools.resize(Swapchain::MAX_FRAMES_IN_FLIGHT * 2);
+    for (size_t i = 0; i < queuePools.size(); ++i) {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = queueFamilies[i % 2];
+        if (vkCreateCommandPool(device.device, &poolInfo, nullptr, &queuePools[i].pool) != VK_SUCCESS) {
+            disableAsyncCompute(device);
+            throw std::runtime_error("Failed to create command pool!");
+        }
+    }
+
+    // Plans compiled so far were scheduled for one queue
+    asyncCompute = true;
+    resetLayoutTracking();
+    return true;
+}
+
+void RenderGraph::disableAsyncCompute(Device& device) {
+    for (RecordPool& pool : queuePools) {
+        if (pool.pool != VK_NULL_HANDLE) vkDestroyCommandPool(device.device, pool.pool, nullptr);
+    }
+    queuePools.clear();
+    for (size_t queue = 0; queue < 2; ++queue) {
+        if (queueTimelines[queue] != VK_NULL_HANDLE) vkDestroySemaphore(device.device, queueTimelines[queue], nullptr);
+        queueTimelines[queue] = VK_NULL_HANDLE;
+        queueTimelineValues[queue] = 0;
+    }
+    lastFrameGraphicsValue = 0;
+    if (asyncCompute) {
+        asyncCompute = false;
+        resetLayoutTracking();
+    }
+}
+
+void RenderGraph::enableProfiling(Device& device) {
+    disableProfiling(device);
+    profiler.init(device, Swapchain::MAX_FRAMES_IN_FLIGHT);
+}
+
+void RenderGraph::disableProfiling(Device& device) {
+    profiler.destroy(device);
+}
+
+void RenderGraph::enableParallelRecording(Device& device, JobSystem& jobs, uint32_t queueFamilyIndex) {
+    disableParallelRecording(device);
+    vkDevice = device.device;
+
+    // Pools are reset whole once their frame's submission is done
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = queueFamilyIndex;
+
+    size_t workerCount = static_cast<size_t>(jobs.getWorkerCount());
+    recordPools.resize(Swapchain::MAX_FRAMES_IN_FLIGHT * workerCount);
+    for (RecordPool& pool : recordPools) {
+        if (vkCreateCommandPool(device.device, &poolInfo, nullptr, &pool.pool) != VK_SUCCESS) {
+            disableParallelRecording(device);
+            throw std::runtime_error("Failed to create command pool!");
+        }
+    }
+    recordJobSystem = &jobs;
+    recordTimings.workerNanoseconds.assign(workerCount, 0);
+    recordTimings.workerRecords.assign(workerCount, 0);
+    resetRecordTimings();
+}
+
+void RenderGraph::disableParallelRecording(Device& device) {
+    // Destroying a pool frees its command buffers
+    for (RecordPool& pool : recordPools) {
+        if (pool.pool != VK_NULL_HANDLE) vkDestroyCommandPool(device.device, pool.pool, nullptr);
+    }
+    recordPools.clear();
+    recordSlots.clear();
+    recordSecondaries = nullptr;
+    recordSpans = nullptr;
+    recordJobs.clear();
+    recordGraph = nullptr;
+    recordJobSystem = nullptr;
+}
 
-    // Don't track PRESENT layout - after presenting, driver may reset to UNDEFINED
-    // Remove from map so next frame assumes UNDEFINED (safe transition)
-    imageLayouts.erase(presentImage);
+void RenderGraph::resetRecordTimings() {
+    std::fill(recordTimings.workerNanoseconds.begin(), recordTimings.workerNanoseconds.end(), 0);
+    std::fill(recordTimings.workerRecords.begin(), recordTimings.workerRecords.end(), 0);
+    recordTimings.wallNanoseconds = 0;
+    recordTimings.frames = 0;
 }
 
+void RenderGraph::recordInParallel(uint32_t frame) {
+    // One job per graphics callback, listed in the order execute() stitches them back together. The
+    // job graph only depends on the callbacks, so it is rebuilt only when they change.
+    if (recordGraph != current) {
+        recordSlots.clear();
+        for (uint32_t scope = 0; scope < current->passes.size(); ++scope) {
+            if (current->passes[scope].queue != PassQueue::Graphics) continue; // Recorded by execute()
+            for (uint32_t record = 0; record < current->passes[scope].records.size(); ++record) {
+                recordSlots.push_back(RecordSlot{scope, record});
+            }
+        }
+        recordJobs.clear();
+        recordJobs.addParallel(recordSlots.size(), 1, [this](size_t begin, size_t end) {
+            for (size_t slot = begin; slot < end; ++slot) recordSlot(slot);
+        });
+        recordGraph = current;
+    }
+
+    // The frame's last submission has finished, so its secondaries can be recorded again
+    size_t workerCount = recordTimings.workerNanoseconds.size();
+    recordFrame = frame;
+    for (size_t worker = 0; worker < workerCount; ++worker) {
+        RecordPool& pool = recordPools[frame * workerCount + worker];
+        if (pool.used == 0) continue;
+        if (vkResetCommandPool(vkDevice, pool.pool, 0) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to reset command pool!");
+        }
+        pool.used = 0;
+    }
+    recordSecondaries = frameArenas[frame].allocateArray<VkCommandBuffer>(recordSlots.size());
+    recordSpans = frameArenas[frame].allocateArray<RecordSpan>(recordSlots.size());
+
+    auto start = std::chrono::steady_clock::now();
+    recordJobSystem->run(recordJobs);
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    recordTimings.wallNanoseconds += static_cast<uint64_t>(elapsed.count());
+    ++recordTimings.frames;
+}
+
+void RenderGraph::recordSlot(size_t slot) {
+    auto start = std::chrono::steady_clock::now();
+
+    // Each worker records only into its own pool, so no locking is needed
+    size_t worker = static_cast<size_t>(std::max(JobSystem::currentWorker(), 0));
+    RecordPool& pool = recordPools[recordFrame * recordTimings.workerNanoseconds.size() + worker];
+    if (pool.used == pool.buffers.size()) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = pool.pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
 
+        VkCommandBuffer buffer = VK_NULL_HANDLE;
+        if (vkAllocateCommandBuffers(vkDevice, &allocInfo, &buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate secondary command buffer!");
+        }
+        pool.buffers.push_back(buffer);
+    }
+    VkCommandBuffer cmd = pool.buffers[pool.used++];
+
+    // Continue the rendering scope execute() begins for this pass
+    const RecordSlot& where = recordSlots[slot];
+    const CompiledPass& pass = current->passes[where.scope];
+    VkCommandBufferInheritanceInfo inheritance{};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.pNext = &pass.inheritance;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritance;
+    if (vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to begin secondary command buffer!");
+    }
+    if (profiler.isEnabled()) {
+        int64_t recordStart = PassProfiler::now();
+        pass.records[where.record](cmd);
+        recordSpans[slot] = RecordSpan{recordStart, PassProfiler::now(), static_cast<uint32_t>(worker)};
+    } else {
+        pass.records[where.record](cmd);
+    }
+    if (vkEndCommandBuffer(cmd) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to record secondary command buffer!");
+    }
+    recordSecondaries[slot] = cmd;
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    recordTimings.workerNanoseconds[worker] += static_cast<uint64_t>(elapsed.count());
+    ++recordTimings.workerRecords[worker];
+}
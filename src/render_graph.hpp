@@ -1,11 +1,21 @@
 #pragma once
 
 #include <vulkan/vulkan.h>
+#include <cstdint>
 #include <functional>
-#include <vector>
+#include <string>
 #include <unordered_map>
-#include "device.hpp"
+#include <utility>
+#include <vector>
+#include "barrier_planner.hpp"
+#include "command_recorder.hpp"
+#include "frame_arena.hpp"
+#include "job_system.hpp"
+#include "pass_profiler.hpp"
 #include "swapchain.hpp"
+#include "transient_aliasing.hpp"
+
+struct Device;
 
 struct RenderAttachment {
     VkImageView colorView{VK_NULL_HANDLE};
@@ -17,46 +27,322 @@ struct RenderAttachment {
     VkFormat colorFormat{VK_FORMAT_UNDEFINED};
     VkFormat depthFormat{VK_FORMAT_UNDEFINED};
 
-    // Images are required for layout transitions; views alone are insufficient.
+    // Images are required for layout transitions; views alone are insufficient. Views of
+    // transient images may be left null and are filled in by compile().
     VkImage colorImage{VK_NULL_HANDLE};
     VkImage resolveImage{VK_NULL_HANDLE};
     VkImage depthImage{VK_NULL_HANDLE};
     VkImage depthResolveImage{VK_NULL_HANDLE};
+
+    // Render into the acquired swapchain image. colorView and colorImage are ignored and
+    // patched in every frame, so the compiled plan doesn't depend on the image index.
+    bool swapchainColor{false};
+};
+
+// An image that lives only within a frame. The graph creates it and places it in memory it
+// shares with transient images whose lifetimes in the frame don't overlap.
+struct TransientImageDesc {
+    VkFormat format{VK_FORMAT_UNDEFINED};
+    VkExtent2D extent{};
+    VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
+    VkImageUsageFlags usage{0};
+    uint32_t mipLevels{1};
+};
+
+// image reuses memory previous had, starting with the pass group it is first used in
+struct TransientAlias {
+    uint32_t group;
+    VkImage image;
+    VkImage previous;
+};
+
+// Queue a pass runs on
+enum class PassQueue : uint8_t {
+    Graphics,
+    // Compute work without attachments. Runs on Device::computeQueue, overlapping the graphics
+    // passes it doesn't share images with, once enableAsyncCompute() found one; until then
+    // (or without a second queue) it runs in order on the graphics queue.
+    AsyncCompute,
 };
 
 struct RenderPassDesc {
     const char* name;
+    PassQueue queue{PassQueue::Graphics};
     RenderAttachment attachments;
     VkClearColorValue clearColor{};
     float clearDepth{1.0f};
     uint32_t clearStencil{0};
+    VkAttachmentLoadOp colorLoadOp{VK_ATTACHMENT_LOAD_OP_CLEAR}; // LOAD to draw over an earlier pass
     VkAttachmentLoadOp depthLoadOp{VK_ATTACHMENT_LOAD_OP_CLEAR}; // Control depth load operation
-    bool depthReadOnly{false}; // If true, transition/use depth as READ_ONLY for sampling
-    // Images that will be sampled in this pass (transition to SHADER_READ_ONLY_OPTIMAL)
-    std::vector<VkImage> sampledImages;
+    // Keep the pass even when no later pass reads what it writes (e.g. it writes buffers)
+    bool sideEffects{false};
+    // Images used other than as attachments (sampled textures, storage images, ...).
+    // Attachment usage is derived from attachments.
+    std::vector<ImageAccess> images;
+    // Records the pass's commands inside its rendering scope. With parallel recording it runs
+    // on a worker thread, alongside the other passes' callbacks, so it must only read shared
+    // state; it gets a secondary command buffer and sets its own viewport and scissor.
     std::function<void(VkCommandBuffer)> record;
 };
 
+// Barriers derived for one frame: those before pass i are [passOffsets[i], passOffsets[i + 1])
+// and the final present transition runs from passOffsets.back() to the end.
+struct BarrierPlan {
+    std::vector<VkImageMemoryBarrier2> barriers;
+    std::vector<uint32_t> passOffsets;
+
+    void clear() {
+        barriers.clear();
+        passOffsets.clear();
+    }
+};
+
+// Rendering state of one rendering scope, built once at compile time. Passes merged into the
+// scope record one after another inside it.
+struct CompiledPass {
+    const char* name; // Of the first pass in the scope
+    VkRenderingAttachmentInfo color{};
+    VkRenderingAttachmentInfo depth{};
+    VkRenderingInfo rendering{};
+    bool swapchainColor{false};
+    std::vector<std::function<void(VkCommandBuffer)>> records;
+    PassQueue queue{PassQueue::Graphics}; // AsyncCompute scopes have no rendering scope
+
+    // What secondary command buffers recorded for this scope inherit
+    VkFormat colorFormat{VK_FORMAT_UNDEFINED};
+    VkCommandBufferInheritanceRenderingInfo inheritance{};
+};
+
+// What compile() did to the declared passes
+struct CompileReport {
+    std::vector<std::string> culled;                          // Nothing read what they wrote
+    std::vector<std::pair<std::string, std::string>> merged; // (pass, pass whose scope it joined)
+};
+
+// One submission of a frame split across the graphics and compute queues: the scopes of one
+// queue between two points where it has to wait for, or signal, the other
+struct QueueBatch {
+    PassQueue queue{PassQueue::Graphics};
+    int32_t waitBatch{-1}; // Batch of the other queue this one waits for before starting
+};
+
+// What a frame submits besides its command buffers
+struct FrameSubmitInfo {
+    VkSemaphore waitSemaphore{VK_NULL_HANDLE};     // Acquire, waited on at color output
+    VkSemaphore signalSemaphore{VK_NULL_HANDLE};   // Binary, waited on by present
+    VkSemaphore timelineSemaphore{VK_NULL_HANDLE}; // Reaches timelineValue when the frame is done
+    uint64_t timelineValue{0};
+};
+
+// Where recording time went with parallel recording, summed over the frames since
+// resetRecordTimings()
+struct RecordTimings {
+    std::vector<uint64_t> workerNanoseconds; // In record callbacks and begin/end, per worker
+    std::vector<uint32_t> workerRecords;     // Callbacks each worker ran
+    uint64_t wallNanoseconds{0};             // From starting the jobs to the last one ending
+    uint32_t frames{0};
+};
+
+// Execution plan for one graph structure. Everything a frame needs is precomputed; a frame
+// only writes the acquired swapchain image into the barriers and attachments that use it.
+struct CompiledGraph {
+    uint64_t hash{0};
+    std::vector<CompiledPass> passes;
+    std::vector<int32_t> scopeOf; // Scope of each declared pass, -1 if culled
+    CompileReport report;
+
+    // Barriers for a frame that follows a frame of the same plan
+    BarrierPlan barriers;
+    std::vector<uint32_t> swapchainBarriers; // Indices into barriers.barriers
+    int32_t swapchainAcquireBarrier{-1};     // Its first barrier if that keeps the image's contents
+
+    // What each pass touches, grouped like BarrierPlan (the last group is the present), kept
+    // to plan the first frame against whatever state the previous plan left behind
+    std::vector<ImageAccess> accesses;
+    std::vector<uint32_t> accessOffsets;
+    std::vector<uint32_t> swapchainAccesses; // Indices into accesses
+    std::vector<TransientAlias> aliases;     // Sorted by group
+
+    // With async compute: the frame's submissions in order, the last being graphics and
+    // holding the present transition, the queue family acquires each starts with and the
+    // releases each ends with. Empty on a single queue.
+    std::vector<QueueBatch> batches;
+    std::vector<uint32_t> batchOf; // Batch of each scope
+    uint32_t acquireBatch{0};      // Batch that waits for the swapchain image
+    std::vector<std::vector<VkImageMemoryBarrier2>> acquires;  // Of what the previous frame released
+    std::vector<std::vector<VkImageMemoryBarrier2>> releases;  // To later batches of the frame
+    std::vector<std::vector<VkImageMemoryBarrier2>> handOvers; // To the next frame
+};
+
+// Passes are declared once with addPass() and turned into a CompiledGraph by compile(). Plans
+// are cached by a hash of the declared structure (images, views, formats, clears, usages), so
+// declaring the same graph again costs a hash and a lookup. Frames then only call execute().
 class RenderGraph {
 public:
-    void beginFrame(Device& device, Swapchain& swapchain, VkCommandBuffer cmd);
     void addPass(const RenderPassDesc& pass);
-    void execute();
-    void endFrame();
-    void resetLayoutTracking(); // Call when swapchain is recreated
+
+    // Turn the passes added since the last compile into the plan execute() records, reusing
+    // the cached plan with the same structure if there is one. The record callbacks are taken
+    // from the new declarations either way. Passes whose output never reaches the present are
+    // dropped, and passes that draw onto the same attachments as the pass before them share
+    // its rendering scope.
+    const CompiledGraph& compile(Device& device, const Swapchain& swapchain);
+    bool isCompiled() const { return current != nullptr; }
+
+    // Record the compiled passes for the acquired swapchain image, ending with its transition
+    // to present. With parallel recording the frame's previous submission must have finished
+    // (acquireNextImage() waits for it), since its secondary command buffers are reused.
+    void execute(VkCommandBuffer cmd, const Swapchain& swapchain);
+
+    // Record the passes' callbacks on jobs' workers into secondary command buffers, one per
+    // callback, from per-worker pools for each frame in flight. cmd then only gets the
+    // barriers and rendering scopes, and executes the secondaries in declaration order.
+    // Compute passes are still recorded by execute() itself.
+    void enableParallelRecording(Device& device, JobSystem& jobs, uint32_t queueFamilyIndex);
+    void disableParallelRecording(Device& device); // Destroys the pools; call before the device
+    bool isRecordingInParallel() const { return recordJobSystem != nullptr; }
+
+    const RecordTimings& getRecordTimings() const { return recordTimings; }
+    void resetRecordTimings();
+
+    // Run AsyncCompute passes on device.computeQueue. Returns false, leaving every pass on
+    // the graphics queue, if the device has no second queue. Drops every compiled plan.
+    bool enableAsyncCompute(Device& device);
+    void disableAsyncCompute(Device& device); // Call before the device is destroyed
+    bool isComputeAsync() const { return asyncCompute; }
+
+    // Record through recorder instead of straight into the command buffers, e.g. a
+    // RecordingCommandRecorder to run the graph without a device. Parallel recording and async
+    // compute still need one for their command pools.
+    void setCommandRecorder(CommandRecorder& commandRecorder) { recorder = &commandRecorder; }
+
+    // Time every rendering scope on the GPU, and each record callback on the thread that
+    // runs it. Results arrive a few frames late; see PassProfiler.
+    void enableProfiling(Device& device);
+    void disableProfiling(Device& device); // Call before the device is destroyed
+    const PassProfiler& getProfiler() const { return profiler; }
+
+    // Submit what execute() recorded for the frame. On one queue that is cmd alone. With async
+    // compute, cmd holds the first graphics batch and the graph's own command buffers the
+    // rest, submitted to both queues with timeline semaphores between them.
+    void submit(Device& device, VkCommandBuffer cmd, const FrameSubmitInfo& info);
+
+    // Scratch for the frame execute() is recording or last recorded. It is released when that
+    // frame slot is recorded again, after its previous submission finished. Only for the thread
+    // calling execute(): callbacks recorded on workers must not use it.
+    FrameArena& getFrameArena() { return frameArenas[arenaFrame]; }
+
+    // Barriers recorded by the last execute()
+    const BarrierPlan& getBarrierPlan() const { return *lastPlan; }
+    uint64_t getStructureHash() const { return current ? current->hash : 0; }
+    const CompileReport& getCompileReport() const { return current->report; }
+
+    void resetLayoutTracking(); // Call when swapchain is recreated; drops every compiled plan
+
+    // Track an image passes use by mip level or array layer (Hi-Z chains, shadow cascades)
+    // separately per subresource. Register before compiling graphs that use it; transient
+    // images are registered with their mip levels by the graph.
+    void registerImage(VkImage image, uint32_t mipLevels, uint32_t arrayLayers = 1);
+
+    // Create a transient image. It gets memory and a view from the first compile() after it
+    // is created, which places every transient image by its lifetime in that graph; graphs
+    // compiled later must not overlap the lifetimes of images that ended up sharing memory.
+    uint32_t createTransientImage(Device& device, const TransientImageDesc& desc);
+    const Image& getTransientImage(uint32_t handle) const { return transients[handle].image; }
+    void destroyTransientImages(Device& device); // Also drops every compiled plan
+
+    // Where the transient images were placed, with peak and unaliased sizes
+    const TransientLayout& getTransientLayout() const { return transientLayout; }
 
 private:
-    Device* device{nullptr};
-    Swapchain* swapchain{nullptr};
-    VkCommandBuffer cmd{VK_NULL_HANDLE};
-    std::vector<RenderPassDesc> passes;
+    std::vector<RenderPassDesc> passes; // Declared, not yet compiled
+    VkDevice vkDevice{VK_NULL_HANDLE};  // For the command pools below, once either is enabled
+    CommandRecorder* recorder{&vulkanCommandRecorder()};
+    std::unordered_map<uint64_t, CompiledGraph> cache;
+    CompiledGraph* current{nullptr};
+    const CompiledGraph* lastExecuted{nullptr};
 
-    // Track last images to avoid unnecessary undefined->optimal toggles
-    VkImage lastMsaaImage{VK_NULL_HANDLE};
-    VkImage lastDepthImage{VK_NULL_HANDLE};
+    // Tracks layouts and pending writes per image across frames. Only advanced on the first
+    // frame of a plan: after one frame of a plan the tracked state no longer changes.
+    BarrierPlanner planner;
+    BarrierPlan firstFramePlan;
+    const BarrierPlan* lastPlan{&firstFramePlan};
+    std::vector<ImageHandle> swapchainHandles; // planner's handle per swapchain image index
 
-    // Track current known layouts per image across frames
-    std::unordered_map<VkImage, VkImageLayout> imageLayouts;
-};
+    struct RegisteredImage {
+        VkImage image;
+        uint32_t mipLevels;
+        uint32_t arrayLayers;
+    };
+    std::vector<RegisteredImage> registeredImages;
+
+    struct TransientImage {
+        Image image;
+        VkMemoryRequirements requirements;
+    };
+    std::vector<TransientImage> transients;
+    std::vector<VmaAllocation> transientMemory; // One per heap of transientLayout
+    TransientLayout transientLayout;
+
+    // Parallel recording. Pools are [frame * workerCount + worker]; each keeps the secondary
+    // command buffers it has allocated and hands them out again after a reset.
+    struct RecordPool {
+        VkCommandPool pool{VK_NULL_HANDLE};
+        std::vector<VkCommandBuffer> buffers;
+        uint32_t used{0};
+    };
+    struct RecordSlot {
+        uint32_t scope;
+        uint32_t record;
+    };
+    struct RecordSpan {
+        int64_t start;
+        int64_t end;
+        uint32_t worker;
+    };
+    JobSystem* recordJobSystem{nullptr};
+    std::vector<RecordPool> recordPools;
+    std::vector<RecordSlot> recordSlots;           // Every callback of current, in order
+    VkCommandBuffer* recordSecondaries{nullptr};    // What each slot recorded this frame
+    RecordSpan* recordSpans{nullptr};               // When each slot's callback ran, if profiling
+    const CompiledGraph* recordGraph{nullptr};      // Whose callbacks recordSlots lists
+    JobGraph recordJobs;
+    uint32_t recordFrame{0};
+    RecordTimings recordTimings;
 
+    // Async compute. Pools are [frame * 2 + queue] and hold the primaries for the batches
+    // other than the caller's command buffer; each queue signals its own timeline.
+    bool asyncCompute{false};
+    uint32_t queueFamilies[2]{};
+    VkSemaphore queueTimelines[2]{};
+    uint64_t queueTimelineValues[2]{};
+    std::vector<RecordPool> queuePools;
+    VkCommandBuffer* batchCommands{nullptr};      // This frame's, per batch
+    uint64_t* batchValues{nullptr};               // Timeline value each batch signals
+    uint32_t batchCount{0};
+    uint64_t lastFrameGraphicsValue{0};
+    std::vector<std::vector<VkImageMemoryBarrier2>> firstFrameAcquires;
+    std::vector<std::vector<VkImageMemoryBarrier2>> firstFrameReleases;
 
+    PassProfiler profiler;
+
+    // Per-frame arrays above (secondaries, spans, batch commands and values) come from the
+    // arena of the frame being recorded
+    FrameArena frameArenas[Swapchain::MAX_FRAMES_IN_FLIGHT];
+    uint32_t arenaFrame{0};
+
+    void build(CompiledGraph& graph, Device& device, const Swapchain& swapchain);
+    void scheduleQueues(CompiledGraph& graph) const;
+    // previous is the plan that ran the frame before, graph itself for its steady frames, and
+    // handOvers are only written for those
+    void splitAcrossQueues(const CompiledGraph& graph, const CompiledGraph* previous, BarrierPlan& plan,
+                           std::vector<std::vector<VkImageMemoryBarrier2>>& acquires,
+                           std::vector<std::vector<VkImageMemoryBarrier2>>& releases,
+                           std::vector<std::vector<VkImageMemoryBarrier2>>& handOvers) const;
+    VkCommandBuffer beginBatchCommands(uint32_t frame, PassQueue queue);
+    void recordInParallel(uint32_t frame);
+    void recordSlot(size_t slot);
+    void placeTransients(CompiledGraph& graph, Device& device);
+    VkImageView viewOf(VkImageView view, VkImage image) const;
+    void registerImages(BarrierPlanner& target) const;
+};
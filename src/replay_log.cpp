@@ -0,0 +1,181 @@
+#include "replay_log.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+constexpr char MAGIC[4] = {'S', 'V', 'R', 'P'};
+constexpr uint32_t VERSION = 1;
+
+void writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void writeFixed(std::vector<uint8_t>& out, uint64_t value, int byteCount) {
+    for (int i = 0; i < byteCount; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+class ByteReader {
+public:
+    ByteReader(const std::vector<uint8_t>& bytes, size_t offset) : bytes(bytes), offset(offset) {}
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = next();
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+        throw std::runtime_error("Replay log has an overlong varint");
+    }
+
+    uint64_t fixed(int byteCount) {
+        uint64_t value = 0;
+        for (int i = 0; i < byteCount; ++i) {
+            value |= static_cast<uint64_t>(next()) << (8 * i);
+        }
+        return value;
+    }
+
+    size_t getOffset() const { return offset; }
+
+private:
+    const std::vector<uint8_t>& bytes;
+    size_t offset;
+
+    uint8_t next() {
+        if (offset >= bytes.size()) throw std::runtime_error("Replay log is truncated");
+        return bytes[offset++];
+    }
+};
+
+} // namespace
+
+ReplayLog::ReplayLog(const ReplayHeader& header)
+    : header(header)
+{
+}
+
+void ReplayLog::record(const SimulationCommand& command) {
+    pending.push_back(static_cast<uint8_t>(command.type));
+    switch (command.type) {
+    case CommandType::Populate:
+        writeVarint(pending, static_cast<uint32_t>(command.arg0));
+        writeVarint(pending, static_cast<uint32_t>(command.arg1));
+        break;
+    case CommandType::SetDestination:
+        writeVarint(pending, command.entity.index);
+        writeVarint(pending, command.entity.generation);
+        writeVarint(pending, static_cast<uint32_t>(command.arg0 + 1)); // -1 clears
+        break;
+    }
+    ++pendingCount;
+}
+
+void ReplayLog::endTurn(uint64_t checksum) {
+    writeVarint(bytes, pendingCount);
+    bytes.insert(bytes.end(), pending.begin(), pending.end());
+    writeFixed(bytes, checksum, 8);
+    pending.clear();
+    pendingCount = 0;
+    ++turnCount;
+}
+
+bool ReplayLog::readTurn(ReplayCursor& cursor, std::vector<SimulationCommand>& commands, uint64_t& checksum) const {
+    commands.clear();
+    if (cursor.turn >= turnCount) return false;
+
+    ByteReader reader(bytes, cursor.offset);
+    uint64_t count = reader.varint();
+    for (uint64_t i = 0; i < count; ++i) {
+        SimulationCommand command;
+        uint64_t type = reader.fixed(1);
+        switch (type) {
+        case static_cast<uint64_t>(CommandType::Populate):
+            command.type = CommandType::Populate;
+            command.arg0 = static_cast<int32_t>(reader.varint());
+            command.arg1 = static_cast<int32_t>(reader.varint());
+            break;
+        case static_cast<uint64_t>(CommandType::SetDestination):
+            command.type = CommandType::SetDestination;
+            command.entity.index = static_cast<uint32_t>(reader.varint());
+            command.entity.generation = static_cast<uint32_t>(reader.varint());
+            command.arg0 = static_cast<int32_t>(reader.varint()) - 1;
+            break;
+        default:
+            throw std::runtime_error("Replay log has an unknown command type");
+        }
+        commands.push_back(command);
+    }
+    checksum = reader.fixed(8);
+
+    cursor.offset = reader.getOffset();
+    ++cursor.turn;
+    return true;
+}
+
+void ReplayLog::save(const std::string& path) const {
+    std::vector<uint8_t> prefix(MAGIC, MAGIC + sizeof(MAGIC));
+    writeFixed(prefix, VERSION, 4);
+    writeFixed(prefix, header.seed, 8);
+    writeFixed(prefix, static_cast<uint32_t>(header.playerCount), 4);
+    writeFixed(prefix, static_cast<uint32_t>(header.gridWidth), 4);
+    writeFixed(prefix, static_cast<uint32_t>(header.gridHeight), 4);
+    writeFixed(prefix, header.gridHash, 8);
+    writeFixed(prefix, turnCount, 4);
+    writeFixed(prefix, bytes.size(), 8);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open replay log for writing: " + path);
+    }
+    file.write(reinterpret_cast<const char*>(prefix.data()), static_cast<std::streamsize>(prefix.size()));
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write replay log: " + path);
+    }
+}
+
+ReplayLog ReplayLog::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Failed to open replay log: " + path);
+    }
+    std::vector<uint8_t> contents(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(contents.data()), static_cast<std::streamsize>(contents.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to read replay log: " + path);
+    }
+
+    ByteReader reader(contents, 0);
+    for (char expected : MAGIC) {
+        if (static_cast<char>(reader.fixed(1)) != expected) {
+            throw std::runtime_error("Not a replay log: " + path);
+        }
+    }
+    if (reader.fixed(4) != VERSION) {
+        throw std::runtime_error("Unsupported replay log version: " + path);
+    }
+
+    ReplayLog log;
+    log.header.seed = reader.fixed(8);
+    log.header.playerCount = static_cast<int32_t>(reader.fixed(4));
+    log.header.gridWidth = static_cast<int32_t>(reader.fixed(4));
+    log.header.gridHeight = static_cast<int32_t>(reader.fixed(4));
+    log.header.gridHash = reader.fixed(8);
+    log.turnCount = static_cast<uint32_t>(reader.fixed(4));
+    uint64_t byteCount = reader.fixed(8);
+    if (byteCount != contents.size() - reader.getOffset()) {
+        throw std::runtime_error("Replay log is truncated: " + path);
+    }
+    log.bytes.assign(contents.begin() + static_cast<std::ptrdiff_t>(reader.getOffset()), contents.end());
+    return log;
+}
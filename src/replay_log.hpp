@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "entity_store.hpp"
+
+enum class CommandType : uint8_t {
+    Populate,
+    SetDestination,
+};
+
+// A player or setup action fed to TurnSimulation. Everything that changes the simulation
+// from outside goes through one of these, so the commands plus the seed reproduce a game.
+struct SimulationCommand {
+    CommandType type = CommandType::SetDestination;
+    EntityHandle entity; // SetDestination
+    int32_t arg0 = 0;    // Populate: ships per player; SetDestination: tile
+    int32_t arg1 = 0;    // Populate: cities per player
+
+    static SimulationCommand populate(int shipsPerPlayer, int citiesPerPlayer) {
+        return SimulationCommand{CommandType::Populate, EntityHandle{}, shipsPerPlayer, citiesPerPlayer};
+    }
+    static SimulationCommand setDestination(EntityHandle entity, int tile) {
+        return SimulationCommand{CommandType::SetDestination, entity, tile, 0};
+    }
+};
+
+// What a replay needs to rebuild the starting state before applying commands
+struct ReplayHeader {
+    uint64_t seed = 1;
+    int32_t playerCount = 4;
+    int32_t gridWidth = 0;
+    int32_t gridHeight = 0;
+    uint64_t gridHash = 0; // StateHasher::getTileHash() of the starting map
+};
+
+// Position in a log for ReplayLog::readTurn()
+struct ReplayCursor {
+    size_t offset = 0;
+    uint32_t turn = 0;
+};
+
+// Compact binary record of every turn's commands and the checksum the turn ended with.
+//
+// Each turn is a varint command count, the commands with varint fields, and the 64-bit
+// checksum, so a quiet turn costs 9 bytes. Commands recorded before a turn runs belong to
+// it. Replaying applies each turn's commands, steps, and compares checksums: the first
+// mismatch is the turn a lockstep peer or a repro run diverged.
+class ReplayLog {
+public:
+    ReplayLog() = default;
+    explicit ReplayLog(const ReplayHeader& header);
+
+    const ReplayHeader& getHeader() const { return header; }
+
+    void record(const SimulationCommand& command);
+    void endTurn(uint64_t checksum);
+
+    uint32_t getTurnCount() const { return turnCount; }
+    size_t getByteSize() const { return bytes.size(); }
+
+    // Decode the turn at cursor and advance it; false once every turn has been read
+    bool readTurn(ReplayCursor& cursor, std::vector<SimulationCommand>& commands, uint64_t& checksum) const;
+
+    // Throw std::runtime_error on I/O failure or a malformed file
+    void save(const std::string& path) const;
+    static ReplayLog load(const std::string& path);
+
+private:
+    ReplayHeader header;
+    std::vector<uint8_t> bytes;   // Finished turns
+    std::vector<uint8_t> pending; // Commands of the turn in progress
+    uint32_t pendingCount = 0;
+    uint32_t turnCount = 0;
+};
@@ -0,0 +1,501 @@
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char KEYFRAME_MAGIC[4] = {'S', 'V', 'S', 'K'};
+constexpr char DELTA_MAGIC[4] = {'S', 'V', 'S', 'D'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t SECTION_ALIGNMENT = 16;
+
+// Zero runs shorter than this stay inside a literal; a token costs at least two bytes
+constexpr size_t MIN_ZERO_RUN = 4;
+
+// Read-only view of a whole file, unmapped when the last Snapshot section using it goes
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Failed to open snapshot: " + path);
+        }
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(file, &fileSize);
+        size = static_cast<size_t>(fileSize.QuadPart);
+        if (size == 0) return;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open snapshot: " + path);
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0) size = static_cast<size_t>(info.st_size);
+        if (size > 0) {
+            void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view != MAP_FAILED) data = static_cast<const uint8_t*>(view);
+        }
+        close(fd);
+#endif
+        if (size > 0 && !data) {
+            release();
+            throw std::runtime_error("Failed to map snapshot: " + path);
+        }
+    }
+
+    ~MappedFile() { release(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* getData() const { return data; }
+    size_t getSize() const { return size; }
+
+private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+    void release() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (data) munmap(const_cast<uint8_t*>(data), size);
+#endif
+        data = nullptr;
+    }
+};
+
+void writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void writeFixed(std::vector<uint8_t>& out, uint64_t value, int byteCount) {
+    for (int i = 0; i < byteCount; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = bytes(1)[0];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+        throw std::runtime_error("Snapshot has an overlong varint");
+    }
+
+    uint64_t fixed(int byteCount) {
+        const uint8_t* in = bytes(static_cast<size_t>(byteCount));
+        uint64_t value = 0;
+        for (int i = 0; i < byteCount; ++i) {
+            value |= static_cast<uint64_t>(in[i]) << (8 * i);
+        }
+        return value;
+    }
+
+    const uint8_t* bytes(size_t count) {
+        if (count > size - offset) throw std::runtime_error("Snapshot is truncated");
+        const uint8_t* in = data + offset;
+        offset += count;
+        return in;
+    }
+
+    void expectMagic(const char (&magic)[4]) {
+        if (std::memcmp(bytes(4), magic, 4) != 0) throw std::runtime_error("Not a snapshot file");
+        if (fixed(4) != VERSION) throw std::runtime_error("Unsupported snapshot version");
+    }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t offset = 0;
+};
+
+uint64_t hashBytes(uint64_t hash, const uint8_t* data, size_t size) {
+    // Word at a time; this only has to tell keyframes apart, not resist tampering
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * 0x100000001B3ull;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ data[i]) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+// XOR of current with the keyframe zero-extended to current's size, as tokens of
+// (zero run, literal length, literal bytes)
+void encodeXorRle(const uint8_t* current, size_t size, const uint8_t* base, size_t baseSize, std::vector<uint8_t>& out) {
+    size_t overlap = std::min(size, baseSize);
+    auto xorAt = [&](size_t i) -> uint8_t { return i < overlap ? current[i] ^ base[i] : current[i]; };
+
+    size_t i = 0;
+    while (i < size) {
+        size_t zeroStart = i;
+        while (i + 8 <= overlap && std::memcmp(current + i, base + i, 8) == 0) i += 8;
+        while (i < size && xorAt(i) == 0) ++i;
+
+        // Extend the literal over zero gaps too short to be worth a token
+        size_t literalStart = i;
+        size_t literalEnd = i;
+        size_t j = i;
+        while (j < size) {
+            if (xorAt(j) != 0) {
+                literalEnd = ++j;
+                continue;
+            }
+            size_t gapEnd = j;
+            while (gapEnd < size && gapEnd - j < MIN_ZERO_RUN && xorAt(gapEnd) == 0) ++gapEnd;
+            if (gapEnd - j >= MIN_ZERO_RUN || gapEnd == size) break;
+            j = gapEnd;
+        }
+
+        writeVarint(out, literalStart - zeroStart);
+        writeVarint(out, literalEnd - literalStart);
+        for (size_t k = literalStart; k < literalEnd; ++k) out.push_back(xorAt(k));
+        i = literalEnd;
+    }
+}
+
+void decodeXorRle(ByteReader& reader, size_t encodedSize, std::vector<uint8_t>& inOut) {
+    ByteReader tokens(reader.bytes(encodedSize), encodedSize);
+    size_t position = 0;
+    while (position < inOut.size()) {
+        uint64_t zeros = tokens.varint();
+        uint64_t literal = tokens.varint();
+        if ((zeros == 0 && literal == 0) || zeros > inOut.size() - position ||
+            literal > inOut.size() - position - zeros) {
+            throw std::runtime_error("Snapshot delta overruns its section");
+        }
+        position += static_cast<size_t>(zeros);
+        const uint8_t* bytes = tokens.bytes(static_cast<size_t>(literal));
+        for (size_t k = 0; k < literal; ++k) inOut[position + k] ^= bytes[k];
+        position += static_cast<size_t>(literal);
+    }
+}
+
+void writeFile(const std::string& path, const std::vector<uint8_t>& prefix, const Snapshot& snapshot,
+               const std::vector<SnapshotSection>& order, const std::vector<uint64_t>& padding) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Failed to open snapshot for writing: " + path);
+    }
+    file.write(reinterpret_cast<const char*>(prefix.data()), static_cast<std::streamsize>(prefix.size()));
+    static constexpr char zeros[SECTION_ALIGNMENT] = {};
+    for (size_t i = 0; i < order.size(); ++i) {
+        file.write(zeros, static_cast<std::streamsize>(padding[i]));
+        const Snapshot::Section& section = snapshot.get(order[i]);
+        file.write(reinterpret_cast<const char*>(section.data), static_cast<std::streamsize>(section.size));
+    }
+    if (!file) {
+        throw std::runtime_error("Failed to write snapshot: " + path);
+    }
+}
+
+} // namespace
+
+void Snapshot::set(SnapshotSection id, std::shared_ptr<const std::vector<uint8_t>> bytes) {
+    Section section;
+    section.data = bytes->data();
+    section.size = bytes->size();
+    section.owner = std::move(bytes);
+    set(id, std::move(section));
+}
+
+size_t Snapshot::getByteSize() const {
+    size_t total = 0;
+    for (const Section& section : sections) total += section.size;
+    return total;
+}
+
+void saveGrid(const HexGrid& grid, Snapshot& snapshot) {
+    glm::ivec2 origin = grid.getOrigin();
+    snapshot.put(SnapshotSection::GridInfo, std::vector<int32_t>{grid.getWidth(), grid.getHeight(), origin.x, origin.y});
+    snapshot.put(SnapshotSection::GridTypes, grid.getTypes());
+}
+
+HexGrid loadGrid(const Snapshot& snapshot) {
+    std::vector<int32_t> info;
+    std::vector<TerrainType> types;
+    snapshot.read(SnapshotSection::GridInfo, info);
+    snapshot.read(SnapshotSection::GridTypes, types);
+    if (info.size() != 4 || info[0] <= 0 || info[1] <= 0 ||
+        types.size() != static_cast<size_t>(info[0]) * static_cast<size_t>(info[1])) {
+        throw std::runtime_error("Snapshot grid is malformed");
+    }
+
+    HexGrid grid(info[0], info[1], VOID_TERRAIN, glm::ivec2(info[2], info[3]));
+    for (size_t tile = 0; tile < types.size(); ++tile) {
+        grid.setType(static_cast<int>(tile), types[tile]);
+    }
+    return grid;
+}
+
+uint64_t writeKeyframe(const Snapshot& snapshot, const std::string& path) {
+    std::vector<SnapshotSection> order;
+    for (uint32_t id = 0; id < static_cast<uint32_t>(SnapshotSection::Count); ++id) {
+        if (snapshot.has(static_cast<SnapshotSection>(id))) order.push_back(static_cast<SnapshotSection>(id));
+    }
+
+    // Header, then a table of (id, offset, size), then the aligned section data
+    size_t headerSize = 24 + order.size() * 24;
+    std::vector<uint64_t> offsets(order.size());
+    std::vector<uint64_t> padding(order.size());
+    uint64_t contentHash = 0xCBF29CE484222325ull;
+    size_t offset = headerSize;
+    for (size_t i = 0; i < order.size(); ++i) {
+        size_t aligned = (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+        padding[i] = aligned - offset;
+        offsets[i] = aligned;
+        const Snapshot::Section& section = snapshot.get(order[i]);
+        offset = aligned + section.size;
+        contentHash = hashBytes(contentHash ^ static_cast<uint32_t>(order[i]), section.data, section.size);
+    }
+
+    std::vector<uint8_t> prefix(KEYFRAME_MAGIC, KEYFRAME_MAGIC + 4);
+    writeFixed(prefix, VERSION, 4);
+    writeFixed(prefix, order.size(), 4);
+    writeFixed(prefix, 0, 4);
+    writeFixed(prefix, contentHash, 8);
+    for (size_t i = 0; i < order.size(); ++i) {
+        writeFixed(prefix, static_cast<uint32_t>(order[i]), 4);
+        writeFixed(prefix, 0, 4);
+        writeFixed(prefix, offsets[i], 8);
+        writeFixed(prefix, snapshot.get(order[i]).size, 8);
+    }
+    writeFile(path, prefix, snapshot, order, padding);
+    return contentHash;
+}
+
+void writeDelta(const Snapshot& snapshot, const Snapshot& keyframe, uint64_t keyframeHash, const std::string& path) {
+    std::vector<uint8_t> out(DELTA_MAGIC, DELTA_MAGIC + 4);
+    writeFixed(out, VERSION, 4);
+    size_t countOffset = out.size();
+    writeFixed(out, 0, 4);
+    writeFixed(out, 0, 4);
+    writeFixed(out, keyframeHash, 8);
+
+    uint32_t count = 0;
+    std::vector<uint8_t> encoded;
+    for (uint32_t id = 0; id < static_cast<uint32_t>(SnapshotSection::Count); ++id) {
+        const Snapshot::Section& section = snapshot.get(static_cast<SnapshotSection>(id));
+        if (!section.data) continue;
+        const Snapshot::Section& base = keyframe.get(static_cast<SnapshotSection>(id));
+
+        encoded.clear();
+        if (section.data != base.data || section.size != base.size) {
+            encodeXorRle(section.data, section.size, base.data, base.size, encoded);
+        } else if (section.size > 0) {
+            // Shared with the keyframe, so identical: one all-zero token
+            writeVarint(encoded, section.size);
+            writeVarint(encoded, 0);
+        }
+        writeFixed(out, id, 4);
+        writeFixed(out, 0, 4);
+        writeFixed(out, section.size, 8);
+        writeFixed(out, encoded.size(), 8);
+        out.insert(out.end(), encoded.begin(), encoded.end());
+        ++count;
+    }
+    for (int i = 0; i < 4; ++i) out[countOffset + i] = static_cast<uint8_t>(count >> (8 * i));
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Failed to open snapshot delta for writing: " + path);
+    }
+    file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write snapshot delta: " + path);
+    }
+}
+
+Snapshot loadSnapshot(const std::string& keyframePath, const std::string& deltaPath) {
+    auto mapped = std::make_shared<MappedFile>(keyframePath);
+    ByteReader header(mapped->getData(), mapped->getSize());
+    header.expectMagic(KEYFRAME_MAGIC);
+    uint32_t count = static_cast<uint32_t>(header.fixed(4));
+    header.fixed(4);
+    uint64_t contentHash = header.fixed(8);
+
+    Snapshot snapshot;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t id = static_cast<uint32_t>(header.fixed(4));
+        header.fixed(4);
+        uint64_t offset = header.fixed(8);
+        uint64_t size = header.fixed(8);
+        if (id >= static_cast<uint32_t>(SnapshotSection::Count) || offset > mapped->getSize() ||
+            size > mapped->getSize() - offset) {
+            throw std::runtime_error("Snapshot section table is malformed: " + keyframePath);
+        }
+        Snapshot::Section section;
+        section.owner = mapped;
+        section.data = mapped->getData() + offset;
+        section.size = static_cast<size_t>(size);
+        snapshot.set(static_cast<SnapshotSection>(id), std::move(section));
+    }
+
+    if (deltaPath.empty() || !std::filesystem::exists(deltaPath)) return snapshot;
+
+    std::ifstream file(deltaPath, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Failed to open snapshot delta: " + deltaPath);
+    }
+    std::vector<uint8_t> contents(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(contents.data()), static_cast<std::streamsize>(contents.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to read snapshot delta: " + deltaPath);
+    }
+
+    ByteReader reader(contents.data(), contents.size());
+    reader.expectMagic(DELTA_MAGIC);
+    uint32_t deltaCount = static_cast<uint32_t>(reader.fixed(4));
+    reader.fixed(4);
+    // A delta left over from before the keyframe was replaced no longer applies
+    if (reader.fixed(8) != contentHash) return snapshot;
+
+    Snapshot result;
+    for (uint32_t i = 0; i < deltaCount; ++i) {
+        uint32_t id = static_cast<uint32_t>(reader.fixed(4));
+        reader.fixed(4);
+        uint64_t size = reader.fixed(8);
+        uint64_t encodedSize = reader.fixed(8);
+        if (id >= static_cast<uint32_t>(SnapshotSection::Count)) {
+            throw std::runtime_error("Snapshot delta is malformed: " + deltaPath);
+        }
+
+        const Snapshot::Section& base = snapshot.get(static_cast<SnapshotSection>(id));
+        auto bytes = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(size), uint8_t{0});
+        if (base.data) std::memcpy(bytes->data(), base.data, std::min<size_t>(base.size, bytes->size()));
+        decodeXorRle(reader, static_cast<size_t>(encodedSize), *bytes);
+        result.set(static_cast<SnapshotSection>(id), std::move(bytes));
+    }
+    return result;
+}
+
+AutosaveWriter::AutosaveWriter(std::string basePath, int keyframeInterval)
+    : keyframePath(basePath + ".key")
+    , deltaPath(basePath + ".delta")
+    , keyframeInterval(std::max(keyframeInterval, 1))
+{
+    worker = std::jthread([this]() { run(); });
+}
+
+AutosaveWriter::~AutosaveWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+void AutosaveWriter::save(std::shared_ptr<const Snapshot> snapshot) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (error) {
+        std::exception_ptr failed = std::exchange(error, nullptr);
+        std::rethrow_exception(failed);
+    }
+    queued = std::move(snapshot);
+    wake.notify_one();
+}
+
+void AutosaveWriter::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]() { return !queued && !busy; });
+    if (error) {
+        std::exception_ptr failed = std::exchange(error, nullptr);
+        std::rethrow_exception(failed);
+    }
+}
+
+uint32_t AutosaveWriter::getSavedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return savedCount;
+}
+
+void AutosaveWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this]() { return queued || stopping; });
+        if (!queued) return; // Stopping with nothing left to write
+
+        std::shared_ptr<const Snapshot> snapshot = std::move(queued);
+        queued = nullptr;
+        busy = true;
+        lock.unlock();
+
+        std::exception_ptr failed;
+        try {
+            write(std::move(snapshot));
+        } catch (...) {
+            failed = std::current_exception();
+        }
+
+        lock.lock();
+        busy = false;
+        if (failed) {
+            error = failed;
+        } else {
+            ++savedCount;
+        }
+        idle.notify_all();
+    }
+}
+
+void AutosaveWriter::write(std::shared_ptr<const Snapshot> snapshot) {
+    if (!keyframe || sinceKeyframe + 1 >= keyframeInterval) {
+        std::string temporary = keyframePath + ".tmp";
+        uint64_t hash = writeKeyframe(*snapshot, temporary);
+        std::filesystem::rename(temporary, keyframePath);
+        // The old delta names the old keyframe's hash, so loading would skip it anyway
+        std::error_code ignored;
+        std::filesystem::remove(deltaPath, ignored);
+        keyframe = std::move(snapshot);
+        keyframeHash = hash;
+        sinceKeyframe = 0;
+        return;
+    }
+
+    std::string temporary = deltaPath + ".tmp";
+    writeDelta(*snapshot, *keyframe, keyframeHash, temporary);
+    std::filesystem::rename(temporary, deltaPath);
+    ++sinceKeyframe;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "hex_grid.hpp"
+
+enum class SnapshotSection : uint32_t {
+    GridInfo,
+    GridTypes,
+    EntitySparse,
+    EntityGenerations,
+    EntityFreeIndices,
+    EntityHandles,
+    EntityKinds,
+    EntityTiles,
+    EntityOwners,
+    EntityFacings,
+    EntityFlags,
+    EntityHealth,
+    SimulationState,
+    Players,
+    Destinations,
+    Count
+};
+
+// A game state as a set of immutable byte arrays, one per SnapshotSection.
+//
+// Sections are shared rather than owned: a section can point into a vector held by a
+// shared_ptr or into a memory-mapped keyframe, and copying a Snapshot only copies the
+// pointers. Whoever captures state can hand over a section it captured last time when the
+// data hasn't changed (e.g. the tile types), which makes a snapshot copy-on-write per array.
+class Snapshot {
+public:
+    struct Section {
+        std::shared_ptr<const void> owner; // Keeps data alive
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    void set(SnapshotSection id, Section section) { sections[index(id)] = std::move(section); }
+    void set(SnapshotSection id, std::shared_ptr<const std::vector<uint8_t>> bytes);
+    const Section& get(SnapshotSection id) const { return sections[index(id)]; }
+    bool has(SnapshotSection id) const { return sections[index(id)].data != nullptr; }
+
+    // Copy a vector of trivially copyable values into a new section
+    template <typename T>
+    void put(SnapshotSection id, const std::vector<T>& values) {
+        auto bytes = std::make_shared<std::vector<uint8_t>>(values.size() * sizeof(T));
+        if (!values.empty()) std::memcpy(bytes->data(), values.data(), bytes->size());
+        set(id, std::move(bytes));
+    }
+
+    // Copy a section back out; throws std::runtime_error if it is missing or malformed
+    template <typename T>
+    void read(SnapshotSection id, std::vector<T>& values) const {
+        const Section& section = get(id);
+        if (!section.data || section.size % sizeof(T) != 0) {
+            throw std::runtime_error("Snapshot section " + std::to_string(index(id)) + " is missing or malformed");
+        }
+        values.resize(section.size / sizeof(T));
+        if (section.size > 0) std::memcpy(values.data(), section.data, section.size);
+    }
+
+    size_t getByteSize() const;
+
+private:
+    std::array<Section, static_cast<size_t>(SnapshotSection::Count)> sections;
+
+    static size_t index(SnapshotSection id) { return static_cast<size_t>(id); }
+};
+
+void saveGrid(const HexGrid& grid, Snapshot& snapshot);
+HexGrid loadGrid(const Snapshot& snapshot);
+
+// Snapshot files. A keyframe stores every section raw and 16-byte aligned so loading can
+// map the file and point the sections straight into it. A delta stores each section XORed
+// with the keyframe's and run-length encoded, so the unchanged bulk of a save costs a few
+// bytes; it names the keyframe it was taken against by content hash.
+//
+// All of these throw std::runtime_error on I/O failure or malformed files.
+uint64_t writeKeyframe(const Snapshot& snapshot, const std::string& path); // Returns the content hash
+void writeDelta(const Snapshot& snapshot, const Snapshot& keyframe, uint64_t keyframeHash, const std::string& path);
+
+// Map a keyframe, then apply deltaPath on top if it is given, exists and was taken against
+// this keyframe
+Snapshot loadSnapshot(const std::string& keyframePath, const std::string& deltaPath = std::string());
+
+// Saves snapshots on a background thread.
+//
+// The caller captures a Snapshot (the only work on its thread) and hands it to save(), which
+// returns immediately. Every keyframeInterval saves the worker writes basePath.key, and in
+// between basePath.delta against that keyframe; each file is written beside its final name
+// and renamed into place, so a crash mid-save leaves the previous save intact. If saves
+// arrive faster than they are written only the newest queued one is kept.
+class AutosaveWriter {
+public:
+    explicit AutosaveWriter(std::string basePath, int keyframeInterval = 10);
+    ~AutosaveWriter();
+
+    AutosaveWriter(const AutosaveWriter&) = delete;
+    AutosaveWriter& operator=(const AutosaveWriter&) = delete;
+
+    // Rethrows the error of a previous failed save
+    void save(std::shared_ptr<const Snapshot> snapshot);
+
+    // Block until every queued save is written; rethrows a failed save's error
+    void wait();
+
+    const std::string& getKeyframePath() const { return keyframePath; }
+    const std::string& getDeltaPath() const { return deltaPath; }
+    uint32_t getSavedCount() const;
+
+private:
+    std::string keyframePath;
+    std::string deltaPath;
+    int keyframeInterval;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::shared_ptr<const Snapshot> queued;
+    bool busy = false;
+    bool stopping = false;
+    std::exception_ptr error;
+    uint32_t savedCount = 0;
+
+    // Worker thread only
+    std::shared_ptr<const Snapshot> keyframe;
+    uint64_t keyframeHash = 0;
+    int sinceKeyframe = 0;
+
+    std::jthread worker;
+
+    void run();
+    void write(std::shared_ptr<const Snapshot> snapshot);
+};
@@ -0,0 +1,151 @@
+#include "state_hasher.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+
+uint64_t mix64(uint64_t x) {
+    // splitmix64 finalizer
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+uint64_t combine(uint64_t hash, uint64_t value) {
+    return mix64(hash ^ value);
+}
+
+// Separate salts so a tile chunk and an entity chunk with the same id never collide
+constexpr uint64_t TILE_SALT = 0x74696C6500000000ull;
+constexpr uint64_t ENTITY_SALT = 0x656E746900000000ull;
+
+} // namespace
+
+StateHasher::StateHasher(const HexGrid& grid, int tileChunkSize, uint32_t entityChunkSize)
+    : grid(grid)
+    , tileChunkSize(std::max(tileChunkSize, 1))
+    , entityChunkSize(std::max<uint32_t>(entityChunkSize, 1))
+{
+    tileChunksX = (grid.getWidth() + this->tileChunkSize - 1) / this->tileChunkSize;
+    int tileChunksY = (grid.getHeight() + this->tileChunkSize - 1) / this->tileChunkSize;
+    tileChunkHashes.assign(static_cast<size_t>(tileChunksX) * tileChunksY, 0);
+    tileDirty.assign(tileChunkHashes.size(), 0);
+    markAll();
+}
+
+void StateHasher::markTile(int tile) {
+    uint32_t chunk = static_cast<uint32_t>((tile / grid.getWidth() / tileChunkSize) * tileChunksX +
+                                           (tile % grid.getWidth()) / tileChunkSize);
+    if (tileDirty[chunk]) return;
+    tileDirty[chunk] = 1;
+    dirtyTileChunks.push_back(chunk);
+}
+
+void StateHasher::markEntity(uint32_t index) {
+    uint32_t chunk = index / entityChunkSize;
+    if (chunk >= entityDirty.size()) {
+        entityDirty.resize(chunk + 1, 0);
+        entityChunkHashes.resize(chunk + 1, 0);
+    }
+    if (entityDirty[chunk]) return;
+    entityDirty[chunk] = 1;
+    dirtyEntityChunks.push_back(chunk);
+}
+
+void StateHasher::markAll() {
+    for (uint32_t chunk = 0; chunk < tileDirty.size(); ++chunk) {
+        if (!tileDirty[chunk]) dirtyTileChunks.push_back(chunk);
+        tileDirty[chunk] = 1;
+    }
+    for (uint32_t chunk = 0; chunk < entityDirty.size(); ++chunk) {
+        if (!entityDirty[chunk]) dirtyEntityChunks.push_back(chunk);
+        entityDirty[chunk] = 1;
+    }
+}
+
+uint64_t StateHasher::hashTileChunk(uint32_t chunk) const {
+    int width = grid.getWidth();
+    int colBegin = static_cast<int>(chunk % tileChunksX) * tileChunkSize;
+    int rowBegin = static_cast<int>(chunk / tileChunksX) * tileChunkSize;
+    int colEnd = std::min(colBegin + tileChunkSize, width);
+    int rowEnd = std::min(rowBegin + tileChunkSize, grid.getHeight());
+
+    uint64_t hash = mix64(TILE_SALT | chunk);
+    for (int row = rowBegin; row < rowEnd; ++row) {
+        // Pack a row of types into words rather than mixing tile by tile
+        uint64_t word = 0;
+        int packed = 0;
+        for (int col = colBegin; col < colEnd; ++col) {
+            word = (word << 8) | static_cast<uint8_t>(grid.getType(row * width + col));
+            if (++packed == 8) {
+                hash = combine(hash, word);
+                word = 0;
+                packed = 0;
+            }
+        }
+        if (packed > 0) hash = combine(hash, word);
+    }
+    return hash;
+}
+
+uint64_t StateHasher::hashEntityChunk(const EntityStore& entities, uint32_t chunk) const {
+    uint32_t begin = chunk * entityChunkSize;
+    uint32_t end = std::min<uint32_t>(begin + entityChunkSize, static_cast<uint32_t>(entities.getIndexCount()));
+
+    uint64_t hash = mix64(ENTITY_SALT | chunk);
+    for (uint32_t index = begin; index < end; ++index) {
+        EntityHandle handle = entities.handleAt(index);
+        uint32_t dense = entities.denseIndex(handle);
+        // Dead slots still count their generation, so a despawn changes the hash
+        hash = combine(hash, (static_cast<uint64_t>(handle.generation) << 32) | index);
+        if (dense == EntityHandle::INVALID_INDEX) continue;
+
+        uint64_t packed = static_cast<uint64_t>(entities.getKinds()[dense]) |
+                          static_cast<uint64_t>(entities.getOwners()[dense]) << 8 |
+                          static_cast<uint64_t>(entities.getFacings()[dense]) << 16 |
+                          static_cast<uint64_t>(entities.getFlags()[dense]) << 24 |
+                          static_cast<uint64_t>(static_cast<uint32_t>(entities.getTiles()[dense])) << 32;
+        hash = combine(hash, packed);
+        hash = combine(hash, std::bit_cast<uint32_t>(entities.getHealth()[dense]));
+    }
+    return hash;
+}
+
+uint64_t StateHasher::update(const EntityStore& entities) {
+    // Handle indices handed out since the last update are new chunks
+    uint32_t entityChunks = static_cast<uint32_t>((entities.getIndexCount() + entityChunkSize - 1) / entityChunkSize);
+    for (uint32_t chunk = static_cast<uint32_t>(entityDirty.size()); chunk < entityChunks; ++chunk) {
+        markEntity(chunk * entityChunkSize);
+    }
+
+    for (uint32_t chunk : dirtyTileChunks) {
+        uint64_t hash = hashTileChunk(chunk);
+        tileTotal += hash - tileChunkHashes[chunk];
+        tileChunkHashes[chunk] = hash;
+        tileDirty[chunk] = 0;
+    }
+    for (uint32_t chunk : dirtyEntityChunks) {
+        uint64_t hash = hashEntityChunk(entities, chunk);
+        entityTotal += hash - entityChunkHashes[chunk];
+        entityChunkHashes[chunk] = hash;
+        entityDirty[chunk] = 0;
+    }
+    lastRehashCount = dirtyTileChunks.size() + dirtyEntityChunks.size();
+    dirtyTileChunks.clear();
+    dirtyEntityChunks.clear();
+    return tileTotal + entityTotal;
+}
+
+uint64_t StateHasher::hashAll(const EntityStore& entities) const {
+    uint64_t total = 0;
+    for (uint32_t chunk = 0; chunk < tileChunkHashes.size(); ++chunk) {
+        total += hashTileChunk(chunk);
+    }
+    uint32_t entityChunks = static_cast<uint32_t>((entities.getIndexCount() + entityChunkSize - 1) / entityChunkSize);
+    for (uint32_t chunk = 0; chunk < entityChunks; ++chunk) {
+        total += hashEntityChunk(entities, chunk);
+    }
+    return total;
+}
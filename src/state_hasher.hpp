@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "entity_store.hpp"
+#include "hex_grid.hpp"
+
+// Incremental hash of tile and entity state for lockstep desync detection.
+//
+// Tiles are hashed per square chunk and entities per run of handle indices. The state hash
+// is the sum of the chunk hashes, each salted with its chunk id, so update() only rehashes
+// chunks marked dirty since the last call and patches the sum with the difference. Whoever
+// changes a tile or an entity's components marks it; hashAll() recomputes everything from
+// scratch for checking that nothing was missed.
+class StateHasher {
+public:
+    explicit StateHasher(const HexGrid& grid, int tileChunkSize = 8, uint32_t entityChunkSize = 64);
+
+    void markTile(int tile);
+    void markEntity(uint32_t index); // Handle index; also after a despawn
+    void markAll();
+
+    // Rehash the dirty chunks and return the state hash
+    uint64_t update(const EntityStore& entities);
+    uint64_t hashAll(const EntityStore& entities) const;
+
+    // Hash of the tile chunks alone as of the last update(), to tell maps apart
+    uint64_t getTileHash() const { return tileTotal; }
+    size_t getLastRehashCount() const { return lastRehashCount; }
+
+private:
+    const HexGrid& grid;
+    int tileChunkSize;
+    int tileChunksX;
+    uint32_t entityChunkSize;
+
+    std::vector<uint64_t> tileChunkHashes;
+    std::vector<uint64_t> entityChunkHashes;
+    std::vector<uint8_t> tileDirty;
+    std::vector<uint8_t> entityDirty;
+    std::vector<uint32_t> dirtyTileChunks;
+    std::vector<uint32_t> dirtyEntityChunks;
+    uint64_t tileTotal = 0;
+    uint64_t entityTotal = 0;
+    size_t lastRehashCount = 0;
+
+    uint64_t hashTileChunk(uint32_t chunk) const;
+    uint64_t hashEntityChunk(const EntityStore& entities, uint32_t chunk) const;
+};
@@ -146,45 +146,9 @@ void createSwapchain(Device& device, VkSurfaceKHR surface, Window& window, Swapc
         }
     }
 
-    // MSAA setup: create a single transient color image with 4x if supported
+    // MSAA setup: 4x if supported. The frame's color, depth and SSAO targets are transient
+    // images owned by the render graph.
     swapchain.msaaSamples = chooseMsaaSamples(device.physicalDevice, VK_SAMPLE_COUNT_4_BIT);
-    if (swapchain.msaaSamples != VK_SAMPLE_COUNT_1_BIT) {
-        swapchain.msaaColor = createImage(device, extent.width, extent.height, swapchain.format,
-                                          VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-                                          VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
-                                          1, swapchain.msaaSamples);
-        createImageView(device, swapchain.msaaColor, VK_IMAGE_ASPECT_COLOR_BIT);
-    } else {
-        swapchain.msaaColor = {}; // zero-init
-    }
-
-    // Create depth buffer (also sampleable for SSAO)
-    swapchain.depthImage = createImage(device, extent.width, extent.height, swapchain.depthFormat,
-                                       VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                                       VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
-                                       1, swapchain.msaaSamples);
-    createImageView(device, swapchain.depthImage, VK_IMAGE_ASPECT_DEPTH_BIT);
-
-    // Create SSAO target (single-sampled color, sampled later)
-    swapchain.ssaoImage = createImage(device, extent.width, extent.height, swapchain.ssaoFormat,
-                                      VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                                      VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
-                                      1, VK_SAMPLE_COUNT_1_BIT);
-    createImageView(device, swapchain.ssaoImage, VK_IMAGE_ASPECT_COLOR_BIT);
-
-    // Create scene color (single-sample) for post-processing
-    swapchain.sceneColor = createImage(device, extent.width, extent.height, swapchain.format,
-                                       VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                                       VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
-                                       1, VK_SAMPLE_COUNT_1_BIT);
-    createImageView(device, swapchain.sceneColor, VK_IMAGE_ASPECT_COLOR_BIT);
-
-    // Create resolved depth (single-sample) for SSAO sampling
-    swapchain.depthResolved = createImage(device, extent.width, extent.height, swapchain.depthFormat,
-                                          VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                                          VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
-                                          1, VK_SAMPLE_COUNT_1_BIT);
-    createImageView(device, swapchain.depthResolved, VK_IMAGE_ASPECT_DEPTH_BIT);
 
     // Create SSAO sampler
     VkSamplerCreateInfo samplerInfo{};
@@ -235,35 +199,7 @@ void createSwapchain(Device& device, VkSurfaceKHR surface, Window& window, Swapc
 }
 
 void cleanupSwapchain(Device& device, Swapchain& swapchain) {
-    // Destroy MSAA color target if present
-    if (swapchain.msaaColor.image != VK_NULL_HANDLE) {
-        destroyImage(device, swapchain.msaaColor);
-        swapchain.msaaColor = {};
-    }
-    
-    // Destroy depth buffer
-    if (swapchain.depthImage.image != VK_NULL_HANDLE) {
-        destroyImage(device, swapchain.depthImage);
-        swapchain.depthImage = {};
-    }
-
-    // Destroy resolved depth
-    if (swapchain.depthResolved.image != VK_NULL_HANDLE) {
-        destroyImage(device, swapchain.depthResolved);
-        swapchain.depthResolved = {};
-    }
-
-    // Destroy scene color
-    if (swapchain.sceneColor.image != VK_NULL_HANDLE) {
-        destroyImage(device, swapchain.sceneColor);
-        swapchain.sceneColor = {};
-    }
-
-    // Destroy SSAO target and sampler
-    if (swapchain.ssaoImage.image != VK_NULL_HANDLE) {
-        destroyImage(device, swapchain.ssaoImage);
-        swapchain.ssaoImage = {};
-    }
+    // Destroy SSAO sampler
     if (swapchain.ssaoSampler != VK_NULL_HANDLE) {
         vkDestroySampler(device.device, swapchain.ssaoSampler, nullptr);
         swapchain.ssaoSampler = VK_NULL_HANDLE;
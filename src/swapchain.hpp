@@ -18,6 +18,10 @@ struct Swapchain {
     VkExtent2D extent;
     std::vector<SwapchainImage> images;
 
+    // The frame's targets below are transient images owned by the render graph, which places
+    // them in shared memory by lifetime; the handles are copied here for the pipelines that
+    // bind them.
+
     // MSAA color target
     VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
     Image msaaColor;
@@ -76,6 +76,11 @@ struct TerrainProperties {
     }
 };
 
+// Water tiles (navigable by ships)
+inline bool isWaterTerrain(TerrainType type) {
+    return type == TerrainType::Ocean || type == TerrainType::CoastalWater || type == TerrainType::River;
+}
+
 // Individual tile data
 struct TerrainTile {
     TerrainType type;
@@ -10,6 +10,9 @@
 #include "map_builder.hpp"
 #include "ssao_pipeline.hpp"
 #include "tiltshift_pipeline.hpp"
+#include "hex_grid.hpp"
+#include "pathfinding.hpp"
+#include "turn_simulation.hpp"
 
 // Example terrain scene setup
 class TerrainExample {
@@ -20,6 +23,7 @@ public:
         , terrainRenderer(device, 1.0f) // Hex size of 1.0
         , treeRenderer(device)
         , camera()
+        , pathfinder(grid)
     {
         // Setup camera for diorama view
         camera.setAspectRatio(static_cast<float>(swapchain.extent.width) / 
@@ -39,6 +43,8 @@ public:
         // Bind SSAO for terrain and depth for SSAO
         updateTerrainSsaoDescriptor(device, pipeline, swapchain.ssaoImage.view, swapchain.ssaoSampler);
         updateSSAODepthDescriptor(device, ssaoPipeline, swapchain);
+        // Bind fog-of-war texture (owned by the terrain renderer)
+        rebindFogDescriptor();
         // Create tilt-shift pipeline and bind scene/depth
         createTiltShiftPipeline(device, swapchain, tiltPipeline);
         updateTiltShiftDescriptors(device, tiltPipeline, swapchain);
@@ -72,11 +78,18 @@ public:
         config.moistureFrequency = 0.10f;
         
         MapBuilder::generateMap(terrainRenderer, config);
+        grid = HexGrid::fromTiles(terrainRenderer.getTiles());
     }
     
     void update(float deltaTime) {
         elapsedTime += deltaTime;
         
+        // rebuildMesh() recreates the fog texture when the tile bounds change (after waiting
+        // for the device), leaving the descriptor pointing at the destroyed view
+        if (terrainRenderer.getFogTextureVersion() != boundFogTextureVersion) {
+            rebindFogDescriptor();
+        }
+        
         // Update terrain rendering parameters
         terrainRenderer.updateRenderParams(camera, elapsedTime);
         
@@ -88,10 +101,30 @@ public:
         params.ambientIntensity = renderParams.ambientIntensity;
         params.hexSize = renderParams.hexSize;
         params.currentEra = static_cast<int>(renderParams.currentEra);
+        params.fogOrigin = terrainRenderer.getFogOrigin();
         
         updateTerrainParams(pipeline, params);
     }
     
+    // Mirror a player's sight into the fog of war: tiles seen this turn are visible, tiles
+    // seen before stay explored. Only changed texels are uploaded next frame.
+    void updateFog(const TurnSimulation& simulation, int player) {
+        const auto& tiles = terrainRenderer.getTiles();
+        for (int i = 0; i < grid.size(); ++i) {
+            HexCoord hex = grid.coordOf(i);
+            auto it = tiles.find(hex);
+            if (it == tiles.end()) continue;
+            uint8_t visible = simulation.isVisible(player, i) ? 255 : 0;
+            uint8_t explored = visible > 0 ? 255 : it->second.explored;
+            terrainRenderer.setTileVisibility(hex, explored, visible);
+        }
+    }
+    
+    // Record per-frame resource uploads (must happen before any rendering scope begins)
+    void recordUploads(VkCommandBuffer cmd, uint32_t frameIndex) {
+        terrainRenderer.recordFogUpload(cmd, frameIndex);
+    }
+    
     void renderDepthOnly(VkCommandBuffer cmd) {
         // Set viewport and scissor
         VkViewport viewport{};
@@ -223,6 +256,11 @@ public:
         vkCmdDraw(cmd, 3, 1, 0, 0);
     }
 
+    void rebindFogDescriptor() {
+        updateTerrainFogDescriptor(device, pipeline, terrainRenderer.getFogImageView(), terrainRenderer.getFogSampler());
+        boundFogTextureVersion = terrainRenderer.getFogTextureVersion();
+    }
+
     void rebindSsaoDescriptors() {
         updateTerrainSsaoDescriptor(device, pipeline, swapchain.ssaoImage.view, swapchain.ssaoSampler);
         updateSSAODepthDescriptor(device, ssaoPipeline, swapchain);
@@ -265,7 +303,13 @@ public:
         vkCmdDraw(cmd, 3, 1, 0, 0);
     }
     
+    // Cheapest path between two hexes over all terrain (false if unreachable)
+    bool findPath(const HexCoord& from, const HexCoord& to, std::vector<HexCoord>& outPath, float& outCost) {
+        return pathfinder.findPath(from, to, MovementProfile::allTerrain(), outPath, &outCost);
+    }
+    
     Camera& getCamera() { return camera; }
+    const HexGrid& getGrid() const { return grid; }
     float getHexSize() const { return terrainRenderer.getRenderParams().hexSize; }
     
 private:
@@ -278,6 +322,9 @@ private:
     SSAOPipeline ssaoPipeline;
     TiltShiftPipeline tiltPipeline;
     Camera camera;
+    HexGrid grid; // Dense gameplay view of the terrain tiles
+    HexPathfinder pathfinder;
     float elapsedTime = 0.0f;
+    uint32_t boundFogTextureVersion = 0; // Fog texture version the terrain descriptor points at
 };
 
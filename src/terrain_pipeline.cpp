@@ -100,8 +100,8 @@ void createTerrainPipeline(Device& device, Swapchain& swapchain, TerrainPipeline
     depthStencil.depthBoundsTestEnable = VK_FALSE;
     depthStencil.stencilTestEnable = VK_FALSE;
 
-    // Descriptor set layout (binding 0: UBO, binding 1: SSAO sampler)
-    VkDescriptorSetLayoutBinding bindings[2]{};
+    // Descriptor set layout (binding 0: UBO, binding 1: SSAO sampler, binding 2: fog-of-war sampler)
+    VkDescriptorSetLayoutBinding bindings[3]{};
     // UBO
     bindings[0].binding = 0;
     bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
@@ -112,10 +112,15 @@ void createTerrainPipeline(Device& device, Swapchain& swapchain, TerrainPipeline
     bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     bindings[1].descriptorCount = 1;
     bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    // Fog-of-war texture (tile space)
+    bindings[2].binding = 2;
+    bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[2].descriptorCount = 1;
+    bindings[2].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
     VkDescriptorSetLayoutCreateInfo layoutInfo{};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.bindingCount = 2;
+    layoutInfo.bindingCount = 3;
     layoutInfo.pBindings = bindings;
 
     if (vkCreateDescriptorSetLayout(device.device, &layoutInfo, nullptr, &pipeline.descriptorSetLayout) != VK_SUCCESS) {
@@ -235,7 +240,7 @@ void createTerrainPipeline(Device& device, Swapchain& swapchain, TerrainPipeline
     poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
     poolSizes[0].descriptorCount = 1;
     poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSizes[1].descriptorCount = 1;
+    poolSizes[1].descriptorCount = 2; // SSAO + fog
 
     VkDescriptorPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -258,7 +263,7 @@ void createTerrainPipeline(Device& device, Swapchain& swapchain, TerrainPipeline
         throw std::runtime_error("Failed to allocate terrain descriptor set!");
     }
 
-    // Update descriptor set (binding 0: UBO). SSAO (binding 1) updated separately.
+    // Update descriptor set (binding 0: UBO). SSAO (binding 1) and fog (binding 2) updated separately.
     VkDescriptorBufferInfo bufferInfoDesc{};
     bufferInfoDesc.buffer = pipeline.uniformBuffer;
     bufferInfoDesc.offset = 0;
@@ -361,3 +366,20 @@ void updateTerrainSsaoDescriptor(Device& device, TerrainPipeline& pipeline, VkIm
     vkUpdateDescriptorSets(device.device, 1, &write, 0, nullptr);
 }
 
+void updateTerrainFogDescriptor(Device& device, TerrainPipeline& pipeline, VkImageView fogView, VkSampler fogSampler) {
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.imageView = fogView;
+    imageInfo.sampler = fogSampler;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = pipeline.descriptorSet;
+    write.dstBinding = 2;
+    write.dstArrayElement = 0;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.descriptorCount = 1;
+    write.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(device.device, 1, &write, 0, nullptr);
+}
@@ -20,7 +20,7 @@ struct TerrainParamsUBO {
     float ambientIntensity;
     float hexSize;
     int32_t currentEra;
-    float padding2[2];
+    glm::ivec2 fogOrigin; // Offset (col, row) of fog texel (0, 0)
 };
 
 // Terrain pipeline structure
@@ -55,3 +55,6 @@ void updateTerrainParams(TerrainPipeline& pipeline, const TerrainParamsUBO& para
 // Update SSAO texture binding
 void updateTerrainSsaoDescriptor(Device& device, TerrainPipeline& pipeline, VkImageView ssaoView, VkSampler ssaoSampler);
 
+// Update fog-of-war texture binding
+void updateTerrainFogDescriptor(Device& device, TerrainPipeline& pipeline, VkImageView fogView, VkSampler fogSampler);
+
@@ -1,4 +1,5 @@
 #include "terrain_renderer.hpp"
+#include <algorithm>
 #include <iostream>
 
 TerrainRenderer::TerrainRenderer(Device& device, float hexSize)
@@ -18,6 +19,7 @@ TerrainRenderer::~TerrainRenderer() {
     if (indexBuffer.buffer != VK_NULL_HANDLE) {
         destroyBuffer(device, indexBuffer);
     }
+    destroyFogTexture(device, fog);
 }
 
 void TerrainRenderer::initializeRectangularGrid(int width, int height) {
@@ -165,6 +167,23 @@ void TerrainRenderer::setTerrainHeight(const HexCoord& hex, float height) {
     }
 }
 
+void TerrainRenderer::setTileVisibility(const HexCoord& hex, uint8_t explored, uint8_t visible) {
+    auto it = tiles.find(hex);
+    if (it == tiles.end()) return;
+    it->second.explored = explored;
+    it->second.visible = visible;
+
+    glm::ivec2 texel = hexToOffset(hex) - fog.origin;
+    if (texel.x >= 0 && texel.y >= 0) {
+        setFogTexel(fog, static_cast<uint32_t>(texel.x), static_cast<uint32_t>(texel.y),
+                    encodeFogTexel(explored, visible));
+    }
+}
+
+void TerrainRenderer::recordFogUpload(VkCommandBuffer cmd, uint32_t frameIndex) {
+    ::recordFogUpload(device, cmd, fog, frameIndex);
+}
+
 void TerrainRenderer::rebuildMesh() {
     if (!meshDirty) return;
     
@@ -181,6 +200,7 @@ void TerrainRenderer::rebuildMesh() {
     
     // Upload to GPU
     uploadMeshToGPU();
+    rebuildFogTexture();
     
     meshDirty = false;
     std::cout << "Rebuilt terrain mesh: " << mesh.vertices.size() 
@@ -192,6 +212,40 @@ void TerrainRenderer::updateRenderParams(const Camera& camera, float time) {
     // Update other params as needed (sun direction, era, etc.)
 }
 
+void TerrainRenderer::rebuildFogTexture() {
+    if (tileOrder.empty()) return;
+
+    // Bounding box of all tiles in offset space
+    glm::ivec2 minOffset = hexToOffset(tileOrder.front());
+    glm::ivec2 maxOffset = minOffset;
+    for (const auto& hex : tileOrder) {
+        glm::ivec2 o = hexToOffset(hex);
+        minOffset.x = std::min(minOffset.x, o.x);
+        minOffset.y = std::min(minOffset.y, o.y);
+        maxOffset.x = std::max(maxOffset.x, o.x);
+        maxOffset.y = std::max(maxOffset.y, o.y);
+    }
+    uint32_t width = static_cast<uint32_t>(maxOffset.x - minOffset.x + 1);
+    uint32_t height = static_cast<uint32_t>(maxOffset.y - minOffset.y + 1);
+
+    // Same layout: keep the texture and let setFogTexel mark only what changed
+    if (fog.image.image == VK_NULL_HANDLE || fog.width != width || fog.height != height ||
+        fog.origin != minOffset) {
+        if (fog.image.image != VK_NULL_HANDLE) {
+            vkDeviceWaitIdle(device.device); // Old texture may still be sampled by frames in flight
+            destroyFogTexture(device, fog);
+        }
+        createFogTexture(device, fog, width, height, minOffset, Swapchain::MAX_FRAMES_IN_FLIGHT);
+        ++fogTextureVersion;
+    }
+
+    for (const auto& [hex, tile] : tiles) {
+        glm::ivec2 texel = hexToOffset(hex) - fog.origin;
+        setFogTexel(fog, static_cast<uint32_t>(texel.x), static_cast<uint32_t>(texel.y),
+                    encodeFogTexel(tile.explored, tile.visible));
+    }
+}
+
 void TerrainRenderer::uploadMeshToGPU() {
     // Destroy old buffers if they exist
     if (vertexBuffer.buffer != VK_NULL_HANDLE) {
@@ -10,6 +10,7 @@
 #include "hex_mesh.hpp"
 #include "terrain.hpp"
 #include "terrain_pipeline.hpp"
+#include "fog_texture.hpp"
 
 // Terrain renderer - manages all hex tiles and rendering
 class TerrainRenderer {
@@ -29,6 +30,12 @@ public:
     void setTerrainType(const HexCoord& hex, TerrainType type);
     void setTerrainHeight(const HexCoord& hex, float height);
     
+    // Set fog-of-war state for a hex (only the changed fog texel is re-uploaded)
+    void setTileVisibility(const HexCoord& hex, uint8_t explored, uint8_t visible);
+    
+    // Record pending fog texture uploads (call outside of rendering, once per frame)
+    void recordFogUpload(VkCommandBuffer cmd, uint32_t frameIndex);
+    
     // Update terrain mesh (call after modifying terrain)
     void rebuildMesh();
     
@@ -45,6 +52,13 @@ public:
     const Buffer& getIndexBuffer() const { return indexBuffer; }
     uint32_t getIndexCount() const { return static_cast<uint32_t>(mesh.indices.size()); }
     
+    // Get fog-of-war texture (recreated when the grid layout changes; rebind after rebuildMesh)
+    VkImageView getFogImageView() const { return fog.image.view; }
+    VkSampler getFogSampler() const { return fog.sampler; }
+    glm::ivec2 getFogOrigin() const { return fog.origin; }
+    // Bumped each time the fog texture is recreated; descriptors bound to an older version are stale
+    uint32_t getFogTextureVersion() const { return fogTextureVersion; }
+    
     // Get terrain data
     const std::unordered_map<HexCoord, TerrainTile>& getTiles() const { return tiles; }
     
@@ -62,10 +76,17 @@ private:
     Buffer indexBuffer;
     bool meshDirty;
     
+    // Fog of war (tile-space texture)
+    FogTexture fog;
+    uint32_t fogTextureVersion = 0;
+    
     // Rendering parameters
     TerrainRenderParams renderParams;
     
     // Upload mesh to GPU
     void uploadMeshToGPU();
+    
+    // Resize fog texture to the tile bounds and refresh its texels from the tiles
+    void rebuildFogTexture();
 };
 
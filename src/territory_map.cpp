@@ -0,0 +1,253 @@
+#include "territory_map.hpp"
+
+#include <algorithm>
+
+TerritoryMap::TerritoryMap(const HexGrid& grid, const MovementProfile& profile, float claimRange)
+    : grid(grid)
+    , profile(profile)
+    , claimRange(claimRange)
+{
+    size_t tileCount = static_cast<size_t>(grid.size());
+    owners.assign(tileCount, UNOWNED);
+    costs.assign(tileCount, MovementProfile::IMPASSABLE);
+    queuedStamp.assign(tileCount, 0);
+    settledStamp.assign(tileCount, 0);
+    holeStamp.assign(tileCount, 0);
+    heap.reserve(grid.size());
+}
+
+void TerritoryMap::beginSearch() {
+    // Bumping the generation forgets the previous search; on wrap-around reset once for real
+    if (++generation == 0) {
+        std::fill(queuedStamp.begin(), queuedStamp.end(), 0);
+        std::fill(settledStamp.begin(), settledStamp.end(), 0);
+        std::fill(holeStamp.begin(), holeStamp.end(), 0);
+        generation = 1;
+    }
+    heap.clear();
+}
+
+void TerritoryMap::setLabel(int tile, float cost, int32_t owner) {
+    if (owners[tile] != owner) {
+        if (owners[tile] != UNOWNED) --cities[owners[tile]].territorySize;
+        if (owner != UNOWNED) ++cities[owner].territorySize;
+    }
+    owners[tile] = owner;
+    costs[tile] = cost;
+}
+
+void TerritoryMap::offer(int tile, float cost, int32_t owner) {
+    // Labels compare as (cost, owner), so equal-cost ties always go the same way
+    if (settledStamp[tile] == generation) return;
+    if (owners[tile] != UNOWNED && (cost > costs[tile] || (cost == costs[tile] && owner >= owners[tile]))) return;
+
+    setLabel(tile, cost, owner);
+    if (queuedStamp[tile] == generation) {
+        heap.decreaseKey(tile, cost, static_cast<float>(owner));
+    } else {
+        queuedStamp[tile] = generation;
+        heap.push(tile, cost, static_cast<float>(owner));
+    }
+}
+
+void TerritoryMap::propagate(bool holeOnly) {
+    const std::vector<TerrainType>& types = grid.getTypes();
+    std::array<int, 6> neighbors;
+    while (!heap.empty()) {
+        int tile = heap.pop().id;
+        settledStamp[tile] = generation;
+
+        grid.neighborIndices(tile, neighbors);
+        for (int next : neighbors) {
+            if (next < 0 || (holeOnly && holeStamp[next] != generation)) continue;
+            float cost = costs[tile] + profile.entryCost(types[next]);
+            if (cost == MovementProfile::IMPASSABLE || cost > claimRange) continue;
+            offer(next, cost, owners[tile]);
+        }
+    }
+}
+
+void TerritoryMap::rebuild() {
+    std::fill(owners.begin(), owners.end(), UNOWNED);
+    std::fill(costs.begin(), costs.end(), MovementProfile::IMPASSABLE);
+    for (City& city : cities) city.territorySize = 0;
+
+    beginSearch();
+    for (CityId id = 0; id < static_cast<CityId>(cities.size()); ++id) {
+        if (cities[id].alive) offer(cities[id].tile, 0.0f, id);
+    }
+    propagate(false);
+}
+
+CityId TerritoryMap::foundCity(int tile) {
+    if (tile < 0 || tile >= grid.size()) return UNOWNED;
+
+    CityId id;
+    if (!freeCities.empty()) {
+        id = freeCities.back();
+        freeCities.pop_back();
+    } else {
+        id = static_cast<CityId>(cities.size());
+        cities.emplace_back();
+    }
+    cities[id] = City{tile, true, 0};
+
+    // Only tiles the new city wins are relabeled, so the search stops at its border
+    beginSearch();
+    offer(tile, 0.0f, id);
+    propagate(false);
+    return id;
+}
+
+void TerritoryMap::loseCity(CityId id) {
+    City& city = cities[id];
+    if (!city.alive) return;
+    city.alive = false;
+    freeCities.push_back(id);
+
+    // Territories are connected through the city's own shortest-path tree, so a flood from
+    // the city tile finds all of it
+    beginSearch();
+    queue.clear();
+    if (owners[city.tile] == id) {
+        holeStamp[city.tile] = generation;
+        queue.push_back(city.tile);
+    }
+    std::array<int, 6> neighbors;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        grid.neighborIndices(queue[head], neighbors);
+        for (int next : neighbors) {
+            if (next >= 0 && owners[next] == id && holeStamp[next] != generation) {
+                holeStamp[next] = generation;
+                queue.push_back(next);
+            }
+        }
+    }
+    for (int32_t tile : queue) setLabel(tile, MovementProfile::IMPASSABLE, UNOWNED);
+    city.territorySize = 0;
+
+    // Refill the hole from its rim, plus any city standing inside it (a later city founded
+    // on the same tile)
+    for (int32_t tile : queue) {
+        grid.neighborIndices(tile, neighbors);
+        for (int next : neighbors) {
+            if (next < 0 || holeStamp[next] == generation || owners[next] == UNOWNED) continue;
+            if (queuedStamp[next] == generation) continue;
+            queuedStamp[next] = generation;
+            heap.push(next, costs[next], static_cast<float>(owners[next]));
+        }
+    }
+    for (CityId other = 0; other < static_cast<CityId>(cities.size()); ++other) {
+        if (cities[other].alive && holeStamp[cities[other].tile] == generation) {
+            offer(cities[other].tile, 0.0f, other);
+        }
+    }
+    propagate(true);
+}
+
+uint32_t TerritoryMap::cornerId(int tile, int corner) const {
+    // Each corner is shared by three hexes; corner c of a hex is corner c + 2 of its
+    // neighbor in direction c. That folds every corner onto corner 0 or 1 of one hex, which
+    // may sit one step outside the grid.
+    static constexpr int BASE_DIRECTION[6] = {-1, -1, 3, 4, 4, 5};
+    HexCoord hex = grid.coordOf(tile);
+    if (BASE_DIRECTION[corner] >= 0) hex = hexNeighbor(hex, BASE_DIRECTION[corner]);
+    glm::ivec2 offset = hexToOffset(hex) - grid.getOrigin();
+    uint32_t cell = static_cast<uint32_t>((offset.y + 1) * (grid.getWidth() + 2) + offset.x + 1);
+    return cell * 2 + static_cast<uint32_t>(corner & 1);
+}
+
+void TerritoryMap::addCornerEdge(uint32_t corner, int32_t edge) {
+    if (cornerStamp[corner] != cornerGeneration) {
+        cornerStamp[corner] = cornerGeneration;
+        cornerSlot[corner] = static_cast<int32_t>(cornerEdges.size());
+        cornerEdges.emplace_back();
+        cornerDegree.push_back(0);
+    }
+    int32_t slot = cornerSlot[corner];
+    cornerEdges[slot][cornerDegree[slot]++] = edge;
+}
+
+void TerritoryMap::extractBorders(TerritoryBorders& out, float hexSize, float height) {
+    out.points.clear();
+    out.lineStarts.clear();
+    out.owners.clear();
+
+    size_t cornerCount = static_cast<size_t>(grid.getWidth() + 2) * (grid.getHeight() + 2) * 2;
+    if (cornerStamp.size() != cornerCount) {
+        cornerStamp.assign(cornerCount, 0);
+        cornerSlot.resize(cornerCount);
+        cornerGeneration = 0;
+    }
+    if (++cornerGeneration == 0) {
+        std::fill(cornerStamp.begin(), cornerStamp.end(), 0);
+        cornerGeneration = 1;
+    }
+    edges.clear();
+    cornerEdges.clear();
+    cornerDegree.clear();
+
+    // The edge facing direction d runs from corner d - 1 to corner d. Edges between two grid
+    // tiles are taken from the side where d is 0..2 only, so each one is emitted once;
+    // edges on the grid rim have just the one side.
+    const std::array<glm::vec3, 6> corners = hexVertices(HexCoord(0, 0), hexSize, height);
+    std::array<int, 6> neighbors;
+    for (int tile = 0; tile < grid.size(); ++tile) {
+        grid.neighborIndices(tile, neighbors);
+        glm::vec3 center;
+        bool centerKnown = false;
+        for (int dir = 0; dir < 6; ++dir) {
+            int next = neighbors[dir];
+            int32_t other = next >= 0 ? owners[next] : UNOWNED;
+            if (owners[tile] == other || (next >= 0 && dir >= 3)) continue;
+
+            if (!centerKnown) {
+                center = hexToWorld(grid.coordOf(tile), hexSize);
+                centerKnown = true;
+            }
+            int from = (dir + 5) % 6;
+            int32_t edge = static_cast<int32_t>(edges.size());
+            edges.push_back(BorderEdge{cornerId(tile, from), cornerId(tile, dir), center + corners[from],
+                                       center + corners[dir],
+                                       glm::ivec2(std::min(owners[tile], other), std::max(owners[tile], other))});
+            addCornerEdge(edges.back().cornerA, edge);
+            addCornerEdge(edges.back().cornerB, edge);
+        }
+    }
+
+    // A corner touches 0, 2 or 3 border edges. Lines run through the 2-edge corners and end
+    // at the 3-way junctions; whatever is left afterwards is a closed loop.
+    edgeUsed.assign(edges.size(), 0);
+    for (int32_t edge = 0; edge < static_cast<int32_t>(edges.size()); ++edge) {
+        if (edgeUsed[edge]) continue;
+        if (cornerDegree[cornerSlot[edges[edge].cornerA]] != 2) {
+            walkBorder(edge, edges[edge].cornerA, out);
+        } else if (cornerDegree[cornerSlot[edges[edge].cornerB]] != 2) {
+            walkBorder(edge, edges[edge].cornerB, out);
+        }
+    }
+    for (int32_t edge = 0; edge < static_cast<int32_t>(edges.size()); ++edge) {
+        if (!edgeUsed[edge]) walkBorder(edge, edges[edge].cornerA, out);
+    }
+    out.lineStarts.push_back(static_cast<uint32_t>(out.points.size()));
+}
+
+void TerritoryMap::walkBorder(int32_t edge, uint32_t fromCorner, TerritoryBorders& out) {
+    out.lineStarts.push_back(static_cast<uint32_t>(out.points.size()));
+    out.owners.push_back(edges[edge].owners);
+    out.points.push_back(edges[edge].cornerA == fromCorner ? edges[edge].a : edges[edge].b);
+
+    uint32_t corner = fromCorner;
+    while (true) {
+        const BorderEdge& current = edges[edge];
+        edgeUsed[edge] = 1;
+        bool forward = current.cornerA == corner;
+        corner = forward ? current.cornerB : current.cornerA;
+        out.points.push_back(forward ? current.b : current.a);
+
+        int32_t slot = cornerSlot[corner];
+        if (cornerDegree[slot] != 2) break;
+        edge = cornerEdges[slot][0] == edge ? cornerEdges[slot][1] : cornerEdges[slot][0];
+        if (edgeUsed[edge]) break; // Back at the start of a closed loop
+    }
+}
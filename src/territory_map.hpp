@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "hex_grid.hpp"
+#include "indexed_heap.hpp"
+
+using CityId = int32_t;
+
+// Border lines between differently owned tiles, each shared hex edge emitted once.
+// Polyline i covers points[lineStarts[i] .. lineStarts[i + 1]) and separates the territories
+// owners[i].x < owners[i].y (TerritoryMap::UNOWNED for unclaimed tiles and the map edge).
+// Closed borders repeat their first point at the end, so every polyline draws as a strip.
+struct TerritoryBorders {
+    std::vector<glm::vec3> points;
+    std::vector<uint32_t> lineStarts;
+    std::vector<glm::ivec2> owners;
+};
+
+// City territories as the terrain-weighted Voronoi regions of the cities: every tile belongs
+// to the city with the cheapest path to it (summed entry costs under profile), ties going to
+// the lower city id, and tiles farther than claimRange from every city stay unclaimed.
+//
+// rebuild() runs one multi-source Dijkstra. Founding a city only searches the area it wins,
+// since every tile it takes is reached through tiles it also takes. Losing a city clears
+// its territory and refills that hole from the surrounding tiles' existing labels; nothing
+// outside the hole can change.
+class TerritoryMap {
+public:
+    static constexpr int32_t UNOWNED = -1;
+
+    TerritoryMap(const HexGrid& grid, const MovementProfile& profile = MovementProfile::allTerrain(),
+                 float claimRange = MovementProfile::IMPASSABLE);
+
+    // Returns UNOWNED when tile is outside the grid
+    CityId foundCity(int tile);
+    void loseCity(CityId id);
+
+    // Recompute every tile, e.g. after terrain edits
+    void rebuild();
+
+    int32_t ownerOf(int tile) const { return owners[tile]; }
+    float costOf(int tile) const { return costs[tile]; }
+    const std::vector<int32_t>& getOwners() const { return owners; }
+    int getCityTile(CityId id) const { return cities[id].tile; }
+    int getTerritorySize(CityId id) const { return cities[id].territorySize; }
+
+    // Border polylines in world space, in one pass over the tiles plus a walk over the edges
+    void extractBorders(TerritoryBorders& out, float hexSize, float height = 0.0f);
+
+private:
+    struct City {
+        int tile = -1;
+        bool alive = false;
+        int territorySize = 0;
+    };
+
+    struct BorderEdge {
+        uint32_t cornerA;
+        uint32_t cornerB;
+        glm::vec3 a;
+        glm::vec3 b;
+        glm::ivec2 owners;
+    };
+
+    const HexGrid& grid;
+    MovementProfile profile;
+    float claimRange;
+
+    std::vector<City> cities;
+    std::vector<CityId> freeCities;
+    std::vector<int32_t> owners;
+    std::vector<float> costs;
+
+    // Search scratch, stamped per search
+    IndexedMinHeap heap;
+    std::vector<uint32_t> queuedStamp;
+    std::vector<uint32_t> settledStamp;
+    std::vector<uint32_t> holeStamp;
+    uint32_t generation = 0;
+    std::vector<int32_t> queue;
+
+    // Border scratch, stamped per extraction
+    std::vector<BorderEdge> edges;
+    std::vector<uint32_t> cornerStamp;
+    std::vector<int32_t> cornerSlot;
+    std::vector<std::array<int32_t, 3>> cornerEdges;
+    std::vector<uint8_t> cornerDegree;
+    std::vector<uint8_t> edgeUsed;
+    uint32_t cornerGeneration = 0;
+
+    void beginSearch();
+    void setLabel(int tile, float cost, int32_t owner);
+    void offer(int tile, float cost, int32_t owner);
+    void propagate(bool holeOnly);
+
+    uint32_t cornerId(int tile, int corner) const;
+    void addCornerEdge(uint32_t corner, int32_t edge);
+    void walkBorder(int32_t edge, uint32_t fromCorner, TerritoryBorders& out);
+};
@@ -0,0 +1,145 @@
+#include "trade_routes.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+TradeRouteCache::TradeRouteCache(const HexGrid& grid, const MovementProfile& profile, int chunkSize, int threadCount)
+    : grid(grid)
+    , profile(profile)
+    , chunkSize(std::max(chunkSize, 1))
+    , threadCount(threadCount > 0 ? threadCount : std::max(1, static_cast<int>(std::thread::hardware_concurrency())))
+{
+    chunksX = (grid.getWidth() + this->chunkSize - 1) / this->chunkSize;
+    int chunksY = (grid.getHeight() + this->chunkSize - 1) / this->chunkSize;
+    routesByChunk.resize(static_cast<size_t>(chunksX) * chunksY);
+}
+
+int TradeRouteCache::chunkOf(int tileIndex) const {
+    int col = tileIndex % grid.getWidth();
+    int row = tileIndex / grid.getWidth();
+    return (row / chunkSize) * chunksX + col / chunkSize;
+}
+
+RouteId TradeRouteCache::addRoute(int from, int to) {
+    RouteId id;
+    if (!freeSlots.empty()) {
+        id = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        id = static_cast<RouteId>(slots.size());
+        slots.emplace_back();
+    }
+
+    Slot& slot = slots[id];
+    slot.route = TradeRoute{};
+    slot.route.from = from;
+    slot.route.to = to;
+    slot.alive = true;
+    slot.valid = false;
+    pending.push_back(id);
+    return id;
+}
+
+void TradeRouteCache::removeRoute(RouteId id) {
+    Slot& slot = slots[id];
+    if (!slot.alive) return;
+    unlinkChunks(id);
+    slot.alive = false;
+    slot.valid = false;
+    slot.route.path.clear();
+    freeSlots.push_back(id);
+}
+
+void TradeRouteCache::invalidate(RouteId id) {
+    Slot& slot = slots[id];
+    if (!slot.alive || !slot.valid) return;
+    slot.valid = false;
+    pending.push_back(id);
+}
+
+void TradeRouteCache::markChunkDirty(int chunk) {
+    if (chunk < 0 || chunk >= static_cast<int>(routesByChunk.size())) return;
+    // invalidate() doesn't touch the chunk lists, so iterating them directly is safe
+    for (RouteId id : routesByChunk[chunk]) invalidate(id);
+    for (RouteId id : unreachableRoutes) invalidate(id);
+}
+
+void TradeRouteCache::invalidateAll() {
+    for (RouteId id = 0; id < slots.size(); ++id) invalidate(id);
+}
+
+void TradeRouteCache::unlinkChunks(RouteId id) {
+    TradeRoute& route = slots[id].route;
+    for (uint32_t chunk : route.chunks) {
+        auto& routes = routesByChunk[chunk];
+        auto it = std::find(routes.begin(), routes.end(), id);
+        if (it != routes.end()) {
+            *it = routes.back();
+            routes.pop_back();
+        }
+    }
+    route.chunks.clear();
+    unreachableRoutes.erase(std::remove(unreachableRoutes.begin(), unreachableRoutes.end(), id),
+                            unreachableRoutes.end());
+}
+
+void TradeRouteCache::linkChunks(RouteId id) {
+    const TradeRoute& route = slots[id].route;
+    for (uint32_t chunk : route.chunks) {
+        routesByChunk[chunk].push_back(id);
+    }
+    if (!route.reachable) unreachableRoutes.push_back(id);
+}
+
+size_t TradeRouteCache::update() {
+    // A slot can be queued twice if it was removed and reused before an update
+    std::sort(pending.begin(), pending.end());
+    pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+    pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                 [&](RouteId id) { return !slots[id].alive || slots[id].valid; }),
+                  pending.end());
+    if (pending.empty()) return 0;
+
+    // Chunk lists are shared between routes, so they are edited here rather than by the workers
+    for (RouteId id : pending) unlinkChunks(id);
+
+    int workers = std::min(threadCount, static_cast<int>(pending.size()));
+    while (static_cast<int>(pathfinders.size()) < workers) {
+        pathfinders.emplace_back(grid);
+    }
+
+    std::atomic<size_t> nextJob{0};
+    auto work = [&](int worker) {
+        HexPathfinder& pathfinder = pathfinders[worker];
+        for (size_t job = nextJob++; job < pending.size(); job = nextJob++) {
+            TradeRoute& route = slots[pending[job]].route;
+            route.reachable = pathfinder.findPath(route.from, route.to, profile, route.path, &route.cost);
+
+            route.chunks.clear();
+            for (int tile : route.path) {
+                route.chunks.push_back(static_cast<uint32_t>(chunkOf(tile)));
+            }
+            std::sort(route.chunks.begin(), route.chunks.end());
+            route.chunks.erase(std::unique(route.chunks.begin(), route.chunks.end()), route.chunks.end());
+        }
+    };
+
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(workers - 1);
+        for (int worker = 1; worker < workers; ++worker) {
+            threads.emplace_back(work, worker);
+        }
+        work(0);
+    }
+
+    for (RouteId id : pending) {
+        linkChunks(id);
+        slots[id].valid = true;
+    }
+
+    size_t planned = pending.size();
+    pending.clear();
+    return planned;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "hex_grid.hpp"
+#include "pathfinding.hpp"
+
+using RouteId = uint32_t;
+
+struct TradeRoute {
+    int from = -1;
+    int to = -1;
+    bool reachable = false;
+    float cost = 0.0f;
+    std::vector<int> path;         // Tile indices, both endpoints inclusive
+    std::vector<uint32_t> chunks;  // Sorted chunk ids the path crosses
+};
+
+// Persistent routes (galleons between cities) that are only re-planned when something
+// along them changes.
+//
+// The grid is divided into square chunks in offset space. Each route remembers the chunks
+// its path crosses and every chunk keeps the routes crossing it, so marking a chunk dirty
+// (terrain edit, blockade, ownership change) invalidates just those routes. update()
+// re-plans every invalid route, spreading them over worker threads that each own a
+// HexPathfinder.
+//
+// A change elsewhere can open a shorter route without touching the current path; such
+// routes keep their (still valid) path until invalidateAll(). Unreachable routes have no
+// path to track, so any dirty chunk retries them.
+class TradeRouteCache {
+public:
+    // threadCount 0 uses hardware_concurrency
+    TradeRouteCache(const HexGrid& grid, const MovementProfile& profile, int chunkSize = 16, int threadCount = 0);
+
+    // Routes are planned on the next update()
+    RouteId addRoute(int from, int to);
+    void removeRoute(RouteId id);
+    const TradeRoute& getRoute(RouteId id) const { return slots[id].route; }
+
+    // Call after grid.setType(tileIndex, ...)
+    void onTileChanged(int tileIndex) { markChunkDirty(chunkOf(tileIndex)); }
+    void markChunkDirty(int chunk);
+    void invalidateAll();
+
+    // Re-plan invalid routes; returns how many were planned
+    size_t update();
+
+    int chunkOf(int tileIndex) const;
+
+private:
+    struct Slot {
+        TradeRoute route;
+        bool alive = false;
+        bool valid = false;
+    };
+
+    const HexGrid& grid;
+    MovementProfile profile;
+    int chunkSize;
+    int chunksX;
+    int threadCount;
+
+    std::vector<Slot> slots;
+    std::vector<RouteId> freeSlots;
+    std::vector<std::vector<RouteId>> routesByChunk;
+    std::vector<RouteId> unreachableRoutes;
+    std::vector<RouteId> pending;
+    std::vector<HexPathfinder> pathfinders; // One per worker
+
+    void invalidate(RouteId id);
+    void unlinkChunks(RouteId id);
+    void linkChunks(RouteId id);
+};
@@ -0,0 +1,103 @@
+#include "transient_aliasing.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+bool livesOverlap(const TransientRequest& a, const TransientRequest& b) {
+    return a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+}
+
+struct Interval {
+    uint64_t begin;
+    uint64_t end;
+};
+
+} // namespace
+
+bool TransientLayout::overlaps(uint32_t a, uint32_t b) const {
+    if (a == b || heaps[a] != heaps[b]) return false;
+    return offsets[a] < offsets[b] + sizes[b] && offsets[b] < offsets[a] + sizes[a];
+}
+
+TransientLayout solveAliasing(const std::vector<TransientRequest>& requests) {
+    TransientLayout layout;
+    layout.heaps.assign(requests.size(), 0);
+    layout.offsets.assign(requests.size(), 0);
+    layout.sizes.resize(requests.size());
+    for (size_t i = 0; i < requests.size(); ++i) {
+        layout.sizes[i] = requests[i].size;
+        // Separate allocations would each be padded to their alignment too
+        layout.naiveBytes += alignUp(requests[i].size, requests[i].alignment);
+    }
+
+    // Largest first so small resources fill the gaps left between big ones
+    std::vector<uint32_t> order(requests.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return requests[a].size > requests[b].size;
+    });
+
+    std::vector<std::vector<uint32_t>> placed; // Requests in each heap
+    std::vector<Interval> busy;
+    for (size_t n = 0; n < order.size(); ++n) {
+        uint32_t index = order[n];
+        const TransientRequest& request = requests[index];
+
+        uint32_t bestHeap = UINT32_MAX;
+        uint64_t bestOffset = 0;
+        uint64_t bestGrowth = UINT64_MAX;
+        for (uint32_t heap = 0; heap < layout.heapInfo.size(); ++heap) {
+            if ((layout.heapInfo[heap].memoryTypeBits & request.memoryTypeBits) == 0) continue;
+
+            // Byte ranges of everything in this heap that is alive at the same time
+            busy.clear();
+            for (uint32_t other : placed[heap]) {
+                if (livesOverlap(request, requests[other])) {
+                    busy.push_back({layout.offsets[other], layout.offsets[other] + requests[other].size});
+                }
+            }
+            std::sort(busy.begin(), busy.end(), [](const Interval& a, const Interval& b) { return a.begin < b.begin; });
+
+            uint64_t offset = 0;
+            for (const Interval& range : busy) {
+                if (alignUp(offset, request.alignment) + request.size <= range.begin) break;
+                offset = std::max(offset, range.end);
+            }
+            offset = alignUp(offset, request.alignment);
+
+            uint64_t end = offset + request.size;
+            uint64_t growth = end > layout.heapInfo[heap].size ? end - layout.heapInfo[heap].size : 0;
+            if (growth < bestGrowth) {
+                bestHeap = heap;
+                bestOffset = offset;
+                bestGrowth = growth;
+            }
+        }
+
+        if (bestHeap == UINT32_MAX) {
+            bestHeap = static_cast<uint32_t>(layout.heapInfo.size());
+            bestOffset = 0;
+            layout.heapInfo.push_back(TransientHeap{0, 1, ~0u});
+            placed.emplace_back();
+        }
+
+        TransientHeap& heap = layout.heapInfo[bestHeap];
+        heap.size = std::max(heap.size, bestOffset + request.size);
+        heap.alignment = std::max(heap.alignment, request.alignment);
+        heap.memoryTypeBits &= request.memoryTypeBits;
+        placed[bestHeap].push_back(index);
+        layout.heaps[index] = bestHeap;
+        layout.offsets[index] = bestOffset;
+    }
+
+    for (const TransientHeap& heap : layout.heapInfo) {
+        layout.peakBytes += heap.size;
+    }
+    return layout;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// One transient resource to place: its memory requirements and the first and last pass
+// (inclusive) that touch it.
+struct TransientRequest {
+    uint64_t size{0};
+    uint64_t alignment{1};
+    uint32_t memoryTypeBits{~0u};
+    uint32_t firstPass{0};
+    uint32_t lastPass{0};
+};
+
+// One shared allocation. memoryTypeBits is what every resource placed in it accepts.
+struct TransientHeap {
+    uint64_t size{0};
+    uint64_t alignment{1};
+    uint32_t memoryTypeBits{~0u};
+};
+
+struct TransientLayout {
+    std::vector<uint32_t> heaps;   // Heap of each request
+    std::vector<uint64_t> offsets; // Offset of each request within its heap
+    std::vector<uint64_t> sizes;
+    std::vector<TransientHeap> heapInfo;
+    uint64_t peakBytes{0};  // Sum of heap sizes
+    uint64_t naiveBytes{0}; // Sum of aligned request sizes, as if nothing were aliased
+
+    // Whether requests a and b share bytes (only possible when their lifetimes are disjoint)
+    bool overlaps(uint32_t a, uint32_t b) const;
+};
+
+// Place transient resources so that resources whose pass ranges don't overlap may share
+// memory. Largest first, each goes at the lowest aligned offset that is free for its whole
+// lifetime in the compatible heap it grows least, or in a new heap if no heap's memory types
+// suit it. Pure CPU; nothing is allocated.
+TransientLayout solveAliasing(const std::vector<TransientRequest>& requests);
@@ -0,0 +1,439 @@
+#include "turn_simulation.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+// Per-kind tuning, indexed by EntityKind
+constexpr int MOVE_STEPS[] = {3, 1, 2, 1, 2, 1, 0};
+constexpr int VISION_RADIUS[] = {3, 1, 2, 2, 2, 2, 2};
+constexpr int64_t DOCKED_INCOME = 10; // Gold per turn for a galleon next to a friendly port
+
+constexpr EntityKind FLEET_MIX[] = {
+    EntityKind::Galleon, EntityKind::Frigate, EntityKind::Caravel, EntityKind::Galleon,
+    EntityKind::ShipOfTheLine, EntityKind::Privateer, EntityKind::Frigate, EntityKind::Flagship,
+};
+
+// Random streams, so different decisions about the same entity use unrelated numbers.
+// Combat draws from CombatResolver's own counters.
+constexpr uint32_t STREAM_DESTINATION = 0;
+
+// The merged engagement batch is only sized at run time, so combat resolves in a fixed
+// number of slices of it; a fixed count keeps the graph shape independent of the batch
+constexpr size_t COMBAT_SLICES = 64;
+
+void hashBytes(uint64_t& hash, const void* data, size_t size) {
+    // FNV-1a
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+    }
+}
+
+template <typename T>
+void hashValue(uint64_t& hash, const T& value) {
+    hashBytes(hash, &value, sizeof(T));
+}
+
+size_t kindIndex(EntityKind kind) { return static_cast<size_t>(kind); }
+
+} // namespace
+
+TurnSimulation::TurnSimulation(const HexGrid& grid, JobSystem& jobs, const SimulationConfig& config)
+    : grid(grid)
+    , jobs(jobs)
+    , config(config)
+    , naval(MovementProfile::naval())
+    , rngKey(philoxKey(config.seed))
+    , entities(grid)
+    , players(static_cast<size_t>(std::max(config.playerCount, 1)))
+    , visibleStamps(players.size(), std::vector<uint32_t>(static_cast<size_t>(grid.size()), 0))
+    , combat(config.seed)
+    , hasher(grid)
+{
+    this->config.playerCount = static_cast<int>(players.size());
+    this->config.chunkSize = std::max<size_t>(config.chunkSize, 1);
+    hasher.update(entities);
+}
+
+float TurnSimulation::random(uint32_t stream, uint32_t index) const {
+    return philoxUnitFloat(philox4x32({turn, index, stream, 0}, rngKey)[0]);
+}
+
+int TurnSimulation::randomWaterTile(uint32_t stream, uint32_t index) const {
+    for (uint32_t attempt = 0; attempt < 8; ++attempt) {
+        int tile = static_cast<int>(random(stream + attempt, index) * static_cast<float>(grid.size()));
+        tile = std::min(tile, grid.size() - 1);
+        if (naval.passable(grid.getType(tile))) return tile;
+    }
+    return -1;
+}
+
+void TurnSimulation::populate(int shipsPerPlayer, int citiesPerPlayer) {
+    std::vector<int> water;
+    std::vector<int> coast;
+    std::array<int, 6> neighbors;
+    for (int tile = 0; tile < grid.size(); ++tile) {
+        if (naval.passable(grid.getType(tile))) {
+            water.push_back(tile);
+            continue;
+        }
+        if (grid.getType(tile) == VOID_TERRAIN) continue;
+        grid.neighborIndices(tile, neighbors);
+        for (int next : neighbors) {
+            if (next >= 0 && naval.passable(grid.getType(next))) {
+                coast.push_back(tile);
+                break;
+            }
+        }
+    }
+    if (recorder) recorder->record(SimulationCommand::populate(shipsPerPlayer, citiesPerPlayer));
+    if (water.empty()) return;
+
+    std::mt19937_64 rng(config.seed);
+    entities.reserve(entities.size() + players.size() * (shipsPerPlayer + citiesPerPlayer));
+    for (int player = 0; player < config.playerCount; ++player) {
+        for (int i = 0; i < citiesPerPlayer && !coast.empty(); ++i) {
+            EntityHandle handle = entities.spawn(EntityKind::City, coast[rng() % coast.size()], static_cast<uint8_t>(player));
+            hasher.markEntity(handle.index);
+        }
+        for (int i = 0; i < shipsPerPlayer; ++i) {
+            EntityKind kind = FLEET_MIX[i % std::size(FLEET_MIX)];
+            EntityHandle handle = entities.spawn(kind, water[rng() % water.size()], static_cast<uint8_t>(player),
+                                                 static_cast<uint8_t>(rng() % 6));
+            hasher.markEntity(handle.index);
+            // Direct rather than through setDestination() so the log holds just the populate
+            destinations.resize(entities.getIndexCount(), -1);
+            destinations[handle.index] = water[rng() % water.size()];
+        }
+    }
+}
+
+void TurnSimulation::setDestination(EntityHandle handle, int tile) {
+    if (!entities.isAlive(handle)) return;
+    if (recorder) recorder->record(SimulationCommand::setDestination(handle, tile));
+    if (destinations.size() <= handle.index) destinations.resize(entities.getIndexCount(), -1);
+    destinations[handle.index] = tile;
+}
+
+void TurnSimulation::apply(const SimulationCommand& command) {
+    switch (command.type) {
+    case CommandType::Populate:
+        populate(command.arg0, command.arg1);
+        break;
+    case CommandType::SetDestination:
+        setDestination(command.entity, command.arg0);
+        break;
+    }
+}
+
+ReplayHeader TurnSimulation::makeReplayHeader() {
+    hasher.update(entities);
+    ReplayHeader header;
+    header.seed = config.seed;
+    header.playerCount = config.playerCount;
+    header.gridWidth = grid.getWidth();
+    header.gridHeight = grid.getHeight();
+    header.gridHash = hasher.getTileHash();
+    return header;
+}
+
+int TurnSimulation::replay(const ReplayLog& log) {
+    ReplayHeader expected = makeReplayHeader();
+    const ReplayHeader& header = log.getHeader();
+    if (header.seed != expected.seed || header.playerCount != expected.playerCount ||
+        header.gridWidth != expected.gridWidth || header.gridHeight != expected.gridHeight ||
+        header.gridHash != expected.gridHash) {
+        throw std::runtime_error("Replay log was recorded with a different map or seed");
+    }
+
+    ReplayCursor cursor;
+    std::vector<SimulationCommand> commands;
+    uint64_t recorded = 0;
+    while (log.readTurn(cursor, commands, recorded)) {
+        for (const SimulationCommand& command : commands) apply(command);
+        step();
+        if (lastChecksum != recorded) return static_cast<int>(cursor.turn - 1);
+    }
+    return -1;
+}
+
+bool TurnSimulation::hasEnemyWithin(uint32_t dense, int radius) const {
+    uint8_t owner = entities.getOwners()[dense];
+    bool found = false;
+    entities.getSpatialIndex().forEachInRadius(entities.getPositions()[dense], radius, [&](uint32_t index, int) {
+        uint32_t other = entities.denseIndex(entities.handleAt(index));
+        if (entities.getOwners()[other] != owner) found = true;
+    });
+    return found;
+}
+
+void TurnSimulation::save(Snapshot& snapshot) {
+    hasher.update(entities);
+    if (!savedGrid.has(SnapshotSection::GridTypes) || savedGridHash != hasher.getTileHash()) {
+        saveGrid(grid, savedGrid);
+        savedGridHash = hasher.getTileHash();
+    }
+    snapshot.set(SnapshotSection::GridInfo, savedGrid.get(SnapshotSection::GridInfo));
+    snapshot.set(SnapshotSection::GridTypes, savedGrid.get(SnapshotSection::GridTypes));
+
+    entities.save(snapshot);
+    snapshot.put(SnapshotSection::SimulationState,
+                 std::vector<uint64_t>{config.seed, static_cast<uint64_t>(config.playerCount), turn, lastChecksum,
+                                       std::bit_cast<uint32_t>(accumulator)});
+    snapshot.put(SnapshotSection::Players, players);
+    snapshot.put(SnapshotSection::Destinations, destinations);
+}
+
+void TurnSimulation::load(const Snapshot& snapshot) {
+    const Snapshot::Section& types = snapshot.get(SnapshotSection::GridTypes);
+    if (types.size != grid.getTypes().size() ||
+        (types.size > 0 && std::memcmp(types.data, grid.getTypes().data(), types.size) != 0)) {
+        throw std::runtime_error("Snapshot was saved on a different map");
+    }
+
+    std::vector<uint64_t> state;
+    snapshot.read(SnapshotSection::SimulationState, state);
+    if (state.size() != 5 || state[1] == 0) {
+        throw std::runtime_error("Snapshot simulation state is malformed");
+    }
+    std::vector<PlayerState> loadedPlayers;
+    snapshot.read(SnapshotSection::Players, loadedPlayers);
+    if (loadedPlayers.size() != state[1]) {
+        throw std::runtime_error("Snapshot player state is malformed");
+    }
+    entities.load(snapshot);
+    snapshot.read(SnapshotSection::Destinations, destinations);
+
+    config.seed = state[0];
+    config.playerCount = static_cast<int>(state[1]);
+    turn = static_cast<uint32_t>(state[2]);
+    lastChecksum = state[3];
+    accumulator = std::bit_cast<float>(static_cast<uint32_t>(state[4]));
+    rngKey = philoxKey(config.seed);
+    combat = CombatResolver(config.seed);
+    players = std::move(loadedPlayers);
+
+    // Visibility is derived from the positions, so rebuild it rather than storing it
+    visibleStamps.assign(players.size(), std::vector<uint32_t>(static_cast<size_t>(grid.size()), 0));
+    for (int player = 0; player < config.playerCount; ++player) updateVision(player, turn);
+
+    hasher.markAll();
+    hasher.update(entities);
+}
+
+void TurnSimulation::moveRange(size_t begin, size_t end) {
+    const auto& handles = entities.getHandles();
+    const auto& kinds = entities.getKinds();
+    const auto& tiles = entities.getTiles();
+
+    for (size_t dense = begin; dense < end; ++dense) {
+        int tile = tiles[dense];
+        nextTiles[dense] = tile;
+        EntityKind kind = kinds[dense];
+        int steps = MOVE_STEPS[kindIndex(kind)];
+        if (steps == 0) continue;
+
+        // Warships in contact hold position so their guns are loaded next turn
+        if (CombatResolver::firepowerOf(kind) > 0.0f && hasEnemyWithin(static_cast<uint32_t>(dense), 1)) continue;
+
+        uint32_t index = handles[dense].index;
+        int32_t& destination = destinations[index];
+        if (destination < 0 || destination == tile) {
+            destination = randomWaterTile(STREAM_DESTINATION, index);
+            if (destination < 0) continue;
+        }
+
+        // Greedy steps over water; a ship boxed in by land gives up and picks a new
+        // destination next turn
+        HexCoord target = grid.coordOf(destination);
+        for (int step = 0; step < steps && tile != destination; ++step) {
+            int best = -1;
+            int bestDistance = hexDistance(grid.coordOf(tile), target);
+            for (int dir = 0; dir < 6; ++dir) {
+                int next = grid.neighborIndex(tile, dir);
+                if (next < 0 || !naval.passable(grid.getType(next))) continue;
+                int distance = hexDistance(grid.coordOf(next), target);
+                if (distance < bestDistance) {
+                    best = next;
+                    bestDistance = distance;
+                }
+            }
+            if (best < 0) {
+                destination = -1;
+                break;
+            }
+            tile = best;
+        }
+        nextTiles[dense] = tile;
+    }
+}
+
+void TurnSimulation::applyMoves() {
+    auto& flags = entities.getFlags();
+    auto& facings = entities.getFacings();
+    for (uint32_t dense = 0; dense < entities.size(); ++dense) {
+        int from = entities.getTiles()[dense];
+        int to = nextTiles[dense];
+        if (from == to) {
+            if (flags[dense] & EntityFlags::MovedLastTurn) {
+                flags[dense] &= static_cast<uint8_t>(~EntityFlags::MovedLastTurn);
+                hasher.markEntity(entities.getHandles()[dense].index);
+            }
+            continue;
+        }
+
+        // Face along the overall move
+        HexCoord fromHex = grid.coordOf(from);
+        HexCoord toHex = grid.coordOf(to);
+        int bestDistance = hexDistance(fromHex, toHex);
+        for (int dir = 0; dir < 6; ++dir) {
+            int distance = hexDistance(hexNeighbor(fromHex, dir), toHex);
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                facings[dense] = static_cast<uint8_t>(dir);
+            }
+        }
+        flags[dense] |= EntityFlags::MovedLastTurn;
+        entities.moveDense(dense, to);
+        hasher.markEntity(entities.getHandles()[dense].index);
+    }
+}
+
+void TurnSimulation::tradeRange(size_t begin, size_t end) {
+    int64_t* income = tradeIncome.data() + (begin / config.chunkSize) * players.size();
+
+    const auto& kinds = entities.getKinds();
+    const auto& owners = entities.getOwners();
+    const HexSpatialIndex& spatial = entities.getSpatialIndex();
+
+    for (size_t dense = begin; dense < end; ++dense) {
+        if (kinds[dense] != EntityKind::Galleon) continue;
+        bool docked = false;
+        spatial.forEachInRadius(entities.getPositions()[dense], 1, [&](uint32_t index, int) {
+            uint32_t other = entities.denseIndex(entities.handleAt(index));
+            if (kinds[other] == EntityKind::City && owners[other] == owners[dense]) docked = true;
+        });
+        if (docked) income[owners[dense]] += DOCKED_INCOME;
+    }
+}
+
+void TurnSimulation::updateVision(int player, uint32_t stamp) {
+    // Stamped with the turn number resolve() is about to move to, so nothing needs clearing
+    std::vector<uint32_t>& stamps = visibleStamps[player];
+    uint32_t visible = 0;
+
+    const auto& kinds = entities.getKinds();
+    const auto& owners = entities.getOwners();
+    const auto& positions = entities.getPositions();
+    for (size_t dense = 0; dense < entities.size(); ++dense) {
+        if (owners[dense] != player) continue;
+        int radius = VISION_RADIUS[kindIndex(kinds[dense])];
+        const HexCoord& center = positions[dense];
+        for (int dq = -radius; dq <= radius; ++dq) {
+            int r1 = std::max(-radius, -dq - radius);
+            int r2 = std::min(radius, -dq + radius);
+            for (int dr = r1; dr <= r2; ++dr) {
+                int tile = grid.indexOf(center + HexCoord(dq, dr));
+                if (tile < 0 || stamps[tile] == stamp) continue;
+                stamps[tile] = stamp;
+                ++visible;
+            }
+        }
+    }
+    players[player].visibleTiles = visible;
+}
+
+void TurnSimulation::resolve() {
+    combat.apply(engagements, entities);
+    for (uint32_t target : engagements.targets) hasher.markEntity(target);
+
+    auto& health = entities.getHealth();
+
+    std::vector<EntityHandle> sunk;
+    for (uint32_t dense = 0; dense < entities.size(); ++dense) {
+        if (health[dense] <= 0.0f) sunk.push_back(entities.getHandles()[dense]);
+    }
+    for (EntityHandle handle : sunk) {
+        ++players[entities.getOwners()[entities.denseIndex(handle)]].shipsLost;
+        entities.despawn(handle);
+        hasher.markEntity(handle.index);
+    }
+
+    for (size_t chunk = 0; chunk < engagementChunks.size(); ++chunk) {
+        for (size_t player = 0; player < players.size(); ++player) {
+            players[player].gold += tradeIncome[chunk * players.size() + player];
+        }
+    }
+
+    ++turn;
+
+    // Roll this turn's state into the previous checksum, so a divergence stays visible
+    uint64_t hash = 0xCBF29CE484222325ull;
+    hashValue(hash, lastChecksum);
+    hashValue(hash, turn);
+    hashValue(hash, hasher.update(entities));
+    for (const PlayerState& player : players) {
+        hashValue(hash, player.gold);
+        hashValue(hash, player.visibleTiles);
+        hashValue(hash, player.shipsLost);
+    }
+    lastChecksum = hash;
+}
+
+void TurnSimulation::step() {
+    size_t count = entities.size();
+    size_t chunkCount = std::max<size_t>((count + config.chunkSize - 1) / config.chunkSize, 1);
+    nextTiles.resize(count);
+    destinations.resize(entities.getIndexCount(), -1);
+    engagementChunks.resize(chunkCount);
+    for (auto& chunk : engagementChunks) chunk.clear();
+    tradeIncome.assign(chunkCount * players.size(), 0);
+
+    graph.clear();
+    JobId movement = graph.addParallel(count, config.chunkSize, [this](size_t begin, size_t end) {
+        moveRange(begin, end);
+    });
+    JobId moves = graph.add([this]() { applyMoves(); });
+    JobId gather = graph.addParallel(count, config.chunkSize, [this](size_t begin, size_t end) {
+        combat.gather(entities, begin, end, engagementChunks[begin / config.chunkSize]);
+    });
+    JobId merge = graph.add([this]() { combat.merge(engagementChunks, engagements); });
+    JobId fire = graph.addParallel(COMBAT_SLICES, 1, [this](size_t begin, size_t end) {
+        size_t total = engagements.size();
+        combat.resolve(engagements, turn, begin * total / COMBAT_SLICES, end * total / COMBAT_SLICES);
+    });
+    JobId trade = graph.addParallel(count, config.chunkSize, [this](size_t begin, size_t end) {
+        tradeRange(begin, end);
+    });
+    JobId vision = graph.addParallel(players.size(), 1, [this](size_t begin, size_t end) {
+        for (size_t player = begin; player < end; ++player) updateVision(static_cast<int>(player), turn + 1);
+    });
+    JobId resolution = graph.add([this]() { resolve(); });
+
+    graph.precede(movement, moves);
+    graph.precede(gather, merge);
+    graph.precede(merge, fire);
+    for (JobId system : {gather, trade, vision}) graph.precede(moves, system);
+    for (JobId system : {fire, trade, vision}) graph.precede(system, resolution);
+    jobs.run(graph);
+    if (recorder) recorder->endTurn(lastChecksum);
+}
+
+int TurnSimulation::advance(float deltaTime) {
+    accumulator += deltaTime;
+    int ran = 0;
+    while (accumulator >= config.turnSeconds && ran < config.maxTurnsPerAdvance) {
+        accumulator -= config.turnSeconds;
+        step();
+        ++ran;
+    }
+    // Drop whatever couldn't be caught up rather than spiralling after a stall
+    if (ran == config.maxTurnsPerAdvance) accumulator = std::min(accumulator, config.turnSeconds);
+    return ran;
+}
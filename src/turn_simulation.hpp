@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "combat_resolver.hpp"
+#include "entity_store.hpp"
+#include "hex_grid.hpp"
+#include "job_system.hpp"
+#include "replay_log.hpp"
+#include "snapshot.hpp"
+#include "state_hasher.hpp"
+
+struct SimulationConfig {
+    uint64_t seed = 1;
+    int playerCount = 4;
+    size_t chunkSize = 512;    // Entities per job chunk; fixed so results don't depend on thread count
+    float turnSeconds = 1.0f;  // Real time per turn for advance()
+    int maxTurnsPerAdvance = 4; // Catch-up limit after a long frame
+};
+
+struct PlayerState {
+    int64_t gold = 0;
+    uint32_t visibleTiles = 0;
+    uint32_t shipsLost = 0;
+};
+
+// Headless turn simulation: movement, trade, combat and vision over an EntityStore.
+//
+// Each turn is a JobGraph run on a JobSystem:
+//
+//   movement -> apply moves -> { gather -> merge -> combat, trade, vision } -> resolve
+//
+// Parallel systems only read shared state and write their own entity's slot or a buffer per
+// chunk; the single-threaded steps apply those buffers in chunk order. Random numbers come
+// from Philox with counter (turn, entity index, stream) rather than a shared generator. Together that
+// makes every turn bit-identical for any worker count, so checksum() can be compared
+// between runs, machines and thread counts.
+//
+// The checksum rolls each turn's state hash into the previous turn's. The state hash comes
+// from a StateHasher that only rehashes the tile and entity chunks the turn touched, so it
+// stays cheap enough to compare every turn in lockstep. Commands can be recorded into a
+// ReplayLog and replayed headless as fast as the turns run.
+//
+// Nothing here touches Vulkan; the same code runs under the renderer and in HeadlessSim.
+class TurnSimulation {
+public:
+    TurnSimulation(const HexGrid& grid, JobSystem& jobs, const SimulationConfig& config = SimulationConfig());
+
+    // Scatter ships on water and port cities on coastal land, reproducibly from the seed
+    void populate(int shipsPerPlayer, int citiesPerPlayer);
+
+    EntityStore& getEntities() { return entities; }
+    const EntityStore& getEntities() const { return entities; }
+    void setDestination(EntityHandle handle, int tile);
+    void apply(const SimulationCommand& command);
+
+    // Record every command and the checksum of every turn into log until reset to nullptr
+    void setRecorder(ReplayLog* log) { recorder = log; }
+    ReplayHeader makeReplayHeader();
+
+    // Apply a log's commands turn by turn from a fresh simulation. Returns the first turn
+    // whose checksum differs from the recorded one, or -1 if every turn matched. Throws
+    // std::runtime_error if the log was recorded on another map or seed.
+    int replay(const ReplayLog& log);
+
+    // The grid was edited; its tile chunk is rehashed at the end of the next turn
+    void onTileChanged(int tile) { hasher.markTile(tile); }
+
+    // Capture the grid, entities and simulation state between turns. The tile section is
+    // reused from the previous save while the tile hash is unchanged, so only entity and
+    // player arrays are copied.
+    void save(Snapshot& snapshot);
+
+    // Continue from a snapshot; the grid must already hold the snapshot's tiles (see
+    // loadGrid()). Throws std::runtime_error if it doesn't or the snapshot is malformed.
+    void load(const Snapshot& snapshot);
+
+    // Run one turn
+    void step();
+
+    // Fixed timestep: run a turn for every config.turnSeconds of accumulated time, at most
+    // config.maxTurnsPerAdvance per call; returns how many ran
+    int advance(float deltaTime);
+
+    uint32_t getTurn() const { return turn; }
+    const std::vector<PlayerState>& getPlayers() const { return players; }
+    bool isVisible(int player, int tile) const { return turn > 0 && visibleStamps[player][tile] == turn; }
+
+    // Rolling hash of tile, entity and player state after the last turn
+    uint64_t checksum() const { return lastChecksum; }
+
+private:
+    const HexGrid& grid;
+    JobSystem& jobs;
+    SimulationConfig config;
+    MovementProfile naval;
+    PhiloxKey rngKey;
+
+    EntityStore entities;
+    std::vector<int32_t> destinations; // Per handle index
+    std::vector<int32_t> nextTiles;    // Per dense index, written by movement
+
+    std::vector<PlayerState> players;
+    std::vector<std::vector<uint32_t>> visibleStamps; // Per player and tile: turn last seen
+
+    // Per chunk outputs, applied in chunk order
+    std::vector<EngagementBatch> engagementChunks;
+    std::vector<int64_t> tradeIncome; // chunk * playerCount + player
+
+    CombatResolver combat;
+    EngagementBatch engagements; // Merged and sorted, resolved in COMBAT_SLICES slices
+
+    StateHasher hasher;
+    ReplayLog* recorder = nullptr;
+
+    Snapshot savedGrid; // GridInfo and GridTypes from the last save()
+    uint64_t savedGridHash = 0;
+
+    JobGraph graph;
+    uint32_t turn = 0;
+    float accumulator = 0.0f;
+    uint64_t lastChecksum = 0;
+
+    float random(uint32_t stream, uint32_t index) const;
+    int randomWaterTile(uint32_t stream, uint32_t index) const;
+    bool hasEnemyWithin(uint32_t dense, int radius) const;
+
+    void moveRange(size_t begin, size_t end);
+    void applyMoves();
+    void tradeRange(size_t begin, size_t end);
+    void updateVision(int player, uint32_t stamp);
+    void resolve();
+};
@@ -0,0 +1,232 @@
+#include "barrier_planner.hpp"
+#include "check.hpp"
+
+#include <stdexcept>
+
+namespace {
+
+VkImage fakeImage(uintptr_t id) {
+    return reinterpret_cast<VkImage>(id);
+}
+
+ImageAccess access(VkImage image, ImageUsage usage, VkFormat format, uint32_t baseMip, uint32_t mipCount,
+                   uint32_t baseLayer = 0, uint32_t layerCount = VK_REMAINING_ARRAY_LAYERS) {
+    ImageAccess a{};
+    a.image = image;
+    a.format = format;
+    a.usage = usage;
+    a.baseMipLevel = baseMip;
+    a.levelCount = mipCount;
+    a.baseArrayLayer = baseLayer;
+    a.layerCount = layerCount;
+    return a;
+}
+
+bool hasRange(const VkImageMemoryBarrier2& b, uint32_t baseMip, uint32_t mipCount, uint32_t baseLayer,
+              uint32_t layerCount) {
+    const VkImageSubresourceRange& r = b.subresourceRange;
+    return r.baseMipLevel == baseMip && r.levelCount == mipCount && r.baseArrayLayer == baseLayer &&
+           r.layerCount == layerCount;
+}
+
+// Bloom-style downsample: each compute pass samples mip m-1 and writes mip m
+void testMipChain() {
+    const VkFormat format = VK_FORMAT_B8G8R8A8_UNORM;
+    const VkImage image = fakeImage(1);
+    BarrierPlanner planner;
+    std::vector<VkImageMemoryBarrier2> out;
+    planner.registerImage(image, 5);
+
+    ImageAccess whole = access(image, ImageUsage::StorageCompute, format, 0, VK_REMAINING_MIP_LEVELS);
+    planner.plan(&whole, 1, out);
+    CHECK(out.size() == 1);
+    CHECK(out[0].oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && out[0].newLayout == VK_IMAGE_LAYOUT_GENERAL);
+    CHECK(hasRange(out[0], 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS));
+
+    for (uint32_t mip = 1; mip < 5; ++mip) {
+        out.clear();
+        ImageAccess pass[2] = {access(image, ImageUsage::SampledCompute, format, mip - 1, 1),
+                               access(image, ImageUsage::StorageCompute, format, mip, 1)};
+        planner.plan(pass, 2, out);
+        CHECK(out.size() == 2);
+        if (out.size() != 2) continue;
+        CHECK(hasRange(out[0], mip - 1, 1, 0, VK_REMAINING_ARRAY_LAYERS));
+        CHECK(out[0].newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        // Write after write in GENERAL still needs an execution and memory dependency
+        CHECK(hasRange(out[1], mip, 1, 0, VK_REMAINING_ARRAY_LAYERS));
+        CHECK(out[1].oldLayout == VK_IMAGE_LAYOUT_GENERAL && out[1].newLayout == VK_IMAGE_LAYOUT_GENERAL);
+        CHECK(out[1].srcStageMask == VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+    }
+
+    // Mips 0-3 are already read-only and only need the compute writes made visible; mip 4
+    // changes layout and keeps the remaining count
+    out.clear();
+    ImageAccess sampled = access(image, ImageUsage::SampledFragment, format, 0, VK_REMAINING_MIP_LEVELS);
+    planner.plan(&sampled, 1, out);
+    CHECK(out.size() == 2);
+    if (out.size() == 2) {
+        CHECK(hasRange(out[0], 0, 4, 0, VK_REMAINING_ARRAY_LAYERS));
+        CHECK(out[0].oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        CHECK(out[0].dstStageMask == VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT);
+        CHECK(hasRange(out[1], 4, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS));
+        CHECK(out[1].oldLayout == VK_IMAGE_LAYOUT_GENERAL);
+    }
+    for (uint32_t mip = 0; mip < 5; ++mip) {
+        CHECK(planner.layoutOf(image, mip) == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+
+    // Sampling again waits for nothing
+    out.clear();
+    planner.plan(&sampled, 1, out);
+    CHECK(out.empty());
+}
+
+// Shadow cascades: one depth pass per layer, then every layer sampled at once
+void testPerLayerCascades() {
+    const VkFormat format = VK_FORMAT_D32_SFLOAT;
+    const VkImage image = fakeImage(2);
+    BarrierPlanner planner;
+    std::vector<VkImageMemoryBarrier2> out;
+    planner.registerImage(image, 1, 4);
+
+    for (uint32_t layer = 0; layer < 4; ++layer) {
+        ImageAccess cascade = access(image, ImageUsage::DepthAttachment, format, 0, 1, layer, 1);
+        planner.plan(&cascade, 1, out);
+    }
+    CHECK(out.size() == 4);
+    for (uint32_t layer = 0; layer < out.size(); ++layer) {
+        CHECK(hasRange(out[layer], 0, 1, layer, 1));
+        CHECK(out[layer].newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+        CHECK(out[layer].subresourceRange.aspectMask == VK_IMAGE_ASPECT_DEPTH_BIT);
+    }
+
+    // The layers end in the same state, so one barrier covers them all
+    out.clear();
+    ImageAccess sampled = access(image, ImageUsage::SampledFragment, format, 0, 1, 0, VK_REMAINING_ARRAY_LAYERS);
+    planner.plan(&sampled, 1, out);
+    CHECK(out.size() == 1);
+    if (out.size() == 1) {
+        CHECK(hasRange(out[0], 0, 1, 0, VK_REMAINING_ARRAY_LAYERS));
+        CHECK(out[0].oldLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+        CHECK(out[0].newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+    }
+}
+
+void testLayoutConflict() {
+    const VkFormat format = VK_FORMAT_B8G8R8A8_UNORM;
+    const VkImage image = fakeImage(3);
+    BarrierPlanner planner;
+    std::vector<VkImageMemoryBarrier2> out;
+    planner.registerImage(image, 3, 4);
+
+    ImageAccess pass[2] = {access(image, ImageUsage::ColorAttachment, format, 0, 1, 0, 2),
+                           access(image, ImageUsage::SampledFragment, format, 0, 1, 1, 1)};
+    bool threw = false;
+    try {
+        planner.plan(pass, 2, out);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    // Different layouts are fine on disjoint subresources
+    out.clear();
+    pass[1] = access(image, ImageUsage::SampledFragment, format, 1, 1, 0, 1);
+    planner.plan(pass, 2, out);
+    CHECK(out.size() == 2);
+    CHECK(planner.layoutOf(image, 0, 1) == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    CHECK(planner.layoutOf(image, 1, 0) == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    CHECK(planner.layoutOf(image, 1, 1) == VK_IMAGE_LAYOUT_UNDEFINED);
+}
+
+// Mips 0 and 2 don't overlap each other but both overlap mips 0-2, so all three are one use
+void testBridgedUsesMerge() {
+    const VkFormat format = VK_FORMAT_B8G8R8A8_UNORM;
+    const VkImage image = fakeImage(4);
+    BarrierPlanner planner;
+    std::vector<VkImageMemoryBarrier2> out;
+    planner.registerImage(image, 4, 1);
+
+    ImageAccess pass[3] = {access(image, ImageUsage::SampledFragment, format, 0, 1, 0, 1),
+                           access(image, ImageUsage::SampledFragment, format, 2, 1, 0, 1),
+                           access(image, ImageUsage::SampledFragment, format, 0, 3, 0, 1)};
+    planner.plan(pass, 3, out);
+    CHECK(out.size() == 1);
+    if (out.size() == 1) CHECK(hasRange(out[0], 0, 3, 0, 1));
+    CHECK(planner.layoutOf(image, 3) == VK_IMAGE_LAYOUT_UNDEFINED);
+}
+
+// Two overlapping uses forming an L: the corner their bounding box adds isn't touched
+void testMergedCoverageIsExact() {
+    const VkFormat format = VK_FORMAT_B8G8R8A8_UNORM;
+    const VkImage image = fakeImage(5);
+    BarrierPlanner planner;
+    std::vector<VkImageMemoryBarrier2> out;
+    planner.registerImage(image, 3, 3);
+
+    ImageAccess pass[2] = {access(image, ImageUsage::TransferDst, format, 0, 1, 0, 3),
+                           access(image, ImageUsage::TransferDst, format, 0, 3, 0, 1)};
+    planner.plan(pass, 2, out);
+    CHECK(out.size() == 2);
+    uint32_t covered = 0;
+    for (const VkImageMemoryBarrier2& b : out) covered += b.subresourceRange.levelCount * b.subresourceRange.layerCount;
+    CHECK(covered == 5);
+    for (uint32_t mip = 1; mip < 3; ++mip) {
+        for (uint32_t layer = 1; layer < 3; ++layer) {
+            CHECK(planner.layoutOf(image, mip, layer) == VK_IMAGE_LAYOUT_UNDEFINED);
+        }
+    }
+    CHECK(planner.layoutOf(image, 2, 0) == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+}
+
+// An image used without registering is tracked whole until an access reaches past it
+void testUnregisteredImageGrows() {
+    const VkFormat format = VK_FORMAT_B8G8R8A8_UNORM;
+    const VkImage image = fakeImage(6);
+    BarrierPlanner planner;
+    std::vector<VkImageMemoryBarrier2> out;
+
+    ImageAccess color = access(image, ImageUsage::ColorAttachment, format, 0, VK_REMAINING_MIP_LEVELS);
+    planner.plan(&color, 1, out);
+    CHECK(out.size() == 1);
+    CHECK(planner.handleOf(image) != INVALID_IMAGE_HANDLE);
+
+    out.clear();
+    ImageAccess mip2 = access(image, ImageUsage::SampledFragment, format, 2, 1);
+    planner.plan(&mip2, 1, out);
+    CHECK(out.size() == 1);
+    if (out.size() == 1) CHECK(out[0].oldLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    CHECK(planner.layoutOf(image, 0) == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    CHECK(planner.layoutOf(image, 2) == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+// A VK_REMAINING_MIP_LEVELS use earlier in the pass than the access that grows the image
+// still reaches the levels the growth adds
+void testGrowthReachesEarlierUses() {
+    const VkFormat format = VK_FORMAT_B8G8R8A8_UNORM;
+    const VkImage image = fakeImage(7);
+    BarrierPlanner planner;
+    std::vector<VkImageMemoryBarrier2> out;
+
+    ImageAccess pass[2] = {access(image, ImageUsage::TransferDst, format, 0, VK_REMAINING_MIP_LEVELS),
+                           access(image, ImageUsage::TransferDst, format, 2, 2)};
+    planner.plan(pass, 2, out);
+    CHECK(out.size() == 1);
+    if (out.size() == 1) CHECK(hasRange(out[0], 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS));
+    for (uint32_t mip = 0; mip < 4; ++mip) {
+        CHECK(planner.layoutOf(image, mip) == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    }
+}
+
+} // namespace
+
+int main() {
+    testMipChain();
+    testPerLayerCascades();
+    testLayoutConflict();
+    testBridgedUsesMerge();
+    testMergedCoverageIsExact();
+    testUnregisteredImageGrows();
+    testGrowthReachesEarlierUses();
+    return testResult();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal assertions for the test executables. A failed check reports itself and the test
+// carries on, so one run lists every failure; main() returns testResult().
+inline int& checkFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(expr)                                                                 \
+    do {                                                                            \
+        if (!(expr)) {                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr); \
+            ++checkFailures();                                                      \
+        }                                                                           \
+    } while (0)
+
+inline int testResult() {
+    if (checkFailures() != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", checkFailures());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "dirty_rects.hpp"
+#include "check.hpp"
+
+#include <set>
+#include <utility>
+
+namespace {
+
+bool covers(const DirtyRectSet& set, uint32_t x, uint32_t y) {
+    for (const DirtyRect& r : set.getRects()) {
+        if (x >= r.x && x < r.right() && y >= r.y && y < r.bottom()) return true;
+    }
+    return false;
+}
+
+void testAdjacentTexelsMerge() {
+    DirtyRectSet set;
+    for (uint32_t x = 0; x < 8; ++x) set.markTexel(x, 3);
+    CHECK(set.getRects().size() == 1);
+    CHECK(set.getRects()[0] == (DirtyRect{0, 3, 8, 1}));
+    CHECK(set.texelCount() == 8);
+}
+
+void testTouchingRectsMerge() {
+    DirtyRectSet set(16, 0);
+    set.markRect({0, 0, 4, 4});
+    set.markRect({4, 0, 4, 4}); // Shares an edge: the union wastes nothing
+    set.markRect({0, 4, 8, 2});
+    CHECK(set.getRects().size() == 1);
+    CHECK(set.getRects()[0] == (DirtyRect{0, 0, 8, 6}));
+}
+
+void testOverlappingRects() {
+    // The bounding box uploads 36 texels against 32 for both rects: 4 wasted
+    DirtyRectSet loose(16, 4);
+    loose.markRect({0, 0, 4, 4});
+    loose.markRect({2, 2, 4, 4});
+    CHECK(loose.getRects().size() == 1);
+    CHECK(loose.getRects()[0] == (DirtyRect{0, 0, 6, 6}));
+
+    DirtyRectSet strict(16, 3);
+    strict.markRect({0, 0, 4, 4});
+    strict.markRect({2, 2, 4, 4});
+    CHECK(strict.getRects().size() == 2);
+
+    // Contained rects always merge and change nothing
+    strict.markRect({1, 1, 2, 2});
+    CHECK(strict.getRects().size() == 2);
+    CHECK(strict.texelCount() == 32);
+}
+
+void testDistantRectsStaySeparate() {
+    DirtyRectSet set(16, 16);
+    set.markTexel(0, 0);
+    set.markTexel(100, 100);
+    CHECK(set.getRects().size() == 2);
+    CHECK(set.texelCount() == 2);
+}
+
+void testSlackAllowsNearbyMerge() {
+    // Two texels one apart: merging uploads one extra texel, within a slack of 1
+    DirtyRectSet loose(16, 1);
+    loose.markTexel(0, 0);
+    loose.markTexel(2, 0);
+    CHECK(loose.getRects().size() == 1);
+
+    DirtyRectSet strict(16, 0);
+    strict.markTexel(0, 0);
+    strict.markTexel(2, 0);
+    CHECK(strict.getRects().size() == 2);
+}
+
+void testGrownRectAbsorbsOthers() {
+    // The middle rect bridges the two: once merged with one, it must reach the other too
+    DirtyRectSet set(16, 0);
+    set.markRect({0, 0, 2, 2});
+    set.markRect({4, 0, 2, 2});
+    CHECK(set.getRects().size() == 2);
+    set.markRect({2, 0, 2, 2});
+    CHECK(set.getRects().size() == 1);
+    CHECK(set.getRects()[0] == (DirtyRect{0, 0, 6, 2}));
+}
+
+void testCapMergesCheapestPair() {
+    DirtyRectSet set(4, 0);
+    std::set<std::pair<uint32_t, uint32_t>> marked;
+    for (uint32_t i = 0; i < 32; ++i) {
+        uint32_t x = (i * 37) % 200;
+        uint32_t y = (i * 91) % 150;
+        set.markTexel(x, y);
+        marked.insert({x, y});
+        CHECK(set.getRects().size() <= 4);
+    }
+    // Merging under the cap may only grow coverage, never drop a texel
+    for (const auto& [x, y] : marked) CHECK(covers(set, x, y));
+    CHECK(set.texelCount() >= marked.size());
+
+    // A cap of one coalesces everything into the bounding box
+    DirtyRectSet single(1, 0);
+    single.markTexel(1, 2);
+    single.markTexel(9, 4);
+    CHECK(single.getRects().size() == 1);
+    CHECK(single.getRects()[0] == (DirtyRect{1, 2, 9, 3}));
+}
+
+void testEmptyAndClear() {
+    DirtyRectSet set;
+    CHECK(set.empty());
+    set.markRect({5, 5, 0, 3}); // Zero-sized rects are ignored
+    CHECK(set.empty());
+    set.markTexel(1, 1);
+    CHECK(!set.empty());
+    set.clear();
+    CHECK(set.empty());
+    CHECK(set.texelCount() == 0);
+}
+
+} // namespace
+
+int main() {
+    testAdjacentTexelsMerge();
+    testTouchingRectsMerge();
+    testOverlappingRects();
+    testDistantRectsStaySeparate();
+    testSlackAllowsNearbyMerge();
+    testGrownRectAbsorbsOthers();
+    testCapMergesCheapestPair();
+    testEmptyAndClear();
+    return testResult();
+}
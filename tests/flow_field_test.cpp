@@ -0,0 +1,148 @@
+#include "flow_field.hpp"
+#include "check.hpp"
+
+#include <cmath>
+#include <queue>
+#include <random>
+#include <utility>
+
+namespace {
+
+// Plain Dijkstra from the target over reversed steps: a tile's cost is what entering every
+// tile after it on the way to the target adds up to
+std::vector<float> referenceIntegration(const HexGrid& grid, const MovementProfile& profile, int target) {
+    std::vector<float> cost(grid.size(), MovementProfile::IMPASSABLE);
+    using Item = std::pair<float, int>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> open;
+    cost[target] = 0.0f;
+    open.push({0.0f, target});
+    while (!open.empty()) {
+        auto [current, tile] = open.top();
+        open.pop();
+        if (current > cost[tile]) continue;
+        float next = current + profile.entryCost(grid.getType(tile));
+        for (int dir = 0; dir < 6; ++dir) {
+            int neighbor = grid.neighborIndex(tile, dir);
+            if (neighbor < 0 || !profile.passable(grid.getType(neighbor)) || next >= cost[neighbor]) continue;
+            cost[neighbor] = next;
+            open.push({next, neighbor});
+        }
+    }
+    return cost;
+}
+
+bool near(float a, float b) {
+    return std::abs(a - b) <= 1e-4f * std::max(1.0f, std::abs(b));
+}
+
+// The field matches an independent Dijkstra, and from every reachable tile the directions
+// step to a neighbor whose cost is lower by exactly that neighbor's entry cost, so following
+// them reaches the target
+void checkField(const HexGrid& grid, const MovementProfile& profile, const FlowField& field) {
+    std::vector<float> expected = referenceIntegration(grid, profile, field.target);
+    CHECK(field.direction[field.target] == FlowField::NO_DIRECTION);
+    for (int tile = 0; tile < grid.size(); ++tile) {
+        CHECK(near(field.integration[tile], expected[tile]) ||
+              (field.integration[tile] == MovementProfile::IMPASSABLE && expected[tile] == MovementProfile::IMPASSABLE));
+        if (tile == field.target || field.integration[tile] == MovementProfile::IMPASSABLE) continue;
+
+        int next = field.nextTile(grid, tile);
+        CHECK(next >= 0);
+        if (next < 0) continue;
+        CHECK(field.integration[next] < field.integration[tile]);
+        CHECK(near(field.integration[tile], field.integration[next] + profile.entryCost(grid.getType(next))));
+    }
+
+    int walked = 0;
+    for (int tile = 0; tile < grid.size(); tile += 7) {
+        if (field.integration[tile] == MovementProfile::IMPASSABLE) continue;
+        int steps = 0;
+        int at = tile;
+        while (at != field.target && at >= 0 && steps <= grid.size()) {
+            at = field.nextTile(grid, at);
+            ++steps;
+        }
+        CHECK(at == field.target);
+        ++walked;
+    }
+    CHECK(walked > 0);
+}
+
+HexGrid randomLand(int width, int height, uint32_t seed) {
+    const TerrainType types[] = {TerrainType::Grassland, TerrainType::Forest, TerrainType::Hills,
+                                 TerrainType::Mountains, TerrainType::Ocean};
+    HexGrid grid(width, height);
+    std::mt19937 rng(seed);
+    for (int i = 0; i < grid.size(); ++i) grid.setType(i, types[rng() % 5]);
+    return grid;
+}
+
+void testDirectionsDescend() {
+    const MovementProfile profile = MovementProfile::land();
+    HexGrid grid = randomLand(40, 30, 5);
+    int target = 15 * 40 + 20;
+    grid.setType(target, TerrainType::Grassland);
+
+    // Serial and parallel builds give the same field
+    FlowFieldCache serial(grid, profile, 4, 1);
+    FlowFieldCache parallel(grid, profile, 4, 4);
+    const FlowField& one = serial.get(target);
+    checkField(grid, profile, one);
+    const FlowField& four = parallel.get(target);
+    checkField(grid, profile, four);
+    CHECK(one.integration == four.integration);
+
+    // An impassable target has no field
+    grid.setType(0, TerrainType::Ocean);
+    const FlowField& none = serial.get(0);
+    for (int tile = 0; tile < grid.size(); ++tile) CHECK(none.direction[tile] == FlowField::NO_DIRECTION);
+}
+
+// Two islands with a port each. Editing one island rebuilds only its port's field; editing
+// open sea away from both coasts rebuilds neither.
+void testTileChangeInvalidatesAffectedFields() {
+    const MovementProfile profile = MovementProfile::land();
+    HexGrid grid(16, 8, TerrainType::Ocean);
+    auto tile = [](int col, int row) { return row * 16 + col; };
+    for (int row = 1; row < 7; ++row) {
+        for (int col = 1; col < 6; ++col) grid.setType(tile(col, row), TerrainType::Grassland);
+        for (int col = 10; col < 15; ++col) grid.setType(tile(col, row), TerrainType::Grassland);
+    }
+    int west = tile(3, 3);
+    int east = tile(12, 3);
+
+    FlowFieldCache cache(grid, profile, 4, 1);
+    cache.get(west);
+    cache.get(east);
+    CHECK(cache.getBuildCount() == 2);
+
+    grid.setType(tile(8, 4), TerrainType::CoastalWater);
+    cache.onTileChanged(tile(8, 4));
+    cache.get(west);
+    cache.get(east);
+    CHECK(cache.getBuildCount() == 2);
+
+    grid.setType(tile(2, 5), TerrainType::Mountains);
+    cache.onTileChanged(tile(2, 5));
+    cache.get(east);
+    CHECK(cache.getBuildCount() == 2);
+    const FlowField& rebuilt = cache.get(west);
+    CHECK(cache.getBuildCount() == 3);
+    checkField(grid, profile, rebuilt);
+
+    // Land rising from the sea next to an island changes that island's field too
+    grid.setType(tile(6, 3), TerrainType::Grassland);
+    cache.onTileChanged(tile(6, 3));
+    cache.get(east);
+    CHECK(cache.getBuildCount() == 3);
+    checkField(grid, profile, cache.get(west));
+    CHECK(cache.getBuildCount() == 4);
+}
+
+} // namespace
+
+int main() {
+    testDirectionsDescend();
+    testTileChangeInvalidatesAffectedFields();
+    return testResult();
+}
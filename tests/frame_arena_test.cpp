@@ -0,0 +1,140 @@
+#include "frame_arena.hpp"
+#include "check.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef COUNT_HEAP_ALLOCATIONS
+// Every heap allocation the test makes, the same counter main.cpp reports per frame
+static std::atomic<uint64_t> heapAllocations{0};
+
+void* operator new(std::size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+#endif
+
+namespace {
+
+bool isAligned(const void* memory, size_t alignment) {
+    return reinterpret_cast<uintptr_t>(memory) % alignment == 0;
+}
+
+struct alignas(64) CacheLine {
+    uint32_t values[4];
+};
+
+// A frame's worth of mixed requests, 6 KB in all: more than the test arena starts with
+void allocateFrame(FrameArena& arena) {
+    for (int i = 0; i < 32; ++i) {
+        arena.allocate(24, 8);
+        arena.allocateArray<float>(16);
+        arena.allocateArray<CacheLine>(1);
+    }
+    arena.allocate(1024, 256);
+}
+
+// Once a frame's peak has been seen, the same frame neither spills nor touches the heap
+void testNoAllocationsAfterWarmUp() {
+    FrameArena arena(1024);
+    allocateFrame(arena);
+    CHECK(arena.getHeapAllocations() > 1); // Spilled
+    arena.reset();
+    allocateFrame(arena);
+    arena.reset();
+
+    uint64_t arenaBlocks = arena.getHeapAllocations();
+    size_t capacity = arena.getCapacity();
+#ifdef COUNT_HEAP_ALLOCATIONS
+    uint64_t before = heapAllocations.load();
+#endif
+    for (int frame = 0; frame < 100; ++frame) {
+        allocateFrame(arena);
+        arena.reset();
+    }
+#ifdef COUNT_HEAP_ALLOCATIONS
+    CHECK(heapAllocations.load() == before);
+#endif
+    CHECK(arena.getHeapAllocations() == arenaBlocks);
+    CHECK(arena.getCapacity() == capacity);
+}
+
+// reset() hands the same memory out again, and folds spilled blocks into one big enough for
+// the peak
+void testReset() {
+    FrameArena arena(256);
+    void* first = arena.allocate(64, 16);
+    arena.allocate(64, 16);
+    CHECK(arena.getUsedBytes() == 128);
+    arena.reset();
+    CHECK(arena.getUsedBytes() == 0);
+    CHECK(arena.allocate(64, 16) == first);
+    arena.reset();
+
+    // 200 fit, 300 more spill into a block of their own
+    arena.allocate(200, 8);
+    arena.allocate(300, 8);
+    CHECK(arena.getHeapAllocations() == 2);
+    CHECK(arena.getCapacity() > 256);
+    size_t peak = arena.getUsedBytes();
+    CHECK(peak >= 500);
+    arena.reset();
+    CHECK(arena.getUsedBytes() == 0);
+    CHECK(arena.getHeapAllocations() == 3);
+    CHECK(arena.getCapacity() >= peak);
+    CHECK(arena.getCapacity() % 4096 == 0);
+
+    // Now both fit in the block
+    arena.allocate(200, 8);
+    arena.allocate(300, 8);
+    CHECK(arena.getHeapAllocations() == 3);
+    CHECK(arena.getUsedBytes() <= arena.getCapacity());
+
+    // Arrays come back value-initialized however the memory was last used
+    arena.reset();
+    uint8_t* dirty = static_cast<uint8_t*>(arena.allocate(64, 4));
+    for (int i = 0; i < 64; ++i) dirty[i] = 0xff;
+    arena.reset();
+    uint32_t* zeroed = arena.allocateArray<uint32_t>(16);
+    bool allZero = true;
+    for (int i = 0; i < 16; ++i) allZero = allZero && zeroed[i] == 0;
+    CHECK(allZero);
+    CHECK(arena.allocateArray<uint32_t>(0) == nullptr);
+}
+
+// Every power of two up to 4 KB, after an odd-sized request, in the block and in spills
+void testAlignment() {
+    FrameArena arena(4096);
+    for (size_t alignment = 1; alignment <= 4096; alignment *= 2) {
+        arena.allocate(1, 1);
+        void* memory = arena.allocate(8, alignment);
+        CHECK(isAligned(memory, alignment));
+    }
+    CHECK(arena.getHeapAllocations() > 1); // The larger alignments spilled
+
+    arena.reset();
+    CacheLine* lines = arena.allocateArray<CacheLine>(3);
+    CHECK(isAligned(lines, alignof(CacheLine)));
+    arena.allocate(3, 1);
+    CHECK(isAligned(arena.allocateArray<CacheLine>(1), alignof(CacheLine)));
+    CHECK(isAligned(arena.allocateArray<double>(1), alignof(double)));
+}
+
+} // namespace
+
+int main() {
+    testNoAllocationsAfterWarmUp();
+    testReset();
+    testAlignment();
+    return testResult();
+}
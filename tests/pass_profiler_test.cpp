@@ -0,0 +1,199 @@
+#include "pass_profiler.hpp"
+#include "device.hpp"
+#include "check.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Timestamps the fake query pool hands back, by query index; one tick is a microsecond
+std::vector<uint64_t> timestamps(64, 0);
+
+} // namespace
+
+// The profiler's device calls: one queue family with 64-bit timestamps and a query pool whose
+// results are always available
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties(VkPhysicalDevice, VkPhysicalDeviceProperties* properties) {
+    *properties = {};
+    properties->limits.timestampPeriod = 1000.0f;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice, uint32_t* count,
+                                                                    VkQueueFamilyProperties* families) {
+    if (families) {
+        families[0] = {};
+        families[0].timestampValidBits = 64;
+    }
+    *count = 1;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateQueryPool(VkDevice, const VkQueryPoolCreateInfo*, const VkAllocationCallbacks*,
+                                                 VkQueryPool* pool) {
+    *pool = reinterpret_cast<VkQueryPool>(uintptr_t(1));
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyQueryPool(VkDevice, VkQueryPool, const VkAllocationCallbacks*) {}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetQueryPoolResults(VkDevice, VkQueryPool, uint32_t firstQuery, uint32_t queryCount,
+                                                     size_t, void* data, VkDeviceSize stride, VkQueryResultFlags) {
+    for (uint32_t i = 0; i < queryCount; ++i) {
+        uint64_t* result = reinterpret_cast<uint64_t*>(static_cast<char*>(data) + i * stride);
+        result[0] = timestamps[firstQuery + i];
+        result[1] = 1;
+    }
+    return VK_SUCCESS;
+}
+
+namespace {
+
+constexpr int64_t MS = 1000000;
+
+// Mean and nearest-rank percentiles over the newest HISTORY samples
+void testPercentiles() {
+    Device device{};
+    PassProfiler profiler;
+    profiler.init(device, 2, 4);
+
+    // 1..100 ms, one sample per frame
+    for (int64_t i = 1; i <= 100; ++i) {
+        profiler.beginFrame(uint32_t(i % 2));
+        profiler.addCpuTime("sort", 0, 0, i * MS);
+    }
+    profiler.beginFrame(0);
+    PassTimingStats stats = profiler.getCpuStats("sort");
+    CHECK(stats.samples == 100);
+    CHECK(stats.mean == 50.5);
+    CHECK(stats.p95 == 95.0);
+    CHECK(stats.p99 == 99.0);
+
+    // 101..300 more: the ring keeps 45..300
+    for (int64_t i = 101; i <= 300; ++i) {
+        profiler.beginFrame(uint32_t(i % 2));
+        profiler.addCpuTime("sort", 0, 0, i * MS);
+    }
+    profiler.beginFrame(0);
+    stats = profiler.getCpuStats("sort");
+    CHECK(stats.samples == PassProfiler::HISTORY);
+    CHECK(stats.mean == 172.5);
+    CHECK(stats.p95 == 288.0); // Rank ceil(0.95 * 256) = 244
+    CHECK(stats.p99 == 298.0); // Rank ceil(0.99 * 256) = 254
+
+    // Several callbacks of one pass in a frame make one sample
+    profiler.addCpuTime("split", 1, 0, 2 * MS);
+    profiler.addCpuTime("split", 2, 5 * MS, 8 * MS);
+    profiler.beginFrame(1);
+    stats = profiler.getCpuStats("split");
+    CHECK(stats.samples == 1);
+    CHECK(stats.mean == 5.0);
+    CHECK(stats.p99 == 5.0);
+
+    CHECK(profiler.getCpuStats("missing").samples == 0);
+    CHECK(profiler.getGpuStats("sort").samples == 0);
+    profiler.destroy(device);
+}
+
+// A pass's name is kept by contents: a buffer reused for another name starts a new series,
+// and the trace still has both names after the buffer changed
+void testNamesByContents() {
+    Device device{};
+    PassProfiler profiler;
+    profiler.init(device, 2, 4);
+    profiler.beginFrame(0);
+
+    char name[16];
+    std::strcpy(name, "shadow");
+    profiler.addCpuTime(name, 0, 0, 1 * MS);
+    std::strcpy(name, "water");
+    profiler.addCpuTime(name, 0, 0, 3 * MS);
+    std::strcpy(name, "xxxxx");
+    profiler.beginFrame(1);
+
+    CHECK(profiler.getPassNames() == (std::vector<std::string>{"shadow", "water"}));
+    CHECK(profiler.getCpuStats("shadow").mean == 1.0);
+    CHECK(profiler.getCpuStats("water").mean == 3.0);
+
+    const std::string path = "pass_profiler_names.json";
+    profiler.exportChromeTrace(path);
+    std::ifstream file(path);
+    std::stringstream json;
+    json << file.rdbuf();
+    CHECK(json.str().find("\"name\":\"shadow\"") != std::string::npos);
+    CHECK(json.str().find("\"name\":\"water\"") != std::string::npos);
+    CHECK(json.str().find("xxxxx") == std::string::npos);
+    std::remove(path.c_str());
+    profiler.destroy(device);
+}
+
+// Read back a frame's timestamps and export it: metadata first, then complete events oldest
+// frame first, GPU times relative to the first timestamp read
+void testChromeTrace() {
+    Device device{};
+    PassProfiler profiler;
+    profiler.init(device, 2, 4);
+    RecordingCommandRecorder recorder;
+    VkCommandBuffer cmd = reinterpret_cast<VkCommandBuffer>(uintptr_t(1));
+
+    profiler.beginFrame(0);
+    int32_t shadow = profiler.beginPass(recorder, cmd, "shadow", 0);
+    profiler.endPass(recorder, cmd, shadow);
+    int32_t blur = profiler.beginPass(recorder, cmd, "blur", 1);
+    profiler.endPass(recorder, cmd, blur);
+    CHECK(shadow == 0);
+    CHECK(blur == 2);
+    timestamps[0] = 1000;
+    timestamps[1] = 1500;
+    timestamps[2] = 1200;
+    timestamps[3] = 1450;
+    int64_t start = PassProfiler::now();
+    profiler.addCpuTime("shadow", 3, start, start + 2 * MS);
+
+    profiler.beginFrame(1);
+    profiler.beginFrame(0); // Slot 0 comes round: its timestamps are read
+
+    PassTimingStats gpu = profiler.getGpuStats("shadow");
+    CHECK(gpu.samples == 1);
+    CHECK(gpu.mean == 0.5);
+    CHECK(profiler.getGpuStats("blur").mean == 0.25);
+
+    const std::string path = "pass_profiler_trace.json";
+    profiler.exportChromeTrace(path);
+    std::ifstream file(path);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(file, line);) lines.push_back(line);
+    std::remove(path.c_str());
+
+    CHECK(lines.size() == 9);
+    if (lines.size() != 9) return;
+    CHECK(lines[0] == "{\"traceEvents\":[");
+    CHECK(lines[1] == "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}},");
+    CHECK(lines[2] == "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}},");
+    CHECK(lines[3] == "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Graphics queue\"}},");
+    CHECK(lines[4] == "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Compute queue\"}},");
+
+    // The CPU event's start is against the profiler's own epoch, so only its shape is known
+    const std::string cpuPrefix = "{\"name\":\"shadow\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":3,\"ts\":";
+    const std::string cpuSuffix = ",\"dur\":2000.000},";
+    CHECK(lines[5].compare(0, cpuPrefix.size(), cpuPrefix) == 0);
+    CHECK(lines[5].size() > cpuPrefix.size() + cpuSuffix.size());
+    CHECK(lines[5].compare(lines[5].size() - cpuSuffix.size(), cpuSuffix.size(), cpuSuffix) == 0);
+
+    CHECK(lines[6] == "{\"name\":\"shadow\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":0.000,\"dur\":500.000},");
+    CHECK(lines[7] == "{\"name\":\"blur\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":200.000,\"dur\":250.000}");
+    CHECK(lines[8] == "]}");
+    profiler.destroy(device);
+}
+
+} // namespace
+
+int main() {
+    testPercentiles();
+    testNamesByContents();
+    testChromeTrace();
+    return testResult();
+}
@@ -0,0 +1,107 @@
+#include "region_map.hpp"
+#include "check.hpp"
+
+#include <random>
+
+namespace {
+
+// Two maps label the grid the same way: the same tiles share regions, whatever the labels
+void checkSamePartition(const HexGrid& grid, const RegionMap& actual, const RegionMap& expected) {
+    CHECK(actual.getRegionCount() == expected.getRegionCount());
+    for (int tile = 0; tile < grid.size(); ++tile) {
+        CHECK(actual.kindOf(tile) == expected.kindOf(tile));
+        if (actual.regionOf(tile) >= 0) {
+            CHECK(actual.regionSize(actual.regionOf(tile)) == expected.regionSize(expected.regionOf(tile)));
+        }
+        for (int dir = 0; dir < 6; ++dir) {
+            int neighbor = grid.neighborIndex(tile, dir);
+            if (neighbor >= 0) CHECK(actual.sameRegion(tile, neighbor) == expected.sameRegion(tile, neighbor));
+        }
+    }
+}
+
+// Two seas split by a one-tile-wide land bridge. Flooding one tile of the bridge merges the
+// seas and splits the land in two; draining it again undoes both.
+void testMergeAndSplit() {
+    HexGrid grid(9, 6, TerrainType::Ocean);
+    auto tile = [](int col, int row) { return row * 9 + col; };
+    for (int row = 0; row < 6; ++row) grid.setType(tile(4, row), TerrainType::Grassland);
+    int westSea = tile(1, 2);
+    int eastSea = tile(7, 2);
+    int northLand = tile(4, 0);
+    int southLand = tile(4, 5);
+
+    RegionMap regions(grid);
+    CHECK(regions.getRegionCount() == 3);
+    CHECK(!regions.sameRegion(westSea, eastSea));
+    CHECK(regions.sameRegion(northLand, southLand));
+    CHECK(regions.regionSize(regions.regionOf(northLand)) == 6);
+    CHECK(regions.regionSize(regions.regionOf(westSea)) == 24);
+    CHECK(regions.kindOf(westSea) == RegionKind::Water && regions.kindOf(northLand) == RegionKind::Land);
+    CHECK(!regions.connectedByWater(tile(3, 2), tile(5, 2)));
+    // The bridge touches both seas
+    CHECK(regions.connectedByWater(tile(3, 2), northLand));
+    CHECK(regions.connectedByWater(northLand, tile(5, 2)));
+
+    grid.setType(tile(4, 2), TerrainType::Ocean);
+    regions.onTileChanged(tile(4, 2));
+    CHECK(regions.getRegionCount() == 3);
+    CHECK(regions.sameRegion(westSea, eastSea));
+    CHECK(!regions.sameRegion(northLand, southLand));
+    CHECK(regions.regionSize(regions.regionOf(westSea)) == 49);
+    CHECK(regions.regionSize(regions.regionOf(northLand)) == 2);
+    CHECK(regions.regionSize(regions.regionOf(southLand)) == 3);
+    CHECK(regions.connectedByWater(tile(3, 2), tile(5, 2)));
+    checkSamePartition(grid, regions, RegionMap(grid));
+
+    grid.setType(tile(4, 2), TerrainType::Hills);
+    regions.onTileChanged(tile(4, 2));
+    CHECK(regions.getRegionCount() == 3);
+    CHECK(!regions.sameRegion(westSea, eastSea));
+    CHECK(regions.sameRegion(northLand, southLand));
+    CHECK(regions.regionSize(regions.regionOf(southLand)) == 6);
+    checkSamePartition(grid, regions, RegionMap(grid));
+}
+
+// Void cells belong to no region and split what is around them
+void testVoidTiles() {
+    HexGrid grid(5, 3, TerrainType::Grassland);
+    for (int row = 0; row < 3; ++row) grid.setType(row * 5 + 2, VOID_TERRAIN);
+    RegionMap regions(grid);
+    CHECK(regions.getRegionCount() == 2);
+    CHECK(regions.regionOf(2) == -1 && regions.kindOf(2) == RegionKind::None);
+    CHECK(!regions.sameRegion(2, 2));
+    CHECK(!regions.sameRegion(0, 4));
+}
+
+// Random edits kept up incrementally match a full relabel after each one, and the
+// strip-parallel relabel matches the serial one
+void testRandomEditsMatchRebuild() {
+    const TerrainType types[] = {TerrainType::Ocean, TerrainType::CoastalWater, TerrainType::Grassland,
+                                 TerrainType::Hills, VOID_TERRAIN};
+    HexGrid grid(24, 20);
+    std::mt19937 rng(11);
+    for (int i = 0; i < grid.size(); ++i) grid.setType(i, types[rng() % 5]);
+
+    RegionMap regions(grid);
+    RegionMap parallel(grid);
+    parallel.rebuildParallel(4);
+    checkSamePartition(grid, parallel, regions);
+
+    for (int edit = 0; edit < 300; ++edit) {
+        int tile = static_cast<int>(rng() % grid.size());
+        grid.setType(tile, types[rng() % 5]);
+        regions.onTileChanged(tile);
+        if (edit % 10 == 0) checkSamePartition(grid, regions, RegionMap(grid));
+    }
+    checkSamePartition(grid, regions, RegionMap(grid));
+}
+
+} // namespace
+
+int main() {
+    testMergeAndSplit();
+    testVoidTiles();
+    testRandomEditsMatchRebuild();
+    return testResult();
+}
@@ -0,0 +1,795 @@
+#include "render_graph.hpp"
+#include "device.hpp"
+#include "image.hpp"
+#include "check.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+template <typename Handle>
+Handle fakeHandle(uintptr_t id) {
+    return reinterpret_cast<Handle>(id);
+}
+
+// The frame main.cpp declares: depth prepass with a resolve, SSAO, MSAA terrain and the
+// tilt-shift pass into the swapchain image. The targets are imported with made-up handles,
+// so compiling creates nothing and the graph runs without a device.
+struct Target {
+    VkImage image;
+    VkImageView view;
+};
+
+struct FrameTargets {
+    Target msaaColor{fakeHandle<VkImage>(1), fakeHandle<VkImageView>(11)};
+    Target depth{fakeHandle<VkImage>(2), fakeHandle<VkImageView>(12)};
+    Target depthResolved{fakeHandle<VkImage>(3), fakeHandle<VkImageView>(13)};
+    Target ssao{fakeHandle<VkImage>(4), fakeHandle<VkImageView>(14)};
+    Target scene{fakeHandle<VkImage>(5), fakeHandle<VkImageView>(15)};
+};
+
+void declareFrame(RenderGraph& graph, const Swapchain& swapchain, const FrameTargets& targets,
+                  std::vector<std::string>& recorded) {
+    RenderPassDesc depthPass{};
+    depthPass.name = "depth_prepass";
+    depthPass.attachments.extent = swapchain.extent;
+    depthPass.attachments.samples = swapchain.msaaSamples;
+    depthPass.attachments.depthFormat = swapchain.depthFormat;
+    depthPass.attachments.depthView = targets.depth.view;
+    depthPass.attachments.depthImage = targets.depth.image;
+    depthPass.attachments.depthResolveView = targets.depthResolved.view;
+    depthPass.attachments.depthResolveImage = targets.depthResolved.image;
+    depthPass.record = [&recorded](VkCommandBuffer) { recorded.push_back("depth_prepass"); };
+    graph.addPass(depthPass);
+
+    RenderPassDesc ssaoPass{};
+    ssaoPass.name = "ssao";
+    ssaoPass.attachments.extent = swapchain.extent;
+    ssaoPass.attachments.colorFormat = swapchain.ssaoFormat;
+    ssaoPass.attachments.colorView = targets.ssao.view;
+    ssaoPass.attachments.colorImage = targets.ssao.image;
+    ssaoPass.images.push_back(ImageAccess{targets.depthResolved.image, swapchain.depthFormat, ImageUsage::SampledFragment});
+    ssaoPass.record = [&recorded](VkCommandBuffer) { recorded.push_back("ssao"); };
+    graph.addPass(ssaoPass);
+
+    RenderPassDesc terrainPass{};
+    terrainPass.name = "terrain";
+    terrainPass.attachments.extent = swapchain.extent;
+    terrainPass.attachments.samples = swapchain.msaaSamples;
+    terrainPass.attachments.colorFormat = swapchain.format;
+    terrainPass.attachments.depthFormat = swapchain.depthFormat;
+    terrainPass.attachments.colorView = targets.msaaColor.view;
+    terrainPass.attachments.colorImage = targets.msaaColor.image;
+    terrainPass.attachments.resolveView = targets.scene.view;
+    terrainPass.attachments.resolveImage = targets.scene.image;
+    terrainPass.attachments.depthView = targets.depth.view;
+    terrainPass.attachments.depthImage = targets.depth.image;
+    terrainPass.depthLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    terrainPass.images.push_back(ImageAccess{targets.ssao.image, swapchain.ssaoFormat, ImageUsage::SampledFragment});
+    terrainPass.record = [&recorded](VkCommandBuffer) { recorded.push_back("terrain"); };
+    graph.addPass(terrainPass);
+
+    RenderPassDesc tiltPass{};
+    tiltPass.name = "tiltshift";
+    tiltPass.attachments.extent = swapchain.extent;
+    tiltPass.attachments.colorFormat = swapchain.format;
+    tiltPass.attachments.swapchainColor = true;
+    tiltPass.images.push_back(ImageAccess{targets.scene.image, swapchain.format, ImageUsage::SampledFragment});
+    tiltPass.images.push_back(ImageAccess{targets.depthResolved.image, swapchain.depthFormat, ImageUsage::SampledFragment});
+    tiltPass.record = [&recorded](VkCommandBuffer) { recorded.push_back("tiltshift"); };
+    graph.addPass(tiltPass);
+}
+
+// Replays what was recorded, tracking each image's layout through the barriers. Every
+// barrier must start from the layout the image is in, or discard it from UNDEFINED before the
+// scope that first writes it, and every attachment must be in the layout its rendering scope
+// says it is.
+struct LayoutReplay {
+    std::unordered_map<VkImage, VkImageLayout> layouts;
+    std::unordered_map<VkImageView, VkImage> imageOfView;
+    std::unordered_map<VkImage, size_t> firstWriteScope;
+
+    VkImageLayout layoutOf(VkImage image) const {
+        auto it = layouts.find(image);
+        return it != layouts.end() ? it->second : VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+
+    void checkAttachment(const VkRenderingAttachmentInfo& attachment) const {
+        auto it = imageOfView.find(attachment.imageView);
+        CHECK(it != imageOfView.end());
+        if (it != imageOfView.end()) CHECK(layoutOf(it->second) == attachment.imageLayout);
+    }
+
+    // Layouts of the images each rendering scope sampled, in scope order
+    std::vector<std::unordered_map<VkImage, VkImageLayout>> run(const RecordingCommandRecorder& recorder) {
+        std::vector<std::unordered_map<VkImage, VkImageLayout>> scopes;
+        for (const RecordedCommand& command : recorder.commands) {
+            if (command.type == RecordedCommand::Type::Barrier) {
+                for (uint32_t i = 0; i < command.count; ++i) {
+                    const VkImageMemoryBarrier2& barrier = recorder.barriers[command.first + i];
+                    if (barrier.oldLayout == VK_IMAGE_LAYOUT_UNDEFINED) {
+                        auto it = firstWriteScope.find(barrier.image);
+                        CHECK(it != firstWriteScope.end() && it->second == scopes.size());
+                    } else {
+                        CHECK(barrier.oldLayout == layoutOf(barrier.image));
+                    }
+                    layouts[barrier.image] = barrier.newLayout;
+                }
+            } else if (command.type == RecordedCommand::Type::BeginRendering) {
+                const RecordedRendering& rendering = recorder.renderings[command.first];
+                if (rendering.hasColor) {
+                    checkAttachment(rendering.color);
+                    if (rendering.color.resolveImageView != VK_NULL_HANDLE) {
+                        VkRenderingAttachmentInfo resolve{};
+                        resolve.imageView = rendering.color.resolveImageView;
+                        resolve.imageLayout = rendering.color.resolveImageLayout;
+                        checkAttachment(resolve);
+                    }
+                }
+                if (rendering.hasDepth) checkAttachment(rendering.depth);
+                scopes.push_back(layouts);
+            }
+        }
+        return scopes;
+    }
+};
+
+// Three images with made-up handles, 100-102 and their views 200-202
+Swapchain fakeSwapchain() {
+    Swapchain swapchain{};
+    swapchain.format = VK_FORMAT_B8G8R8A8_UNORM;
+    swapchain.extent = {1280, 720};
+    swapchain.msaaSamples = VK_SAMPLE_COUNT_4_BIT;
+    for (uintptr_t i = 0; i < 3; ++i) {
+        swapchain.images.push_back({fakeHandle<VkImage>(100 + i), fakeHandle<VkImageView>(200 + i)});
+    }
+    return swapchain;
+}
+
+void testFourPassFrame() {
+    Device device{};
+    Swapchain swapchain = fakeSwapchain();
+    FrameTargets targets;
+
+    RenderGraph graph;
+    RecordingCommandRecorder recorder;
+    graph.setCommandRecorder(recorder);
+    std::vector<std::string> recorded;
+    declareFrame(graph, swapchain, targets, recorded);
+    const CompiledGraph& compiled = graph.compile(device, swapchain);
+    CHECK(compiled.passes.size() == 4);
+    CHECK(compiled.report.culled.empty());
+    CHECK(compiled.report.merged.empty());
+    uint64_t hash = graph.getStructureHash();
+
+    LayoutReplay replay;
+    for (const Target* image : {&targets.msaaColor, &targets.depth, &targets.depthResolved, &targets.ssao, &targets.scene}) {
+        replay.imageOfView[image->view] = image->image;
+    }
+    for (const SwapchainImage& image : swapchain.images) {
+        replay.imageOfView[image.view] = image.image;
+        replay.firstWriteScope[image.image] = 3;
+    }
+    replay.firstWriteScope[targets.depth.image] = 0;
+    replay.firstWriteScope[targets.depthResolved.image] = 0;
+    replay.firstWriteScope[targets.ssao.image] = 1;
+    replay.firstWriteScope[targets.msaaColor.image] = 2;
+    replay.firstWriteScope[targets.scene.image] = 2;
+
+    VkCommandBuffer cmd = fakeHandle<VkCommandBuffer>(1);
+    size_t firstFrameBarriers = 0;
+    // Frames after the first run the steady-state plan
+    for (uint32_t frame = 0; frame < 6; ++frame) {
+        recorder.clear();
+        recorded.clear();
+        swapchain.currentFrame = frame % Swapchain::MAX_FRAMES_IN_FLIGHT;
+        swapchain.currentImageIndex = frame % 3;
+        const SwapchainImage& acquired = swapchain.images[swapchain.currentImageIndex];
+        graph.execute(cmd, swapchain);
+
+        CHECK((recorded == std::vector<std::string>{"depth_prepass", "ssao", "terrain", "tiltshift"}));
+        CHECK(recorder.renderings.size() == 4);
+        if (recorder.renderings.size() != 4) continue;
+        for (const RecordedCommand& command : recorder.commands) CHECK(command.cmd == cmd);
+
+        // The acquired image's contents are discarded; the final barrier hands it to present
+        replay.layouts[acquired.image] = VK_IMAGE_LAYOUT_UNDEFINED;
+        std::vector<std::unordered_map<VkImage, VkImageLayout>> scopes = replay.run(recorder);
+        CHECK(replay.layoutOf(acquired.image) == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+        CHECK(recorder.commands.back().type == RecordedCommand::Type::Barrier);
+
+        const RecordedRendering& depthPass = recorder.renderings[0];
+        CHECK(!depthPass.hasColor && depthPass.hasDepth);
+        CHECK(depthPass.depth.loadOp == VK_ATTACHMENT_LOAD_OP_CLEAR);
+        CHECK(depthPass.depth.resolveImageView == targets.depthResolved.view);
+        CHECK(scopes[1][targets.depthResolved.image] == VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+
+        const RecordedRendering& terrainPass = recorder.renderings[2];
+        CHECK(terrainPass.depth.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD);
+        CHECK(terrainPass.color.resolveImageView == targets.scene.view);
+        CHECK(scopes[2][targets.ssao.image] == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+        const RecordedRendering& tiltPass = recorder.renderings[3];
+        CHECK(tiltPass.color.imageView == acquired.view);
+        CHECK(scopes[3][targets.scene.image] == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        CHECK(scopes[3][targets.depthResolved.image] == VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+
+        for (const VkImageMemoryBarrier2& barrier : recorder.barriers) {
+            bool swapchainImage = barrier.image == swapchain.images[0].image || barrier.image == swapchain.images[1].image ||
+                                  barrier.image == swapchain.images[2].image;
+            if (swapchainImage) CHECK(barrier.image == acquired.image);
+        }
+        // After the first frame, every frame records the same barriers
+        if (frame == 1) firstFrameBarriers = recorder.barriers.size();
+        if (frame > 1) CHECK(recorder.barriers.size() == firstFrameBarriers);
+    }
+
+    // Declaring the same frame again reuses the compiled plan
+    declareFrame(graph, swapchain, targets, recorded);
+    graph.compile(device, swapchain);
+    CHECK(graph.getStructureHash() == hash);
+}
+
+// A pass whose output nothing reads is culled and its callback never runs, and a pass drawing
+// over the one before it with the same attachments joins its rendering scope
+void testCullAndMerge() {
+    Device device{};
+    Swapchain swapchain = fakeSwapchain();
+    Target unread{fakeHandle<VkImage>(9), fakeHandle<VkImageView>(19)};
+
+    RenderGraph graph;
+    RecordingCommandRecorder recorder;
+    graph.setCommandRecorder(recorder);
+    std::vector<std::string> recorded;
+    auto addPass = [&](const char* name, RenderAttachment attachments, VkAttachmentLoadOp loadOp) {
+        RenderPassDesc pass{};
+        pass.name = name;
+        pass.attachments = attachments;
+        pass.colorLoadOp = loadOp;
+        pass.record = [&recorded, name](VkCommandBuffer) { recorded.push_back(name); };
+        graph.addPass(pass);
+    };
+    RenderAttachment offscreen{};
+    offscreen.extent = swapchain.extent;
+    offscreen.colorFormat = swapchain.format;
+    offscreen.colorView = unread.view;
+    offscreen.colorImage = unread.image;
+    RenderAttachment backbuffer{};
+    backbuffer.extent = swapchain.extent;
+    backbuffer.colorFormat = swapchain.format;
+    backbuffer.swapchainColor = true;
+    addPass("minimap", offscreen, VK_ATTACHMENT_LOAD_OP_CLEAR);
+    addPass("terrain", backbuffer, VK_ATTACHMENT_LOAD_OP_CLEAR);
+    addPass("hud", backbuffer, VK_ATTACHMENT_LOAD_OP_LOAD);
+
+    const CompiledGraph& compiled = graph.compile(device, swapchain);
+    CHECK((compiled.report.culled == std::vector<std::string>{"minimap"}));
+    CHECK(compiled.report.merged.size() == 1);
+    if (compiled.report.merged.size() == 1) {
+        CHECK(compiled.report.merged[0].first == "hud" && compiled.report.merged[0].second == "terrain");
+    }
+    CHECK(compiled.passes.size() == 1);
+    CHECK((compiled.scopeOf == std::vector<int32_t>{-1, 0, 0}));
+
+    for (uint32_t frame = 0; frame < 2; ++frame) {
+        recorder.clear();
+        recorded.clear();
+        swapchain.currentFrame = frame % Swapchain::MAX_FRAMES_IN_FLIGHT;
+        swapchain.currentImageIndex = frame % 3;
+        graph.execute(fakeHandle<VkCommandBuffer>(1), swapchain);
+        CHECK((recorded == std::vector<std::string>{"terrain", "hud"}));
+        CHECK(recorder.renderings.size() == 1);
+        for (const VkImageMemoryBarrier2& barrier : recorder.barriers) CHECK(barrier.image != unread.image);
+    }
+}
+
+// A pass drawing over the same multisampled color while sampling what the scope before it
+// resolved to needs a barrier after that resolve, so it starts a scope of its own
+void testResolveReaderDoesNotMerge() {
+    Device device{};
+    Swapchain swapchain = fakeSwapchain();
+    FrameTargets targets;
+    Target water{fakeHandle<VkImage>(10), fakeHandle<VkImageView>(20)};
+
+    RenderGraph graph;
+    RecordingCommandRecorder recorder;
+    graph.setCommandRecorder(recorder);
+    RenderAttachment msaa{};
+    msaa.extent = swapchain.extent;
+    msaa.samples = swapchain.msaaSamples;
+    msaa.colorFormat = swapchain.format;
+    msaa.colorView = targets.msaaColor.view;
+    msaa.colorImage = targets.msaaColor.image;
+    msaa.resolveView = targets.scene.view;
+    msaa.resolveImage = targets.scene.image;
+
+    RenderPassDesc scenePass{};
+    scenePass.name = "scene";
+    scenePass.attachments = msaa;
+    graph.addPass(scenePass);
+
+    RenderPassDesc refractionPass{};
+    refractionPass.name = "refraction";
+    refractionPass.attachments = msaa;
+    refractionPass.attachments.resolveView = water.view;
+    refractionPass.attachments.resolveImage = water.image;
+    refractionPass.colorLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    refractionPass.images.push_back(ImageAccess{targets.scene.image, swapchain.format, ImageUsage::SampledFragment});
+    graph.addPass(refractionPass);
+
+    RenderPassDesc tiltPass{};
+    tiltPass.name = "tiltshift";
+    tiltPass.attachments.extent = swapchain.extent;
+    tiltPass.attachments.colorFormat = swapchain.format;
+    tiltPass.attachments.swapchainColor = true;
+    tiltPass.images.push_back(ImageAccess{targets.scene.image, swapchain.format, ImageUsage::SampledFragment});
+    tiltPass.images.push_back(ImageAccess{water.image, swapchain.format, ImageUsage::SampledFragment});
+    graph.addPass(tiltPass);
+
+    const CompiledGraph& compiled = graph.compile(device, swapchain);
+    CHECK(compiled.report.culled.empty());
+    CHECK(compiled.report.merged.empty());
+    CHECK(compiled.passes.size() == 3);
+    if (compiled.passes.size() != 3) return;
+
+    // The refraction scope starts by making the resolve readable
+    bool resolveReadable = false;
+    for (uint32_t b = compiled.barriers.passOffsets[1]; b < compiled.barriers.passOffsets[2]; ++b) {
+        const VkImageMemoryBarrier2& barrier = compiled.barriers.barriers[b];
+        resolveReadable = resolveReadable || (barrier.image == targets.scene.image &&
+                                              barrier.newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+    CHECK(resolveReadable);
+
+    // Resolving to the image it samples, it can't be compiled at all rather than being merged
+    refractionPass.attachments = msaa;
+    graph.addPass(scenePass);
+    graph.addPass(refractionPass);
+    graph.addPass(tiltPass);
+    bool threw = false;
+    try {
+        graph.compile(device, swapchain);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+// Compiles passes, returning what compile() threw, or an empty string
+std::string compileError(RenderGraph& graph, Device& device, const Swapchain& swapchain) {
+    try {
+        graph.compile(device, swapchain);
+    } catch (const std::runtime_error& error) {
+        return error.what();
+    }
+    return "";
+}
+
+// Two transient images whose lifetimes don't overlap share memory. The second one's first
+// barrier discards the memory after the first image's last read; reading it before writing
+// it, or keeping both alive in one frame, is rejected.
+void testTransientAliasing() {
+    Device device{};
+    Swapchain swapchain = fakeSwapchain();
+    FrameTargets targets;
+
+    RenderGraph graph;
+    RecordingCommandRecorder recorder;
+    graph.setCommandRecorder(recorder);
+    TransientImageDesc desc{};
+    desc.format = swapchain.format;
+    desc.extent = swapchain.extent;
+    desc.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    VkImage glow = graph.getTransientImage(graph.createTransientImage(device, desc)).image;
+    VkImage blur = graph.getTransientImage(graph.createTransientImage(device, desc)).image;
+
+    // glow is written and sampled by the first two passes, blur by the last two
+    auto declare = [&](VkAttachmentLoadOp blurLoadOp, bool sampleGlowLate) {
+        auto addPass = [&](const char* name, VkImage color, VkAttachmentLoadOp loadOp, std::vector<VkImage> sampled) {
+            RenderPassDesc pass{};
+            pass.name = name;
+            pass.attachments.extent = swapchain.extent;
+            pass.attachments.colorFormat = swapchain.format;
+            pass.attachments.colorImage = color;
+            pass.attachments.colorView = color == targets.scene.image ? targets.scene.view : VK_NULL_HANDLE;
+            pass.attachments.swapchainColor = color == VK_NULL_HANDLE;
+            pass.colorLoadOp = loadOp;
+            for (VkImage image : sampled) pass.images.push_back(ImageAccess{image, swapchain.format, ImageUsage::SampledFragment});
+            graph.addPass(pass);
+        };
+        addPass("glow", glow, VK_ATTACHMENT_LOAD_OP_CLEAR, {});
+        addPass("scene", targets.scene.image, VK_ATTACHMENT_LOAD_OP_CLEAR, {glow});
+        addPass("blur", blur, blurLoadOp, {targets.scene.image});
+        addPass("composite", VK_NULL_HANDLE, VK_ATTACHMENT_LOAD_OP_CLEAR,
+                sampleGlowLate ? std::vector<VkImage>{blur, glow} : std::vector<VkImage>{blur});
+    };
+
+    declare(VK_ATTACHMENT_LOAD_OP_CLEAR, false);
+    const CompiledGraph& compiled = graph.compile(device, swapchain);
+    const TransientLayout& layout = graph.getTransientLayout();
+    CHECK(layout.heaps.size() == 2 && layout.heaps[0] == layout.heaps[1] && layout.offsets[0] == layout.offsets[1]);
+    // glow takes the memory back from the previous frame's blur
+    CHECK(compiled.aliases.size() == 2);
+    if (compiled.aliases.size() == 2) {
+        CHECK(compiled.aliases[0].group == 0);
+        CHECK(compiled.aliases[0].image == glow && compiled.aliases[0].previous == blur);
+        CHECK(compiled.aliases[1].group == 2);
+        CHECK(compiled.aliases[1].image == blur && compiled.aliases[1].previous == glow);
+    }
+
+    // Before the blur pass, blur starts from undefined contents once the scene pass's samples
+    // of glow are done
+    const VkImageMemoryBarrier2* aliasBarrier = nullptr;
+    for (uint32_t b = compiled.barriers.passOffsets[2]; b < compiled.barriers.passOffsets[3]; ++b) {
+        if (compiled.barriers.barriers[b].image == blur) aliasBarrier = &compiled.barriers.barriers[b];
+    }
+    CHECK(aliasBarrier != nullptr);
+    if (aliasBarrier) {
+        CHECK(aliasBarrier->oldLayout == VK_IMAGE_LAYOUT_UNDEFINED);
+        CHECK(aliasBarrier->newLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        CHECK((aliasBarrier->srcStageMask & VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT) != 0);
+    }
+    for (uint32_t frame = 0; frame < 2; ++frame) {
+        recorder.clear();
+        swapchain.currentFrame = frame % Swapchain::MAX_FRAMES_IN_FLIGHT;
+        swapchain.currentImageIndex = frame % 3;
+        graph.execute(fakeHandle<VkCommandBuffer>(1), swapchain);
+        CHECK(recorder.renderings.size() == 4);
+    }
+
+    // The memory is placed; graphs using it another way have to fit the same placement
+    declare(VK_ATTACHMENT_LOAD_OP_LOAD, false);
+    CHECK(compileError(graph, device, swapchain) ==
+          "Transient image sharing memory is read before it is written in pass blur");
+    declare(VK_ATTACHMENT_LOAD_OP_CLEAR, true);
+    CHECK(compileError(graph, device, swapchain) == "Transient images sharing memory are both alive in pass blur");
+    graph.destroyTransientImages(device);
+}
+
+// What the queue submissions below were given
+struct FakeSubmit {
+    VkQueue queue;
+    VkCommandBuffer cmd;
+    std::vector<VkSemaphoreSubmitInfo> waits;
+    std::vector<VkSemaphoreSubmitInfo> signals;
+};
+std::vector<FakeSubmit> fakeSubmits;
+uintptr_t lastFakeHandle = 1000;
+
+} // namespace
+
+// The device calls the async compute and transient image paths make, answered without a
+// device. Defined in the test, they take the place of the loader's and VMA's.
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateSemaphore(VkDevice, const VkSemaphoreCreateInfo*, const VkAllocationCallbacks*,
+                                                 VkSemaphore* semaphore) {
+    *semaphore = fakeHandle<VkSemaphore>(++lastFakeHandle);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroySemaphore(VkDevice, VkSemaphore, const VkAllocationCallbacks*) {}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateCommandPool(VkDevice, const VkCommandPoolCreateInfo*, const VkAllocationCallbacks*,
+                                                   VkCommandPool* pool) {
+    *pool = fakeHandle<VkCommandPool>(++lastFakeHandle);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyCommandPool(VkDevice, VkCommandPool, const VkAllocationCallbacks*) {}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkResetCommandPool(VkDevice, VkCommandPool, VkCommandPoolResetFlags) {
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateCommandBuffers(VkDevice, const VkCommandBufferAllocateInfo* info,
+                                                        VkCommandBuffer* buffers) {
+    for (uint32_t i = 0; i < info->commandBufferCount; ++i) buffers[i] = fakeHandle<VkCommandBuffer>(++lastFakeHandle);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBeginCommandBuffer(VkCommandBuffer, const VkCommandBufferBeginInfo*) {
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEndCommandBuffer(VkCommandBuffer) {
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkQueueSubmit2(VkQueue queue, uint32_t count, const VkSubmitInfo2* submits, VkFence) {
+    for (uint32_t i = 0; i < count; ++i) {
+        const VkSubmitInfo2& submit = submits[i];
+        fakeSubmits.push_back(FakeSubmit{
+            queue, submit.pCommandBufferInfos[0].commandBuffer,
+            {submit.pWaitSemaphoreInfos, submit.pWaitSemaphoreInfos + submit.waitSemaphoreInfoCount},
+            {submit.pSignalSemaphoreInfos, submit.pSignalSemaphoreInfos + submit.signalSemaphoreInfoCount}});
+    }
+    return VK_SUCCESS;
+}
+
+// Transient images get made-up handles and a megabyte each, placed in made-up allocations
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateImage(VkDevice, const VkImageCreateInfo*, const VkAllocationCallbacks*, VkImage* image) {
+    *image = fakeHandle<VkImage>(++lastFakeHandle);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements(VkDevice, VkImage, VkMemoryRequirements* requirements) {
+    requirements->size = 1 << 20;
+    requirements->alignment = 256;
+    requirements->memoryTypeBits = 1;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyImage(VkDevice, VkImage, const VkAllocationCallbacks*) {}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyImageView(VkDevice, VkImageView, const VkAllocationCallbacks*) {}
+
+VkResult vmaAllocateMemory(VmaAllocator, const VkMemoryRequirements*, const VmaAllocationCreateInfo*, VmaAllocation* allocation,
+                           VmaAllocationInfo*) {
+    *allocation = fakeHandle<VmaAllocation>(++lastFakeHandle);
+    return VK_SUCCESS;
+}
+
+VkResult vmaBindImageMemory2(VmaAllocator, VmaAllocation, VkDeviceSize, VkImage, const void*) {
+    return VK_SUCCESS;
+}
+
+void vmaFreeMemory(VmaAllocator, VmaAllocation) {}
+
+void createImageView(Device&, Image& image, VkImageAspectFlags) {
+    image.view = fakeHandle<VkImageView>(++lastFakeHandle);
+}
+
+namespace {
+
+// Graphics on family 0 and a compute-only family 1
+Device twoFamilyDevice() {
+    Device device{};
+    device.device = fakeHandle<VkDevice>(1);
+    device.queue = fakeHandle<VkQueue>(2);
+    device.queueFamilyIndex = 0;
+    device.computeQueue = fakeHandle<VkQueue>(3);
+    device.computeQueueFamilyIndex = 1;
+    return device;
+}
+
+bool sameRange(const VkImageSubresourceRange& a, const VkImageSubresourceRange& b) {
+    return a.aspectMask == b.aspectMask && a.baseMipLevel == b.baseMipLevel && a.levelCount == b.levelCount &&
+           a.baseArrayLayer == b.baseArrayLayer && a.layerCount == b.layerCount;
+}
+
+// Async compute writes mip 1 of an image whose mip 0 stays on the graphics queue. Only mip 1
+// changes queue family, and the compute batch releases exactly what graphics acquires.
+void testAsyncComputeMipOwnership() {
+    Device device = twoFamilyDevice();
+    Swapchain swapchain = fakeSwapchain();
+    VkImage bloom = fakeHandle<VkImage>(6);
+    const VkFormat format = VK_FORMAT_B8G8R8A8_UNORM;
+
+    RenderGraph graph;
+    RecordingCommandRecorder recorder;
+    graph.setCommandRecorder(recorder);
+    CHECK(graph.enableAsyncCompute(device));
+    graph.registerImage(bloom, 2);
+
+    RenderPassDesc copyPass{};
+    copyPass.name = "bloom_copy";
+    copyPass.images.push_back(ImageAccess{bloom, format, ImageUsage::TransferDst, 0, 1, 0, 1, true});
+    graph.addPass(copyPass);
+
+    RenderPassDesc downsamplePass{};
+    downsamplePass.name = "bloom_downsample";
+    downsamplePass.queue = PassQueue::AsyncCompute;
+    downsamplePass.images.push_back(ImageAccess{bloom, format, ImageUsage::StorageCompute, 1, 1, 0, 1, true});
+    graph.addPass(downsamplePass);
+
+    RenderPassDesc compositePass{};
+    compositePass.name = "composite";
+    compositePass.attachments.extent = swapchain.extent;
+    compositePass.attachments.colorFormat = swapchain.format;
+    compositePass.attachments.swapchainColor = true;
+    compositePass.images.push_back(ImageAccess{bloom, format, ImageUsage::SampledFragment});
+    graph.addPass(compositePass);
+
+    const CompiledGraph& compiled = graph.compile(device, swapchain);
+    CHECK(compiled.passes.size() == 3);
+    CHECK(compiled.batches.size() == 3);
+    if (compiled.passes.size() != 3 || compiled.batches.size() != 3) return;
+
+    const BarrierPlan& plan = compiled.barriers;
+    const VkImageMemoryBarrier2* mip0 = nullptr;
+    const VkImageMemoryBarrier2* mip1 = nullptr;
+    for (uint32_t b = plan.passOffsets[2]; b < plan.passOffsets[3]; ++b) {
+        const VkImageMemoryBarrier2& barrier = plan.barriers[b];
+        if (barrier.image != bloom) continue;
+        if (barrier.subresourceRange.baseMipLevel == 0) mip0 = &barrier;
+        if (barrier.subresourceRange.baseMipLevel == 1) mip1 = &barrier;
+    }
+    CHECK(mip0 != nullptr && mip1 != nullptr);
+    if (!mip0 || !mip1) return;
+    CHECK(mip0->subresourceRange.levelCount == 1);
+    CHECK(mip0->srcQueueFamilyIndex == mip0->dstQueueFamilyIndex);
+    CHECK(mip0->oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    CHECK(mip1->srcQueueFamilyIndex == 1 && mip1->dstQueueFamilyIndex == 0);
+    CHECK(mip1->oldLayout == VK_IMAGE_LAYOUT_GENERAL);
+
+    uint32_t computeBatch = compiled.batchOf[1];
+    for (uint32_t batch = 0; batch < compiled.batches.size(); ++batch) {
+        CHECK(compiled.releases[batch].size() == (batch == computeBatch ? 1u : 0u));
+    }
+    if (compiled.releases[computeBatch].size() != 1) return;
+    const VkImageMemoryBarrier2& release = compiled.releases[computeBatch][0];
+    CHECK(release.image == bloom);
+    CHECK(sameRange(release.subresourceRange, mip1->subresourceRange));
+    CHECK(release.oldLayout == mip1->oldLayout && release.newLayout == mip1->newLayout);
+    CHECK(release.srcQueueFamilyIndex == 1 && release.dstQueueFamilyIndex == 0);
+    graph.disableAsyncCompute(device);
+}
+
+// A barrier recorded in one frame, with the family of the queue it went to
+struct QueuedBarrier {
+    VkImageMemoryBarrier2 barrier;
+    uint32_t family;
+};
+
+bool isRelease(const QueuedBarrier& queued) {
+    return queued.barrier.srcQueueFamilyIndex != queued.barrier.dstQueueFamilyIndex &&
+           queued.barrier.dstStageMask == VK_PIPELINE_STAGE_2_NONE;
+}
+
+bool isAcquire(const QueuedBarrier& queued) {
+    return queued.barrier.srcQueueFamilyIndex != queued.barrier.dstQueueFamilyIndex &&
+           queued.barrier.dstStageMask != VK_PIPELINE_STAGE_2_NONE;
+}
+
+bool releases(const QueuedBarrier& release, const QueuedBarrier& acquire) {
+    const VkImageMemoryBarrier2& a = release.barrier;
+    const VkImageMemoryBarrier2& b = acquire.barrier;
+    return isRelease(release) && release.family == a.srcQueueFamilyIndex && acquire.family == b.dstQueueFamilyIndex &&
+           a.image == b.image && sameRange(a.subresourceRange, b.subresourceRange) && a.oldLayout == b.oldLayout &&
+           a.newLayout == b.newLayout && a.srcQueueFamilyIndex == b.srcQueueFamilyIndex &&
+           a.dstQueueFamilyIndex == b.dstQueueFamilyIndex;
+}
+
+// Runs one frame and submits it, returning the barriers each queue recorded
+std::vector<QueuedBarrier> runFrame(RenderGraph& graph, RecordingCommandRecorder& recorder, Device& device,
+                                    Swapchain& swapchain, uint32_t frame) {
+    recorder.clear();
+    fakeSubmits.clear();
+    swapchain.currentFrame = frame % Swapchain::MAX_FRAMES_IN_FLIGHT;
+    swapchain.currentImageIndex = frame % 3;
+    VkCommandBuffer cmd = fakeHandle<VkCommandBuffer>(1);
+    graph.execute(cmd, swapchain);
+    FrameSubmitInfo info{};
+    info.waitSemaphore = fakeHandle<VkSemaphore>(20);
+    info.signalSemaphore = fakeHandle<VkSemaphore>(21);
+    info.timelineSemaphore = fakeHandle<VkSemaphore>(22);
+    info.timelineValue = frame + 1;
+    graph.submit(device, cmd, info);
+
+    std::vector<QueuedBarrier> barriers;
+    for (const RecordedCommand& command : recorder.commands) {
+        if (command.type != RecordedCommand::Type::Barrier) continue;
+        uint32_t family = UINT32_MAX;
+        for (const FakeSubmit& submit : fakeSubmits) {
+            if (submit.cmd == command.cmd) family = submit.queue == device.queue ? device.queueFamilyIndex : device.computeQueueFamilyIndex;
+        }
+        CHECK(family != UINT32_MAX);
+        for (uint32_t i = 0; i < command.count; ++i) barriers.push_back(QueuedBarrier{recorder.barriers[command.first + i], family});
+    }
+    return barriers;
+}
+
+// Every acquire has a release on the other queue, in the frame before or earlier in its own,
+// and every release of the frame before is acquired
+void checkOwnershipTransfers(const std::vector<QueuedBarrier>& previous, const std::vector<QueuedBarrier>& barriers) {
+    for (const QueuedBarrier& acquire : barriers) {
+        if (!isAcquire(acquire)) continue;
+        bool released = false;
+        for (const auto* frame : {&previous, &barriers}) {
+            for (const QueuedBarrier& release : *frame) released = released || releases(release, acquire);
+        }
+        CHECK(released);
+    }
+    for (const QueuedBarrier& release : previous) {
+        if (!isRelease(release)) continue;
+        bool acquired = false;
+        for (const auto* frame : {&previous, &barriers}) {
+            for (const QueuedBarrier& acquire : *frame) acquired = acquired || releases(release, acquire);
+        }
+        CHECK(acquired);
+    }
+}
+
+// Particles that async compute advances every frame and graphics draws: each frame compute
+// takes the image back from the graphics family that sampled it last, and hands it over again.
+// The hand-over from one frame to the next is released by graphics at the end of its frame
+// and acquired by compute at the start of the next, which waits for that frame's graphics.
+void testAsyncCrossFrameOwnership() {
+    Device device = twoFamilyDevice();
+    Swapchain swapchain = fakeSwapchain();
+    VkImage particles = fakeHandle<VkImage>(7);
+    VkImage trails = fakeHandle<VkImage>(8);
+    const VkFormat format = VK_FORMAT_B8G8R8A8_UNORM;
+
+    RenderGraph graph;
+    RecordingCommandRecorder recorder;
+    graph.setCommandRecorder(recorder);
+    CHECK(graph.enableAsyncCompute(device));
+
+    auto declare = [&](bool withTrails) {
+        RenderPassDesc simulatePass{};
+        simulatePass.name = "particles_simulate";
+        simulatePass.queue = PassQueue::AsyncCompute;
+        simulatePass.images.push_back(ImageAccess{particles, format, ImageUsage::StorageCompute});
+        graph.addPass(simulatePass);
+
+        RenderPassDesc compositePass{};
+        compositePass.name = "composite";
+        compositePass.attachments.extent = swapchain.extent;
+        compositePass.attachments.colorFormat = swapchain.format;
+        compositePass.attachments.swapchainColor = true;
+        compositePass.images.push_back(ImageAccess{particles, format, ImageUsage::SampledFragment});
+        if (withTrails) compositePass.images.push_back(ImageAccess{trails, format, ImageUsage::SampledFragment});
+        graph.addPass(compositePass);
+        return &graph.compile(device, swapchain);
+    };
+
+    const CompiledGraph* compiled = declare(false);
+    CHECK(compiled->batches.size() == 2);
+    if (compiled->batches.size() != 2) return;
+    CHECK(compiled->batches[0].queue == PassQueue::AsyncCompute);
+
+    std::vector<QueuedBarrier> previous;
+    uint64_t graphicsSignaled = 0;
+    for (uint32_t frame = 0; frame < 8; ++frame) {
+        // Halfway through, the frame changes and the new plan takes over what the last frame
+        // of the old one released
+        if (frame == 4) compiled = declare(true);
+        std::vector<QueuedBarrier> barriers = runFrame(graph, recorder, device, swapchain, frame);
+        checkOwnershipTransfers(previous, barriers);
+
+        size_t handOvers = 0;
+        size_t takenBack = 0;
+        for (const QueuedBarrier& queued : barriers) {
+            if (queued.barrier.image != particles) continue;
+            if (isRelease(queued) && queued.family == 0) ++handOvers;
+            if (isAcquire(queued) && queued.family == 1) ++takenBack;
+        }
+        CHECK(handOvers == 1);
+        CHECK(takenBack == (frame == 0 ? 0u : 1u));
+
+        CHECK(fakeSubmits.size() == 2);
+        if (fakeSubmits.size() != 2) return;
+        const FakeSubmit& compute = fakeSubmits[0];
+        const FakeSubmit& graphics = fakeSubmits[1];
+        CHECK(compute.queue == device.computeQueue && graphics.queue == device.queue);
+        // Compute starts after the previous frame's graphics, which released the particles
+        CHECK(compute.waits.size() == (frame == 0 ? 0u : 1u));
+        if (frame > 0 && compute.waits.size() == 1) {
+            CHECK(compute.waits[0].semaphore == graphics.signals[0].semaphore);
+            CHECK(compute.waits[0].value == graphicsSignaled);
+        }
+        // and graphics after the compute it samples
+        bool waitsForCompute = false;
+        for (const VkSemaphoreSubmitInfo& wait : graphics.waits) {
+            waitsForCompute = waitsForCompute ||
+                              (wait.semaphore == compute.signals[0].semaphore && wait.value == compute.signals[0].value);
+        }
+        CHECK(waitsForCompute);
+        graphicsSignaled = graphics.signals[0].value;
+        previous = std::move(barriers);
+    }
+    graph.disableAsyncCompute(device);
+}
+
+} // namespace
+
+int main() {
+    testFourPassFrame();
+    testCullAndMerge();
+    testResolveReaderDoesNotMerge();
+    testTransientAliasing();
+    testAsyncComputeMipOwnership();
+    testAsyncCrossFrameOwnership();
+    return testResult();
+}
@@ -0,0 +1,159 @@
+#include "territory_map.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+namespace {
+
+constexpr int WIDTH = 10;
+constexpr int HEIGHT = 6;
+
+int tile(int col, int row) {
+    return row * WIDTH + col;
+}
+
+// Cost of reaching every tile from source, entering each tile on the way, within claimRange
+std::vector<float> costsFrom(const HexGrid& grid, const MovementProfile& profile, float claimRange, int source) {
+    std::vector<float> cost(grid.size(), MovementProfile::IMPASSABLE);
+    using Item = std::pair<float, int>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> open;
+    cost[source] = 0.0f;
+    open.push({0.0f, source});
+    while (!open.empty()) {
+        auto [current, at] = open.top();
+        open.pop();
+        if (current > cost[at]) continue;
+        for (int dir = 0; dir < 6; ++dir) {
+            int next = grid.neighborIndex(at, dir);
+            if (next < 0) continue;
+            float step = current + profile.entryCost(grid.getType(next));
+            if (step == MovementProfile::IMPASSABLE || step > claimRange || step >= cost[next]) continue;
+            cost[next] = step;
+            open.push({step, next});
+        }
+    }
+    return cost;
+}
+
+// Every tile goes to the city that reaches it cheapest, the lower id on ties, and each
+// city's territory size counts its tiles
+void checkTerritories(const HexGrid& grid, const MovementProfile& profile, float claimRange, const TerritoryMap& map,
+                      const std::vector<CityId>& alive) {
+    std::vector<int32_t> owners(grid.size(), TerritoryMap::UNOWNED);
+    std::vector<float> costs(grid.size(), MovementProfile::IMPASSABLE);
+    for (CityId id : alive) {
+        std::vector<float> cost = costsFrom(grid, profile, claimRange, map.getCityTile(id));
+        for (int t = 0; t < grid.size(); ++t) {
+            if (cost[t] == MovementProfile::IMPASSABLE) continue;
+            if (cost[t] < costs[t] || (cost[t] == costs[t] && id < owners[t])) {
+                costs[t] = cost[t];
+                owners[t] = id;
+            }
+        }
+    }
+    CHECK(map.getOwners() == owners);
+    for (int t = 0; t < grid.size(); ++t) CHECK(map.costOf(t) == costs[t]);
+    for (CityId id : alive) {
+        CHECK(map.getTerritorySize(id) == static_cast<int>(std::count(owners.begin(), owners.end(), id)));
+    }
+}
+
+// Grassland with a mountain ridge and a lake. Territories follow the terrain-weighted
+// distance, founding and losing cities update them like a rebuild would.
+void testTerritories() {
+    const MovementProfile profile = MovementProfile::allTerrain();
+    const float range = MovementProfile::IMPASSABLE;
+    HexGrid grid(WIDTH, HEIGHT, TerrainType::Grassland);
+    for (int row = 0; row < 4; ++row) grid.setType(tile(5, row), TerrainType::Mountains);
+    grid.setType(tile(2, 4), TerrainType::Ocean);
+    grid.setType(tile(3, 4), TerrainType::Ocean);
+
+    TerritoryMap map(grid, profile, range);
+    CityId west = map.foundCity(tile(1, 2));
+    CityId east = map.foundCity(tile(8, 2));
+    CHECK(west == 0 && east == 1);
+    checkTerritories(grid, profile, range, map, {west, east});
+    CHECK(map.ownerOf(tile(0, 0)) == west && map.ownerOf(tile(9, 5)) == east);
+    CHECK(map.costOf(tile(1, 2)) == 0.0f);
+    CHECK(map.getTerritorySize(west) + map.getTerritorySize(east) == grid.size());
+
+    CityId south = map.foundCity(tile(4, 5));
+    checkTerritories(grid, profile, range, map, {west, east, south});
+    map.loseCity(west);
+    checkTerritories(grid, profile, range, map, {east, south});
+    CHECK(map.ownerOf(tile(1, 2)) != west);
+
+    // The lost city's id is reused
+    CHECK(map.foundCity(tile(0, 5)) == west);
+    checkTerritories(grid, profile, range, map, {west, east, south});
+    CHECK(map.foundCity(-1) == TerritoryMap::UNOWNED);
+
+    grid.setType(tile(5, 4), TerrainType::Mountains);
+    map.rebuild();
+    checkTerritories(grid, profile, range, map, {west, east, south});
+}
+
+// Land cities claim at most three steps of grassland and no water
+void testClaimRange() {
+    const MovementProfile profile = MovementProfile::land();
+    const float range = 3.0f;
+    HexGrid grid(WIDTH, HEIGHT, TerrainType::Grassland);
+    for (int row = 0; row < HEIGHT; ++row) grid.setType(tile(4, row), TerrainType::Ocean);
+
+    TerritoryMap map(grid, profile, range);
+    CityId city = map.foundCity(tile(2, 2));
+    checkTerritories(grid, profile, range, map, {city});
+    CHECK(map.ownerOf(tile(4, 2)) == TerritoryMap::UNOWNED);
+    CHECK(map.ownerOf(tile(5, 2)) == TerritoryMap::UNOWNED);
+    CHECK(map.ownerOf(tile(9, 2)) == TerritoryMap::UNOWNED);
+    CHECK(map.getTerritorySize(city) < 4 * HEIGHT);
+}
+
+// Every hex edge between differently owned tiles, and between an owned tile and the map
+// edge, is drawn exactly once, with the lower owner first
+void testBorders() {
+    const MovementProfile profile = MovementProfile::allTerrain();
+    HexGrid grid(WIDTH, HEIGHT, TerrainType::Grassland);
+    TerritoryMap map(grid, profile, 3.0f);
+    map.foundCity(tile(2, 2));
+    map.foundCity(tile(6, 3));
+    CHECK(std::count(map.getOwners().begin(), map.getOwners().end(), TerritoryMap::UNOWNED) > 0);
+
+    TerritoryBorders borders;
+    map.extractBorders(borders, 1.0f);
+    CHECK(borders.lineStarts.size() == borders.owners.size() + 1);
+    if (borders.lineStarts.size() != borders.owners.size() + 1) return;
+    CHECK(borders.lineStarts.back() == borders.points.size());
+
+    size_t segments = 0;
+    for (size_t line = 0; line < borders.owners.size(); ++line) {
+        CHECK(borders.owners[line].x < borders.owners[line].y);
+        CHECK(borders.lineStarts[line + 1] - borders.lineStarts[line] >= 2);
+        segments += borders.lineStarts[line + 1] - borders.lineStarts[line] - 1;
+    }
+
+    size_t expected = 0;
+    for (int t = 0; t < grid.size(); ++t) {
+        for (int dir = 0; dir < 6; ++dir) {
+            int next = grid.neighborIndex(t, dir);
+            int32_t mine = map.ownerOf(t);
+            int32_t theirs = next >= 0 ? map.ownerOf(next) : TerritoryMap::UNOWNED;
+            if (mine == theirs) continue;
+            // Edges between two owned tiles are seen from both sides
+            if (mine != TerritoryMap::UNOWNED && (theirs == TerritoryMap::UNOWNED || mine < theirs)) ++expected;
+        }
+    }
+    CHECK(segments == expected);
+    CHECK(!borders.owners.empty());
+}
+
+} // namespace
+
+int main() {
+    testTerritories();
+    testClaimRange();
+    testBorders();
+    return testResult();
+}
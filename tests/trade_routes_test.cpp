@@ -0,0 +1,100 @@
+#include "trade_routes.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr int WIDTH = 12;
+constexpr int HEIGHT = 12;
+
+int tile(int col, int row) {
+    return row * WIDTH + col;
+}
+
+bool adjacent(const HexGrid& grid, int a, int b) {
+    for (int dir = 0; dir < 6; ++dir) {
+        if (grid.neighborIndex(a, dir) == b) return true;
+    }
+    return false;
+}
+
+// A reachable route is a water path between its ends whose cost is what entering each tile
+// after the first adds up to, and it is linked to every chunk it crosses
+void checkRoute(const HexGrid& grid, const MovementProfile& profile, const TradeRouteCache& cache, const TradeRoute& route) {
+    CHECK(route.reachable);
+    CHECK(route.path.size() >= 2);
+    if (route.path.size() < 2) return;
+    CHECK(route.path.front() == route.from && route.path.back() == route.to);
+    float cost = 0.0f;
+    for (size_t i = 1; i < route.path.size(); ++i) {
+        CHECK(adjacent(grid, route.path[i - 1], route.path[i]));
+        CHECK(profile.passable(grid.getType(route.path[i])));
+        cost += profile.entryCost(grid.getType(route.path[i]));
+    }
+    CHECK(std::abs(cost - route.cost) < 1e-4f);
+    for (int step : route.path) {
+        CHECK(std::binary_search(route.chunks.begin(), route.chunks.end(), static_cast<uint32_t>(cache.chunkOf(step))));
+    }
+}
+
+// A sea split by a wall of land with one gap at the bottom. The route between the two halves
+// goes through the gap, so edits far from it leave it alone, closing the gap makes it
+// unreachable and opening it again brings it back.
+void testRouteInvalidation() {
+    const MovementProfile profile = MovementProfile::naval();
+    HexGrid grid(WIDTH, HEIGHT, TerrainType::Ocean);
+    for (int row = 0; row < HEIGHT - 1; ++row) grid.setType(tile(6, row), TerrainType::Grassland);
+    int gap = tile(6, HEIGHT - 1);
+
+    TradeRouteCache cache(grid, profile, 4, 2);
+    RouteId id = cache.addRoute(tile(2, 9), tile(10, 9));
+    CHECK(cache.update() == 1);
+    const TradeRoute& route = cache.getRoute(id);
+    checkRoute(grid, profile, cache, route);
+    CHECK(std::find(route.path.begin(), route.path.end(), gap) != route.path.end());
+
+    // Flat A* finds the same cost
+    HexPathfinder pathfinder(grid);
+    std::vector<int> path;
+    float cost = 0.0f;
+    CHECK(pathfinder.findPath(route.from, route.to, profile, path, &cost));
+    CHECK(std::abs(cost - route.cost) < 1e-4f);
+
+    // The top rows are another chunk row the route doesn't cross
+    int far = tile(2, 1);
+    CHECK(!std::binary_search(route.chunks.begin(), route.chunks.end(), static_cast<uint32_t>(cache.chunkOf(far))));
+    grid.setType(far, TerrainType::Grassland);
+    cache.onTileChanged(far);
+    CHECK(cache.update() == 0);
+    CHECK(cache.update() == 0);
+
+    grid.setType(gap, TerrainType::Hills);
+    cache.onTileChanged(gap);
+    CHECK(cache.update() == 1);
+    CHECK(!cache.getRoute(id).reachable);
+    CHECK(cache.getRoute(id).path.empty());
+
+    // Unreachable routes are retried on any edit
+    grid.setType(gap, TerrainType::CoastalWater);
+    cache.onTileChanged(gap);
+    CHECK(cache.update() == 1);
+    checkRoute(grid, profile, cache, cache.getRoute(id));
+
+    // A removed route is never planned again, and its slot is reused
+    cache.removeRoute(id);
+    cache.invalidateAll();
+    CHECK(cache.update() == 0);
+    RouteId reused = cache.addRoute(tile(10, 9), tile(2, 9));
+    CHECK(reused == id);
+    CHECK(cache.update() == 1);
+    checkRoute(grid, profile, cache, cache.getRoute(reused));
+}
+
+} // namespace
+
+int main() {
+    testRouteInvalidation();
+    return testResult();
+}
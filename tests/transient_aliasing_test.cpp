@@ -0,0 +1,112 @@
+#include "transient_aliasing.hpp"
+#include "check.hpp"
+
+#include <random>
+
+namespace {
+
+bool livesOverlap(const TransientRequest& a, const TransientRequest& b) {
+    return a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+}
+
+// Everything solveAliasing promises about a layout, whatever the requests
+void checkLayout(const std::vector<TransientRequest>& requests, const TransientLayout& layout) {
+    CHECK(layout.heaps.size() == requests.size());
+    CHECK(layout.offsets.size() == requests.size());
+    if (layout.heaps.size() != requests.size() || layout.offsets.size() != requests.size()) return;
+
+    uint64_t worstCase = 0;
+    for (uint32_t i = 0; i < requests.size(); ++i) {
+        const TransientRequest& request = requests[i];
+        CHECK(layout.heaps[i] < layout.heapInfo.size());
+        if (layout.heaps[i] >= layout.heapInfo.size()) continue;
+        const TransientHeap& heap = layout.heapInfo[layout.heaps[i]];
+
+        CHECK(layout.offsets[i] % request.alignment == 0);
+        CHECK(heap.alignment % request.alignment == 0);
+        CHECK(layout.offsets[i] + request.size <= heap.size);
+        // The heap's memory types are ones every resource in it accepts
+        CHECK(heap.memoryTypeBits != 0);
+        CHECK((heap.memoryTypeBits & ~request.memoryTypeBits) == 0);
+
+        for (uint32_t j = 0; j < i; ++j) {
+            if (livesOverlap(request, requests[j])) CHECK(!layout.overlaps(i, j));
+        }
+        // Each placement grows its heap by at most its size plus alignment padding
+        worstCase += request.size + request.alignment - 1;
+    }
+
+    uint64_t heapBytes = 0;
+    for (const TransientHeap& heap : layout.heapInfo) heapBytes += heap.size;
+    CHECK(layout.peakBytes == heapBytes);
+    CHECK(layout.peakBytes <= worstCase);
+}
+
+// The four-pass frame at 1280x720 with 4x MSAA: depth, SSAO, terrain and tilt-shift
+void testFrameTargets() {
+    const uint64_t pixels = 1280 * 720;
+    std::vector<TransientRequest> requests = {
+        {pixels * 4 * 4, 65536, 7, 0, 2}, // MSAA depth
+        {pixels * 4, 65536, 7, 0, 3},     // Resolved depth
+        {pixels, 65536, 7, 1, 2},         // SSAO
+        {pixels * 4 * 4, 65536, 7, 2, 2}, // MSAA color
+        {pixels * 4, 65536, 7, 2, 3},     // Resolved scene
+    };
+    TransientLayout layout = solveAliasing(requests);
+    checkLayout(requests, layout);
+    CHECK(layout.heapInfo.size() == 1);
+    CHECK(layout.peakBytes <= layout.naiveBytes);
+}
+
+// A ping-pong chain: each target is written by one pass and read by the next, so targets two
+// apart can share memory
+void testChainReusesMemory() {
+    std::vector<TransientRequest> requests;
+    for (uint32_t pass = 0; pass < 8; ++pass) requests.push_back({1 << 20, 256, 3, pass, pass + 1});
+    TransientLayout layout = solveAliasing(requests);
+    checkLayout(requests, layout);
+    CHECK(layout.peakBytes == 2 << 20);
+    CHECK(layout.naiveBytes == 8 << 20);
+    CHECK(layout.overlaps(0, 2));
+}
+
+void testLiveTogetherNeverShare() {
+    std::vector<TransientRequest> requests = {{1000, 1, ~0u, 0, 3}, {1000, 1, ~0u, 1, 2}, {1000, 1, ~0u, 2, 5}};
+    TransientLayout layout = solveAliasing(requests);
+    checkLayout(requests, layout);
+    CHECK(layout.peakBytes == layout.naiveBytes);
+}
+
+void testIncompatibleMemoryTypesSplitHeaps() {
+    std::vector<TransientRequest> requests = {{100, 1, 1, 0, 0}, {100, 1, 2, 1, 1}};
+    TransientLayout layout = solveAliasing(requests);
+    checkLayout(requests, layout);
+    CHECK(layout.heapInfo.size() == 2);
+    CHECK(layout.heaps[0] != layout.heaps[1]);
+}
+
+void testRandomLayouts() {
+    std::mt19937 rng(1);
+    for (int iteration = 0; iteration < 2000; ++iteration) {
+        std::vector<TransientRequest> requests(1 + rng() % 20);
+        for (TransientRequest& request : requests) {
+            request.size = 1 + rng() % 5000;
+            request.alignment = uint64_t{1} << (rng() % 8);
+            request.memoryTypeBits = 1 + rng() % 3;
+            request.firstPass = rng() % 10;
+            request.lastPass = request.firstPass + rng() % 4;
+        }
+        checkLayout(requests, solveAliasing(requests));
+    }
+}
+
+} // namespace
+
+int main() {
+    testFrameTargets();
+    testChainReusesMemory();
+    testLiveTogetherNeverShare();
+    testIncompatibleMemoryTypesSplitHeaps();
+    testRandomLayouts();
+    return testResult();
+}
@@ -0,0 +1,74 @@
+#include "turn_simulation.hpp"
+#include "check.hpp"
+
+#include <vector>
+
+namespace {
+
+constexpr int SIZE = 48;
+constexpr int TURNS = 60;
+
+// Open sea with a lattice of small islands, so ships meet, trade at coastal cities and steer
+// around land
+HexGrid islandGrid() {
+    HexGrid grid(SIZE, SIZE, TerrainType::Ocean);
+    for (int row = 0; row < SIZE; ++row) {
+        for (int col = 0; col < SIZE; ++col) {
+            int r = row % 12;
+            int c = col % 12;
+            if (r >= 4 && r < 7 && c >= 4 && c < 8) {
+                grid.setType(row * SIZE + col, (r + c) % 3 == 0 ? TerrainType::Hills : TerrainType::Grassland);
+            } else if (r >= 3 && r < 8 && c >= 3 && c < 9) {
+                grid.setType(row * SIZE + col, TerrainType::CoastalWater);
+            }
+        }
+    }
+    return grid;
+}
+
+// Checksum after every turn, on a pool of the given size
+std::vector<uint64_t> runTurns(const HexGrid& grid, int workers) {
+    JobSystem jobs(workers);
+    SimulationConfig config;
+    config.seed = 7;
+    config.chunkSize = 64; // Many chunks, so workers interleave on every parallel step
+    TurnSimulation simulation(grid, jobs, config);
+    simulation.populate(120, 3);
+    std::vector<uint64_t> checksums;
+    for (int turn = 0; turn < TURNS; ++turn) {
+        simulation.step();
+        checksums.push_back(simulation.checksum());
+    }
+    return checksums;
+}
+
+// Every turn hashes the same on one worker and on four
+void testDeterministicAcrossWorkerCounts() {
+    HexGrid grid = islandGrid();
+    std::vector<uint64_t> single = runTurns(grid, 1);
+    std::vector<uint64_t> pooled = runTurns(grid, 4);
+    CHECK(single.size() == static_cast<size_t>(TURNS));
+    CHECK(pooled.size() == single.size());
+    int firstDifference = -1;
+    for (size_t turn = 0; turn < single.size() && turn < pooled.size(); ++turn) {
+        if (single[turn] != pooled[turn]) {
+            firstDifference = static_cast<int>(turn);
+            break;
+        }
+    }
+    CHECK(firstDifference == -1);
+    CHECK(single.back() == pooled.back());
+
+    // The checksum moves every turn, so matching hashes aren't just an idle simulation
+    for (size_t turn = 1; turn < single.size(); ++turn) CHECK(single[turn] != single[turn - 1]);
+
+    // And a rerun on the same pool size repeats itself
+    CHECK(runTurns(grid, 4) == pooled);
+}
+
+} // namespace
+
+int main() {
+    testDeterministicAcrossWorkerCounts();
+    return testResult();
+}